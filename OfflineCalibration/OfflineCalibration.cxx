@@ -0,0 +1,610 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+/*
+* This tool runs the spatial, temporal and stylus calibrations of fCal on recorded
+* sequence files without user interaction. The calibration algorithms are set up
+* the same way as in the fCal toolboxes, from the device set configuration file, and
+* the results are written into the device set configuration file.
+* The independent calibrations run concurrently and the spatial calibration images
+* are segmented using all available cores.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusFidPatternRecognition.h"
+#include "igsioCommon.h"
+#include "igsioMath.h"
+#include "igsioTrackedFrame.h"
+#include "vtkIGSIOAccurateTimer.h"
+#include "vtkIGSIOTrackedFrameList.h"
+#include "vtkIGSIOTransformRepository.h"
+#include "vtkMatrix4x4.h"
+#include "vtkPlusPivotCalibrationAlgo.h"
+#include "vtkPlusProbeCalibrationAlgo.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTemporalCalibrationAlgo.h"
+#include "vtkSmartPointer.h"
+#include "vtkTransform.h"
+#include "vtkXMLUtilities.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+// Stylus poses closer than this to the previous pose are skipped, same as in the stylus calibration toolbox
+const double STYLUS_POSITION_DIFFERENCE_THRESHOLD_MM = 2.0;
+const double STYLUS_ORIENTATION_DIFFERENCE_THRESHOLD_DEGREES = 2.0;
+
+// Result of one calibration, transforms are copied into the output configuration after all calibrations completed
+struct CalibrationResult
+{
+  CalibrationResult() : Status(PLUS_FAIL), Requested(false) {}
+  PlusStatus Status;
+  bool Requested;
+  vtkSmartPointer<vtkIGSIOTransformRepository> TransformRepository;
+  std::vector<igsioTransformName> ResultTransformNames;
+};
+
+struct TemporalCalibrationResult : public CalibrationResult
+{
+  TemporalCalibrationResult() : MovingLagSec(0.0) {}
+  double MovingLagSec;
+};
+
+PlusStatus ReadSequenceFile(const std::string& fileName, vtkIGSIOTrackedFrameList* trackedFrameList);
+PlusStatus SegmentFrames(vtkXMLDataElement* configRootElement, vtkIGSIOTrackedFrameList* trackedFrameList, unsigned int numberOfThreads, int& numberOfSegmentedFrames);
+void RunSpatialCalibration(vtkXMLDataElement* configRootElement, const std::string& calibrationSeqFile, const std::string& validationSeqFile, unsigned int numberOfThreads, CalibrationResult& result);
+void RunTemporalCalibration(vtkXMLDataElement* configRootElement, const std::string& fixedSeqFile, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE fixedType, const std::string& fixedTransformName,
+                            const std::string& movingSeqFile, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE movingType, const std::string& movingTransformName, TemporalCalibrationResult& result);
+void RunStylusCalibration(vtkXMLDataElement* configRootElement, const std::string& stylusSeqFile, CalibrationResult& result);
+PlusStatus CopyResultTransforms(const CalibrationResult& result, vtkIGSIOTransformRepository* outputTransformRepository);
+PlusStatus WriteMovingTimeOffset(vtkXMLDataElement* configRootElement, const std::string& movingDeviceId, double movingLagSec);
+PlusStatus GetFrameType(const std::string& frameTypeName, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE& frameType);
+
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  std::string inputConfigFileName;
+  std::string outputConfigFileName;
+  std::string spatialCalibrationSeqFile;
+  std::string spatialValidationSeqFile;
+  std::string temporalFixedSeqFile;
+  std::string temporalFixedType = "VIDEO";
+  std::string temporalFixedTransformName;
+  std::string temporalMovingSeqFile;
+  std::string temporalMovingType = "TRACKER";
+  std::string temporalMovingTransformName;
+  std::string temporalMovingDeviceId;
+  std::string stylusSeqFile;
+  int numberOfThreads = 0;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Device set configuration file, the calibration algorithms are set up from its fCal and calibration elements");
+  args.AddArgument("--output-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputConfigFileName, "Device set configuration file that the results are written to (Default: the input configuration file is updated)");
+  args.AddArgument("--spatial-calibration-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &spatialCalibrationSeqFile, "Recorded phantom scan used for spatial (probe) calibration");
+  args.AddArgument("--spatial-validation-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &spatialValidationSeqFile, "Recorded phantom scan used for validating the spatial calibration");
+  args.AddArgument("--temporal-fixed-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &temporalFixedSeqFile, "Recorded fixed signal for temporal calibration");
+  args.AddArgument("--temporal-fixed-type", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &temporalFixedType, "Type of the fixed signal: VIDEO or TRACKER (Default: VIDEO)");
+  args.AddArgument("--temporal-fixed-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &temporalFixedTransformName, "Probe to reference transform name of the fixed signal if it is TRACKER type (e.g., ProbeToReference)");
+  args.AddArgument("--temporal-moving-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &temporalMovingSeqFile, "Recorded moving signal for temporal calibration (Default: same as the fixed signal)");
+  args.AddArgument("--temporal-moving-type", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &temporalMovingType, "Type of the moving signal: VIDEO or TRACKER (Default: TRACKER)");
+  args.AddArgument("--temporal-moving-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &temporalMovingTransformName, "Probe to reference transform name of the moving signal if it is TRACKER type (e.g., ProbeToReference)");
+  args.AddArgument("--temporal-moving-device-id", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &temporalMovingDeviceId, "Id of the device that provides the moving signal, its LocalTimeOffsetSec is updated with the result");
+  args.AddArgument("--stylus-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &stylusSeqFile, "Recorded stylus pivoting used for stylus (pivot) calibration");
+  args.AddArgument("--threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfThreads, "Number of threads used for segmenting the spatial calibration images (Default: number of cores)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (inputConfigFileName.empty())
+  {
+    std::cerr << "--config-file is required" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (outputConfigFileName.empty())
+  {
+    outputConfigFileName = inputConfigFileName;
+  }
+  if (spatialCalibrationSeqFile.empty() != spatialValidationSeqFile.empty())
+  {
+    std::cerr << "--spatial-calibration-seq-file and --spatial-validation-seq-file must be specified together" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (temporalMovingSeqFile.empty())
+  {
+    temporalMovingSeqFile = temporalFixedSeqFile;
+  }
+  if (spatialCalibrationSeqFile.empty() && temporalFixedSeqFile.empty() && stylusSeqFile.empty())
+  {
+    std::cerr << "No calibration is requested. Specify recorded data for at least one of the spatial, temporal or stylus calibrations." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  vtkPlusTemporalCalibrationAlgo::FRAME_TYPE fixedType = vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_NONE;
+  vtkPlusTemporalCalibrationAlgo::FRAME_TYPE movingType = vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_NONE;
+  if (!temporalFixedSeqFile.empty())
+  {
+    if (GetFrameType(temporalFixedType, fixedType) != PLUS_SUCCESS || GetFrameType(temporalMovingType, movingType) != PLUS_SUCCESS)
+    {
+      std::cerr << "Invalid temporal calibration signal type. Supported types: VIDEO, TRACKER" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    if ((fixedType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_TRACKER && temporalFixedTransformName.empty())
+        || (movingType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_TRACKER && temporalMovingTransformName.empty()))
+    {
+      std::cerr << "--temporal-fixed-transform and --temporal-moving-transform are required for TRACKER type signals" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromFile(inputConfigFileName.c_str()));
+  if (configRootElement == NULL)
+  {
+    LOG_ERROR("Unable to read configuration from file " << inputConfigFileName);
+    exit(EXIT_FAILURE);
+  }
+  vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+  // The calibrations are independent of each other, only read the configuration and write their own transform repository
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+
+  TemporalCalibrationResult temporalResult;
+  std::thread temporalCalibrationThread;
+  if (!temporalFixedSeqFile.empty())
+  {
+    temporalResult.Requested = true;
+    temporalCalibrationThread = std::thread(RunTemporalCalibration, configRootElement.GetPointer(), temporalFixedSeqFile, fixedType, temporalFixedTransformName,
+                                            temporalMovingSeqFile, movingType, temporalMovingTransformName, std::ref(temporalResult));
+  }
+
+  CalibrationResult stylusResult;
+  std::thread stylusCalibrationThread;
+  if (!stylusSeqFile.empty())
+  {
+    stylusResult.Requested = true;
+    stylusCalibrationThread = std::thread(RunStylusCalibration, configRootElement.GetPointer(), stylusSeqFile, std::ref(stylusResult));
+  }
+
+  CalibrationResult spatialResult;
+  if (!spatialCalibrationSeqFile.empty())
+  {
+    spatialResult.Requested = true;
+    RunSpatialCalibration(configRootElement, spatialCalibrationSeqFile, spatialValidationSeqFile, numberOfThreads, spatialResult);
+  }
+
+  if (temporalCalibrationThread.joinable())
+  {
+    temporalCalibrationThread.join();
+  }
+  if (stylusCalibrationThread.joinable())
+  {
+    stylusCalibrationThread.join();
+  }
+
+  LOG_INFO("Calibrations completed in " << vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec << " s");
+
+  // Collect the results into the configuration
+  vtkSmartPointer<vtkIGSIOTransformRepository> outputTransformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+  if (outputTransformRepository->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read transforms from the device set configuration");
+    exit(EXIT_FAILURE);
+  }
+
+  bool allSucceeded = true;
+  bool anySucceeded = false;
+  CalibrationResult* transformResults[] = { &spatialResult, &stylusResult };
+  for (CalibrationResult* result : transformResults)
+  {
+    if (!result->Requested)
+    {
+      continue;
+    }
+    if (result->Status == PLUS_SUCCESS && CopyResultTransforms(*result, outputTransformRepository) == PLUS_SUCCESS)
+    {
+      anySucceeded = true;
+    }
+    else
+    {
+      allSucceeded = false;
+    }
+  }
+  if (outputTransformRepository->WriteConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to save calibration results in configuration XML tree");
+    exit(EXIT_FAILURE);
+  }
+
+  if (temporalResult.Requested)
+  {
+    if (temporalResult.Status == PLUS_SUCCESS && WriteMovingTimeOffset(configRootElement, temporalMovingDeviceId, temporalResult.MovingLagSec) == PLUS_SUCCESS)
+    {
+      anySucceeded = true;
+    }
+    else
+    {
+      allSucceeded = false;
+    }
+  }
+
+  if (anySucceeded)
+  {
+    if (igsioCommon::XML::PrintXML(outputConfigFileName.c_str(), configRootElement) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Unable to write configuration file: " << outputConfigFileName);
+      exit(EXIT_FAILURE);
+    }
+    LOG_INFO("Calibration results are saved in " << outputConfigFileName);
+  }
+
+  return allSucceeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus GetFrameType(const std::string& frameTypeName, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE& frameType)
+{
+  if (igsioCommon::IsEqualInsensitive(frameTypeName, "VIDEO"))
+  {
+    frameType = vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_VIDEO;
+    return PLUS_SUCCESS;
+  }
+  if (igsioCommon::IsEqualInsensitive(frameTypeName, "TRACKER"))
+  {
+    frameType = vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_TRACKER;
+    return PLUS_SUCCESS;
+  }
+  return PLUS_FAIL;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus ReadSequenceFile(const std::string& fileName, vtkIGSIOTrackedFrameList* trackedFrameList)
+{
+  if (vtkPlusSequenceIO::Read(fileName, trackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to load sequence file: " << fileName);
+    return PLUS_FAIL;
+  }
+  LOG_INFO("Read " << trackedFrameList->GetNumberOfTrackedFrames() << " frames from " << fileName);
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus SegmentFrames(vtkXMLDataElement* configRootElement, vtkIGSIOTrackedFrameList* trackedFrameList, unsigned int numberOfThreads, int& numberOfSegmentedFrames)
+{
+  numberOfSegmentedFrames = 0;
+  unsigned int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  unsigned int numberOfParts = std::max(1u, std::min(numberOfThreads, numberOfFrames));
+
+  // Each thread segments a contiguous index range of the frames in place, with its own pattern recognition instance
+  std::vector<std::unique_ptr<PlusFidPatternRecognition> > patternRecognitions;
+  for (unsigned int partIndex = 0; partIndex < numberOfParts; ++partIndex)
+  {
+    std::unique_ptr<PlusFidPatternRecognition> patternRecognition(new PlusFidPatternRecognition());
+    if (patternRecognition->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read pattern recognition configuration");
+      return PLUS_FAIL;
+    }
+    patternRecognitions.push_back(std::move(patternRecognition));
+  }
+
+  std::vector<PlusStatus> statuses(numberOfParts, PLUS_SUCCESS);
+  std::vector<int> numberOfSegmentedFramesInParts(numberOfParts, 0);
+  std::vector<std::thread> threads;
+  for (unsigned int partIndex = 0; partIndex < numberOfParts; ++partIndex)
+  {
+    threads.push_back(std::thread([&, partIndex]()
+    {
+      bool tooManyCandidates = false;
+      for (unsigned int frameIndex = partIndex * numberOfFrames / numberOfParts; frameIndex < (partIndex + 1) * numberOfFrames / numberOfParts; ++frameIndex)
+      {
+        PlusPatternRecognitionResult segResults;
+        PlusFidPatternRecognition::PatternRecognitionError error = PlusFidPatternRecognition::PATTERN_RECOGNITION_ERROR_NO_ERROR;
+        if (patternRecognitions[partIndex]->RecognizePattern(trackedFrameList->GetTrackedFrame(frameIndex), segResults, error, frameIndex) != PLUS_SUCCESS)
+        {
+          statuses[partIndex] = PLUS_FAIL;
+          continue;
+        }
+        if (error == PlusFidPatternRecognition::PATTERN_RECOGNITION_ERROR_TOO_MANY_CANDIDATES)
+        {
+          tooManyCandidates = true;
+        }
+        if (segResults.GetFoundDotsCoordinateValue().size() > 0)
+        {
+          numberOfSegmentedFramesInParts[partIndex]++;
+        }
+      }
+      if (tooManyCandidates)
+      {
+        LOG_WARNING("Too many candidates in frame. Some candidates have been truncated.");
+      }
+    }));
+  }
+  for (std::vector<std::thread>::iterator threadIt = threads.begin(); threadIt != threads.end(); ++threadIt)
+  {
+    threadIt->join();
+  }
+
+  for (unsigned int partIndex = 0; partIndex < numberOfParts; ++partIndex)
+  {
+    if (statuses[partIndex] != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to segment tracked frame list");
+      return PLUS_FAIL;
+    }
+    numberOfSegmentedFrames += numberOfSegmentedFramesInParts[partIndex];
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void RunSpatialCalibration(vtkXMLDataElement* configRootElement, const std::string& calibrationSeqFile, const std::string& validationSeqFile, unsigned int numberOfThreads, CalibrationResult& result)
+{
+  result.Status = PLUS_FAIL;
+  result.TransformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+  vtkSmartPointer<vtkPlusProbeCalibrationAlgo> calibration = vtkSmartPointer<vtkPlusProbeCalibrationAlgo>::New();
+  PlusFidPatternRecognition patternRecognition;
+  if (result.TransformRepository->ReadConfiguration(configRootElement) != PLUS_SUCCESS
+      || calibration->ReadConfiguration(configRootElement) != PLUS_SUCCESS
+      || patternRecognition.ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read spatial calibration configuration");
+    return;
+  }
+
+  vtkXMLDataElement* fCalElement = configRootElement->FindNestedElementWithName("fCal");
+  if (fCalElement == NULL || fCalElement->GetAttribute("TransducerOriginCoordinateFrame") == NULL || fCalElement->GetAttribute("TransducerOriginPixelCoordinateFrame") == NULL)
+  {
+    LOG_ERROR("Transducer origin coordinate frames are not specified in the fCal section of the configuration!");
+    return;
+  }
+
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> calibrationData = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> validationData = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (ReadSequenceFile(calibrationSeqFile, calibrationData) != PLUS_SUCCESS || ReadSequenceFile(validationSeqFile, validationData) != PLUS_SUCCESS)
+  {
+    return;
+  }
+
+  // Remove tracked frames without valid transforms, as the toolbox does during acquisition
+  igsioTransformName probeToPhantomTransformName(calibration->GetProbeCoordinateFrame(), calibration->GetPhantomCoordinateFrame());
+  vtkIGSIOTrackedFrameList* frameLists[] = { calibrationData, validationData };
+  for (vtkIGSIOTrackedFrameList* frameList : frameLists)
+  {
+    for (unsigned int frameIndex = 0; frameIndex < frameList->GetNumberOfTrackedFrames(); frameIndex++)
+    {
+      bool probeToPhantomTransformValid = false;
+      result.TransformRepository->SetTransforms(*frameList->GetTrackedFrame(frameIndex));
+      result.TransformRepository->GetTransformValid(probeToPhantomTransformName, probeToPhantomTransformValid);
+      if (!probeToPhantomTransformValid)
+      {
+        frameList->RemoveTrackedFrame(frameIndex);
+        frameIndex--; // we've deleted the current frame, so continue with the same frameIndex
+      }
+    }
+  }
+
+  int numberOfSegmentedCalibrationFrames = 0;
+  int numberOfSegmentedValidationFrames = 0;
+  if (SegmentFrames(configRootElement, calibrationData, numberOfThreads, numberOfSegmentedCalibrationFrames) != PLUS_SUCCESS
+      || SegmentFrames(configRootElement, validationData, numberOfThreads, numberOfSegmentedValidationFrames) != PLUS_SUCCESS)
+  {
+    return;
+  }
+  LOG_INFO("Segmentation success rate: " << numberOfSegmentedCalibrationFrames + numberOfSegmentedValidationFrames << " out of "
+           << calibrationData->GetNumberOfTrackedFrames() + validationData->GetNumberOfTrackedFrames());
+
+  if (calibration->Calibrate(validationData, calibrationData, result.TransformRepository, patternRecognition.GetFidLineFinder()->GetNWires()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Spatial calibration failed");
+    return;
+  }
+  LOG_INFO("Spatial calibration result: " << calibration->GetResultString());
+
+  // Set transducer origin related transforms, same as the toolbox
+  vtkSmartPointer<vtkMatrix4x4> imageToProbeTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  calibration->GetImageToProbeTransformMatrix(imageToProbeTransformMatrix);
+  vtkSmartPointer<vtkTransform> imageToProbeTransform = vtkSmartPointer<vtkTransform>::New();
+  imageToProbeTransform->SetMatrix(imageToProbeTransformMatrix);
+  vtkSmartPointer<vtkTransform> transducerOriginPixelToTransducerOriginTransform = vtkSmartPointer<vtkTransform>::New();
+  transducerOriginPixelToTransducerOriginTransform->Identity();
+  transducerOriginPixelToTransducerOriginTransform->Scale(imageToProbeTransform->GetScale());
+
+  igsioTransformName transducerOriginPixelToTransducerOriginTransformName(fCalElement->GetAttribute("TransducerOriginPixelCoordinateFrame"), fCalElement->GetAttribute("TransducerOriginCoordinateFrame"));
+  result.TransformRepository->SetTransform(transducerOriginPixelToTransducerOriginTransformName, transducerOriginPixelToTransducerOriginTransform->GetMatrix());
+  result.TransformRepository->SetTransformPersistent(transducerOriginPixelToTransducerOriginTransformName, true);
+  result.TransformRepository->SetTransformDate(transducerOriginPixelToTransducerOriginTransformName, vtkIGSIOAccurateTimer::GetInstance()->GetDateAndTimeString().c_str());
+
+  result.ResultTransformNames.push_back(igsioTransformName(calibration->GetImageCoordinateFrame(), calibration->GetProbeCoordinateFrame()));
+  result.ResultTransformNames.push_back(transducerOriginPixelToTransducerOriginTransformName);
+  result.Status = PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void RunTemporalCalibration(vtkXMLDataElement* configRootElement, const std::string& fixedSeqFile, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE fixedType, const std::string& fixedTransformName,
+                            const std::string& movingSeqFile, vtkPlusTemporalCalibrationAlgo::FRAME_TYPE movingType, const std::string& movingTransformName, TemporalCalibrationResult& result)
+{
+  result.Status = PLUS_FAIL;
+  vtkSmartPointer<vtkPlusTemporalCalibrationAlgo> temporalCalibrationAlgo = vtkSmartPointer<vtkPlusTemporalCalibrationAlgo>::New();
+  if (temporalCalibrationAlgo->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to configure temporal calibration algorithm.");
+    return;
+  }
+
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> fixedData = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> movingData = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (ReadSequenceFile(fixedSeqFile, fixedData) != PLUS_SUCCESS || ReadSequenceFile(movingSeqFile, movingData) != PLUS_SUCCESS)
+  {
+    return;
+  }
+
+  temporalCalibrationAlgo->SetFixedFrames(fixedData, fixedType);
+  if (fixedType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_TRACKER)
+  {
+    temporalCalibrationAlgo->SetFixedProbeToReferenceTransformName(fixedTransformName);
+  }
+  temporalCalibrationAlgo->SetMovingFrames(movingData, movingType);
+  if (movingType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_TRACKER)
+  {
+    temporalCalibrationAlgo->SetMovingProbeToReferenceTransformName(movingTransformName);
+  }
+  temporalCalibrationAlgo->SetSamplingResolutionSec(0.001);
+
+  vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR error = vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR_NONE;
+  if (temporalCalibrationAlgo->Update(error) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cannot determine tracker lag, temporal calibration failed! Error code: " << error);
+    return;
+  }
+
+  if (temporalCalibrationAlgo->GetMovingLagSec(result.MovingLagSec) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cannot determine time lag, temporal calibration failed");
+    return;
+  }
+
+  LOG_INFO("Temporal calibration result: moving stream lags by " << result.MovingLagSec << "s");
+  result.Status = PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void RunStylusCalibration(vtkXMLDataElement* configRootElement, const std::string& stylusSeqFile, CalibrationResult& result)
+{
+  result.Status = PLUS_FAIL;
+  result.TransformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+  vtkSmartPointer<vtkPlusPivotCalibrationAlgo> pivotCalibration = vtkSmartPointer<vtkPlusPivotCalibrationAlgo>::New();
+  if (result.TransformRepository->ReadConfiguration(configRootElement) != PLUS_SUCCESS
+      || pivotCalibration->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read stylus calibration configuration");
+    return;
+  }
+
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> stylusData = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (ReadSequenceFile(stylusSeqFile, stylusData) != PLUS_SUCCESS)
+  {
+    return;
+  }
+
+  // Insert the poses the same way as the toolbox: skip invalid poses and poses that are too close to the previous one
+  igsioTransformName stylusToReferenceTransformName(pivotCalibration->GetObjectMarkerCoordinateFrame(), pivotCalibration->GetReferenceCoordinateFrame());
+  vtkSmartPointer<vtkMatrix4x4> previousStylusToReferenceTransformMatrix;
+  int numberOfInsertedPoints = 0;
+  for (unsigned int frameIndex = 0; frameIndex < stylusData->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    result.TransformRepository->SetTransforms(*stylusData->GetTrackedFrame(frameIndex));
+    vtkSmartPointer<vtkMatrix4x4> stylusToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    ToolStatus status(TOOL_INVALID);
+    if (result.TransformRepository->GetTransform(stylusToReferenceTransformName, stylusToReferenceTransformMatrix, &status) != PLUS_SUCCESS || status != TOOL_OK)
+    {
+      continue;
+    }
+
+    if (previousStylusToReferenceTransformMatrix != NULL
+        && igsioMath::GetPositionDifference(stylusToReferenceTransformMatrix, previousStylusToReferenceTransformMatrix) < STYLUS_POSITION_DIFFERENCE_THRESHOLD_MM
+        && igsioMath::GetOrientationDifference(stylusToReferenceTransformMatrix, previousStylusToReferenceTransformMatrix) < STYLUS_ORIENTATION_DIFFERENCE_THRESHOLD_DEGREES)
+    {
+      continue;
+    }
+
+    pivotCalibration->InsertNextCalibrationPoint(stylusToReferenceTransformMatrix);
+    previousStylusToReferenceTransformMatrix = stylusToReferenceTransformMatrix;
+    numberOfInsertedPoints++;
+  }
+  LOG_INFO("Stylus calibration uses " << numberOfInsertedPoints << " poses out of " << stylusData->GetNumberOfTrackedFrames());
+
+  if (pivotCalibration->DoPivotCalibration(result.TransformRepository) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Stylus calibration failed");
+    return;
+  }
+  LOG_INFO("Stylus calibration result: " << pivotCalibration->GetPivotPointToMarkerTranslationString() << " (error: " << pivotCalibration->GetPivotCalibrationErrorMm() << " mm)");
+
+  result.ResultTransformNames.push_back(igsioTransformName(pivotCalibration->GetObjectPivotPointCoordinateFrame(), pivotCalibration->GetObjectMarkerCoordinateFrame()));
+  result.Status = PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus CopyResultTransforms(const CalibrationResult& result, vtkIGSIOTransformRepository* outputTransformRepository)
+{
+  for (std::vector<igsioTransformName>::const_iterator nameIt = result.ResultTransformNames.begin(); nameIt != result.ResultTransformNames.end(); ++nameIt)
+  {
+    vtkSmartPointer<vtkMatrix4x4> transformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    ToolStatus status(TOOL_INVALID);
+    if (result.TransformRepository->GetTransform(*nameIt, transformMatrix, &status) != PLUS_SUCCESS || status != TOOL_OK)
+    {
+      LOG_ERROR("Calibration result " << nameIt->GetTransformName() << " is not available");
+      return PLUS_FAIL;
+    }
+    outputTransformRepository->SetTransform(*nameIt, transformMatrix);
+    outputTransformRepository->SetTransformPersistent(*nameIt, true);
+
+    std::string date;
+    if (result.TransformRepository->GetTransformDate(*nameIt, date) == PLUS_SUCCESS)
+    {
+      outputTransformRepository->SetTransformDate(*nameIt, date.c_str());
+    }
+    double error = 0.0;
+    if (result.TransformRepository->GetTransformError(*nameIt, error) == PLUS_SUCCESS)
+    {
+      outputTransformRepository->SetTransformError(*nameIt, error);
+    }
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus WriteMovingTimeOffset(vtkXMLDataElement* configRootElement, const std::string& movingDeviceId, double movingLagSec)
+{
+  if (movingDeviceId.empty())
+  {
+    LOG_WARNING("--temporal-moving-device-id is not specified, the temporal calibration result is not saved");
+    return PLUS_SUCCESS;
+  }
+
+  vtkXMLDataElement* dataCollectionElement = configRootElement->FindNestedElementWithName("DataCollection");
+  vtkXMLDataElement* deviceElement = NULL;
+  if (dataCollectionElement != NULL)
+  {
+    deviceElement = dataCollectionElement->FindNestedElementWithNameAndAttribute("Device", "Id", movingDeviceId.c_str());
+  }
+  if (deviceElement == NULL)
+  {
+    LOG_ERROR("Unable to find device " << movingDeviceId << " in the DataCollection element of the configuration");
+    return PLUS_FAIL;
+  }
+
+  // Same as the toolbox: the lag is removed from the current offset of the moving device
+  double localTimeOffsetSec = 0.0;
+  deviceElement->GetScalarAttribute("LocalTimeOffsetSec", localTimeOffsetSec);
+  deviceElement->SetDoubleAttribute("LocalTimeOffsetSec", localTimeOffsetSec - movingLagSec);
+  return PLUS_SUCCESS;
+}
@@ -24,6 +24,7 @@
 #include <QTextStream>
 #include "PlusServerLauncherMainWindow.h"
 
+#include "vtkIGSIOAccurateTimer.h"
 #include "vtkXMLUtilities.h"
 
 #ifdef _WIN32
@@ -120,12 +121,16 @@ void DisplayMessage(QString msg, QString detail, bool isError)
 //-----------------------------------------------------------------------------
 int appMain(int argc, char* argv[])
 {
+  // Reference time for the time to ready reported by the launcher
+  double launchTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+
   QApplication app(argc, argv);
 
   bool printHelp(false);
   std::string deviceSetConfigurationDirectoryPath;
   std::string inputConfigFileName;
   bool autoConnect = false;
+  bool fastStart = false;
   int remoteControlServerPort = PlusServerLauncherMainWindow::RemoteControlServerPortUseDefault;
 
   if (argc > 1)
@@ -141,6 +146,7 @@ int appMain(int argc, char* argv[])
     cmdargs.AddArgument("--device-set-configuration-dir", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &deviceSetConfigurationDirectoryPath, "Device set configuration directory path");
     cmdargs.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Configuration file name");
     cmdargs.AddBooleanArgument("--connect", &autoConnect, "Automatically connect after the application is started");
+    cmdargs.AddBooleanArgument("--fast-start", &fastStart, "Start listening for remote control requests before anything else, log the supported devices and network configuration in the background");
     cmdargs.AddArgument("--port", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &remoteControlServerPort, "OpenIGTLink port number where the launcher will listen for remote control requests. If set to -1 then no remote control server will be launched. Default = 18904.");
     cmdargs.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug)");
 
@@ -187,7 +193,7 @@ int appMain(int argc, char* argv[])
   }
 
   // Start the application
-  PlusServerLauncherMainWindow mainWindow(0, 0, autoConnect, remoteControlServerPort);
+  PlusServerLauncherMainWindow mainWindow(0, 0, autoConnect, remoteControlServerPort, fastStart, launchTimeSec);
   if (mainWindow.GetHideOnStartup())
   {
     mainWindow.hide();
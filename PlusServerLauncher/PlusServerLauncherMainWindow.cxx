@@ -6,31 +6,31 @@ See License.txt for details.
 
 // Local includes
 #include "PlusServerLauncherMainWindow.h"
+#include "QPlusInProcessServer.h"
+#include "QPlusLauncherDiagnostics.h"
 
 // PlusLib includes
 #include <igsioCommon.h>
 #include <QPlusDeviceSetSelectorWidget.h>
 #include <QPlusStatusIcon.h>
 #include <vtkPlusDataCollector.h>
-#include <vtkPlusDeviceFactory.h>
 #include <vtkPlusOpenIGTLinkServer.h>
+#include <vtkIGSIOAccurateTimer.h>
 #include <vtkIGSIOTransformRepository.h>
 
 // Qt includes
 #include <QCheckBox>
 #include <QComboBox>
+#include <QCryptographicHash>
 #include <QDateTime>
 #include <QDesktopServices>
 #include <QDir>
 #include <QDomDocument>
 #include <QFileInfo>
-#include <QHostAddress>
-#include <QHostInfo>
 #include <QIcon>
 #include <QKeyEvent>
 #include <QMenu>
 #include <QMessageBox>
-#include <QNetworkInterface>
 #include <QProcess>
 #include <QRegExp>
 #include <QStatusBar>
@@ -68,16 +68,90 @@ namespace
       pos += replace.length();
     }
   }
+
+  // Encoding of compressed config file content: qCompress output (4-byte big-endian size followed by zlib data) in Base64
+  const char CONFIG_FILE_CONTENT_ENCODING[] = "qCompress+Base64";
+
+  std::string ComputeContentHash(const std::string& content)
+  {
+    QByteArray hash = QCryptographicHash::hash(QByteArray(content.c_str(), static_cast<int>(content.size())), QCryptographicHash::Sha256);
+    return hash.toHex().toStdString();
+  }
+
+  std::string EncodeContent(const std::string& content)
+  {
+    return qCompress(QByteArray(content.c_str(), static_cast<int>(content.size()))).toBase64().toStdString();
+  }
+
+  PlusStatus DecodeContent(const std::string& encodedContent, std::string& content)
+  {
+    QByteArray decodedContent = qUncompress(QByteArray::fromBase64(QByteArray(encodedContent.c_str(), static_cast<int>(encodedContent.size()))));
+    if (decodedContent.isEmpty() && !encodedContent.empty())
+    {
+      return PLUS_FAIL;
+    }
+    content = std::string(decodedContent.constData(), decodedContent.size());
+    return PLUS_SUCCESS;
+  }
+
+  PlusStatus ReadFileContent(const std::string& filePath, std::string& content)
+  {
+    std::ifstream file(filePath.c_str(), std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open())
+    {
+      return PLUS_FAIL;
+    }
+    std::stringstream contentStream;
+    contentStream << file.rdbuf();
+    content = contentStream.str();
+    return PLUS_SUCCESS;
+  }
 }
 
 const int SYSTEM_TRAY_MESSAGE_TIMEOUT_MS = 1000;
 
+// A launched server is reported as started if it is still running after this time
+const int SERVER_STARTUP_GRACE_PERIOD_MS = 500;
+// Stop requests are repeated with this interval (in release mode on Windows the first terminate request may go unnoticed)
+const int SERVER_STOP_RETRY_INTERVAL_MS = 300;
+// Servers that do not stop on request for this time are killed
+const int SERVER_STOP_TIMEOUT_MS = 15000;
+const int SERVER_LIFECYCLE_TIMER_INTERVAL_MS = 50;
+
+// In fast-start mode a warning is logged if the launcher is not ready to accept remote control commands within this time after launch
+const int FAST_START_TARGET_TIME_TO_READY_MS = 300;
+
+// Number of most recent log records that are kept for replaying to clients that subscribe late
+const size_t LOG_RECORD_BUFFER_SIZE = 10000;
+// Maximum number of log records that are sent in one compressed LogMessages command
+const int LOG_RECORD_REPLAY_BATCH_SIZE = 500;
+
+// Maximum size of the encoded config file content in one ConfigFileContentChunk command
+const size_t CONFIG_FILE_CHUNK_SIZE = 65536;
+// Number of queued ConfigFileContentChunk commands that are sent in one remote control timer tick
+const int CONFIG_FILE_CHUNKS_PER_TICK = 4;
+// Limits of a config file that a client sends in multiple AddConfigFile commands, so that a client cannot make the launcher allocate arbitrary amounts of memory
+const int MAX_CONFIG_FILE_CHUNK_COUNT = 1024;
+const size_t MAX_CONFIG_FILE_TRANSFER_SIZE = MAX_CONFIG_FILE_CHUNK_COUNT * CONFIG_FILE_CHUNK_SIZE;
+// Maximum number of incoming config file transfers that a client can have in progress at the same time
+const int MAX_CONFIG_FILE_TRANSFERS_PER_CLIENT = 4;
+// Incoming config file transfers that do not receive a chunk for this long are dropped
+const qint64 CONFIG_FILE_TRANSFER_TIMEOUT_MS = 60000;
+
 //-----------------------------------------------------------------------------
-PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*/, Qt::WindowFlags flags/*=0*/, bool autoConnect /*=false*/, int remoteControlServerPort/*=RemoteControlServerPortUseDefault*/)
+PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*/, Qt::WindowFlags flags/*=0*/, bool autoConnect /*=false*/, int remoteControlServerPort/*=RemoteControlServerPortUseDefault*/,
+    bool fastStart /*=false*/, double launchTimeSec /*=-1.0*/)
   : QMainWindow(parent, flags)
   , m_DeviceSetSelectorWidget(NULL)
   , m_RemoteControlServerPort(remoteControlServerPort)
   , m_RemoteControlServerConnectorProcessTimer(new QTimer())
+  , m_FastStart(fastStart)
+  , m_LaunchTimeSec(launchTimeSec >= 0 ? launchTimeSec : vtkIGSIOAccurateTimer::GetSystemTime())
+  , m_TimeToReadyReported(false)
+  , m_Diagnostics(nullptr)
+  , m_ServerLifecycleTimer(new QTimer(this))
+  , m_RemoteControlLogSubscribed(false)
+  , m_NextLogRecordSequence(1)
 {
   m_RemoteControlServerCallbackCommand = vtkSmartPointer<vtkCallbackCommand>::New();
   m_RemoteControlServerCallbackCommand->SetCallback(PlusServerLauncherMainWindow::OnRemoteControlServerEventReceived);
@@ -87,6 +161,11 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
   m_RemoteControlLogMessageCallbackCommand->SetCallback(PlusServerLauncherMainWindow::OnLogEvent);
   m_RemoteControlLogMessageCallbackCommand->SetClientData(this);
 
+  if (m_RemoteControlServerPort == PlusServerLauncherMainWindow::RemoteControlServerPortUseDefault)
+  {
+    m_RemoteControlServerPort = DEFAULT_REMOTE_CONTROL_SERVER_PORT;
+  }
+
   // Set up UI
   ui.setupUi(this);
 
@@ -143,32 +222,6 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
   ui.centralLayout->removeWidget(ui.placeholder);
   ui.centralLayout->insertWidget(0, m_DeviceSetSelectorWidget);
 
-  // Log basic info (Plus version, supported devices)
-  std::string strPlusLibVersion = std::string(" Software version: ") + plusVersionString;
-  LOG_INFO(strPlusLibVersion);
-  LOG_INFO("Logging at level " << vtkPlusLogger::Instance()->GetLogLevel() << " to file: " << vtkPlusLogger::Instance()->GetLogFileName());
-  vtkSmartPointer<vtkPlusDeviceFactory> deviceFactory = vtkSmartPointer<vtkPlusDeviceFactory>::New();
-  std::ostringstream supportedDevices;
-  deviceFactory->PrintAvailableDevices(supportedDevices, vtkIndent());
-  LOG_INFO(supportedDevices.str());
-
-  if (autoConnect)
-  {
-    std::string configFileName = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationFileName();
-    if (configFileName.empty())
-    {
-      LOG_ERROR("Auto-connect failed: device set configuration file is not specified");
-    }
-    else
-    {
-      ConnectToDevicesByConfigFile(configFileName);
-      if (m_DeviceSetSelectorWidget->GetConnectionSuccessful())
-      {
-        showMinimized();
-      }
-    }
-  }
-
   // Initialize server table
   ui.serverTable->setColumnCount(ServerTableColumns::ColumnCount);
   ui.serverTable->setHorizontalHeaderItem(ServerTableColumns::ID, new QTableWidgetItem("ID"));
@@ -180,51 +233,40 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
   ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Description, QHeaderView::Stretch);
   ui.serverTable->horizontalHeader()->setSectionResizeMode(ServerTableColumns::Button, QHeaderView::ResizeToContents);
 
-  // Log server host name, domain, and IP addresses
-  LOG_INFO("Server host name: " << QHostInfo::localHostName().toStdString());
-  if (!QHostInfo::localDomainName().isEmpty())
-  {
-    LOG_INFO("Server host domain: " << QHostInfo::localDomainName().toStdString());
-  }
+  // Log basic info (Plus version)
+  std::string strPlusLibVersion = std::string(" Software version: ") + plusVersionString;
+  LOG_INFO(strPlusLibVersion);
+  LOG_INFO("Logging at level " << vtkPlusLogger::Instance()->GetLogLevel() << " to file: " << vtkPlusLogger::Instance()->GetLogFileName());
 
-  QString ipAddresses;
-  QList<QHostAddress> list = QNetworkInterface::allAddresses();
-  for (int hostIndex = 0; hostIndex < list.count(); hostIndex++)
+  m_Diagnostics = new QPlusLauncherDiagnostics();
+  connect(m_Diagnostics, &QPlusLauncherDiagnostics::Collected, this, &PlusServerLauncherMainWindow::OnDiagnosticsCollected);
+
+  if (m_FastStart)
   {
-    if (list[hostIndex].protocol() == QAbstractSocket::IPv4Protocol)
+    // Accept remote control commands as soon as possible, everything else is done in the background or once the event loop runs
+    StartRemoteControlServer();
+
+    m_Diagnostics->moveToThread(&m_DiagnosticsThread);
+    connect(&m_DiagnosticsThread, &QThread::started, m_Diagnostics, &QPlusLauncherDiagnostics::Collect);
+    connect(m_Diagnostics, &QPlusLauncherDiagnostics::Collected, &m_DiagnosticsThread, &QThread::quit);
+    m_DiagnosticsThread.start(QThread::LowPriority);
+
+    if (autoConnect)
     {
-      if (!ipAddresses.isEmpty())
-      {
-        ipAddresses.append(", ");
-      }
-      ipAddresses.append(list[hostIndex].toString());
+      QTimer::singleShot(0, this, &PlusServerLauncherMainWindow::AutoConnect);
     }
   }
-
-  LOG_INFO("Server IP addresses: " << ipAddresses.toStdString());
-
-  if (m_RemoteControlServerPort != PlusServerLauncherMainWindow::RemoteControlServerPortDisable)
+  else
   {
-    if (m_RemoteControlServerPort == PlusServerLauncherMainWindow::RemoteControlServerPortUseDefault)
+    // Log supported devices, server host name, domain, and IP addresses
+    m_Diagnostics->Collect();
+
+    if (autoConnect)
     {
-      m_RemoteControlServerPort = DEFAULT_REMOTE_CONTROL_SERVER_PORT;
+      AutoConnect();
     }
 
-    LOG_INFO("Start remote control server at port: " << m_RemoteControlServerPort);
-    m_RemoteControlServerLogic = igtlioLogicPointer::New();
-    m_RemoteControlServerLogic->AddObserver(igtlioCommand::CommandReceivedEvent, m_RemoteControlServerCallbackCommand);
-    m_RemoteControlServerLogic->AddObserver(igtlioCommand::CommandResponseEvent, m_RemoteControlServerCallbackCommand);
-    m_RemoteControlServerConnector = m_RemoteControlServerLogic->CreateConnector();
-    m_RemoteControlServerConnector->AddObserver(igtlioConnector::ConnectedEvent, m_RemoteControlServerCallbackCommand);
-    m_RemoteControlServerConnector->AddObserver(igtlioConnector::ClientConnectedEvent, m_RemoteControlServerCallbackCommand);
-    m_RemoteControlServerConnector->AddObserver(igtlioConnector::ClientDisconnectedEvent, m_RemoteControlServerCallbackCommand);
-    m_RemoteControlServerConnector->SetTypeServer(m_RemoteControlServerPort);
-    m_RemoteControlServerConnector->Start();
-
-    ui.label_networkDetails->setText(ipAddresses + ", port " + QString::number(m_RemoteControlServerPort));
-
-    vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::MessageLogged, m_RemoteControlLogMessageCallbackCommand);
-    vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::WideMessageLogged, m_RemoteControlLogMessageCallbackCommand);
+    StartRemoteControlServer();
   }
 
   connect(ui.checkBox_writePermission, &QCheckBox::clicked, this, &PlusServerLauncherMainWindow::OnWritePermissionClicked);
@@ -235,13 +277,30 @@ PlusServerLauncherMainWindow::PlusServerLauncherMainWindow(QWidget* parent /*=0*
 
   m_RemoteControlServerConnectorProcessTimer->start(5);
 
+  m_ServerLifecycleTimer->setInterval(SERVER_LIFECYCLE_TIMER_INTERVAL_MS);
+  connect(m_ServerLifecycleTimer, &QTimer::timeout, this, &PlusServerLauncherMainWindow::OnServerLifecycleTimerTimeout);
+
   ReadConfiguration();
 }
 
 //-----------------------------------------------------------------------------
 PlusServerLauncherMainWindow::~PlusServerLauncherMainWindow()
 {
-  LocalStopServer(); // deletes m_CurrentServerInstance
+  // Name resolution cannot be interrupted, wait for the diagnostics to complete
+  if (m_DiagnosticsThread.isRunning())
+  {
+    m_DiagnosticsThread.quit();
+    m_DiagnosticsThread.wait();
+  }
+  delete m_Diagnostics;
+  m_Diagnostics = nullptr;
+
+  m_ServerLifecycleTimer->stop();
+  disconnect(m_ServerLifecycleTimer, &QTimer::timeout, this, &PlusServerLauncherMainWindow::OnServerLifecycleTimerTimeout);
+
+  // Close all currently running servers
+  StopAllServersBlocking();
+  m_LocalConfigFile = "";
 
   if (m_RemoteControlServerLogic)
   {
@@ -258,13 +317,6 @@ PlusServerLauncherMainWindow::~PlusServerLauncherMainWindow()
     }
   }
 
-  // Close all currently running servers
-  std::deque<ServerInfo> runningServers = m_ServerInstances;
-  for (std::deque<ServerInfo>::iterator serverIt = runningServers.begin(); serverIt != runningServers.end(); ++serverIt)
-  {
-    StopServer(QString::fromStdString(serverIt->Filename));
-  }
-
   if (m_DeviceSetSelectorWidget != NULL)
   {
     delete m_DeviceSetSelectorWidget;
@@ -325,6 +377,14 @@ PlusStatus PlusServerLauncherMainWindow::ReadConfiguration()
   }
   ui.checkBox_minimizeOnClose->setChecked(minimizeOnClose);
 
+  const char* hostServersInProcessValue = applicationConfigurationRoot->GetAttribute("HostServersInProcess");
+  bool hostServersInProcess = false;
+  if (hostServersInProcessValue && STRCASECMP(hostServersInProcessValue, "True") == 0)
+  {
+    hostServersInProcess = true;
+  }
+  ui.checkBox_inProcessServers->setChecked(hostServersInProcess);
+
   return PLUS_SUCCESS;
 }
 
@@ -344,6 +404,7 @@ PlusStatus PlusServerLauncherMainWindow::WriteConfiguration()
   applicationConfigurationRoot->SetAttribute("HideOnStartup", ui.checkBox_startMinimized->isChecked() ? "True" : "False");
   applicationConfigurationRoot->SetAttribute("ShowNotifications", ui.checkBox_showNotifications->isChecked() ? "True" : "False");
   applicationConfigurationRoot->SetAttribute("MinimizeOnClose", ui.checkBox_minimizeOnClose->isChecked() ? "True" : "False");
+  applicationConfigurationRoot->SetAttribute("HostServersInProcess", ui.checkBox_inProcessServers->isChecked() ? "True" : "False");
 
   // Write configuration to file
   igsioCommon::XML::PrintXML(applicationConfigurationFilePath.c_str(), applicationConfigurationRoot);
@@ -352,10 +413,19 @@ PlusStatus PlusServerLauncherMainWindow::WriteConfiguration()
 }
 
 //-----------------------------------------------------------------------------
-bool PlusServerLauncherMainWindow::StartServer(const QString& configFilePath, int logLevel)
+bool PlusServerLauncherMainWindow::StartServer(const QString& configFilePath, int logLevel, igtlioCommandPointer command/*=nullptr*/)
 {
+  if (ui.checkBox_inProcessServers->isChecked())
+  {
+    // In-process servers log directly to the launcher's logger, so the requested log level does not apply
+    return StartInProcessServer(configFilePath, command);
+  }
+
   QProcess* newServerProcess = new QProcess();
   ServerInfo newServerInfo(vtksys::SystemTools::GetFilenameName(configFilePath.toStdString()), newServerProcess);
+  newServerInfo.State = ServerState_Starting;
+  newServerInfo.StateChangeTimeMs = QDateTime::currentMSecsSinceEpoch();
+  newServerInfo.PendingStartCommand = command;
   m_ServerInstances.push_back(newServerInfo);
 
   std::string plusServerExecutable = vtkPlusConfig::GetInstance()->GetPlusExecutablePath("PlusServer");
@@ -364,6 +434,8 @@ bool PlusServerLauncherMainWindow::StartServer(const QString& configFilePath, in
 
   connect(newServerProcess, SIGNAL(error(QProcess::ProcessError)), this, SLOT(ErrorReceived(QProcess::ProcessError)));
   connect(newServerProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(ServerExecutableFinished(int, QProcess::ExitStatus)));
+  connect(newServerProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(StdOutMsgReceived()));
+  connect(newServerProcess, SIGNAL(readyReadStandardError()), this, SLOT(StdErrMsgReceived()));
 
   // PlusServerLauncher wants at least LOG_LEVEL_INFO to parse status information from the PlusServer executable
   // Un-requested log entries that are captured from the PlusServer executable are parsed and dropped from output
@@ -379,31 +451,317 @@ bool PlusServerLauncherMainWindow::StartServer(const QString& configFilePath, in
   QString cmdLine = QString("\"%1\" --config-file=\"%2\" --verbose=%3").arg(plusServerExecutable.c_str()).arg(configFilePath).arg(logLevelToPlusServer);
   LOG_INFO("Server process command line: " << cmdLine.toLatin1().constData());
   newServerProcess->start(cmdLine);
-  newServerProcess->waitForFinished(500);
 
-  // During waitForFinished an error signal may be emitted, which may delete newServerProcess,
-  // therefore we need to check if the current server process still exists
-  QString baseFileName = QString::fromStdString(vtksys::SystemTools::GetFilenameName(configFilePath.toStdString()));
-  if (GetServerInfoFromID(newServerInfo.ID).Process &&
-    newServerProcess && newServerProcess->state() == QProcess::Running)
+  // The start failure may have been reported already while launching, in that case the process is released
+  if (GetServerInfoFromProcess(newServerProcess).Process == nullptr)
+  {
+    return false;
+  }
+
+  // The lifecycle timer reports the server as started once it survived the startup grace period,
+  // a process that fails or exits before that is handled by ErrorReceived and ServerExecutableFinished
+  ui.comboBox_LogLevel->setEnabled(false);
+  UpdateRemoteServerTable();
+  if (!m_ServerLifecycleTimer->isActive())
   {
-    LOG_INFO("Server process started successfully");
-    connect(newServerInfo.Process, SIGNAL(readyReadStandardOutput()), this, SLOT(StdOutMsgReceived()));
-    connect(newServerInfo.Process, SIGNAL(readyReadStandardError()), this, SLOT(StdErrMsgReceived()));
-    ui.comboBox_LogLevel->setEnabled(false);
-    UpdateRemoteServerTable();
+    m_ServerLifecycleTimer->start();
+  }
 
-    ShowNotification(QString("Configuration file: %1").arg(baseFileName), "Server starting");
+  return true;
+}
 
-    return true;
+//----------------------------------------------------------------------------
+bool PlusServerLauncherMainWindow::StartInProcessServer(const QString& configFilePath, igtlioCommandPointer command/*=nullptr*/)
+{
+  std::string filename = vtksys::SystemTools::GetFilenameName(configFilePath.toStdString());
+  QPlusInProcessServer* newServer = new QPlusInProcessServer(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(filename));
+  ServerInfo newServerInfo(filename, newServer);
+  newServerInfo.State = ServerState_Starting;
+  newServerInfo.StateChangeTimeMs = QDateTime::currentMSecsSinceEpoch();
+  newServerInfo.PendingStartCommand = command;
+  m_ServerInstances.push_back(newServerInfo);
+
+  connect(newServer, SIGNAL(Started()), this, SLOT(InProcessServerStarted()));
+  connect(newServer, SIGNAL(StartFailed(const QString&)), this, SLOT(InProcessServerStartFailed(const QString&)));
+  connect(newServer, SIGNAL(Stopped()), this, SLOT(InProcessServerStopped()));
+
+  LOG_INFO("Start server in the launcher process using configuration file: " << filename);
+  newServer->Start();
+
+  ui.comboBox_LogLevel->setEnabled(false);
+  UpdateRemoteServerTable();
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::InProcessServerStarted()
+{
+  QObject* server = sender();
+  ServerInfo info = GetServerInfoFromProcess(server);
+  if (info.InProcessServer == nullptr || info.State != ServerState_Starting)
+  {
+    return;
+  }
+
+  // The status that is parsed from the output of a PlusServer process is reported directly by the in-process server
+  if (info.Filename == vtksys::SystemTools::GetFilenameName(m_LocalConfigFile))
+  {
+    m_Suffix = std::string("Plus OpenIGTLink servers running in the launcher process: ") + GetServersFromConfigFile(info.Filename) + "\n";
+    m_DeviceSetSelectorWidget->SetDescriptionSuffix(QString::fromStdString(m_Suffix));
+    m_DeviceSetSelectorWidget->SetConnectionSuccessful(true);
+    m_DeviceSetSelectorWidget->SetConnectButtonText(QString("Stop server"));
+  }
+  ShowNotification(QString("Configuration file: %1").arg(QString::fromStdString(info.Filename)), "Server started");
+
+  OnServerStartCompleted(server);
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::InProcessServerStartFailed(const QString& errorMessage)
+{
+  QObject* server = sender();
+  ServerInfo info = GetServerInfoFromProcess(server);
+  if (info.InProcessServer == nullptr)
+  {
+    return;
+  }
+
+  LOG_ERROR("In-process server failed to start: " << errorMessage.toStdString());
+  if (info.State == ServerState_Stopping)
+  {
+    OnServerStopCompleted(server);
   }
   else
   {
-    LOG_ERROR("Failed to start server process");
+    OnServerStartFailed(server);
+  }
+}
 
-    ShowNotification(QString("Configuration file: %1").arg(baseFileName), "Failed to start server");
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::InProcessServerStopped()
+{
+  OnServerStopCompleted(sender());
+}
 
-    return false;
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnServerLifecycleTimerTimeout()
+{
+  const qint64 currentTimeMs = QDateTime::currentMSecsSinceEpoch();
+  bool transitionPending = false;
+  std::vector<QProcess*> startedProcesses;
+
+  for (std::deque<ServerInfo>::iterator serverIt = m_ServerInstances.begin(); serverIt != m_ServerInstances.end(); ++serverIt)
+  {
+    if (serverIt->Process == nullptr)
+    {
+      // In-process servers report their state changes through callbacks
+      continue;
+    }
+
+    if (serverIt->State == ServerState_Starting)
+    {
+      if (serverIt->Process->state() == QProcess::Running && currentTimeMs - serverIt->StateChangeTimeMs >= SERVER_STARTUP_GRACE_PERIOD_MS)
+      {
+        startedProcesses.push_back(serverIt->Process);
+      }
+      else
+      {
+        transitionPending = true;
+      }
+    }
+    else if (serverIt->State == ServerState_Stopping)
+    {
+      transitionPending = true;
+      if (serverIt->ForcedShutdown)
+      {
+        // Already killed, waiting for the finished signal
+        continue;
+      }
+      if (currentTimeMs - serverIt->StateChangeTimeMs > SERVER_STOP_TIMEOUT_MS)
+      {
+        // graceful termination was not successful, force the process to quit
+        LOG_WARNING("Server process " << serverIt->ID << " did not stop on request for " << (currentTimeMs - serverIt->StateChangeTimeMs) / 1000.0 << " seconds, force it to quit now");
+        serverIt->ForcedShutdown = true;
+        serverIt->Process->kill();
+      }
+      else if (currentTimeMs - serverIt->LastStopRequestTimeMs >= SERVER_STOP_RETRY_INTERVAL_MS)
+      {
+        serverIt->Process->terminate(); // in release mode on Windows the first terminate request may go unnoticed
+        serverIt->LastStopRequestTimeMs = currentTimeMs;
+      }
+    }
+  }
+
+  // Completing a start sends commands and updates the GUI, so it is done after iterating the server list
+  for (std::vector<QProcess*>::iterator processIt = startedProcesses.begin(); processIt != startedProcesses.end(); ++processIt)
+  {
+    OnServerStartCompleted(*processIt);
+  }
+
+  if (!transitionPending)
+  {
+    m_ServerLifecycleTimer->stop();
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnServerStartCompleted(QObject* server)
+{
+  ServerInfo* info = FindServerInfo(server);
+  if (info == nullptr || info->State != ServerState_Starting)
+  {
+    return;
+  }
+  info->State = ServerState_Running;
+  info->StateChangeTimeMs = QDateTime::currentMSecsSinceEpoch();
+  igtlioCommandPointer startCommand = info->PendingStartCommand;
+  info->PendingStartCommand = nullptr;
+  ServerInfo startedInfo = *info;
+
+  LOG_INFO("Server process started successfully");
+  if (startedInfo.Process)
+  {
+    // The PlusServer process may still be connecting to the devices
+    ShowNotification(QString("Configuration file: %1").arg(QString::fromStdString(startedInfo.Filename)), "Server starting");
+  }
+
+  if (startCommand)
+  {
+    std::string servers = GetServersFromConfigFile(startedInfo.Filename);
+    startCommand->SetSuccessful(true);
+    startCommand->SetResponseMetaDataElement("ConfigFileName", startedInfo.Filename);
+    startCommand->SetResponseMetaDataElement("Servers", servers);
+    if (SendCommandResponse(startCommand) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+  }
+  else if (m_RemoteControlServerConnector)
+  {
+    SendServerStartedCommand(startedInfo);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnServerStartFailed(QObject* server)
+{
+  ServerInfo info = GetServerInfoFromProcess(server);
+  if (info.GetHandle() == nullptr)
+  {
+    return;
+  }
+
+  LOG_ERROR("Failed to start server process");
+  ShowNotification(QString("Configuration file: %1").arg(QString::fromStdString(info.Filename)), "Failed to start server");
+
+  ReleaseServerProcess(server);
+
+  if (info.PendingStartCommand)
+  {
+    info.PendingStartCommand->SetSuccessful(false);
+    info.PendingStartCommand->SetErrorMessage("Failed to start server process.");
+    if (SendCommandResponse(info.PendingStartCommand) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+  }
+
+  // Stop requests that arrived while starting are answered as well, the server is down
+  for (std::vector<igtlioCommandPointer>::iterator commandIt = info.PendingStopCommands.begin(); commandIt != info.PendingStopCommands.end(); ++commandIt)
+  {
+    SendServerStopResponse(*commandIt, info.Filename, info.ID);
+  }
+
+  if (info.Filename == vtksys::SystemTools::GetFilenameName(m_LocalConfigFile))
+  {
+    m_LocalConfigFile = "";
+    m_DeviceSetSelectorWidget->ClearDescriptionSuffix();
+    m_DeviceSetSelectorWidget->SetConnectionSuccessful(false);
+    m_DeviceSetSelectorWidget->SetConnectButtonText(QString("Launch server"));
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnServerStopCompleted(QObject* server)
+{
+  ServerInfo info = GetServerInfoFromProcess(server);
+  if (info.GetHandle() == nullptr)
+  {
+    return;
+  }
+
+  LOG_INFO("Server process stopped successfully");
+  ShowNotification(QString("Configuration file: %1").arg(QString::fromStdString(info.Filename)), "Server stopped");
+
+  ReleaseServerProcess(server);
+  m_Suffix.clear();
+
+  // Forced stop or not, the server is down
+  for (std::vector<igtlioCommandPointer>::iterator commandIt = info.PendingStopCommands.begin(); commandIt != info.PendingStopCommands.end(); ++commandIt)
+  {
+    SendServerStopResponse(*commandIt, info.Filename, info.ID);
+  }
+
+  if (info.PendingStartCommand)
+  {
+    info.PendingStartCommand->SetSuccessful(false);
+    info.PendingStartCommand->SetErrorMessage("Server was stopped before it started.");
+    if (SendCommandResponse(info.PendingStartCommand) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+  }
+
+  if (m_RemoteControlServerConnector)
+  {
+    SendServerStoppedCommand(info);
+  }
+
+  // The server launched from the GUI may also be stopped remotely or from the server table
+  if (info.Filename == vtksys::SystemTools::GetFilenameName(m_LocalConfigFile))
+  {
+    m_LocalConfigFile = "";
+    m_DeviceSetSelectorWidget->ClearDescriptionSuffix();
+    m_DeviceSetSelectorWidget->SetConnectionSuccessful(false);
+    m_DeviceSetSelectorWidget->SetConnectButtonText(QString("Launch server"));
+  }
+
+  // Launch the configuration that was requested from the GUI while this server was shutting down
+  if (!m_PendingLocalConfigFile.empty() && vtksys::SystemTools::GetFilenameName(m_PendingLocalConfigFile) == info.Filename)
+  {
+    std::string configFile = m_PendingLocalConfigFile;
+    m_PendingLocalConfigFile = "";
+    ConnectToDevicesByConfigFile(configFile);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::ReleaseServerProcess(QObject* server)
+{
+  // Output, error, finished and in-process status signals
+  disconnect(server, nullptr, this, nullptr);
+
+  RemoveServerProcess(server);
+
+  // May be called from a signal of the server
+  server->deleteLater();
+
+  if (m_ServerInstances.empty())
+  {
+    ui.comboBox_LogLevel->setEnabled(true);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::SendServerStopResponse(igtlioCommandPointer command, const std::string& filename, const std::string& id)
+{
+  command->SetSuccessful(true);
+  command->SetResponseMetaDataElement("ConfigFileName", filename);
+  command->SetResponseMetaDataElement("ServerID", id);
+  if (SendCommandResponse(command) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Command received but response could not be sent.");
   }
 }
 
@@ -434,11 +792,11 @@ PlusServerLauncherMainWindow::ServerInfo PlusServerLauncherMainWindow::GetServer
 }
 
 //----------------------------------------------------------------------------
-PlusServerLauncherMainWindow::ServerInfo PlusServerLauncherMainWindow::GetServerInfoFromProcess(QProcess* process)
+PlusServerLauncherMainWindow::ServerInfo PlusServerLauncherMainWindow::GetServerInfoFromProcess(QObject* server)
 {
   for (std::deque<ServerInfo>::iterator serverIt = m_ServerInstances.begin(); serverIt != m_ServerInstances.end(); ++serverIt)
   {
-    if (serverIt->Process == process)
+    if (server != nullptr && serverIt->GetHandle() == server)
     {
       return *serverIt;
     }
@@ -447,11 +805,24 @@ PlusServerLauncherMainWindow::ServerInfo PlusServerLauncherMainWindow::GetServer
 }
 
 //----------------------------------------------------------------------------
-PlusStatus PlusServerLauncherMainWindow::RemoveServerProcess(QProcess* process)
+PlusServerLauncherMainWindow::ServerInfo* PlusServerLauncherMainWindow::FindServerInfo(QObject* server)
+{
+  for (std::deque<ServerInfo>::iterator serverIt = m_ServerInstances.begin(); serverIt != m_ServerInstances.end(); ++serverIt)
+  {
+    if (server != nullptr && serverIt->GetHandle() == server)
+    {
+      return &(*serverIt);
+    }
+  }
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusServerLauncherMainWindow::RemoveServerProcess(QObject* server)
 {
   for (std::deque<ServerInfo>::iterator serverIt = m_ServerInstances.begin(); serverIt != m_ServerInstances.end(); ++serverIt)
   {
-    if (serverIt->Process == process)
+    if (serverIt->GetHandle() == server)
     {
       m_ServerInstances.erase(serverIt);
       UpdateRemoteServerTable();
@@ -464,19 +835,9 @@ PlusStatus PlusServerLauncherMainWindow::RemoveServerProcess(QProcess* process)
 //----------------------------------------------------------------------------
 bool PlusServerLauncherMainWindow::LocalStartServer()
 {
+  // ServerStarted is broadcast to the remote control clients when the start is completed
   std::string filename = vtksys::SystemTools::GetFilenameName(m_LocalConfigFile);
-  if (!StartServer(QString::fromStdString(filename)))
-  {
-    return false;
-  }
-
-  ServerInfo newServerInfo = GetServerInfoFromFilename(filename);
-  if (m_RemoteControlServerConnector)
-  {
-    SendServerStartedCommand(newServerInfo);
-  }
-
-  return true;
+  return StartServer(QString::fromStdString(filename));
 }
 
 //----------------------------------------------------------------------------
@@ -555,69 +916,107 @@ void PlusServerLauncherMainWindow::StopRemoteServerButtonClicked()
 }
 
 //-----------------------------------------------------------------------------
-bool PlusServerLauncherMainWindow::StopServer(const QString& configFilePath)
+bool PlusServerLauncherMainWindow::StopServer(const QString& configFilePath, igtlioCommandPointer command/*=nullptr*/)
 {
-  ServerInfo info = GetServerInfoFromFilename(vtksys::SystemTools::GetFilenameName(configFilePath.toStdString()));
-  QProcess* process = info.Process;
-  if (!process)
+  std::string filename = vtksys::SystemTools::GetFilenameName(configFilePath.toStdString());
+  ServerInfo* info = FindServerInfo(GetServerInfoFromFilename(filename).GetHandle());
+  if (info == nullptr)
   {
     // Server at config file isn't running
+    if (command)
+    {
+      SendServerStopResponse(command, filename, "");
+    }
     return true;
   }
 
-  bool forcedShutdown = false;
-  if (process->state() == QProcess::Running)
+  if (command)
   {
-    process->terminate();
-    if (process->state() == QProcess::Running)
+    info->PendingStopCommands.push_back(command);
+  }
+
+  if (info->State == ServerState_Stopping)
+  {
+    // Already stopping, the command is answered together with the previous requests
+    return true;
+  }
+
+  const qint64 currentTimeMs = QDateTime::currentMSecsSinceEpoch();
+  info->State = ServerState_Stopping;
+  info->StateChangeTimeMs = currentTimeMs;
+  info->LastStopRequestTimeMs = currentTimeMs;
+  info->ForcedShutdown = false;
+
+  if (info->InProcessServer)
+  {
+    // Completed when the worker reports that the servers are stopped
+    info->InProcessServer->Stop();
+    LOG_INFO("In-process server stop request sent successfully");
+    return true;
+  }
+
+  // The stop is completed in ServerExecutableFinished, the lifecycle timer repeats the request and kills the server on timeout
+  info->Process->terminate();
+  LOG_INFO("Server process stop request sent successfully");
+  if (!m_ServerLifecycleTimer->isActive())
+  {
+    m_ServerLifecycleTimer->start();
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::StopAllServersBlocking()
+{
+  // Request all servers to stop at once, then wait for them together
+  std::deque<ServerInfo> runningServers = m_ServerInstances;
+  m_ServerInstances.clear();
+  for (std::deque<ServerInfo>::iterator serverIt = runningServers.begin(); serverIt != runningServers.end(); ++serverIt)
+  {
+    disconnect(serverIt->GetHandle(), nullptr, this, nullptr);
+    if (serverIt->InProcessServer)
     {
-      LOG_INFO("Server process stop request sent successfully");
+      serverIt->InProcessServer->Stop();
     }
-    const int totalTimeoutSec = 15;
-    const double retryDelayTimeoutSec = 0.3;
-    double timePassedSec = 0;
-    // TODO : make this asynchronous so server can continue performing other actions
-    while (!process->waitForFinished(retryDelayTimeoutSec * 1000))
+    else
     {
-      process->terminate(); // in release mode on Windows the first terminate request may go unnoticed
-      timePassedSec += retryDelayTimeoutSec;
-      if (timePassedSec > totalTimeoutSec)
+      serverIt->Process->terminate();
+    }
+  }
+
+  const qint64 stopRequestTimeMs = QDateTime::currentMSecsSinceEpoch();
+  for (std::deque<ServerInfo>::iterator serverIt = runningServers.begin(); serverIt != runningServers.end(); ++serverIt)
+  {
+    if (serverIt->InProcessServer)
+    {
+      // Waits for the worker thread to finish stopping
+      delete serverIt->InProcessServer;
+      continue;
+    }
+
+    QProcess* process = serverIt->Process;
+    while (process->state() != QProcess::NotRunning && !process->waitForFinished(SERVER_STOP_RETRY_INTERVAL_MS))
+    {
+      if (QDateTime::currentMSecsSinceEpoch() - stopRequestTimeMs > SERVER_STOP_TIMEOUT_MS)
       {
         // graceful termination was not successful, force the process to quit
-        LOG_WARNING("Server process did not stop on request for " << timePassedSec << " seconds, force it to quit now");
+        LOG_WARNING("Server process " << serverIt->ID << " did not stop on request, force it to quit now");
         process->kill();
-        forcedShutdown = true;
+        process->waitForFinished(SERVER_STOP_RETRY_INTERVAL_MS);
         break;
       }
+      process->terminate(); // in release mode on Windows the first terminate request may go unnoticed
     }
-    LOG_INFO("Server process stopped successfully");
-    ui.comboBox_LogLevel->setEnabled(true);
+    delete process;
   }
-
-  disconnect(process, SIGNAL(readyReadStandardOutput()), this, SLOT(StdOutMsgReceived()));
-  disconnect(process, SIGNAL(readyReadStandardError()), this, SLOT(StdErrMsgReceived()));
-  disconnect(process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(ErrorReceived(QProcess::ProcessError)));
-  disconnect(process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(ServerExecutableFinished(int, QProcess::ExitStatus)));
-
-  RemoveServerProcess(process);
-  delete process;
-
-  if (m_RemoteControlServerConnector)
-  {
-    std::string configFileString = vtksys::SystemTools::GetFilenameName(vtksys::SystemTools::GetFilenameName(configFilePath.toStdString()));
-    SendServerStoppedCommand(info);
-  }
-
-  m_Suffix.clear();
-  return !forcedShutdown;
 }
 
 //----------------------------------------------------------------------------
 bool PlusServerLauncherMainWindow::LocalStopServer()
 {
   ServerInfo info = GetServerInfoFromFilename(vtksys::SystemTools::GetFilenameName(m_LocalConfigFile));
-  QProcess* process = info.Process;
-  if (!process)
+  if (!info.GetHandle())
   {
     // Server at config file isn't running
     return true;
@@ -711,6 +1110,7 @@ void PlusServerLauncherMainWindow::ConnectToDevicesByConfigFile(std::string aCon
   // Empty parameter string means disconnect from device
   if (aConfigFile.empty())
   {
+    m_PendingLocalConfigFile = "";
     LOG_INFO("Disconnect request successful");
     m_DeviceSetSelectorWidget->ClearDescriptionSuffix();
     m_DeviceSetSelectorWidget->SetConnectButtonText(QString("Launch server"));
@@ -719,6 +1119,16 @@ void PlusServerLauncherMainWindow::ConnectToDevicesByConfigFile(std::string aCon
 
   LOG_INFO("Connect using configuration file: " << aConfigFile);
 
+  // A server with the same configuration may still be shutting down, launch when it has released its ports
+  ServerInfo previousServerInfo = GetServerInfoFromFilename(vtksys::SystemTools::GetFilenameName(aConfigFile));
+  if (previousServerInfo.GetHandle() && previousServerInfo.State == ServerState_Stopping)
+  {
+    LOG_INFO("Waiting for the previous server of " << previousServerInfo.Filename << " to stop");
+    m_PendingLocalConfigFile = aConfigFile;
+    m_DeviceSetSelectorWidget->SetConnectButtonText(QString("Launching..."));
+    return;
+  }
+
   // Connect
   m_LocalConfigFile = aConfigFile;
   if (LocalStartServer())
@@ -928,9 +1338,20 @@ void PlusServerLauncherMainWindow::ErrorReceived(QProcess::ProcessError errorCod
     {
       m_DeviceSetSelectorWidget->SetConnectionSuccessful(false);
     }
-  }
-
 
+    // The finished signal is not emitted for a process that could not be started
+    if (info.Process && errorCode == QProcess::FailedToStart)
+    {
+      if (info.State == ServerState_Stopping)
+      {
+        OnServerStopCompleted(process);
+      }
+      else
+      {
+        OnServerStartFailed(process);
+      }
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -938,13 +1359,26 @@ void PlusServerLauncherMainWindow::ServerExecutableFinished(int returnCode, QPro
 {
   QProcess* finishedProcess = dynamic_cast<QProcess*>(sender());
   ServerInfo info = GetServerInfoFromProcess(finishedProcess);
+  if (!finishedProcess || !info.Process)
+  {
+    return;
+  }
   std::string configFileName = info.Filename;
 
-  if (finishedProcess)
+  if (info.State == ServerState_Starting)
   {
-    RemoveServerProcess(finishedProcess);
+    LOG_ERROR("Server stopped unexpectedly. Return code: " << returnCode);
+    OnServerStartFailed(finishedProcess);
+    return;
+  }
+  else if (info.State == ServerState_Stopping)
+  {
+    OnServerStopCompleted(finishedProcess);
+    return;
   }
 
+  ReleaseServerProcess(finishedProcess);
+
   if (strcmp(vtksys::SystemTools::GetFilenameName(m_LocalConfigFile).c_str(), configFileName.c_str()) == 0)
   {
     ConnectToDevicesByConfigFile("");
@@ -1100,6 +1534,31 @@ void PlusServerLauncherMainWindow::OnClientDisconnectedEvent()
     m_RemoteControlLogSubscribedClients.erase(unsubscribedClients.front());
     unsubscribedClients.pop();
   }
+  m_RemoteControlLogSubscribed = !m_RemoteControlLogSubscribedClients.empty();
+
+  // Drop config file transfers of disconnected clients
+  for (std::map<std::pair<int, std::string>, ConfigFileTransfer>::iterator transferIt = m_ConfigFileTransfers.begin(); transferIt != m_ConfigFileTransfers.end();)
+  {
+    if (std::find(connectedClientIds.begin(), connectedClientIds.end(), transferIt->first.first) == connectedClientIds.end())
+    {
+      transferIt = m_ConfigFileTransfers.erase(transferIt);
+    }
+    else
+    {
+      ++transferIt;
+    }
+  }
+  for (std::deque<igtlioCommandPointer>::iterator chunkIt = m_OutgoingConfigFileChunks.begin(); chunkIt != m_OutgoingConfigFileChunks.end();)
+  {
+    if (std::find(connectedClientIds.begin(), connectedClientIds.end(), (*chunkIt)->GetClientId()) == connectedClientIds.end())
+    {
+      chunkIt = m_OutgoingConfigFileChunks.erase(chunkIt);
+    }
+    else
+    {
+      ++chunkIt;
+    }
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -1137,12 +1596,13 @@ void PlusServerLauncherMainWindow::OnCommandReceivedEvent(igtlioCommandPointer c
   }
   else if (igsioCommon::IsEqualInsensitive(name, "LogSubscribe"))
   {
-    m_RemoteControlLogSubscribedClients.insert(command->GetClientId());
+    LogSubscribe(command);
     return;
   }
   else if (igsioCommon::IsEqualInsensitive(name, "LogUnsubscribe"))
   {
     m_RemoteControlLogSubscribedClients.erase(command->GetClientId());
+    m_RemoteControlLogSubscribed = !m_RemoteControlLogSubscribedClients.empty();
     return;
   }
   else if (igsioCommon::IsEqualInsensitive(name, "GetRunningServers"))
@@ -1186,28 +1646,8 @@ void PlusServerLauncherMainWindow::RemoteStopServer(igtlioCommandPointer command
     info = GetServerInfoFromFilename(filename);
   }
 
-  StopServer(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(filename))));
-
-  vtkSmartPointer<vtkXMLDataElement> commandElement = vtkSmartPointer<vtkXMLDataElement>::New();
-  commandElement->SetName("Command");
-  vtkSmartPointer<vtkXMLDataElement> responseElement = vtkSmartPointer<vtkXMLDataElement>::New();
-  responseElement->SetName("Response");
-  responseElement->SetAttribute("ConfigFileName", filename.c_str());
-  responseElement->SetAttribute("ServerID", id.c_str());
-  commandElement->AddNestedElement(responseElement);
-
-  std::stringstream commandSS;
-  vtkXMLUtilities::FlattenElement(commandElement, commandSS);
-
-  // Forced stop or not, the server is down
-  command->SetSuccessful(true);
-  command->SetResponseMetaDataElement("ConfigFileName", filename);
-  command->SetResponseMetaDataElement("ServerID", id);
-  if (SendCommandResponse(command) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Command received but response could not be sent.");
-  }
-  return;
+  // The response is sent when the server process has exited, other commands are processed in the meantime
+  StopServer(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(filename))), command);
 }
 
 //----------------------------------------------------------------------------
@@ -1237,10 +1677,18 @@ void PlusServerLauncherMainWindow::RemoteStartServer(igtlioCommandPointer comman
     logLevel = vtkPlusLogger::LOG_LEVEL_INFO;
   }
 
-  if (!StartServer(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(filename))), logLevel))
+  // The response is sent when the server has started or failed to start, other commands are processed in the meantime
+  StartServer(QString::fromStdString(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(filename))), logLevel, command);
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::GetConfigFiles(igtlioCommandPointer command)
+{
+  vtkSmartPointer<vtkDirectory> dir = vtkSmartPointer<vtkDirectory>::New();
+  if (dir->Open(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationDirectory().c_str()) == 0)
   {
     command->SetSuccessful(false);
-    command->SetErrorMessage("Failed to start server process.");
+    command->SetErrorMessage("Unable to open device set directory.");
     if (SendCommandResponse(command) != PLUS_SUCCESS)
     {
       LOG_ERROR("Command received but response could not be sent.");
@@ -1248,35 +1696,184 @@ void PlusServerLauncherMainWindow::RemoteStartServer(igtlioCommandPointer comman
     return;
   }
 
-  std::string servers = GetServersFromConfigFile(filename);
-  std::stringstream responseSS;
-  vtkSmartPointer<vtkXMLDataElement> responseXML = vtkSmartPointer<vtkXMLDataElement>::New();
-  responseXML->SetName("Command");
-  vtkSmartPointer<vtkXMLDataElement> resultXML = vtkSmartPointer<vtkXMLDataElement>::New();
-  resultXML->SetName("Result");
-  resultXML->SetAttribute("ConfigFileName", filename.c_str());
-  resultXML->SetAttribute("Servers", servers.c_str());
-  responseXML->AddNestedElement(resultXML);
-  vtkXMLUtilities::FlattenElement(responseXML, responseSS);
+  std::stringstream ss;
+  for (vtkIdType i = 0; i < dir->GetNumberOfFiles(); ++i)
+  {
+    std::string file = dir->GetFile(i);
+    std::string ext = vtksys::SystemTools::GetFilenameLastExtension(file);
+    if (igsioCommon::IsEqualInsensitive(ext, ".xml"))
+    {
+      ss << file << ";";
+    }
+  }
 
   command->SetSuccessful(true);
-  command->SetResponseMetaDataElement("ConfigFileName", filename);
-  command->SetResponseMetaDataElement("Servers", servers);
+  command->SetResponseMetaDataElement("ConfigFiles", ss.str());
+  command->SetResponseMetaDataElement("Separator", ";");
+  if (SendCommandResponse(command) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Command received but response could not be sent.");
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::GetRunningServers(igtlioCommandPointer command)
+{
+  std::stringstream ss;
+  std::deque<ServerInfo> runningServers = m_ServerInstances;
+  for (std::deque<ServerInfo>::iterator serverIt = runningServers.begin(); serverIt != runningServers.end(); ++serverIt)
+  {
+    ss << serverIt->ID << ";";
+  }
+
+  command->SetSuccessful(true);
+  command->SetResponseMetaDataElement("RunningServers", ss.str());
+  command->SetResponseMetaDataElement("Separator", ";");
+  if (SendCommandResponse(command) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Command received but response could not be sent.");
+  }
+  return;
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::GetConfigFileContents(igtlioCommandPointer command)
+{
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+  std::string serverIdsString;
+  command->GetCommandMetaDataElement("ServerIDs", serverIdsString, encodingType);
+  std::string separator;
+  command->GetCommandMetaDataElement("Separator", separator, encodingType);
+
+  std::string knownHashesString;
+  command->GetCommandMetaDataElement("KnownHashes", knownHashesString, encodingType);
+  std::string streamingString;
+  command->GetCommandMetaDataElement("Streaming", streamingString, encodingType);
+  bool streaming = igsioCommon::IsEqualInsensitive(streamingString, "True");
+
+  std::vector<std::string> serverIds;
+  std::vector<std::string> knownHashes;
+  if (!separator.empty() && !serverIdsString.empty())
+  {
+    serverIds = igsioCommon::SplitStringIntoTokens(serverIdsString, separator.c_str()[0], false);
+    // Hash of the config file content that the client already has, in the same order as the server IDs
+    knownHashes = igsioCommon::SplitStringIntoTokens(knownHashesString, separator.c_str()[0], true);
+  }
+
+  vtkSmartPointer<vtkXMLDataElement> rootElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  rootElement->SetName("Command");
+
+  for (size_t i = 0; i < serverIds.size(); ++i)
+  {
+    std::string serverId = serverIds[i];
+    ServerInfo info = GetServerInfoFromID(serverId);
+    if (!info.GetHandle())
+    {
+      continue;
+    }
+
+    std::string filePath = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(info.Filename));
+    std::string content;
+    if (ReadFileContent(filePath, content) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to read config file: " << filePath);
+      continue;
+    }
+    std::string hash = ComputeContentHash(content);
+
+    vtkSmartPointer<vtkXMLDataElement> configFileElement = vtkSmartPointer<vtkXMLDataElement>::New();
+    configFileElement->SetName(serverId.c_str());
+    configFileElement->SetAttribute("ConfigFileName", info.Filename.c_str());
+    configFileElement->SetAttribute("Hash", hash.c_str());
+
+    if (i < knownHashes.size() && igsioCommon::IsEqualInsensitive(knownHashes[i], hash))
+    {
+      configFileElement->SetAttribute("Unchanged", "True");
+    }
+    else if (streaming)
+    {
+      // Content is sent in ConfigFileContentChunk commands after the response
+      int chunkCount = QueueConfigFileChunks(command->GetClientId(), serverId, info.Filename, hash, content);
+      configFileElement->SetIntAttribute("ChunkCount", chunkCount);
+    }
+    else
+    {
+      vtkSmartPointer<vtkXMLDataElement> contentElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(content.c_str()));
+      if (contentElement)
+      {
+        configFileElement->AddNestedElement(contentElement);
+      }
+    }
+    rootElement->AddNestedElement(configFileElement);
+  }
+
+  std::stringstream ss;
+  vtkXMLUtilities::FlattenElement(rootElement, ss);
+  command->SetResponseContent(ss.str());
+  command->SetSuccessful(true);
   if (SendCommandResponse(command) != PLUS_SUCCESS)
   {
-    LOG_ERROR("Command received but response could not be sent.");
+    LOG_ERROR("Command received but response could not be sent.");
+  }
+  return;
+}
+
+//----------------------------------------------------------------------------
+int PlusServerLauncherMainWindow::QueueConfigFileChunks(int clientId, const std::string& serverId, const std::string& filename, const std::string& hash, const std::string& content)
+{
+  std::string encodedContent = EncodeContent(content);
+  int chunkCount = std::max(1, static_cast<int>((encodedContent.size() + CONFIG_FILE_CHUNK_SIZE - 1) / CONFIG_FILE_CHUNK_SIZE));
+  for (int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+  {
+    igtlioCommandPointer chunkCommand = igtlioCommandPointer::New();
+    chunkCommand->SetClientId(clientId);
+    chunkCommand->BlockingOff();
+    chunkCommand->SetName("ConfigFileContentChunk");
+    chunkCommand->SetCommandContent("<Command/>");
+    chunkCommand->SetCommandMetaDataElement("ServerID", serverId);
+    chunkCommand->SetCommandMetaDataElement("ConfigFileName", filename);
+    chunkCommand->SetCommandMetaDataElement("ConfigFileContentHash", hash);
+    chunkCommand->SetCommandMetaDataElement("ConfigFileContentEncoding", CONFIG_FILE_CONTENT_ENCODING);
+    chunkCommand->SetCommandMetaDataElement("ChunkIndex", igsioCommon::ToString<int>(chunkIndex));
+    chunkCommand->SetCommandMetaDataElement("ChunkCount", igsioCommon::ToString<int>(chunkCount));
+    chunkCommand->SetCommandMetaDataElement("ConfigFileContent", encodedContent.substr(chunkIndex * CONFIG_FILE_CHUNK_SIZE, CONFIG_FILE_CHUNK_SIZE));
+    m_OutgoingConfigFileChunks.push_back(chunkCommand);
+  }
+  return chunkCount;
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::LogSubscribe(igtlioCommandPointer command)
+{
+  m_RemoteControlLogSubscribedClients.insert(command->GetClientId());
+  m_RemoteControlLogSubscribed = true;
+
+  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
+  std::string sinceSequenceString;
+  std::string sinceTimestampString;
+  bool hasSinceSequence = command->GetCommandMetaDataElement("ReplaySinceSequence", sinceSequenceString, encodingType);
+  bool hasSinceTimestamp = command->GetCommandMetaDataElement("ReplaySinceTimestamp", sinceTimestampString, encodingType);
+  if (!hasSinceSequence && !hasSinceTimestamp)
+  {
+    // Only new log messages are requested, no response is expected
+    return;
+  }
+
+  quint64 sinceSequence = 0;
+  qint64 sinceTimestampMs = 0;
+  bool valid = true;
+  if (hasSinceSequence)
+  {
+    sinceSequence = QString::fromStdString(sinceSequenceString).toULongLong(&valid);
+  }
+  if (valid && hasSinceTimestamp)
+  {
+    sinceTimestampMs = QString::fromStdString(sinceTimestampString).toLongLong(&valid);
   }
-
-}
-
-//----------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::GetConfigFiles(igtlioCommandPointer command)
-{
-  vtkSmartPointer<vtkDirectory> dir = vtkSmartPointer<vtkDirectory>::New();
-  if (dir->Open(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationDirectory().c_str()) == 0)
+  if (!valid)
   {
     command->SetSuccessful(false);
-    command->SetErrorMessage("Unable to open device set directory.");
+    command->SetErrorMessage("Invalid ReplaySinceSequence or ReplaySinceTimestamp value.");
     if (SendCommandResponse(command) != PLUS_SUCCESS)
     {
       LOG_ERROR("Command received but response could not be sent.");
@@ -1284,20 +1881,18 @@ void PlusServerLauncherMainWindow::GetConfigFiles(igtlioCommandPointer command)
     return;
   }
 
-  std::stringstream ss;
-  for (vtkIdType i = 0; i < dir->GetNumberOfFiles(); ++i)
+  // Replayed records are sent before the response, so the client knows that the replay is complete when the response arrives
+  int numberOfReplayedRecords = ReplayLogRecords(command->GetClientId(), sinceSequence, sinceTimestampMs);
+
+  quint64 lastSequence = 0;
   {
-    std::string file = dir->GetFile(i);
-    std::string ext = vtksys::SystemTools::GetFilenameLastExtension(file);
-    if (igsioCommon::IsEqualInsensitive(ext, ".xml"))
-    {
-      ss << file << ";";
-    }
+    QMutexLocker lock(&m_LogRecordsMutex);
+    lastSequence = m_NextLogRecordSequence - 1;
   }
 
   command->SetSuccessful(true);
-  command->SetResponseMetaDataElement("ConfigFiles", ss.str());
-  command->SetResponseMetaDataElement("Separator", ";");
+  command->SetResponseMetaDataElement("ReplayedCount", QString::number(numberOfReplayedRecords).toStdString());
+  command->SetResponseMetaDataElement("LastSequence", QString::number(lastSequence).toStdString());
   if (SendCommandResponse(command) != PLUS_SUCCESS)
   {
     LOG_ERROR("Command received but response could not be sent.");
@@ -1305,70 +1900,99 @@ void PlusServerLauncherMainWindow::GetConfigFiles(igtlioCommandPointer command)
 }
 
 //----------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::GetRunningServers(igtlioCommandPointer command)
+PlusServerLauncherMainWindow::LogRecord PlusServerLauncherMainWindow::AddLogRecord(const std::string& logLevel, const std::string& origin, const std::string& message)
 {
-  std::stringstream ss;
-  std::deque<ServerInfo> runningServers = m_ServerInstances;
-  for (std::deque<ServerInfo>::iterator serverIt = runningServers.begin(); serverIt != runningServers.end(); ++serverIt)
-  {
-    ss << serverIt->ID << ";";
-  }
+  QMutexLocker lock(&m_LogRecordsMutex);
 
-  command->SetSuccessful(true);
-  command->SetResponseMetaDataElement("RunningServers", ss.str());
-  command->SetResponseMetaDataElement("Separator", ";");
-  if (SendCommandResponse(command) != PLUS_SUCCESS)
+  LogRecord record;
+  record.Sequence = m_NextLogRecordSequence++;
+  record.TimestampMs = QDateTime::currentMSecsSinceEpoch();
+  record.LogLevel = logLevel;
+  record.Origin = origin;
+  record.Message = message;
+
+  m_LogRecords.push_back(record);
+  if (m_LogRecords.size() > LOG_RECORD_BUFFER_SIZE)
   {
-    LOG_ERROR("Command received but response could not be sent.");
+    m_LogRecords.pop_front();
   }
-  return;
+  return record;
 }
 
 //----------------------------------------------------------------------------
-void PlusServerLauncherMainWindow::GetConfigFileContents(igtlioCommandPointer command)
+int PlusServerLauncherMainWindow::ReplayLogRecords(int clientId, quint64 sinceSequence, qint64 sinceTimestampMs)
 {
-  IANA_ENCODING_TYPE encodingType = IANA_TYPE_US_ASCII;
-  std::string serverIdsString;
-  command->GetCommandMetaDataElement("ServerIDs", serverIdsString, encodingType);
-  std::string separator;
-  command->GetCommandMetaDataElement("Separator", separator, encodingType);
-
-  std::vector<std::string> serverIds;
-  if (!separator.empty() && !serverIdsString.empty())
+  // Copy the requested records so that logging is not blocked while the batches are compressed and sent
+  std::vector<LogRecord> records;
   {
-    serverIds = igsioCommon::SplitStringIntoTokens(serverIdsString, separator.c_str()[0], false);
+    QMutexLocker lock(&m_LogRecordsMutex);
+    for (std::deque<LogRecord>::iterator recordIt = m_LogRecords.begin(); recordIt != m_LogRecords.end(); ++recordIt)
+    {
+      if (recordIt->Sequence > sinceSequence && recordIt->TimestampMs >= sinceTimestampMs)
+      {
+        records.push_back(*recordIt);
+      }
+    }
   }
 
-  vtkSmartPointer<vtkXMLDataElement> rootElement = vtkSmartPointer<vtkXMLDataElement>::New();
-  rootElement->SetName("Command");
-
-  for (std::string serverId : serverIds)
+  for (size_t batchStart = 0; batchStart < records.size(); batchStart += LOG_RECORD_REPLAY_BATCH_SIZE)
   {
-    ServerInfo info = GetServerInfoFromID(serverId);
-    if (!info.Process)
+    size_t batchEnd = std::min(records.size(), batchStart + LOG_RECORD_REPLAY_BATCH_SIZE);
+
+    vtkSmartPointer<vtkXMLDataElement> recordsElement = vtkSmartPointer<vtkXMLDataElement>::New();
+    recordsElement->SetName("LogMessages");
+    for (size_t i = batchStart; i < batchEnd; ++i)
     {
-      continue;
+      vtkSmartPointer<vtkXMLDataElement> messageElement = vtkSmartPointer<vtkXMLDataElement>::New();
+      messageElement->SetName("LogMessage");
+      messageElement->SetAttribute("Sequence", QString::number(records[i].Sequence).toStdString().c_str());
+      messageElement->SetAttribute("Timestamp", QString::number(records[i].TimestampMs).toStdString().c_str());
+      messageElement->SetAttribute("LogLevel", records[i].LogLevel.c_str());
+      messageElement->SetAttribute("Origin", records[i].Origin.c_str());
+      messageElement->SetAttribute("Message", records[i].Message.c_str());
+      recordsElement->AddNestedElement(messageElement);
+    }
+    std::stringstream recordsStream;
+    vtkXMLUtilities::FlattenElement(recordsElement, recordsStream);
+
+    // qCompress output: 4-byte big-endian uncompressed size followed by zlib data
+    std::string recordsString = recordsStream.str();
+    QByteArray compressedRecords = qCompress(QByteArray(recordsString.c_str(), static_cast<int>(recordsString.size()))).toBase64();
+
+    std::string firstSequence = QString::number(records[batchStart].Sequence).toStdString();
+    std::string lastSequence = QString::number(records[batchEnd - 1].Sequence).toStdString();
+    std::string count = QString::number(static_cast<int>(batchEnd - batchStart)).toStdString();
+
+    vtkSmartPointer<vtkXMLDataElement> commandElement = vtkSmartPointer<vtkXMLDataElement>::New();
+    commandElement->SetName("Command");
+    vtkSmartPointer<vtkXMLDataElement> batchElement = vtkSmartPointer<vtkXMLDataElement>::New();
+    batchElement->SetName("LogMessages");
+    batchElement->SetAttribute("FirstSequence", firstSequence.c_str());
+    batchElement->SetAttribute("LastSequence", lastSequence.c_str());
+    batchElement->SetAttribute("Count", count.c_str());
+    batchElement->SetAttribute("Compression", "qCompress");
+    batchElement->SetAttribute("Encoding", "Base64");
+    batchElement->SetCharacterData(compressedRecords.constData(), compressedRecords.size());
+    commandElement->AddNestedElement(batchElement);
+
+    std::stringstream batchCommand;
+    vtkXMLUtilities::FlattenElement(commandElement, batchCommand);
+
+    igtlioCommandPointer logMessagesCommand = igtlioCommandPointer::New();
+    logMessagesCommand->SetClientId(clientId);
+    logMessagesCommand->BlockingOff();
+    logMessagesCommand->SetName("LogMessages");
+    logMessagesCommand->SetCommandContent(batchCommand.str());
+    logMessagesCommand->SetCommandMetaDataElement("FirstSequence", firstSequence);
+    logMessagesCommand->SetCommandMetaDataElement("LastSequence", lastSequence);
+    logMessagesCommand->SetCommandMetaDataElement("Count", count);
+    if (SendCommand(logMessagesCommand) != PLUS_SUCCESS)
+    {
+      return static_cast<int>(batchStart);
     }
-
-    vtkSmartPointer<vtkXMLDataElement> configFileElement = vtkSmartPointer<vtkXMLDataElement>::New();
-    configFileElement->SetName(serverId.c_str());
-
-    std::string filePath = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(vtksys::SystemTools::GetFilenameName(info.Filename));
-    vtkSmartPointer<vtkXMLDataElement> contentElement = vtkXMLUtilities::ReadElementFromFile(filePath.c_str());
-
-    configFileElement->AddNestedElement(contentElement);
-    rootElement->AddNestedElement(configFileElement);
   }
 
-  std::stringstream ss;
-  vtkXMLUtilities::FlattenElement(rootElement, ss);
-  command->SetResponseContent(ss.str());
-  command->SetSuccessful(true);
-  if (SendCommandResponse(command) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Command received but response could not be sent.");
-  }
-  return;
+  return static_cast<int>(records.size());
 }
 
 //----------------------------------------------------------------------------
@@ -1386,6 +2010,12 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
   bool hasFilename = command->GetCommandMetaDataElement("ConfigFileName", configFile, encodingType);
   std::string configFileContent;
   bool hasFileContent = command->GetCommandMetaDataElement("ConfigFileContent", configFileContent, encodingType);
+  std::string contentHash;
+  bool hasContentHash = command->GetCommandMetaDataElement("ConfigFileContentHash", contentHash, encodingType);
+  std::string contentEncoding;
+  command->GetCommandMetaDataElement("ConfigFileContentEncoding", contentEncoding, encodingType);
+  std::string transferId;
+  command->GetCommandMetaDataElement("TransferID", transferId, encodingType);
 
   // Check write permissions
   if (!ui.checkBox_writePermission->isChecked())
@@ -1402,7 +2032,7 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
     return;
   }
 
-  if (!hasFilename || !hasFileContent)
+  if (!hasFilename || (!hasFileContent && !hasContentHash))
   {
     command->SetSuccessful(false);
     command->SetErrorMessage("Required metadata \'ConfigFileName\' and/or \'ConfigFileContent\' missing.");
@@ -1415,6 +2045,176 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
 
   // Strip any path sent over
   configFile = vtksys::SystemTools::GetFilenameName(configFile);
+
+  int chunkIndex = 0;
+  int chunkCount = 1;
+  if (!transferId.empty())
+  {
+    std::string chunkIndexString;
+    std::string chunkCountString;
+    command->GetCommandMetaDataElement("ChunkIndex", chunkIndexString, encodingType);
+    command->GetCommandMetaDataElement("ChunkCount", chunkCountString, encodingType);
+    if (igsioCommon::StringToInt<int>(chunkIndexString.c_str(), chunkIndex) != PLUS_SUCCESS
+        || igsioCommon::StringToInt<int>(chunkCountString.c_str(), chunkCount) != PLUS_SUCCESS
+        || chunkCount < 1 || chunkCount > MAX_CONFIG_FILE_CHUNK_COUNT || chunkIndex < 0 || chunkIndex >= chunkCount)
+    {
+      m_ConfigFileTransfers.erase(std::make_pair(command->GetClientId(), transferId));
+      command->SetSuccessful(false);
+      command->SetErrorMessage("Invalid \'ChunkIndex\' and/or \'ChunkCount\'.");
+      if (SendCommandResponse(command) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Command received but response could not be sent.");
+      }
+      return;
+    }
+  }
+
+  // Skip the transfer if the file already has the same content
+  std::string existingContent;
+  if (hasContentHash && chunkIndex == 0
+      && ReadFileContent(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile), existingContent) == PLUS_SUCCESS
+      && igsioCommon::IsEqualInsensitive(ComputeContentHash(existingContent), contentHash))
+  {
+    LOG_INFO("Config file: " << configFile << " is unchanged.");
+    command->SetSuccessful(true);
+    command->SetResponseMetaDataElement("ConfigFileName", configFile);
+    command->SetResponseMetaDataElement("Unchanged", "True");
+    if (SendCommandResponse(command) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+    return;
+  }
+
+  if (!hasFileContent)
+  {
+    // Only the hash was sent, to check if the content has to be transferred
+    command->SetSuccessful(true);
+    command->SetResponseMetaDataElement("ConfigFileName", configFile);
+    command->SetResponseMetaDataElement("Unchanged", "False");
+    if (SendCommandResponse(command) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+    return;
+  }
+
+  if (!transferId.empty())
+  {
+    RemoveStaleConfigFileTransfers();
+
+    std::pair<int, std::string> transferKey = std::make_pair(command->GetClientId(), transferId);
+    std::map<std::pair<int, std::string>, ConfigFileTransfer>::iterator transferIt = m_ConfigFileTransfers.find(transferKey);
+    if (chunkIndex == 0 && (transferIt == m_ConfigFileTransfers.end() || static_cast<int>(transferIt->second.Chunks.size()) != chunkCount))
+    {
+      int numberOfClientTransfers = 0;
+      for (std::map<std::pair<int, std::string>, ConfigFileTransfer>::iterator clientTransferIt = m_ConfigFileTransfers.begin(); clientTransferIt != m_ConfigFileTransfers.end(); ++clientTransferIt)
+      {
+        if (clientTransferIt->first.first == command->GetClientId() && clientTransferIt->first != transferKey)
+        {
+          ++numberOfClientTransfers;
+        }
+      }
+      if (numberOfClientTransfers >= MAX_CONFIG_FILE_TRANSFERS_PER_CLIENT)
+      {
+        command->SetSuccessful(false);
+        command->SetErrorMessage("Too many config file transfers in progress.");
+        if (SendCommandResponse(command) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Command received but response could not be sent.");
+        }
+        return;
+      }
+
+      // A resent first chunk must not discard the chunks that already arrived
+      ConfigFileTransfer transfer;
+      transfer.Chunks.resize(chunkCount);
+      transfer.ChunkReceived.resize(chunkCount, false);
+      transfer.ReceivedSize = 0;
+      transfer.LastChunkTimeMs = QDateTime::currentMSecsSinceEpoch();
+      m_ConfigFileTransfers[transferKey] = transfer;
+      transferIt = m_ConfigFileTransfers.find(transferKey);
+    }
+
+    if (transferIt == m_ConfigFileTransfers.end() || static_cast<int>(transferIt->second.Chunks.size()) != chunkCount)
+    {
+      command->SetSuccessful(false);
+      command->SetErrorMessage("Unknown transfer, the first chunk must have ChunkIndex 0.");
+      if (SendCommandResponse(command) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Command received but response could not be sent.");
+      }
+      return;
+    }
+
+    ConfigFileTransfer& transfer = transferIt->second;
+    transfer.ReceivedSize = transfer.ReceivedSize - transfer.Chunks[chunkIndex].size() + configFileContent.size();
+    if (transfer.ReceivedSize > MAX_CONFIG_FILE_TRANSFER_SIZE)
+    {
+      LOG_ERROR("Config file transfer of " << configFile << " from client " << command->GetClientId() << " is dropped, the content exceeds " << MAX_CONFIG_FILE_TRANSFER_SIZE << " bytes");
+      m_ConfigFileTransfers.erase(transferIt);
+      command->SetSuccessful(false);
+      command->SetErrorMessage("Config file content is too large.");
+      if (SendCommandResponse(command) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Command received but response could not be sent.");
+      }
+      return;
+    }
+    transfer.Chunks[chunkIndex] = configFileContent;
+    transfer.ChunkReceived[chunkIndex] = true;
+    transfer.LastChunkTimeMs = QDateTime::currentMSecsSinceEpoch();
+    if (std::find(transfer.ChunkReceived.begin(), transfer.ChunkReceived.end(), false) != transfer.ChunkReceived.end())
+    {
+      command->SetSuccessful(true);
+      command->SetResponseMetaDataElement("ConfigFileName", configFile);
+      command->SetResponseMetaDataElement("ChunkIndex", igsioCommon::ToString<int>(chunkIndex));
+      if (SendCommandResponse(command) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Command received but response could not be sent.");
+      }
+      return;
+    }
+
+    configFileContent.clear();
+    for (std::vector<std::string>::iterator chunkIt = transfer.Chunks.begin(); chunkIt != transfer.Chunks.end(); ++chunkIt)
+    {
+      configFileContent += *chunkIt;
+    }
+    m_ConfigFileTransfers.erase(transferIt);
+  }
+
+  if (!contentEncoding.empty())
+  {
+    if (!igsioCommon::IsEqualInsensitive(contentEncoding, CONFIG_FILE_CONTENT_ENCODING) || DecodeContent(configFileContent, configFileContent) != PLUS_SUCCESS)
+    {
+      command->SetSuccessful(false);
+      command->SetErrorMessage(std::string("Config file content could not be decoded. Supported encoding: ") + CONFIG_FILE_CONTENT_ENCODING);
+      if (SendCommandResponse(command) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Command received but response could not be sent.");
+      }
+      return;
+    }
+  }
+
+  if (hasContentHash && !igsioCommon::IsEqualInsensitive(ComputeContentHash(configFileContent), contentHash))
+  {
+    command->SetSuccessful(false);
+    command->SetErrorMessage("Config file content does not match \'ConfigFileContentHash\'.");
+    if (SendCommandResponse(command) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Command received but response could not be sent.");
+    }
+    return;
+  }
+
+  SaveConfigFile(command, configFile, configFileContent);
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::SaveConfigFile(igtlioCommandPointer command, std::string configFile, const std::string& configFileContent)
+{
   // If filename already exists, check overwrite permissions
   if (vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile)))
   {
@@ -1438,7 +2238,7 @@ void PlusServerLauncherMainWindow::AddOrUpdateConfigFile(igtlioCommandPointer co
     }
   }
 
-  std::fstream file(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile), std::fstream::out);
+  std::fstream file(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile), std::fstream::out | std::fstream::binary);
   if (!file.is_open())
   {
     if (vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationPath(configFile) + ".bak"))
@@ -1486,10 +2286,47 @@ void PlusServerLauncherMainWindow::OnWritePermissionClicked()
 //----------------------------------------------------------------------------
 void PlusServerLauncherMainWindow::OnTimerTimeout()
 {
+  if (!m_TimeToReadyReported)
+  {
+    // The first tick is processed once the event loop is running, from now on remote control commands are handled
+    m_TimeToReadyReported = true;
+    ReportTimeToReady();
+  }
+
   if (m_RemoteControlServerConnector != nullptr)
   {
     m_RemoteControlServerConnector->PeriodicProcess();
   }
+
+  for (int i = 0; i < CONFIG_FILE_CHUNKS_PER_TICK && !m_OutgoingConfigFileChunks.empty(); ++i)
+  {
+    igtlioCommandPointer chunkCommand = m_OutgoingConfigFileChunks.front();
+    m_OutgoingConfigFileChunks.pop_front();
+    if (SendCommand(chunkCommand) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Config file content chunk could not be sent to client " << chunkCommand->GetClientId());
+    }
+  }
+
+  RemoveStaleConfigFileTransfers();
+}
+
+//----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::RemoveStaleConfigFileTransfers()
+{
+  const qint64 currentTimeMs = QDateTime::currentMSecsSinceEpoch();
+  for (std::map<std::pair<int, std::string>, ConfigFileTransfer>::iterator transferIt = m_ConfigFileTransfers.begin(); transferIt != m_ConfigFileTransfers.end();)
+  {
+    if (currentTimeMs - transferIt->second.LastChunkTimeMs > CONFIG_FILE_TRANSFER_TIMEOUT_MS)
+    {
+      LOG_WARNING("Config file transfer " << transferIt->first.second << " from client " << transferIt->first.first << " timed out, received chunks are discarded");
+      transferIt = m_ConfigFileTransfers.erase(transferIt);
+    }
+    else
+    {
+      ++transferIt;
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -1551,20 +2388,15 @@ void PlusServerLauncherMainWindow::OnLogEvent(vtkObject* caller, unsigned long e
 {
   PlusServerLauncherMainWindow* self = reinterpret_cast<PlusServerLauncherMainWindow*>(clientData);
 
-  // Return if we are not connected. No client to send log messages to
-  if (!self->m_RemoteControlServerConnector || !self->m_RemoteControlServerConnector->IsConnected())
-  {
-    return;
-  }
-
-  // Return if the client has not subscribed to log messages
-  if (self->m_RemoteControlLogSubscribedClients.empty())
+  // We don't want to end up in an infinite loop of logging if something goes wrong while a message is handled.
+  // In-process servers log from their own threads, so the observer stays registered and messages logged
+  // while a message of the same thread is handled are skipped instead.
+  static thread_local bool handlingLogEvent = false;
+  if (handlingLogEvent)
   {
     return;
   }
-
-  // We don't want to end up in an infinite loop of logging if something goes wrong, so remove the log observer
-  vtkPlusLogger::Instance()->RemoveObserver(self->m_RemoteControlLogMessageCallbackCommand);
+  handlingLogEvent = true;
 
   QString logMessage = QString();
   if (event == vtkPlusLogger::MessageLogged)
@@ -1603,38 +2435,72 @@ void PlusServerLauncherMainWindow::OnLogEvent(vtkObject* caller, unsigned long e
       {
         message << "|" << tokens[i].toStdString();
       }
-      std::string logMessageString = message.str();
-
-      vtkSmartPointer<vtkXMLDataElement> commandElement = vtkSmartPointer<vtkXMLDataElement>::New();
-      commandElement->SetName("Command");
-      vtkSmartPointer<vtkXMLDataElement> messageElement = vtkSmartPointer<vtkXMLDataElement>::New();
-      messageElement->SetName("LogMessage");
-      messageElement->SetAttribute("Message", logMessageString.c_str());
-      messageElement->SetAttribute("LogLevel", logLevel.c_str());
-      messageElement->SetAttribute("Origin", messageOrigin.c_str());
-      commandElement->AddNestedElement(messageElement);
 
-      std::stringstream messageCommand;
-      vtkXMLUtilities::FlattenElement(commandElement, messageCommand);
+      // Records are kept even if no client is subscribed, so that they can be replayed on subscription
+      LogRecord record = self->AddLogRecord(logLevel, messageOrigin, message.str());
 
-      for (std::set<int>::iterator subscribedClientsIt = self->m_RemoteControlLogSubscribedClients.begin(); subscribedClientsIt != self->m_RemoteControlLogSubscribedClients.end(); ++subscribedClientsIt)
+      // The remote control connector is only used from the main thread, so the message is sent from there
+      if (self->m_RemoteControlLogSubscribed)
       {
-        igtlioCommandPointer logMessageCommand = igtlioCommandPointer::New();
-        logMessageCommand->SetClientId(*subscribedClientsIt);
-        logMessageCommand->BlockingOff();
-        logMessageCommand->SetName("LogMessage");
-        logMessageCommand->SetCommandContent(messageCommand.str());
-        logMessageCommand->SetCommandMetaDataElement("Message", logMessageString);
-        logMessageCommand->SetCommandMetaDataElement("LogLevel", logLevel);
-        logMessageCommand->SetCommandMetaDataElement("Origin", messageOrigin);
-        self->SendCommand(logMessageCommand);
+        QMetaObject::invokeMethod(self, "SendLogMessage", QThread::currentThread() == self->thread() ? Qt::DirectConnection : Qt::QueuedConnection,
+                                  Q_ARG(quint64, record.Sequence), Q_ARG(qint64, record.TimestampMs), Q_ARG(QString, QString::fromStdString(record.LogLevel)),
+                                  Q_ARG(QString, QString::fromStdString(record.Origin)), Q_ARG(QString, QString::fromStdString(record.Message)));
       }
     }
   }
 
-  // Re-apply the log observers
-  vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::MessageLogged, self->m_RemoteControlLogMessageCallbackCommand);
-  vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::WideMessageLogged, self->m_RemoteControlLogMessageCallbackCommand);
+  handlingLogEvent = false;
+}
+
+//---------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::SendLogMessage(quint64 sequence, qint64 timestampMs, const QString& logLevel, const QString& origin, const QString& message)
+{
+  // Return if we are not connected. No client to send log messages to
+  if (!m_RemoteControlServerConnector || !m_RemoteControlServerConnector->IsConnected())
+  {
+    return;
+  }
+
+  // Return if the client has not subscribed to log messages
+  if (m_RemoteControlLogSubscribedClients.empty())
+  {
+    return;
+  }
+
+  std::string logMessageString = message.toStdString();
+  std::string logLevelString = logLevel.toStdString();
+  std::string originString = origin.toStdString();
+  std::string sequenceString = QString::number(sequence).toStdString();
+  std::string timestampString = QString::number(timestampMs).toStdString();
+
+  vtkSmartPointer<vtkXMLDataElement> commandElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  commandElement->SetName("Command");
+  vtkSmartPointer<vtkXMLDataElement> messageElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  messageElement->SetName("LogMessage");
+  messageElement->SetAttribute("Message", logMessageString.c_str());
+  messageElement->SetAttribute("LogLevel", logLevelString.c_str());
+  messageElement->SetAttribute("Origin", originString.c_str());
+  messageElement->SetAttribute("Sequence", sequenceString.c_str());
+  messageElement->SetAttribute("Timestamp", timestampString.c_str());
+  commandElement->AddNestedElement(messageElement);
+
+  std::stringstream messageCommand;
+  vtkXMLUtilities::FlattenElement(commandElement, messageCommand);
+
+  for (std::set<int>::iterator subscribedClientsIt = m_RemoteControlLogSubscribedClients.begin(); subscribedClientsIt != m_RemoteControlLogSubscribedClients.end(); ++subscribedClientsIt)
+  {
+    igtlioCommandPointer logMessageCommand = igtlioCommandPointer::New();
+    logMessageCommand->SetClientId(*subscribedClientsIt);
+    logMessageCommand->BlockingOff();
+    logMessageCommand->SetName("LogMessage");
+    logMessageCommand->SetCommandContent(messageCommand.str());
+    logMessageCommand->SetCommandMetaDataElement("Message", logMessageString);
+    logMessageCommand->SetCommandMetaDataElement("LogLevel", logLevelString);
+    logMessageCommand->SetCommandMetaDataElement("Origin", originString);
+    logMessageCommand->SetCommandMetaDataElement("Sequence", sequenceString);
+    logMessageCommand->SetCommandMetaDataElement("Timestamp", timestampString);
+    SendCommand(logMessageCommand);
+  }
 }
 
 //---------------------------------------------------------------------------
@@ -1700,6 +2566,93 @@ void PlusServerLauncherMainWindow::closeEvent(QCloseEvent* event)
   }
 }
 
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::StartRemoteControlServer()
+{
+  if (m_RemoteControlServerPort == PlusServerLauncherMainWindow::RemoteControlServerPortDisable)
+  {
+    return;
+  }
+
+  LOG_INFO("Start remote control server at port: " << m_RemoteControlServerPort);
+  m_RemoteControlServerLogic = igtlioLogicPointer::New();
+  m_RemoteControlServerLogic->AddObserver(igtlioCommand::CommandReceivedEvent, m_RemoteControlServerCallbackCommand);
+  m_RemoteControlServerLogic->AddObserver(igtlioCommand::CommandResponseEvent, m_RemoteControlServerCallbackCommand);
+  m_RemoteControlServerConnector = m_RemoteControlServerLogic->CreateConnector();
+  m_RemoteControlServerConnector->AddObserver(igtlioConnector::ConnectedEvent, m_RemoteControlServerCallbackCommand);
+  m_RemoteControlServerConnector->AddObserver(igtlioConnector::ClientConnectedEvent, m_RemoteControlServerCallbackCommand);
+  m_RemoteControlServerConnector->AddObserver(igtlioConnector::ClientDisconnectedEvent, m_RemoteControlServerCallbackCommand);
+  m_RemoteControlServerConnector->SetTypeServer(m_RemoteControlServerPort);
+  m_RemoteControlServerConnector->Start();
+
+  if (m_NetworkAddresses.isEmpty())
+  {
+    ui.label_networkDetails->setText("port " + QString::number(m_RemoteControlServerPort));
+  }
+  else
+  {
+    ui.label_networkDetails->setText(m_NetworkAddresses + ", port " + QString::number(m_RemoteControlServerPort));
+  }
+
+  vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::MessageLogged, m_RemoteControlLogMessageCallbackCommand);
+  vtkPlusLogger::Instance()->AddObserver(vtkPlusLogger::WideMessageLogged, m_RemoteControlLogMessageCallbackCommand);
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::OnDiagnosticsCollected(const QString& supportedDevices, const QString& hostName, const QString& hostDomain, const QString& ipAddresses)
+{
+  LOG_INFO(supportedDevices.toStdString());
+
+  LOG_INFO("Server host name: " << hostName.toStdString());
+  if (!hostDomain.isEmpty())
+  {
+    LOG_INFO("Server host domain: " << hostDomain.toStdString());
+  }
+  LOG_INFO("Server IP addresses: " << ipAddresses.toStdString());
+
+  m_NetworkAddresses = ipAddresses;
+  if (m_RemoteControlServerConnector != nullptr)
+  {
+    ui.label_networkDetails->setText(ipAddresses + ", port " + QString::number(m_RemoteControlServerPort));
+  }
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::AutoConnect()
+{
+  std::string configFileName = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationFileName();
+  if (configFileName.empty())
+  {
+    LOG_ERROR("Auto-connect failed: device set configuration file is not specified");
+    return;
+  }
+
+  ConnectToDevicesByConfigFile(configFileName);
+  if (m_DeviceSetSelectorWidget->GetConnectionSuccessful())
+  {
+    showMinimized();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void PlusServerLauncherMainWindow::ReportTimeToReady()
+{
+  int timeToReadyMs = static_cast<int>(1000.0 * (vtkIGSIOAccurateTimer::GetSystemTime() - m_LaunchTimeSec) + 0.5);
+  if (m_RemoteControlServerConnector != nullptr)
+  {
+    LOG_INFO("Ready to accept remote control commands at port " << m_RemoteControlServerPort << ", " << timeToReadyMs << " ms after launch");
+  }
+  else
+  {
+    LOG_INFO("Ready " << timeToReadyMs << " ms after launch");
+  }
+
+  if (m_FastStart && timeToReadyMs > FAST_START_TARGET_TIME_TO_READY_MS)
+  {
+    LOG_WARNING("Fast start took " << timeToReadyMs << " ms, longer than the target of " << FAST_START_TARGET_TIME_TO_READY_MS << " ms");
+  }
+}
+
 //-----------------------------------------------------------------------------
 bool PlusServerLauncherMainWindow::GetHideOnStartup() const
 {
@@ -12,8 +12,13 @@
 
 // Qt includes
 #include <QMainWindow>
+#include <QMutex>
 #include <QProcess>
 #include <QSystemTrayIcon>
+#include <QThread>
+
+// STL includes
+#include <atomic>
 
 // OpenIGTLinkIO includes
 #include <igtlioCommand.h>
@@ -22,6 +27,8 @@
 
 class QComboBox;
 class QPlusDeviceSetSelectorWidget;
+class QPlusInProcessServer;
+class QPlusLauncherDiagnostics;
 class QProcess;
 class QTimer;
 class QWidget;
@@ -54,8 +61,11 @@ public:
     \param aParent parent
     \param aFlags widget flag
     \param remoteControlServerPort port number where launcher listens for remote control OpenIGTLink commands. 0 means use default port, -1 means do not start a remote control server.
+    \param fastStart Start the remote control server first and collect the startup diagnostics (supported devices, network configuration) on a background thread
+    \param launchTimeSec System time of the process start, used for reporting the time until the launcher is ready. Negative means the time of the construction.
   */
-  PlusServerLauncherMainWindow(QWidget* parent = 0, Qt::WindowFlags flags = 0, bool autoConnect = false, int remoteControlServerPort = RemoteControlServerPortUseDefault);
+  PlusServerLauncherMainWindow(QWidget* parent = 0, Qt::WindowFlags flags = 0, bool autoConnect = false, int remoteControlServerPort = RemoteControlServerPortUseDefault,
+                               bool fastStart = false, double launchTimeSec = -1.0);
   ~PlusServerLauncherMainWindow();
 
   bool GetHideOnStartup() const;
@@ -78,6 +88,11 @@ protected slots:
 
   void ServerExecutableFinished(int returnCode, QProcess::ExitStatus status);
 
+  /*! Status callbacks of the servers hosted in the launcher process */
+  void InProcessServerStarted();
+  void InProcessServerStartFailed(const QString& errorMessage);
+  void InProcessServerStopped();
+
   void LogLevelChanged();
 
   void LatestLogClicked();
@@ -89,18 +104,37 @@ protected slots:
   void OnCommandReceivedEvent(igtlioCommandPointer command);
   static void OnLogEvent(vtkObject* caller, unsigned long eventId, void* clientData, void* callData);
 
+  /*! Send a log message to the subscribed clients, called on the main thread for messages logged on any thread */
+  void SendLogMessage(quint64 sequence, qint64 timestampMs, const QString& logLevel, const QString& origin, const QString& message);
+
   void OnWritePermissionClicked();
 
   void OnTimerTimeout();
 
+  /*! Drive the start and stop state of the server processes: report started servers, repeat stop requests and kill servers that do not stop */
+  void OnServerLifecycleTimerTimeout();
+
   void StopRemoteServerButtonClicked();
 
   void SystemTrayIconActivated(QSystemTrayIcon::ActivationReason reason);
 
   void SystemTrayMessageClicked();
 
+  /*! Log the startup diagnostics and show the addresses of the remote control server */
+  void OnDiagnosticsCollected(const QString& supportedDevices, const QString& hostName, const QString& hostDomain, const QString& ipAddresses);
+
+  /*! Launch the server of the device set configuration file specified on the command line */
+  void AutoConnect();
+
 protected:
 
+  enum ServerState
+  {
+    ServerState_Starting,
+    ServerState_Running,
+    ServerState_Stopping
+  };
+
   struct ServerInfo
   {
     ServerInfo()
@@ -108,16 +142,52 @@ protected:
       this->ID = "";
       this->Filename = "";
       this->Process = nullptr;
+      this->InProcessServer = nullptr;
+      this->State = ServerState_Starting;
+      this->StateChangeTimeMs = 0;
+      this->LastStopRequestTimeMs = 0;
+      this->ForcedShutdown = false;
     }
     ServerInfo(std::string filename, QProcess* process)
     {
       this->ID = vtksys::SystemTools::GetFilenameWithoutExtension(filename);
       this->Filename = filename;
       this->Process = process;
+      this->InProcessServer = nullptr;
+      this->State = ServerState_Starting;
+      this->StateChangeTimeMs = 0;
+      this->LastStopRequestTimeMs = 0;
+      this->ForcedShutdown = false;
+    }
+    ServerInfo(std::string filename, QPlusInProcessServer* inProcessServer)
+    {
+      this->ID = vtksys::SystemTools::GetFilenameWithoutExtension(filename);
+      this->Filename = filename;
+      this->Process = nullptr;
+      this->InProcessServer = inProcessServer;
+      this->State = ServerState_Starting;
+      this->StateChangeTimeMs = 0;
+      this->LastStopRequestTimeMs = 0;
+      this->ForcedShutdown = false;
+    }
+    /*! The object identifying the server: the PlusServer process or the in-process server, nullptr if there is no such server */
+    QObject* GetHandle() const
+    {
+      return this->Process != nullptr ? static_cast<QObject*>(this->Process) : static_cast<QObject*>(this->InProcessServer);
     }
     std::string ID;
     std::string Filename;
-    QProcess*   Process;
+    /*! Exactly one of these is set, depending on how the server is hosted */
+    QProcess*             Process;
+    QPlusInProcessServer* InProcessServer;
+    /*! Lifecycle state of the process, changed by the QProcess signals and the lifecycle timer */
+    ServerState State;
+    qint64      StateChangeTimeMs;
+    qint64      LastStopRequestTimeMs;
+    bool        ForcedShutdown;
+    /*! Remote control commands that are answered when the pending start or stop is completed */
+    igtlioCommandPointer              PendingStartCommand;
+    std::vector<igtlioCommandPointer> PendingStopCommands;
   };
 
 protected:
@@ -131,15 +201,38 @@ protected:
   /*! Receive standard output or error and send it to the log */
   void SendServerOutputToLogger(const QByteArray& strData);
 
-  /*! Start server process, connect outputs to logger. Returns with true on success. */
-  bool StartServer(const QString& configFilePath, int logLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+  /*!
+    Launch server process, connect outputs to logger. Returns immediately, the server is reported as started (and the optional
+    remote command is answered) by the lifecycle timer once the process has kept running for the startup grace period.
+    Returns with false if the process could not be launched at all.
+  */
+  bool StartServer(const QString& configFilePath, int logLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED, igtlioCommandPointer command = nullptr);
+  /*! Start the servers of the config file on a thread of the launcher process instead of a PlusServer process */
+  bool StartInProcessServer(const QString& configFilePath, igtlioCommandPointer command = nullptr);
   /*! Start server process from GUI */
   bool LocalStartServer();
 
-  /*! Stop server process, disconnect outputs. Returns with true on success (shutdown on request was successful, without forcing). */
-  bool StopServer(const QString& configFilePath);
+  /*!
+    Request the server process to stop. Returns immediately, the optional remote command is answered when the process has exited.
+    Servers are stopped independently, so several servers can be shut down in parallel.
+  */
+  bool StopServer(const QString& configFilePath, igtlioCommandPointer command = nullptr);
   bool LocalStopServer();
 
+  /*! Stop all servers and wait until they exit, used when the launcher is closed */
+  void StopAllServersBlocking();
+
+  /*! Server state transitions */
+  void OnServerStartCompleted(QObject* server);
+  void OnServerStartFailed(QObject* server);
+  void OnServerStopCompleted(QObject* server);
+
+  /*! Disconnect the server process or in-process server, remove it from the list of running servers and delete it */
+  void ReleaseServerProcess(QObject* server);
+
+  /*! Respond to a remote StopServer command */
+  void SendServerStopResponse(igtlioCommandPointer command, const std::string& filename, const std::string& id);
+
   /*! Parse a given log line for salient information from the PlusServer */
   void ParseContent(const std::string& message);
 
@@ -156,6 +249,51 @@ protected:
   void RemoteStopServer(igtlioCommandPointer command);
   void GetRunningServers(igtlioCommandPointer command);
   void GetConfigFileContents(igtlioCommandPointer command);
+  void LogSubscribe(igtlioCommandPointer command);
+
+  /*! Write the received config file content to the device set configuration directory and respond to the AddConfigFile command */
+  void SaveConfigFile(igtlioCommandPointer command, std::string configFile, const std::string& configFileContent);
+
+  /*!
+    Split the compressed content of a config file into ConfigFileContentChunk commands and queue them for sending.
+    The chunks are sent a few at a time from the remote control timer, so that other commands are processed in between.
+    Returns the number of chunks.
+  */
+  int QueueConfigFileChunks(int clientId, const std::string& serverId, const std::string& filename, const std::string& hash, const std::string& content);
+
+  /*! Drop the incoming config file transfers that have not received a chunk within the transfer timeout */
+  void RemoveStaleConfigFileTransfers();
+
+  /*! Config file content that is received in multiple AddConfigFile commands */
+  struct ConfigFileTransfer
+  {
+    std::vector<std::string>  Chunks;
+    /*! Set for each chunk index that has arrived, so that a resent chunk is not counted twice */
+    std::vector<bool>         ChunkReceived;
+    /*! Total size of the chunks received so far */
+    size_t                    ReceivedSize;
+    /*! Time when the last chunk arrived, in milliseconds since epoch */
+    qint64                    LastChunkTimeMs;
+  };
+
+  /*! Structured log message of the launcher or of a server, kept in memory for replaying to clients that subscribe late */
+  struct LogRecord
+  {
+    quint64     Sequence;
+    qint64      TimestampMs;
+    std::string LogLevel;
+    std::string Origin;
+    std::string Message;
+  };
+
+  /*! Store a log record in the ring buffer, the oldest record is dropped when the buffer is full. Returns the stored record. */
+  LogRecord AddLogRecord(const std::string& logLevel, const std::string& origin, const std::string& message);
+
+  /*!
+    Send the buffered log records that are newer than the specified sequence number or timestamp to a client
+    in compressed LogMessages batches. Returns the number of records that were sent.
+  */
+  int ReplayLogRecords(int clientId, quint64 sinceSequence, qint64 sinceTimestampMs);
 
   void LocalLog(vtkPlusLogger::LogLevelType level, const std::string& message);
 
@@ -167,16 +305,24 @@ protected:
   /*! Get the process for the specified config file */
   ServerInfo GetServerInfoFromID(std::string id);
   ServerInfo GetServerInfoFromFilename(std::string filename);
-  ServerInfo GetServerInfoFromProcess(QProcess* process);
+  ServerInfo GetServerInfoFromProcess(QObject* server);
+  /*! Get the stored server info for the process or in-process server to update its state, nullptr if not found */
+  ServerInfo* FindServerInfo(QObject* server);
 
-  /*! Remove the process from the list of running servers */
-  PlusStatus RemoveServerProcess(QProcess* process);
+  /*! Remove the process or in-process server from the list of running servers */
+  PlusStatus RemoveServerProcess(QObject* server);
 
   /*! Update the contents of the remote control table to reflect the current status */
   void UpdateRemoteServerTable();
 
   void ShowNotification(QString message, QString title="PlusServerLauncher");
 
+  /*! Start listening for remote control commands at m_RemoteControlServerPort */
+  void StartRemoteControlServer();
+
+  /*! Log the time elapsed since the process start, called when the launcher first processes events */
+  void ReportTimeToReady();
+
 protected:
   /*! Device set selector widget */
   QPlusDeviceSetSelectorWidget*         m_DeviceSetSelectorWidget;
@@ -205,7 +351,38 @@ protected:
 
   QTimer*                               m_RemoteControlServerConnectorProcessTimer;
 
+  /*! Start the remote control server before anything else that is not needed for accepting commands */
+  bool                                  m_FastStart;
+  /*! System time of the process start */
+  double                                m_LaunchTimeSec;
+  /*! Flag indicating whether the time to ready has been reported */
+  bool                                  m_TimeToReadyReported;
+  /*! Startup diagnostics collector and the thread it runs on in fast-start mode */
+  QPlusLauncherDiagnostics*             m_Diagnostics;
+  QThread                               m_DiagnosticsThread;
+  /*! IPv4 addresses of the host, empty until the diagnostics are collected */
+  QString                               m_NetworkAddresses;
+
+  /*! Timer that drives the server start/stop state machine, only active while a server is starting or stopping */
+  QTimer*                               m_ServerLifecycleTimer;
+
+  /*! Config file to launch from the GUI as soon as the previous server of the same config file has stopped */
+  std::string                           m_PendingLocalConfigFile;
+
   std::set<int>                         m_RemoteControlLogSubscribedClients;
+  /*! True if m_RemoteControlLogSubscribedClients is not empty, read by the log observer on any thread */
+  std::atomic<bool>                     m_RemoteControlLogSubscribed;
+
+  /*! Ring buffer of the most recent log records, guarded by m_LogRecordsMutex as in-process servers log from their own threads */
+  std::deque<LogRecord>                 m_LogRecords;
+  quint64                               m_NextLogRecordSequence;
+  QMutex                                m_LogRecordsMutex;
+
+  /*! Chunked AddConfigFile transfers in progress, by client ID and TransferID */
+  std::map<std::pair<int, std::string>, ConfigFileTransfer> m_ConfigFileTransfers;
+
+  /*! ConfigFileContentChunk commands that are waiting to be sent */
+  std::deque<igtlioCommandPointer>      m_OutgoingConfigFileChunks;
 
   /*! Incomplete string received from PlusServer */
   std::string                           m_LogIncompleteLine;
@@ -0,0 +1,209 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "QPlusInProcessServer.h"
+
+// PlusLib includes
+#include <vtkIGSIOTransformRepository.h>
+#include <vtkPlusDataCollector.h>
+#include <vtkPlusOpenIGTLinkServer.h>
+
+// VTK includes
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+// Qt includes
+#include <QTimer>
+
+namespace
+{
+  // Same interval as the command queue polling of the PlusServer executable
+  const int COMMAND_PROCESSING_INTERVAL_MS = 10;
+}
+
+//-----------------------------------------------------------------------------
+QPlusInProcessServerWorker::QPlusInProcessServerWorker(const std::string& configFilePath)
+  : m_ConfigFilePath(configFilePath)
+  , m_CommandProcessingTimer(nullptr)
+{
+}
+
+//-----------------------------------------------------------------------------
+QPlusInProcessServerWorker::~QPlusInProcessServerWorker()
+{
+  Shutdown();
+}
+
+//-----------------------------------------------------------------------------
+void QPlusInProcessServerWorker::Start()
+{
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromFile(m_ConfigFilePath.c_str()));
+  if (configRootElement == nullptr)
+  {
+    LOG_ERROR("Unable to read configuration from file " << m_ConfigFilePath);
+    emit StartFailed(QString("Unable to read configuration from file %1").arg(QString::fromStdString(m_ConfigFilePath)));
+    return;
+  }
+
+  // The configuration is only passed to the objects of this server and is not published through the process-wide
+  // vtkPlusConfig singleton (which is what the PlusServer executable does), so servers running on other threads
+  // and the launcher itself are not affected
+  m_DataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+  if (m_DataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Datacollector failed to read configuration");
+    Shutdown();
+    emit StartFailed("Datacollector failed to read configuration");
+    return;
+  }
+
+  m_TransformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+  if (m_TransformRepository->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Transform repository failed to read configuration");
+    Shutdown();
+    emit StartFailed("Transform repository failed to read configuration");
+    return;
+  }
+
+  LOG_INFO("Connecting to devices...");
+  if (m_DataCollector->Connect() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Datacollector failed to connect to devices");
+    Shutdown();
+    emit StartFailed("Datacollector failed to connect to devices");
+    return;
+  }
+
+  if (m_DataCollector->Start() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Datacollector failed to start");
+    Shutdown();
+    emit StartFailed("Datacollector failed to start");
+    return;
+  }
+
+  for (int nestedElementIndex = 0; nestedElementIndex < configRootElement->GetNumberOfNestedElements(); ++nestedElementIndex)
+  {
+    vtkXMLDataElement* serverElement = configRootElement->GetNestedElement(nestedElementIndex);
+    if (STRCASECMP(serverElement->GetName(), "PlusOpenIGTLinkServer") != 0)
+    {
+      continue;
+    }
+
+    vtkSmartPointer<vtkPlusOpenIGTLinkServer> server = vtkSmartPointer<vtkPlusOpenIGTLinkServer>::New();
+    if (server->Start(m_DataCollector, m_TransformRepository, serverElement, m_ConfigFilePath) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start OpenIGTLink server");
+      Shutdown();
+      emit StartFailed("Failed to start OpenIGTLink server");
+      return;
+    }
+    m_Servers.push_back(server);
+  }
+
+  if (m_Servers.empty())
+  {
+    LOG_ERROR("No PlusOpenIGTLinkServer element is found in the configuration file " << m_ConfigFilePath);
+    Shutdown();
+    emit StartFailed("No PlusOpenIGTLinkServer element is found in the configuration file");
+    return;
+  }
+
+  m_CommandProcessingTimer = new QTimer(this);
+  connect(m_CommandProcessingTimer, &QTimer::timeout, this, &QPlusInProcessServerWorker::ProcessPendingCommands);
+  m_CommandProcessingTimer->start(COMMAND_PROCESSING_INTERVAL_MS);
+
+  LOG_INFO("Server status: Server(s) are running.");
+  emit Started();
+}
+
+//-----------------------------------------------------------------------------
+void QPlusInProcessServerWorker::Stop()
+{
+  Shutdown();
+  LOG_INFO("Server stopped: " << m_ConfigFilePath);
+  emit Stopped();
+
+  // Nothing else runs on this thread
+  this->thread()->quit();
+}
+
+//-----------------------------------------------------------------------------
+void QPlusInProcessServerWorker::ProcessPendingCommands()
+{
+  for (std::vector<vtkSmartPointer<vtkPlusOpenIGTLinkServer> >::iterator serverIt = m_Servers.begin(); serverIt != m_Servers.end(); ++serverIt)
+  {
+    (*serverIt)->ProcessPendingCommands();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void QPlusInProcessServerWorker::Shutdown()
+{
+  if (m_CommandProcessingTimer != nullptr)
+  {
+    m_CommandProcessingTimer->stop();
+    delete m_CommandProcessingTimer;
+    m_CommandProcessingTimer = nullptr;
+  }
+
+  for (std::vector<vtkSmartPointer<vtkPlusOpenIGTLinkServer> >::iterator serverIt = m_Servers.begin(); serverIt != m_Servers.end(); ++serverIt)
+  {
+    (*serverIt)->Stop();
+  }
+  m_Servers.clear();
+
+  if (m_DataCollector != nullptr)
+  {
+    m_DataCollector->Stop();
+    m_DataCollector->Disconnect();
+    m_DataCollector = nullptr;
+  }
+  m_TransformRepository = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+QPlusInProcessServer::QPlusInProcessServer(const std::string& configFilePath, QObject* parent/*=nullptr*/)
+  : QObject(parent)
+  , m_Worker(new QPlusInProcessServerWorker(configFilePath))
+{
+  m_Worker->moveToThread(&m_WorkerThread);
+
+  // The worker emits on its own thread, the signals are queued to the thread of this object
+  connect(m_Worker, &QPlusInProcessServerWorker::Started, this, &QPlusInProcessServer::Started);
+  connect(m_Worker, &QPlusInProcessServerWorker::StartFailed, this, &QPlusInProcessServer::StartFailed);
+  connect(m_Worker, &QPlusInProcessServerWorker::Stopped, this, &QPlusInProcessServer::Stopped);
+
+  m_WorkerThread.start();
+}
+
+//-----------------------------------------------------------------------------
+QPlusInProcessServer::~QPlusInProcessServer()
+{
+  if (m_WorkerThread.isRunning())
+  {
+    // Stop quits the worker thread when it is done
+    Stop();
+    m_WorkerThread.wait();
+  }
+
+  delete m_Worker;
+  m_Worker = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusInProcessServer::Start()
+{
+  QMetaObject::invokeMethod(m_Worker, "Start", Qt::QueuedConnection);
+}
+
+//-----------------------------------------------------------------------------
+void QPlusInProcessServer::Stop()
+{
+  QMetaObject::invokeMethod(m_Worker, "Stop", Qt::QueuedConnection);
+}
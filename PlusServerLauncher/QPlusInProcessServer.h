@@ -0,0 +1,110 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusInProcessServer_h
+#define __QPlusInProcessServer_h
+
+#include "PlusConfigure.h"
+
+// Qt includes
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+class QTimer;
+class vtkPlusDataCollector;
+class vtkPlusOpenIGTLinkServer;
+class vtkIGSIOTransformRepository;
+
+//-----------------------------------------------------------------------------
+
+/*!
+  \class QPlusInProcessServerWorker
+  \brief Owns the data collector and the OpenIGTLink servers of one device set configuration, lives on the worker thread of a QPlusInProcessServer
+  \ingroup PlusAppPlusServerLauncher
+ */
+class QPlusInProcessServerWorker : public QObject
+{
+  Q_OBJECT
+
+public:
+  QPlusInProcessServerWorker(const std::string& configFilePath);
+  ~QPlusInProcessServerWorker();
+
+public slots:
+  /*! Read the configuration, connect to the devices and start the OpenIGTLink servers, does the same as the PlusServer executable */
+  void Start();
+
+  /*! Stop the servers and disconnect from the devices, then quit the worker thread */
+  void Stop();
+
+signals:
+  void Started();
+  void StartFailed(const QString& errorMessage);
+  void Stopped();
+
+protected slots:
+  /*! Execute the commands received by the servers */
+  void ProcessPendingCommands();
+
+protected:
+  /*! Stop and release everything that has been started */
+  void Shutdown();
+
+protected:
+  std::string                                              m_ConfigFilePath;
+  vtkSmartPointer<vtkPlusDataCollector>                    m_DataCollector;
+  vtkSmartPointer<vtkIGSIOTransformRepository>             m_TransformRepository;
+  std::vector<vtkSmartPointer<vtkPlusOpenIGTLinkServer> > m_Servers;
+  QTimer*                                                  m_CommandProcessingTimer;
+};
+
+//-----------------------------------------------------------------------------
+
+/*!
+  \class QPlusInProcessServer
+  \brief Hosts the OpenIGTLink servers of a device set configuration on a dedicated thread inside the launcher process
+
+  This is the in-process alternative of launching a PlusServer executable. The devices and servers are created by a worker
+  object that runs on its own thread, status is reported through the Started, StartFailed and Stopped signals, which are
+  delivered on the thread that owns this object (the GUI thread). Log messages go directly to the launcher's logger.
+
+  The device set configuration is passed only to the data collector, transform repository and servers of this instance,
+  it is not published through the process-wide vtkPlusConfig singleton, so any number of instances can run side by side.
+  Server commands that use the device set configuration of vtkPlusConfig (such as SaveConfig) are therefore not
+  available for in-process servers.
+
+  \ingroup PlusAppPlusServerLauncher
+ */
+class QPlusInProcessServer : public QObject
+{
+  Q_OBJECT
+
+public:
+  QPlusInProcessServer(const std::string& configFilePath, QObject* parent = nullptr);
+  /*! Stops the servers if they are still running and waits for the worker thread to exit */
+  ~QPlusInProcessServer();
+
+  /*! Request the worker to start the servers, returns immediately */
+  void Start();
+
+  /*! Request the worker to stop the servers, returns immediately */
+  void Stop();
+
+signals:
+  void Started();
+  void StartFailed(const QString& errorMessage);
+  void Stopped();
+
+protected:
+  QThread                       m_WorkerThread;
+  QPlusInProcessServerWorker*   m_Worker;
+};
+
+#endif // __QPlusInProcessServer_h
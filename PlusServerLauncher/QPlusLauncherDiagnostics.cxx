@@ -0,0 +1,49 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "QPlusLauncherDiagnostics.h"
+
+// PlusLib includes
+#include <vtkPlusDeviceFactory.h>
+
+// Qt includes
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QNetworkInterface>
+
+//-----------------------------------------------------------------------------
+QPlusLauncherDiagnostics::QPlusLauncherDiagnostics(QObject* parent/*=nullptr*/)
+  : QObject(parent)
+{
+}
+
+//-----------------------------------------------------------------------------
+void QPlusLauncherDiagnostics::Collect()
+{
+  vtkSmartPointer<vtkPlusDeviceFactory> deviceFactory = vtkSmartPointer<vtkPlusDeviceFactory>::New();
+  std::ostringstream supportedDevices;
+  deviceFactory->PrintAvailableDevices(supportedDevices, vtkIndent());
+
+  QString hostName = QHostInfo::localHostName();
+  QString hostDomain = QHostInfo::localDomainName();
+
+  QString ipAddresses;
+  QList<QHostAddress> list = QNetworkInterface::allAddresses();
+  for (int hostIndex = 0; hostIndex < list.count(); hostIndex++)
+  {
+    if (list[hostIndex].protocol() == QAbstractSocket::IPv4Protocol)
+    {
+      if (!ipAddresses.isEmpty())
+      {
+        ipAddresses.append(", ");
+      }
+      ipAddresses.append(list[hostIndex].toString());
+    }
+  }
+
+  emit Collected(QString::fromStdString(supportedDevices.str()), hostName, hostDomain, ipAddresses);
+}
@@ -0,0 +1,49 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusLauncherDiagnostics_h
+#define __QPlusLauncherDiagnostics_h
+
+#include "PlusConfigure.h"
+
+// Qt includes
+#include <QObject>
+#include <QString>
+
+//-----------------------------------------------------------------------------
+
+/*!
+  \class QPlusLauncherDiagnostics
+  \brief Collects the startup diagnostics of the launcher: the list of supported devices and the network configuration of the host
+
+  Collecting may take long (name resolution of the host domain can block), so in fast-start mode it is done on a
+  background thread and the results are reported through the Collected signal. The results are not logged here,
+  so that all log messages of the launcher are sent from the GUI thread.
+
+  \ingroup PlusAppPlusServerLauncher
+ */
+class QPlusLauncherDiagnostics : public QObject
+{
+  Q_OBJECT
+
+public:
+  QPlusLauncherDiagnostics(QObject* parent = nullptr);
+
+public slots:
+  /*! Collect the diagnostics and emit Collected */
+  void Collect();
+
+signals:
+  /*!
+    \param supportedDevices Description of the devices that the Plus library was built with
+    \param hostName Host name of the computer
+    \param hostDomain DNS domain of the computer, empty if not known
+    \param ipAddresses Comma separated list of the IPv4 addresses of the computer
+  */
+  void Collected(const QString& supportedDevices, const QString& hostName, const QString& hostDomain, const QString& ipAddresses);
+};
+
+#endif // __QPlusLauncherDiagnostics_h
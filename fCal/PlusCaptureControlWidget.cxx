@@ -24,6 +24,7 @@ See License.txt for details.
 PlusCaptureControlWidget::PlusCaptureControlWidget(QWidget* aParent)
   : QWidget(aParent)
   , m_Device(NULL)
+  , m_SaveInProgress(false)
 {
   ui.setupUi(this);
 
@@ -86,7 +87,16 @@ double PlusCaptureControlWidget::GetMaximumFrameRate() const
 //-----------------------------------------------------------------------------
 void PlusCaptureControlWidget::UpdateBasedOnState()
 {
-  if (m_Device != NULL)
+  if (m_Device != NULL && m_SaveInProgress)
+  {
+    ui.startStopButton->setEnabled(false);
+    ui.snapshotButton->setEnabled(false);
+    ui.saveButton->setEnabled(false);
+    ui.saveAsButton->setEnabled(false);
+    ui.clearRecordedFramesButton->setEnabled(false);
+    ui.samplingRateSlider->setEnabled(false);
+  }
+  else if (m_Device != NULL)
   {
     ui.startStopButton->setEnabled(true);
     ui.channelIdentifierLabel->setText(QString::fromStdString(m_Device->GetDeviceId()));
@@ -157,6 +167,7 @@ void PlusCaptureControlWidget::StartStopButtonPressed()
     }
 
     this->UpdateBasedOnState();
+    emit StateChanged();
   }
 }
 
@@ -185,7 +196,7 @@ void PlusCaptureControlWidget::SaveAsButtonPressed()
   m_Device->SetEnableCapturing(false);
 
   // Present dialog, get filename
-  QFileDialog* dialog = new QFileDialog(this, QString("Select save file"), QString(vtkPlusConfig::GetInstance()->GetOutputDirectory().c_str()), QString("All MetaSequence files (*.mha *.mhd)"));
+  QFileDialog* dialog = new QFileDialog(this, QString("Select save file"), QString(vtkPlusConfig::GetInstance()->GetOutputDirectory().c_str()), QString("All sequence files (*.mha *.mhd *.seq.nrrd *.nrrd)"));
   dialog->setMinimumSize(QSize(640, 480));
   dialog->setAcceptMode(QFileDialog::AcceptSave);
   dialog->setFileMode(QFileDialog::AnyFile);
@@ -249,6 +260,7 @@ void PlusCaptureControlWidget::SamplingRateChanged(int aValue)
 void PlusCaptureControlWidget::ClearButtonPressed()
 {
   this->Clear();
+  emit StateChanged();
 }
 
 //-----------------------------------------------------------------------------
@@ -280,7 +292,7 @@ void PlusCaptureControlWidget::TakeSnapshot()
 //-----------------------------------------------------------------------------
 void PlusCaptureControlWidget::SetEnableCapturing(bool aCapturing)
 {
-  if (m_Device != NULL)
+  if (m_Device != NULL && !m_SaveInProgress)
   {
     this->m_Device->SetEnableCapturing(aCapturing);
 
@@ -296,17 +308,7 @@ void PlusCaptureControlWidget::SaveFile()
   // Stop recording
   m_Device->SetEnableCapturing(false);
 
-  std::string baseFileName = m_Device->GetBaseFilename();
-  if (baseFileName.empty())
-  {
-    baseFileName = std::string("TrackedImageSequence_") + m_Device->GetDeviceId();
-  }
-  std::string fileName = vtkPlusConfig::GetInstance()->GetOutputPath(
-                           vtksys::SystemTools::GetFilenamePath(baseFileName) +
-                           vtksys::SystemTools::GetFilenameWithoutLastExtension(baseFileName) + "_" +
-                           vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") +
-                           vtksys::SystemTools::GetFilenameLastExtension(baseFileName)
-                         );
+  std::string fileName = this->GetOutputFilename(vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S"));
 
   std::string message;
   if (this->WriteToFile(QString(fileName.c_str())) != PLUS_FAIL)
@@ -325,6 +327,30 @@ void PlusCaptureControlWidget::SaveFile()
   LOG_INFO("Captured tracked frame list saved into '" << fileName << "'");
 }
 
+//-----------------------------------------------------------------------------
+std::string PlusCaptureControlWidget::GetOutputFilename(const std::string& aDateTime) const
+{
+  std::string baseFileName = m_Device->GetBaseFilename();
+  if (baseFileName.empty())
+  {
+    baseFileName = std::string("TrackedImageSequence_") + m_Device->GetDeviceId();
+  }
+  return vtkPlusConfig::GetInstance()->GetOutputPath(
+           vtksys::SystemTools::GetFilenamePath(baseFileName) +
+           vtksys::SystemTools::GetFilenameWithoutLastExtension(baseFileName) + "_" +
+           aDateTime +
+           vtksys::SystemTools::GetFilenameLastExtension(baseFileName)
+         );
+}
+
+//-----------------------------------------------------------------------------
+void PlusCaptureControlWidget::SetSaveInProgress(bool aSaveInProgress)
+{
+  m_SaveInProgress = aSaveInProgress;
+
+  this->UpdateBasedOnState();
+}
+
 //-----------------------------------------------------------------------------
 void PlusCaptureControlWidget::Clear()
 {
@@ -343,7 +369,7 @@ void PlusCaptureControlWidget::Clear()
 //-----------------------------------------------------------------------------
 bool PlusCaptureControlWidget::CanSave() const
 {
-  return !m_Device->GetEnableCapturing() && m_Device->HasUnsavedData();
+  return !m_SaveInProgress && !m_Device->GetEnableCapturing() && m_Device->HasUnsavedData();
 }
 
 //-----------------------------------------------------------------------------
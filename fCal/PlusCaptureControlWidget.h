@@ -48,6 +48,15 @@ public:
 
   virtual void SaveFile();
 
+  /*!
+  * Output file name used by SaveFile, built from the device base file name
+  * \param aDateTime Date and time string appended to the file name
+  */
+  virtual std::string GetOutputFilename(const std::string& aDateTime) const;
+
+  /*! Disable the controls while the file of the device is written in the background */
+  virtual void SetSaveInProgress(bool aSaveInProgress);
+
   virtual void Clear();
 
   virtual bool CanSave() const;
@@ -75,6 +84,9 @@ protected:
 signals:
   void EmitStatusMessage(const std::string&);
 
+  /*! Emitted when recording is started or stopped, or the recorded frames are cleared */
+  void StateChanged();
+
 protected slots:
   /*!
   * Take snapshot (record the current frame only)
@@ -95,6 +107,9 @@ protected:
   /*! device to interact with */
   vtkPlusVirtualCapture* m_Device;
 
+  /*! True while the recorded data is being written by a background writer */
+  bool m_SaveInProgress;
+
 protected:
   Ui::CaptureControlWidget ui;
 };
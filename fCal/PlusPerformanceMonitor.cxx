@@ -0,0 +1,383 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "PlusPerformanceMonitor.h"
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace
+{
+  //-----------------------------------------------------------------------------
+  /*! Index of the histogram bin of a duration: bin i holds durations of [2^(i-1), 2^i) microseconds */
+  int GetHistogramBin(int64_t durationNs)
+  {
+    uint64_t durationUs = durationNs > 0 ? static_cast<uint64_t>(durationNs / 1000) : 0;
+    int bin = 0;
+    while (durationUs > 0 && bin < PlusPerformanceMonitor::NUMBER_OF_HISTOGRAM_BINS - 1)
+    {
+      durationUs >>= 1;
+      ++bin;
+    }
+    return bin;
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Upper limit of the durations in a histogram bin */
+  double GetHistogramBinUpperLimitMs(int bin)
+  {
+    return static_cast<double>(uint64_t(1) << bin) / 1000.0;
+  }
+
+  //-----------------------------------------------------------------------------
+  std::string EscapeJsonString(const std::string& str)
+  {
+    std::string escaped;
+    for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+    {
+      if (*it == '\"' || *it == '\\')
+      {
+        escaped += '\\';
+      }
+      escaped += *it;
+    }
+    return escaped;
+  }
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::Statistics::Statistics()
+  : Count(0)
+  , TotalMs(0.0)
+  , MaxMs(0.0)
+{
+  std::fill(this->Histogram, this->Histogram + NUMBER_OF_HISTOGRAM_BINS, 0);
+}
+
+//-----------------------------------------------------------------------------
+double PlusPerformanceMonitor::Statistics::GetMeanMs() const
+{
+  return this->Count > 0 ? this->TotalMs / this->Count : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+double PlusPerformanceMonitor::Statistics::GetPercentileMs(double fraction) const
+{
+  if (this->Count == 0)
+  {
+    return 0.0;
+  }
+  uint64_t threshold = static_cast<uint64_t>(fraction * this->Count);
+  uint64_t cumulativeCount = 0;
+  for (int bin = 0; bin < NUMBER_OF_HISTOGRAM_BINS; ++bin)
+  {
+    cumulativeCount += this->Histogram[bin];
+    if (cumulativeCount > threshold)
+    {
+      return std::min(GetHistogramBinUpperLimitMs(bin), this->MaxMs);
+    }
+  }
+  return this->MaxMs;
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::Statistics PlusPerformanceMonitor::Statistics::operator-(const Statistics& earlier) const
+{
+  Statistics difference(*this);
+  difference.Count -= std::min(earlier.Count, this->Count);
+  difference.TotalMs = std::max(0.0, this->TotalMs - earlier.TotalMs);
+  for (int bin = 0; bin < NUMBER_OF_HISTOGRAM_BINS; ++bin)
+  {
+    difference.Histogram[bin] -= std::min(earlier.Histogram[bin], this->Histogram[bin]);
+  }
+  return difference;
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::ThreadData::ThreadData(int threadIndex)
+  : ThreadIndex(threadIndex)
+  , TraceWriteIndex(0)
+{
+  for (int timerId = 0; timerId < MAX_NUMBER_OF_TIMERS; ++timerId)
+  {
+    TimerCounters& counters = this->Timers[timerId];
+    counters.Count.store(0, std::memory_order_relaxed);
+    counters.TotalNs.store(0, std::memory_order_relaxed);
+    counters.MaxNs.store(0, std::memory_order_relaxed);
+    for (int bin = 0; bin < NUMBER_OF_HISTOGRAM_BINS; ++bin)
+    {
+      counters.Histogram[bin].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::ThreadDataOwner::~ThreadDataOwner()
+{
+  if (this->Data != nullptr)
+  {
+    PlusPerformanceMonitor::GetInstance()->ReleaseThreadData(this->Data);
+  }
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor* PlusPerformanceMonitor::GetInstance()
+{
+  static PlusPerformanceMonitor instance;
+  return &instance;
+}
+
+//-----------------------------------------------------------------------------
+int64_t PlusPerformanceMonitor::GetTimeNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::PlusPerformanceMonitor()
+  : m_NextThreadIndex(1)
+  , m_TracingEnabled(false)
+  , m_StartTimeNs(GetTimeNs())
+{
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::~PlusPerformanceMonitor()
+{
+  // Threads that are still running while the application exits may hold a pointer to their data,
+  // so only the data of the exited threads is freed
+  for (std::vector<ThreadData*>::iterator threadIt = m_FreeThreadData.begin(); threadIt != m_FreeThreadData.end(); ++threadIt)
+  {
+    delete *threadIt;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int PlusPerformanceMonitor::RegisterTimer(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  std::vector<std::string>::iterator nameIt = std::find(m_TimerNames.begin(), m_TimerNames.end(), name);
+  if (nameIt != m_TimerNames.end())
+  {
+    return static_cast<int>(nameIt - m_TimerNames.begin());
+  }
+  if (m_TimerNames.size() >= MAX_NUMBER_OF_TIMERS)
+  {
+    LOG_WARNING("Performance timer " << name << " cannot be registered, the maximum number of timers (" << MAX_NUMBER_OF_TIMERS << ") is reached");
+    return -1;
+  }
+  m_TimerNames.push_back(name);
+  return static_cast<int>(m_TimerNames.size()) - 1;
+}
+
+//-----------------------------------------------------------------------------
+std::string PlusPerformanceMonitor::GetTimerName(int timerId)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (timerId < 0 || timerId >= static_cast<int>(m_TimerNames.size()))
+  {
+    return "";
+  }
+  return m_TimerNames[timerId];
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::ThreadData* PlusPerformanceMonitor::GetThreadData()
+{
+  // The data of each thread is assigned once, afterwards it is only accessed through the thread local owner
+  thread_local ThreadDataOwner threadDataOwner;
+  if (threadDataOwner.Data == nullptr)
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_FreeThreadData.empty())
+    {
+      // The counters of the exited thread are kept, they are part of the statistics. Its trace events keep
+      // their thread identifier, the events of this thread get a new one.
+      threadDataOwner.Data = m_FreeThreadData.back();
+      threadDataOwner.Data->ThreadIndex = m_NextThreadIndex++;
+      m_FreeThreadData.pop_back();
+    }
+    else
+    {
+      threadDataOwner.Data = new ThreadData(m_NextThreadIndex++);
+      m_ThreadData.push_back(threadDataOwner.Data);
+    }
+  }
+  return threadDataOwner.Data;
+}
+
+//-----------------------------------------------------------------------------
+void PlusPerformanceMonitor::ReleaseThreadData(ThreadData* threadData)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_FreeThreadData.push_back(threadData);
+}
+
+//-----------------------------------------------------------------------------
+void PlusPerformanceMonitor::AddSampleNs(int timerId, int64_t durationNs)
+{
+  // Only the owner thread writes these counters, so relaxed load + store is sufficient
+  TimerCounters& counters = this->GetThreadData()->Timers[timerId];
+  counters.Count.store(counters.Count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  counters.TotalNs.store(counters.TotalNs.load(std::memory_order_relaxed) + durationNs, std::memory_order_relaxed);
+  if (durationNs > counters.MaxNs.load(std::memory_order_relaxed))
+  {
+    counters.MaxNs.store(durationNs, std::memory_order_relaxed);
+  }
+  std::atomic<uint64_t>& bin = counters.Histogram[GetHistogramBin(durationNs)];
+  bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+void PlusPerformanceMonitor::AddSample(int timerId, int64_t startNs, int64_t durationNs)
+{
+  if (timerId < 0 || timerId >= MAX_NUMBER_OF_TIMERS)
+  {
+    return;
+  }
+  this->AddSampleNs(timerId, durationNs);
+
+  if (m_TracingEnabled.load(std::memory_order_relaxed))
+  {
+    ThreadData* threadData = this->GetThreadData();
+    if (threadData->TraceBuffer == nullptr)
+    {
+      // Allocated under the lock, as WriteChromeTrace may read the buffers of all threads meanwhile.
+      // The slots are zero initialized, sequence 0 marks them as never written.
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      threadData->TraceBuffer.reset(new TraceEvent[ThreadData::TRACE_BUFFER_SIZE]());
+    }
+    // Seqlock write: mark the slot as being written, store the event, then publish it with its final sequence
+    uint64_t writeIndex = threadData->TraceWriteIndex.load(std::memory_order_relaxed);
+    TraceEvent& traceEvent = threadData->TraceBuffer[writeIndex % ThreadData::TRACE_BUFFER_SIZE];
+    traceEvent.Sequence.store(2 * writeIndex + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    traceEvent.TimerId.store(timerId, std::memory_order_relaxed);
+    traceEvent.ThreadIndex.store(threadData->ThreadIndex, std::memory_order_relaxed);
+    traceEvent.StartNs.store(startNs, std::memory_order_relaxed);
+    traceEvent.DurationNs.store(durationNs, std::memory_order_relaxed);
+    traceEvent.Sequence.store(2 * writeIndex + 2, std::memory_order_release);
+    threadData->TraceWriteIndex.store(writeIndex + 1, std::memory_order_release);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void PlusPerformanceMonitor::AddValue(int timerId, double valueMs)
+{
+  if (timerId < 0 || timerId >= MAX_NUMBER_OF_TIMERS)
+  {
+    return;
+  }
+  this->AddSampleNs(timerId, static_cast<int64_t>(valueMs * 1000000.0));
+}
+
+//-----------------------------------------------------------------------------
+PlusPerformanceMonitor::Statistics PlusPerformanceMonitor::GetStatistics(int timerId)
+{
+  Statistics statistics;
+  if (timerId < 0 || timerId >= MAX_NUMBER_OF_TIMERS)
+  {
+    return statistics;
+  }
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  int64_t totalNs = 0;
+  int64_t maxNs = 0;
+  for (std::vector<ThreadData*>::iterator threadIt = m_ThreadData.begin(); threadIt != m_ThreadData.end(); ++threadIt)
+  {
+    TimerCounters& counters = (*threadIt)->Timers[timerId];
+    statistics.Count += counters.Count.load(std::memory_order_relaxed);
+    totalNs += counters.TotalNs.load(std::memory_order_relaxed);
+    maxNs = std::max(maxNs, counters.MaxNs.load(std::memory_order_relaxed));
+    for (int bin = 0; bin < NUMBER_OF_HISTOGRAM_BINS; ++bin)
+    {
+      statistics.Histogram[bin] += counters.Histogram[bin].load(std::memory_order_relaxed);
+    }
+  }
+  statistics.TotalMs = totalNs / 1000000.0;
+  statistics.MaxMs = maxNs / 1000000.0;
+  return statistics;
+}
+
+//-----------------------------------------------------------------------------
+void PlusPerformanceMonitor::SetTracingEnabled(bool enabled)
+{
+  m_TracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+bool PlusPerformanceMonitor::GetTracingEnabled() const
+{
+  return m_TracingEnabled.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus PlusPerformanceMonitor::WriteChromeTrace(const std::string& fileName)
+{
+  std::ofstream traceFile(fileName.c_str(), std::ios::out | std::ios::trunc);
+  if (!traceFile.is_open())
+  {
+    LOG_ERROR("Unable to open performance trace file for writing: " << fileName);
+    return PLUS_FAIL;
+  }
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  traceFile << "{\"traceEvents\":[";
+  bool firstEvent = true;
+  int numberOfEvents = 0;
+  for (std::vector<ThreadData*>::iterator threadIt = m_ThreadData.begin(); threadIt != m_ThreadData.end(); ++threadIt)
+  {
+    ThreadData* threadData = *threadIt;
+    if (threadData->TraceBuffer == nullptr)
+    {
+      continue;
+    }
+    uint64_t writeIndex = threadData->TraceWriteIndex.load(std::memory_order_acquire);
+    uint64_t numberOfAvailableEvents = std::min<uint64_t>(writeIndex, ThreadData::TRACE_BUFFER_SIZE);
+    for (uint64_t eventIndex = writeIndex - numberOfAvailableEvents; eventIndex < writeIndex; ++eventIndex)
+    {
+      // Seqlock read: the owner thread keeps writing, events that are being written or have been overwritten
+      // by a newer event (the sequence does not belong to this event or changes during the read) are skipped
+      const TraceEvent& traceEvent = threadData->TraceBuffer[eventIndex % ThreadData::TRACE_BUFFER_SIZE];
+      const uint64_t expectedSequence = 2 * eventIndex + 2;
+      if (traceEvent.Sequence.load(std::memory_order_acquire) != expectedSequence)
+      {
+        continue;
+      }
+      int timerId = traceEvent.TimerId.load(std::memory_order_relaxed);
+      int threadIndex = traceEvent.ThreadIndex.load(std::memory_order_relaxed);
+      int64_t startNs = traceEvent.StartNs.load(std::memory_order_relaxed);
+      int64_t durationNs = traceEvent.DurationNs.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (traceEvent.Sequence.load(std::memory_order_relaxed) != expectedSequence)
+      {
+        continue;
+      }
+      if (timerId < 0 || timerId >= static_cast<int>(m_TimerNames.size()))
+      {
+        continue;
+      }
+      traceFile << (firstEvent ? "" : ",") << "\n{\"name\":\"" << EscapeJsonString(m_TimerNames[timerId])
+                << "\",\"cat\":\"fCal\",\"ph\":\"X\",\"ts\":" << (startNs - m_StartTimeNs) / 1000.0
+                << ",\"dur\":" << durationNs / 1000.0 << ",\"pid\":1,\"tid\":" << threadIndex << "}";
+      firstEvent = false;
+      ++numberOfEvents;
+    }
+  }
+  traceFile << "\n]}\n";
+  traceFile.close();
+
+  if (traceFile.fail())
+  {
+    LOG_ERROR("Failed to write performance trace file: " << fileName);
+    return PLUS_FAIL;
+  }
+  LOG_INFO("Performance trace with " << numberOfEvents << " events written to " << fileName);
+  return PLUS_SUCCESS;
+}
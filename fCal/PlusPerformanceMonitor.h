@@ -0,0 +1,196 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusPerformanceMonitor_h
+#define __PlusPerformanceMonitor_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// STL includes
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+
+/*! \class PlusPerformanceMonitor
+* \brief Collects timing statistics of the hot paths of fCal
+
+Named timers are registered once with RegisterTimer() and then fed with AddSample() (usually through
+PLUS_SCOPED_TIMER) from any thread. Each thread writes into its own set of counters and histograms,
+so recording a sample does not take a lock; the counters of all threads are only summed up when
+GetStatistics() is called. Durations are binned into a logarithmic histogram (one bin per power of
+two microseconds), which is enough to estimate percentiles.
+
+When tracing is enabled, every sample is also stored as a complete event in a per-thread ring buffer
+and the most recent events can be written into a Chrome trace file (chrome://tracing, Perfetto).
+The ring buffer of a thread is only allocated when it records a sample while tracing is enabled.
+The data of a thread is kept for reuse by the next new thread when the thread exits, so the counters
+of short-lived threads are not lost and the number of thread data sets stays at the peak thread count.
+
+\ingroup PlusAppFCal
+*/
+class PlusPerformanceMonitor
+{
+public:
+  enum
+  {
+    MAX_NUMBER_OF_TIMERS = 64,
+    NUMBER_OF_HISTOGRAM_BINS = 24
+  };
+
+  /*! Summary of the samples of one timer */
+  struct Statistics
+  {
+    Statistics();
+
+    /*! Average duration */
+    double GetMeanMs() const;
+    /*! Estimated duration below which the given fraction (0..1) of the samples fall */
+    double GetPercentileMs(double fraction) const;
+    /*! Samples recorded since an earlier snapshot. MaxMs is kept from this snapshot. */
+    Statistics operator-(const Statistics& earlier) const;
+
+    uint64_t Count;
+    double TotalMs;
+    double MaxMs;
+    uint64_t Histogram[NUMBER_OF_HISTOGRAM_BINS];
+  };
+
+  /*! Process-wide instance */
+  static PlusPerformanceMonitor* GetInstance();
+
+  /*! Monotonic time in nanoseconds, used as time base of all samples */
+  static int64_t GetTimeNs();
+
+  /*!
+  * Get the identifier of a named timer, registering it at the first call
+  * \return Timer identifier, -1 if no more timers can be registered
+  */
+  int RegisterTimer(const std::string& name);
+
+  /*! Name of a registered timer */
+  std::string GetTimerName(int timerId);
+
+  /*! Record a sample measured by the caller */
+  void AddSample(int timerId, int64_t startNs, int64_t durationNs);
+
+  /*! Record a value that is not a duration of a code section (e.g., latency). It does not appear in the trace. */
+  void AddValue(int timerId, double valueMs);
+
+  /*! Sum of the samples of all threads */
+  Statistics GetStatistics(int timerId);
+
+  /*! Store samples in the trace buffers */
+  void SetTracingEnabled(bool enabled);
+  bool GetTracingEnabled() const;
+
+  /*! Write the buffered trace events in Chrome trace event format */
+  PlusStatus WriteChromeTrace(const std::string& fileName);
+
+protected:
+  /*!
+  * Slot of a trace ring buffer. Sequence is odd while the owner thread writes the slot and 2 * (event index + 1)
+  * after the event is written, so readers can detect events that are incomplete or overwritten meanwhile.
+  */
+  struct TraceEvent
+  {
+    std::atomic<uint64_t> Sequence;
+    std::atomic<int> TimerId;
+    std::atomic<int> ThreadIndex;
+    std::atomic<int64_t> StartNs;
+    std::atomic<int64_t> DurationNs;
+  };
+
+  struct TimerCounters
+  {
+    std::atomic<uint64_t> Count;
+    std::atomic<int64_t> TotalNs;
+    std::atomic<int64_t> MaxNs;
+    std::atomic<uint64_t> Histogram[NUMBER_OF_HISTOGRAM_BINS];
+  };
+
+  /*! Counters and trace ring buffer written by a single thread */
+  struct ThreadData
+  {
+    enum { TRACE_BUFFER_SIZE = 32768 };
+    ThreadData(int threadIndex);
+
+    /*! Thread identifier in the trace, a new one is assigned each time the data is taken over by another thread */
+    int ThreadIndex;
+    TimerCounters Timers[MAX_NUMBER_OF_TIMERS];
+    /*! Null until the thread records a sample while tracing is enabled */
+    std::unique_ptr<TraceEvent[]> TraceBuffer;
+    std::atomic<uint64_t> TraceWriteIndex;
+  };
+
+  /*! Thread local holder of the data of a thread, returns the data for reuse when the thread exits */
+  struct ThreadDataOwner
+  {
+    ThreadDataOwner() : Data(nullptr) {}
+    ~ThreadDataOwner();
+    ThreadData* Data;
+  };
+
+  PlusPerformanceMonitor();
+  ~PlusPerformanceMonitor();
+
+  ThreadData* GetThreadData();
+  void ReleaseThreadData(ThreadData* threadData);
+  void AddSampleNs(int timerId, int64_t durationNs);
+
+  std::mutex m_Mutex;
+  std::vector<std::string> m_TimerNames;
+  /*! Data of all threads that have recorded samples, including the data in m_FreeThreadData */
+  std::vector<ThreadData*> m_ThreadData;
+  /*! Data of exited threads, waiting to be reused by new threads */
+  std::vector<ThreadData*> m_FreeThreadData;
+  /*! Trace thread identifier of the next thread that gets data */
+  int m_NextThreadIndex;
+  std::atomic<bool> m_TracingEnabled;
+  int64_t m_StartTimeNs;
+
+private:
+  PlusPerformanceMonitor(const PlusPerformanceMonitor&);
+  void operator=(const PlusPerformanceMonitor&);
+};
+
+//-----------------------------------------------------------------------------
+
+/*! \class PlusScopedTimer
+* \brief Records the time spent in a scope into a PlusPerformanceMonitor timer
+\ingroup PlusAppFCal
+*/
+class PlusScopedTimer
+{
+public:
+  PlusScopedTimer(int timerId)
+    : m_TimerId(timerId)
+    , m_StartNs(PlusPerformanceMonitor::GetTimeNs())
+  {
+  }
+  ~PlusScopedTimer()
+  {
+    PlusPerformanceMonitor::GetInstance()->AddSample(m_TimerId, m_StartNs, PlusPerformanceMonitor::GetTimeNs() - m_StartNs);
+  }
+
+protected:
+  int m_TimerId;
+  int64_t m_StartNs;
+};
+
+#define PLUS_PERFORMANCE_CONCAT_IMPL(a, b) a##b
+#define PLUS_PERFORMANCE_CONCAT(a, b) PLUS_PERFORMANCE_CONCAT_IMPL(a, b)
+
+/*! Time the rest of the enclosing scope. The timer is registered only once per call site. */
+#define PLUS_SCOPED_TIMER(name) \
+  static const int PLUS_PERFORMANCE_CONCAT(plusTimerId, __LINE__) = PlusPerformanceMonitor::GetInstance()->RegisterTimer(name); \
+  PlusScopedTimer PLUS_PERFORMANCE_CONCAT(plusScopedTimer, __LINE__)(PLUS_PERFORMANCE_CONCAT(plusTimerId, __LINE__))
+
+#endif
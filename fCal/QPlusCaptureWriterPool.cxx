@@ -0,0 +1,231 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "QPlusCaptureWriterPool.h"
+
+// PlusLib includes
+#include <vtkIGSIOAccurateTimer.h>
+#include <vtkPlusVirtualCapture.h>
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkXMLDataElement.h>
+#include <vtksys/SystemTools.hxx>
+
+// Qt includes
+#include <QRunnable>
+#include <QThread>
+
+// STL includes
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+  //-----------------------------------------------------------------------------
+  /*! Closes the output file of one capture device on a worker thread and reports back to the pool */
+  class CaptureWriterRunnable : public QRunnable
+  {
+  public:
+    CaptureWriterRunnable(QObject* aPool, int aJobIndex, vtkPlusVirtualCapture* aDevice, const std::string& aFilename)
+      : m_Pool(aPool)
+      , m_JobIndex(aJobIndex)
+      , m_Device(aDevice)
+      , m_Filename(aFilename)
+    {
+    }
+
+    virtual void run()
+    {
+      double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+      bool success = (m_Device->CloseFile(m_Filename.c_str()) == PLUS_SUCCESS);
+      double elapsedSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+
+      // The pool lives on the GUI thread, deliver the result there
+      QMetaObject::invokeMethod(m_Pool, "OnJobFinished", Qt::QueuedConnection, Q_ARG(int, m_JobIndex), Q_ARG(bool, success), Q_ARG(double, elapsedSec));
+    }
+
+  protected:
+    QObject* m_Pool;
+    int m_JobIndex;
+    vtkPlusVirtualCapture* m_Device;
+    std::string m_Filename;
+  };
+}
+
+//-----------------------------------------------------------------------------
+QPlusCaptureWriterPool::QPlusCaptureWriterPool(QObject* aParent)
+  : QObject(aParent)
+  , m_NumberOfRunningJobs(0)
+  , m_SessionStartTime(0.0)
+{
+  // Writing is mostly bound by compression and disk I/O, there is no point having more threads than cores
+  m_ThreadPool.setMaxThreadCount(std::max(QThread::idealThreadCount(), 1));
+}
+
+//-----------------------------------------------------------------------------
+QPlusCaptureWriterPool::~QPlusCaptureWriterPool()
+{
+  m_ThreadPool.waitForDone();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusCaptureWriterPool::AddJob(vtkPlusVirtualCapture* aDevice, const std::string& aFilename)
+{
+  if (this->IsBusy())
+  {
+    LOG_ERROR("Cannot add a capture file to the writer pool while a session is being written");
+    return PLUS_FAIL;
+  }
+  if (aDevice == NULL || aFilename.empty())
+  {
+    LOG_ERROR("Cannot add a capture file to the writer pool: invalid device or file name");
+    return PLUS_FAIL;
+  }
+
+  WriterJob job;
+  job.Device = aDevice;
+  job.DeviceId = aDevice->GetDeviceId();
+  job.Filename = aFilename;
+  job.NumberOfFrames = aDevice->GetTotalFramesRecorded();
+  job.Finished = false;
+  job.Success = false;
+  job.ElapsedSec = 0.0;
+  job.FileSizeMb = 0.0;
+  m_Jobs.push_back(job);
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int QPlusCaptureWriterPool::GetNumberOfJobs() const
+{
+  return static_cast<int>(m_Jobs.size());
+}
+
+//-----------------------------------------------------------------------------
+bool QPlusCaptureWriterPool::IsBusy() const
+{
+  return m_NumberOfRunningJobs > 0;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusCaptureWriterPool::Start(const std::string& aSessionId, const std::string& aManifestFilename)
+{
+  if (this->IsBusy())
+  {
+    LOG_ERROR("Capture writer session is already in progress");
+    return PLUS_FAIL;
+  }
+  if (m_Jobs.empty())
+  {
+    LOG_WARNING("No capture files to write");
+    return PLUS_FAIL;
+  }
+
+  m_SessionId = aSessionId;
+  m_ManifestFilename = aManifestFilename;
+  m_SessionStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_NumberOfRunningJobs = static_cast<int>(m_Jobs.size());
+
+  LOG_INFO("Writing " << m_Jobs.size() << " capture files in parallel");
+
+  for (int jobIndex = 0; jobIndex < static_cast<int>(m_Jobs.size()); ++jobIndex)
+  {
+    WriterJob& job = m_Jobs[jobIndex];
+    emit FileStarted(job.Device, QString::fromStdString(job.Filename));
+    m_ThreadPool.start(new CaptureWriterRunnable(this, jobIndex, job.Device, job.Filename));
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusCaptureWriterPool::OnJobFinished(int aJobIndex, bool aSuccess, double aElapsedSec)
+{
+  if (aJobIndex < 0 || aJobIndex >= static_cast<int>(m_Jobs.size()))
+  {
+    LOG_ERROR("Invalid capture writer job index: " << aJobIndex);
+    return;
+  }
+
+  WriterJob& job = m_Jobs[aJobIndex];
+  job.Finished = true;
+  job.Success = aSuccess;
+  job.ElapsedSec = aElapsedSec;
+  job.FileSizeMb = vtksys::SystemTools::FileLength(job.Filename) / (1024.0 * 1024.0);
+
+  double throughputMbPerSec = (aElapsedSec > 0.0 ? job.FileSizeMb / aElapsedSec : 0.0);
+  if (aSuccess)
+  {
+    LOG_INFO("Captured tracked frame list saved into '" << job.Filename << "' (" << std::fixed << std::setprecision(1) << job.FileSizeMb << " MB in " << aElapsedSec << " sec)");
+  }
+  else
+  {
+    LOG_ERROR("Failed to write capture file '" << job.Filename << "' of device " << job.DeviceId);
+  }
+  emit FileFinished(job.Device, QString::fromStdString(job.Filename), aSuccess, aElapsedSec, throughputMbPerSec);
+
+  --m_NumberOfRunningJobs;
+  if (m_NumberOfRunningJobs > 0)
+  {
+    return;
+  }
+
+  // All files are written
+  double sessionElapsedSec = vtkIGSIOAccurateTimer::GetSystemTime() - m_SessionStartTime;
+  int numberOfSucceededFiles = 0;
+  for (std::vector<WriterJob>::iterator it = m_Jobs.begin(); it != m_Jobs.end(); ++it)
+  {
+    if (it->Success)
+    {
+      ++numberOfSucceededFiles;
+    }
+  }
+  int numberOfFiles = static_cast<int>(m_Jobs.size());
+
+  if (!m_ManifestFilename.empty() && this->WriteManifest() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write capture session manifest '" << m_ManifestFilename << "'");
+  }
+
+  m_Jobs.clear();
+  emit SessionFinished(numberOfSucceededFiles, numberOfFiles, sessionElapsedSec);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusCaptureWriterPool::WriteManifest()
+{
+  // All capture devices timestamp their frames with the same system clock, so the files can be
+  // aligned by these timestamps. The manifest groups the files that were recorded together.
+  vtkSmartPointer<vtkXMLDataElement> sessionElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  sessionElement->SetName("CaptureSession");
+  sessionElement->SetAttribute("Id", m_SessionId.c_str());
+  sessionElement->SetDoubleAttribute("SystemTime", m_SessionStartTime);
+  sessionElement->SetIntAttribute("NumberOfFiles", static_cast<int>(m_Jobs.size()));
+
+  for (std::vector<WriterJob>::iterator it = m_Jobs.begin(); it != m_Jobs.end(); ++it)
+  {
+    vtkSmartPointer<vtkXMLDataElement> fileElement = vtkSmartPointer<vtkXMLDataElement>::New();
+    fileElement->SetName("File");
+    fileElement->SetAttribute("DeviceId", it->DeviceId.c_str());
+    fileElement->SetAttribute("Filename", vtksys::SystemTools::GetFilenameName(it->Filename).c_str());
+    fileElement->SetIntAttribute("NumberOfFrames", it->NumberOfFrames);
+    fileElement->SetAttribute("Status", it->Success ? "OK" : "FAILED");
+    fileElement->SetDoubleAttribute("WriteTimeSec", it->ElapsedSec);
+    fileElement->SetDoubleAttribute("FileSizeMb", it->FileSizeMb);
+    sessionElement->AddNestedElement(fileElement);
+  }
+
+  if (igsioCommon::XML::PrintXML(m_ManifestFilename, sessionElement) != IGSIO_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  LOG_INFO("Capture session manifest saved into '" << m_ManifestFilename << "'");
+  return PLUS_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusCaptureWriterPool_h
+#define __QPlusCaptureWriterPool_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// Qt includes
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+class vtkPlusVirtualCapture;
+
+//-----------------------------------------------------------------------------
+
+/*! \class QPlusCaptureWriterPool
+* \brief Finalizes the output files of several capture devices concurrently
+
+Jobs are queued with AddJob() and started together with Start(). Each capture device is closed on a
+worker thread of a pool shared by all jobs, so the whole session takes about as long as the slowest
+file. Progress is reported through signals that are delivered on the thread owning the pool (normally
+the GUI thread). When all files are done a session manifest is written that lists every file of the
+session with its device, frame count and write statistics.
+
+\ingroup PlusAppFCal
+*/
+class QPlusCaptureWriterPool : public QObject
+{
+  Q_OBJECT
+
+public:
+  QPlusCaptureWriterPool(QObject* aParent = NULL);
+  /*! Waits for all running jobs to finish */
+  ~QPlusCaptureWriterPool();
+
+  /*!
+  * Queue a capture device to be written. The device must not capture while it is being written.
+  * \param aDevice Capture device to close
+  * \param aFilename Output file name
+  */
+  PlusStatus AddJob(vtkPlusVirtualCapture* aDevice, const std::string& aFilename);
+
+  /*! Number of queued jobs of the current session */
+  int GetNumberOfJobs() const;
+
+  /*!
+  * Start writing all queued files
+  * \param aSessionId Identifier of the session, stored in the manifest
+  * \param aManifestFilename Output file name of the session manifest, no manifest is written if empty
+  */
+  PlusStatus Start(const std::string& aSessionId, const std::string& aManifestFilename);
+
+  /*! True while the files of a session are being written */
+  bool IsBusy() const;
+
+signals:
+  void FileStarted(vtkPlusVirtualCapture* aDevice, const QString& aFilename);
+  void FileFinished(vtkPlusVirtualCapture* aDevice, const QString& aFilename, bool aSuccess, double aElapsedSec, double aThroughputMbPerSec);
+  void SessionFinished(int aNumberOfSucceededFiles, int aNumberOfFiles, double aElapsedSec);
+
+protected slots:
+  /*! Called on the pool's thread when a worker has finished a job */
+  void OnJobFinished(int aJobIndex, bool aSuccess, double aElapsedSec);
+
+protected:
+  /*! Write the manifest of the finished session */
+  PlusStatus WriteManifest();
+
+  struct WriterJob
+  {
+    vtkPlusVirtualCapture* Device;
+    std::string DeviceId;
+    std::string Filename;
+    int NumberOfFrames;
+    bool Finished;
+    bool Success;
+    double ElapsedSec;
+    double FileSizeMb;
+  };
+
+protected:
+  /*! Worker threads, one job occupies one thread */
+  QThreadPool m_ThreadPool;
+  /*! Jobs of the current session */
+  std::vector<WriterJob> m_Jobs;
+  /*! Number of jobs of the current session that are not finished yet */
+  int m_NumberOfRunningJobs;
+  /*! System time when the session was started */
+  double m_SessionStartTime;
+  std::string m_SessionId;
+  std::string m_ManifestFilename;
+};
+
+#endif // __QPlusCaptureWriterPool_h
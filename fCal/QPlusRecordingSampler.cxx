@@ -0,0 +1,228 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "PlusPerformanceMonitor.h"
+#include "QPlusRecordingSampler.h"
+
+// PlusLib includes
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOAccurateTimer.h>
+#include <vtkIGSIOTrackedFrameList.h>
+#include <vtkPlusChannel.h>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+  const double MAX_ALLOWED_RECORDING_LAG_SEC = 3.0; // if the recording lags more than this then it'll skip frames to catch up
+  const double FRAME_RATE_ESTIMATION_PERIOD_SEC = 5.0;
+}
+
+//-----------------------------------------------------------------------------
+QPlusRecordingSampler::Statistics::Statistics()
+  : NumberOfFrames(0)
+  , NumberOfRecordedFrames(0)
+  , ActualFrameRate(0.0)
+  , CurrentLagSec(0.0)
+  , MaxLagSec(0.0)
+  , MaxBatchDurationSec(0.0)
+  , NumberOfMissedDeadlines(0)
+  , SkippedSec(0.0)
+{
+}
+
+//-----------------------------------------------------------------------------
+QPlusRecordingSampler::QPlusRecordingSampler(QObject* aParent)
+  : QThread(aParent)
+  , m_Channel(NULL)
+  , m_RecordedFrames(NULL)
+  , m_RequestedFramePeriodSec(0.1)
+  , m_SamplingPeriodSec(0.125)
+  , m_LastAlreadyRecordedFrameTimestamp(UNDEFINED_TIMESTAMP)
+  , m_NextFrameToBeRecordedTimestamp(0.0)
+  , m_PreTriggerBacklogSec(0.0)
+  , m_FirstFrameIndex(0)
+  , m_StopRequested(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+QPlusRecordingSampler::~QPlusRecordingSampler()
+{
+  StopSampling();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QPlusRecordingSampler::StartSampling(vtkPlusChannel* aChannel, vtkIGSIOTrackedFrameList* aRecordedFrames, double aRequestedFramePeriodSec, double aSamplingPeriodSec,
+    double aNextFrameToBeRecordedTimestamp, double aLastAlreadyRecordedFrameTimestamp, double aPreTriggerBacklogSec)
+{
+  if (isRunning())
+  {
+    LOG_ERROR("Recording sampler is already running");
+    return PLUS_FAIL;
+  }
+  if (aChannel == NULL || aRecordedFrames == NULL)
+  {
+    LOG_ERROR("Unable to start recording: invalid channel or frame list");
+    return PLUS_FAIL;
+  }
+  if (aRequestedFramePeriodSec <= 0 || aSamplingPeriodSec <= 0)
+  {
+    LOG_ERROR("Unable to start recording: invalid frame period (" << aRequestedFramePeriodSec << " sec) or sampling period (" << aSamplingPeriodSec << " sec)");
+    return PLUS_FAIL;
+  }
+
+  m_Channel = aChannel;
+  m_RecordedFrames = aRecordedFrames;
+  m_RequestedFramePeriodSec = aRequestedFramePeriodSec;
+  m_SamplingPeriodSec = aSamplingPeriodSec;
+  m_NextFrameToBeRecordedTimestamp = aNextFrameToBeRecordedTimestamp;
+  m_LastAlreadyRecordedFrameTimestamp = aLastAlreadyRecordedFrameTimestamp;
+  m_PreTriggerBacklogSec = aPreTriggerBacklogSec;
+  m_FirstFrameIndex = m_RecordedFrames->GetNumberOfTrackedFrames();
+  m_RecentBatches.clear();
+
+  {
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    m_Statistics = Statistics();
+    m_Statistics.NumberOfFrames = m_FirstFrameIndex;
+  }
+
+  m_StopRequested = false;
+  start(QThread::HighPriority);
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingSampler::StopSampling()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_WakeMutex);
+    m_StopRequested = true;
+  }
+  m_WakeCondition.notify_all();
+  wait();
+}
+
+//-----------------------------------------------------------------------------
+bool QPlusRecordingSampler::IsSampling() const
+{
+  return isRunning();
+}
+
+//-----------------------------------------------------------------------------
+QPlusRecordingSampler::Statistics QPlusRecordingSampler::GetStatistics()
+{
+  std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+  return m_Statistics;
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingSampler::run()
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::duration samplingPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_SamplingPeriodSec));
+
+  Clock::time_point deadline = Clock::now();
+  while (!m_StopRequested)
+  {
+    SampleBatch();
+
+    // The deadlines are fixed multiples of the sampling period from the start, the batch duration does not shift them
+    deadline += samplingPeriod;
+    Clock::time_point now = Clock::now();
+    if (deadline < now)
+    {
+      // Do not make up for the missed deadlines, the next batch gets all the frames acquired in the meantime anyway
+      Clock::duration::rep numberOfMissedDeadlines = (now - deadline) / samplingPeriod + 1;
+      deadline += numberOfMissedDeadlines * samplingPeriod;
+      std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+      m_Statistics.NumberOfMissedDeadlines += static_cast<int>(numberOfMissedDeadlines);
+    }
+
+    std::unique_lock<std::mutex> lock(m_WakeMutex);
+    m_WakeCondition.wait_until(lock, deadline, [this] { return m_StopRequested.load(); });
+  }
+
+  // Record the frames that were acquired until the stop request
+  SampleBatch();
+}
+
+//-----------------------------------------------------------------------------
+void QPlusRecordingSampler::SampleBatch()
+{
+  PLUS_SCOPED_TIMER("CapturingRecordFrames");
+
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+
+  // Put a hard limit on the processing time, so the next deadline can be met
+  if (m_Channel->GetTrackedFrameListSampled(m_LastAlreadyRecordedFrameTimestamp, m_NextFrameToBeRecordedTimestamp, m_RecordedFrames, m_RequestedFramePeriodSec, m_SamplingPeriodSec) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Error while getting tracked frame list from data collector during capturing. Last recorded timestamp: " << std::fixed << m_NextFrameToBeRecordedTimestamp);
+  }
+
+  // Compute the frame rate from the frames recorded in the last few seconds of this recording
+  int numberOfFrames = m_RecordedFrames->GetNumberOfTrackedFrames();
+  double actualFrameRate = 0.0;
+  if (numberOfFrames > m_FirstFrameIndex)
+  {
+    double latestTimestamp = m_RecordedFrames->GetTrackedFrame(numberOfFrames - 1)->GetTimestamp();
+    if (m_RecentBatches.empty())
+    {
+      m_RecentBatches.push_back(std::make_pair(m_FirstFrameIndex + 1, m_RecordedFrames->GetTrackedFrame(m_FirstFrameIndex)->GetTimestamp()));
+    }
+    if (m_RecentBatches.back().first != numberOfFrames)
+    {
+      m_RecentBatches.push_back(std::make_pair(numberOfFrames, latestTimestamp));
+    }
+    while (m_RecentBatches.size() > 2 && latestTimestamp - m_RecentBatches[1].second >= FRAME_RATE_ESTIMATION_PERIOD_SEC)
+    {
+      m_RecentBatches.pop_front();
+    }
+    double frameTimeDiff = latestTimestamp - m_RecentBatches.front().second;
+    if (frameTimeDiff > 0)
+    {
+      actualFrameRate = (numberOfFrames - m_RecentBatches.front().first) / frameTimeDiff;
+    }
+  }
+
+  double nowSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  double batchDurationSec = nowSec - startTimeSec;
+  if (batchDurationSec > m_SamplingPeriodSec)
+  {
+    LOG_WARNING("Recording of frames takes too long time (" << batchDurationSec << "sec instead of the allocated " << m_SamplingPeriodSec << "sec). Reduce the acquisition rate or sampling rate to resolve the problem.");
+  }
+
+  double recordingLagSec = nowSec - m_NextFrameToBeRecordedTimestamp;
+  if (recordingLagSec <= MAX_ALLOWED_RECORDING_LAG_SEC)
+  {
+    // Pre-trigger data is processed, from now on the usual lag limit applies
+    m_PreTriggerBacklogSec = 0.0;
+  }
+  double skippedSec = 0.0;
+  if (recordingLagSec > MAX_ALLOWED_RECORDING_LAG_SEC + m_PreTriggerBacklogSec)
+  {
+    LOG_ERROR("Recording cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up.");
+    skippedSec = recordingLagSec;
+    m_NextFrameToBeRecordedTimestamp = nowSec;
+  }
+
+  std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+  m_Statistics.NumberOfFrames = numberOfFrames;
+  m_Statistics.NumberOfRecordedFrames = numberOfFrames - m_FirstFrameIndex;
+  m_Statistics.ActualFrameRate = actualFrameRate;
+  m_Statistics.CurrentLagSec = std::max(recordingLagSec, 0.0);
+  if (m_PreTriggerBacklogSec == 0.0)
+  {
+    m_Statistics.MaxLagSec = std::max(m_Statistics.MaxLagSec, m_Statistics.CurrentLagSec);
+  }
+  m_Statistics.MaxBatchDurationSec = std::max(m_Statistics.MaxBatchDurationSec, batchDurationSec);
+  m_Statistics.SkippedSec += skippedSec;
+}
@@ -0,0 +1,133 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __QPlusRecordingSampler_h
+#define __QPlusRecordingSampler_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// Qt includes
+#include <QThread>
+
+// STL includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+class vtkIGSIOTrackedFrameList;
+class vtkPlusChannel;
+
+//-----------------------------------------------------------------------------
+
+/*! \class QPlusRecordingSampler
+* \brief Samples the tracked frames of a channel into a frame list on a dedicated thread
+
+The sampling runs on its own high priority thread, so a busy GUI thread (rendering, dialogs, file
+writing) does not delay it. Batches are pulled on a fixed schedule: the deadline of the n-th batch
+is the start time plus n sampling periods, so the time spent in a batch does not accumulate into
+drift. If a deadline is missed, the skipped deadlines are not made up in a burst; the next batch
+simply picks up all frames acquired in the meantime at the requested frame period, so the recording
+stays uniform. The processing time of a batch is bounded by one sampling period.
+
+The output frame list is written by the sampler thread between Start() and Stop(), it must not be
+accessed by other threads in the meantime. Use GetStatistics() to follow the progress.
+
+\ingroup PlusAppFCal
+*/
+class QPlusRecordingSampler : public QThread
+{
+  Q_OBJECT
+
+public:
+  /*! Progress of the current recording */
+  struct Statistics
+  {
+    Statistics();
+
+    /*! Number of frames in the output frame list */
+    int NumberOfFrames;
+    /*! Number of frames recorded since Start() */
+    int NumberOfRecordedFrames;
+    /*! Frame rate of the recorded frames in the last few seconds (frames per second) */
+    double ActualFrameRate;
+    /*! Time between the acquisition of the latest frames and the current time, after the last batch */
+    double CurrentLagSec;
+    /*! Worst lag after a batch, not counting the data acquired before Start() */
+    double MaxLagSec;
+    /*! Longest time spent in a batch */
+    double MaxBatchDurationSec;
+    /*! Number of deadlines that were missed because the previous batch finished late */
+    int NumberOfMissedDeadlines;
+    /*! Length of the data stream that was skipped because the recording could not keep up */
+    double SkippedSec;
+  };
+
+  QPlusRecordingSampler(QObject* aParent = NULL);
+  /*! Stops the sampling */
+  ~QPlusRecordingSampler();
+
+  /*!
+  * Start sampling
+  * \param aChannel Channel to get the tracked frames from
+  * \param aRecordedFrames Frame list to append the frames to
+  * \param aRequestedFramePeriodSec Time between the recorded frames
+  * \param aSamplingPeriodSec Time between the batches
+  * \param aNextFrameToBeRecordedTimestamp Desired timestamp of the first frame to be recorded
+  * \param aLastAlreadyRecordedFrameTimestamp Only frames after this timestamp are added (UNDEFINED_TIMESTAMP if none)
+  * \param aPreTriggerBacklogSec Data acquired before Start() that is still to be recorded, the recording may lag this much more without skipping frames
+  */
+  PlusStatus StartSampling(vtkPlusChannel* aChannel, vtkIGSIOTrackedFrameList* aRecordedFrames, double aRequestedFramePeriodSec, double aSamplingPeriodSec,
+                           double aNextFrameToBeRecordedTimestamp, double aLastAlreadyRecordedFrameTimestamp, double aPreTriggerBacklogSec);
+
+  /*! Record the frames acquired until now and stop the sampling thread. Returns when the thread has finished. */
+  void StopSampling();
+
+  /*! True between StartSampling() and StopSampling() */
+  bool IsSampling() const;
+
+  /*! Snapshot of the statistics of the current (or last) recording, can be called from any thread */
+  Statistics GetStatistics();
+
+protected:
+  /*! Sampling loop */
+  virtual void run();
+
+  /*! Pull the frames acquired since the previous batch */
+  void SampleBatch();
+
+protected:
+  vtkPlusChannel* m_Channel;
+  vtkIGSIOTrackedFrameList* m_RecordedFrames;
+
+  double m_RequestedFramePeriodSec;
+  double m_SamplingPeriodSec;
+
+  /*! Timestamp of last recorded frame (only frames that have more recent timestamp will be added) */
+  double m_LastAlreadyRecordedFrameTimestamp;
+
+  /*! Desired timestamp of the next frame to be recorded */
+  double m_NextFrameToBeRecordedTimestamp;
+
+  /*! Pre-trigger data still to be recorded (in seconds) */
+  double m_PreTriggerBacklogSec;
+
+  /*! Index of the first frame recorded since StartSampling() */
+  int m_FirstFrameIndex;
+
+  /*! Number of frames and timestamp of the latest frame after the recent batches, for estimating the actual frame rate */
+  std::deque<std::pair<int, double> > m_RecentBatches;
+
+  std::atomic<bool> m_StopRequested;
+  std::mutex m_WakeMutex;
+  std::condition_variable m_WakeCondition;
+
+  std::mutex m_StatisticsMutex;
+  Statistics m_Statistics;
+};
+
+#endif
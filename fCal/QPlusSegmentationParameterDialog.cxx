@@ -25,7 +25,7 @@ See License.txt for details.
 #include <vtkCallbackCommand.h>
 #include <vtkCamera.h>
 #include <vtkConeSource.h>
-#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkLineSource.h>
@@ -921,14 +921,14 @@ PlusStatus QPlusSegmentationParameterDialog::InitializeVisualization()
   m_SegmentedPointsPolyData = vtkPolyData::New();
   m_SegmentedPointsPolyData->Initialize();
 
-  vtkSmartPointer<vtkPolyDataMapper> segmentedPointMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  vtkSmartPointer<vtkGlyph3D> segmentedPointGlyph = vtkSmartPointer<vtkGlyph3D>::New();
+  vtkSmartPointer<vtkGlyph3DMapper> segmentedPointMapper = vtkSmartPointer<vtkGlyph3DMapper>::New();
   vtkSmartPointer<vtkSphereSource> segmentedPointSphereSource = vtkSmartPointer<vtkSphereSource>::New();
   segmentedPointSphereSource->SetRadius(4.0);
 
-  segmentedPointGlyph->SetInputData(m_SegmentedPointsPolyData);
-  segmentedPointGlyph->SetSourceConnection(segmentedPointSphereSource->GetOutputPort());
-  segmentedPointMapper->SetInputConnection(segmentedPointGlyph->GetOutputPort());
+  segmentedPointMapper->SetInputData(m_SegmentedPointsPolyData);
+  segmentedPointMapper->SetSourceConnection(segmentedPointSphereSource->GetOutputPort());
+  segmentedPointMapper->ScalingOff();
+  segmentedPointMapper->OrientOff();
 
   m_SegmentedPointsActor->SetMapper(segmentedPointMapper);
   m_SegmentedPointsActor->GetProperty()->SetColor(0.0, 0.8, 0.0);
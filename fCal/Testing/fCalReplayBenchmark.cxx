@@ -0,0 +1,528 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+/*
+* This benchmark runs fCal headless of user interaction: the main window is created, the device set
+* is connected through the Configuration toolbox and the processing path is driven through the same
+* visualization controller and toolbox slots as the buttons of the application. The frames are
+* replayed by the simulated devices of the device set configuration at their recorded rate.
+* The frame rate, the latency percentiles measured by the performance monitor of fCal and the peak
+* memory usage are reported and compared to a baseline file; the benchmark fails if the performance
+* is worse than the baseline by more than the tolerance, or if the baseline file does not exist.
+* Baselines are created with --update-baseline.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusPerformanceMonitor.h"
+#include "QAbstractToolbox.h"
+#include "QCapturingToolbox.h"
+#include "fCalMainWindow.h"
+#include "igsioCommon.h"
+#include "vtkIGSIOAccurateTimer.h"
+#include "vtkIGSIOTrackedFrameList.h"
+#include "vtkPlusVisualizationController.h"
+#include "vtkSmartPointer.h"
+#include "vtkXMLDataElement.h"
+#include "vtkXMLUtilities.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+#include <QApplication>
+#include <QEventLoop>
+#include <QTimer>
+#include <QToolBox>
+#include <fstream>
+#include <iomanip>
+
+#if defined(_WIN32)
+  #include <windows.h>
+  #include <psapi.h>
+  #pragma comment(lib, "psapi.lib")
+#elif defined(__APPLE__)
+  #include <sys/resource.h>
+#endif
+
+//-----------------------------------------------------------------------------
+struct BenchmarkResult
+{
+  BenchmarkResult() : NumberOfFrames(0), ElapsedTimeSec(0.0), PeakMemoryMb(0.0) {}
+  double GetFramesPerSecond() const { return this->ElapsedTimeSec > 0 ? this->NumberOfFrames / this->ElapsedTimeSec : 0.0; }
+  double GetLatencyPercentileMs(double fraction) const { return this->Latency.Count > 0 ? this->Latency.GetPercentileMs(fraction) : 0.0; }
+
+  int NumberOfFrames;
+  double ElapsedTimeSec;
+  double PeakMemoryMb;
+  /*! Samples of the performance monitor timer that measures the per-frame latency of the processing path */
+  PlusPerformanceMonitor::Statistics Latency;
+};
+
+PlusStatus ConnectToDevices(fCalMainWindow& mainWindow, const std::string& configFileName);
+QAbstractToolbox* ActivateToolbox(fCalMainWindow& mainWindow, ToolboxType toolboxType, const QString& toolboxTitle);
+PlusStatus InvokeToolboxSlot(QAbstractToolbox* toolbox, const char* slotName);
+void ProcessEvents(double durationSec);
+PlusStatus WaitForToolboxState(QAbstractToolbox* toolbox, ToolboxState state, double timeoutSec);
+PlusStatus RecordFrames(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result);
+PlusStatus RunDisplayBenchmark(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result);
+PlusStatus RunSpatialCalibrationBenchmark(fCalMainWindow& mainWindow, double timeoutSec, BenchmarkResult& result);
+PlusStatus RunCaptureBenchmark(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result);
+PlusStatus RunVolumeReconstructionBenchmark(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result);
+PlusStatus CompareToBaseline(const std::string& benchmarkName, const BenchmarkResult& result, const std::string& baselineFileName, double tolerancePercent);
+PlusStatus WriteBaseline(const std::string& benchmarkName, const BenchmarkResult& result, const std::string& baselineFileName);
+void ResetPeakMemory();
+double GetPeakMemoryMb();
+
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  std::string benchmarkName;
+  std::string inputConfigFileName;
+  std::string baselineFileName;
+  bool updateBaseline(false);
+  double durationSec = 10.0;
+  double timeoutSec = 300.0;
+  double tolerancePercent = 50.0;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--benchmark", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &benchmarkName, "Processing path to measure: Display, SpatialCalibration, Capture or VolumeReconstruction");
+  args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Device set configuration file, it is connected the same way as in the Configuration toolbox of fCal");
+  args.AddArgument("--duration-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &durationSec, "Time while frames are displayed or recorded (Default: 10)");
+  args.AddArgument("--timeout-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &timeoutSec, "Maximum time of the spatial calibration (Default: 300)");
+  args.AddArgument("--baseline-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &baselineFileName, "Baseline file that the results are compared to");
+  args.AddArgument("--update-baseline", vtksys::CommandLineArguments::NO_ARGUMENT, &updateBaseline, "Write the results into the baseline file instead of comparing them");
+  args.AddArgument("--tolerance-percent", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &tolerancePercent, "Allowed performance decrease compared to the baseline in percent (Default: 50)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (benchmarkName.empty() || inputConfigFileName.empty())
+  {
+    std::cerr << "--benchmark and --config-file are required" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (updateBaseline && baselineFileName.empty())
+  {
+    std::cerr << "--update-baseline requires --baseline-file" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+  // Without a display the window system integration falls back to offscreen rendering, so the benchmark runs headless
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") && qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY"))
+  {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+#endif
+
+  QApplication app(argc, argv);
+
+  fCalMainWindow mainWindow;
+  mainWindow.show();
+  mainWindow.Initialize();
+
+  if (ConnectToDevices(mainWindow, inputConfigFileName) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to connect to devices using configuration file " << inputConfigFileName);
+    exit(EXIT_FAILURE);
+  }
+
+  // Only the memory used by the processing path is of interest, not the start-up of the application
+  ResetPeakMemory();
+
+  BenchmarkResult result;
+  PlusStatus status = PLUS_FAIL;
+  if (igsioCommon::IsEqualInsensitive(benchmarkName, "Display"))
+  {
+    status = RunDisplayBenchmark(mainWindow, durationSec, result);
+  }
+  else if (igsioCommon::IsEqualInsensitive(benchmarkName, "SpatialCalibration"))
+  {
+    status = RunSpatialCalibrationBenchmark(mainWindow, timeoutSec, result);
+  }
+  else if (igsioCommon::IsEqualInsensitive(benchmarkName, "Capture"))
+  {
+    status = RunCaptureBenchmark(mainWindow, durationSec, result);
+  }
+  else if (igsioCommon::IsEqualInsensitive(benchmarkName, "VolumeReconstruction"))
+  {
+    status = RunVolumeReconstructionBenchmark(mainWindow, durationSec, result);
+  }
+  else
+  {
+    std::cerr << "Unknown benchmark: " << benchmarkName << ". Supported benchmarks: Display, SpatialCalibration, Capture, VolumeReconstruction" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (status != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Benchmark " << benchmarkName << " failed");
+    exit(EXIT_FAILURE);
+  }
+  result.PeakMemoryMb = GetPeakMemoryMb();
+
+  LOG_INFO("Benchmark " << benchmarkName << ": " << result.NumberOfFrames << " frames in " << std::fixed << std::setprecision(3) << result.ElapsedTimeSec << " s");
+  LOG_INFO("  Frame rate: " << result.GetFramesPerSecond() << " fps");
+  if (result.Latency.Count > 0)
+  {
+    LOG_INFO("  Latency: p50 " << result.GetLatencyPercentileMs(0.50) << " ms, p95 " << result.GetLatencyPercentileMs(0.95)
+             << " ms, p99 " << result.GetLatencyPercentileMs(0.99) << " ms, max " << result.Latency.MaxMs << " ms");
+  }
+  LOG_INFO("  Peak memory: " << result.PeakMemoryMb << " MB");
+
+  if (baselineFileName.empty())
+  {
+    return EXIT_SUCCESS;
+  }
+  if (updateBaseline)
+  {
+    return WriteBaseline(benchmarkName, result, baselineFileName) == PLUS_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  if (!vtksys::SystemTools::FileExists(baselineFileName.c_str(), true))
+  {
+    LOG_ERROR("Baseline file " << baselineFileName << " does not exist. Run the benchmark with --update-baseline to create it.");
+    return EXIT_FAILURE;
+  }
+  return CompareToBaseline(benchmarkName, result, baselineFileName, tolerancePercent) == PLUS_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus ConnectToDevices(fCalMainWindow& mainWindow, const std::string& configFileName)
+{
+  // Same as selecting the configuration file and pressing Connect in the Configuration toolbox
+  QAbstractToolbox* configurationToolbox = ActivateToolbox(mainWindow, ToolboxType_Configuration, "Configuration");
+  QObject* configurationToolboxObject = dynamic_cast<QObject*>(configurationToolbox);
+  if (configurationToolboxObject == NULL
+      || !QMetaObject::invokeMethod(configurationToolboxObject, "ConnectToDevicesByConfigFile", Qt::DirectConnection, Q_ARG(std::string, configFileName)))
+  {
+    LOG_ERROR("Unable to connect through the Configuration toolbox");
+    return PLUS_FAIL;
+  }
+  if (mainWindow.GetVisualizationController()->GetDataCollector() == NULL || mainWindow.GetSelectedChannel() == NULL)
+  {
+    return PLUS_FAIL;
+  }
+
+  // Let the simulated devices fill their buffers
+  ProcessEvents(1.0);
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+QAbstractToolbox* ActivateToolbox(fCalMainWindow& mainWindow, ToolboxType toolboxType, const QString& toolboxTitle)
+{
+  // Same as clicking on the title of the toolbox, the main window activates the toolbox when the current item changes
+  QToolBox* toolboxWidget = mainWindow.findChild<QToolBox*>("toolbox");
+  if (toolboxWidget == NULL)
+  {
+    LOG_ERROR("Toolbox widget is not found in the main window");
+    return NULL;
+  }
+  for (int itemIndex = 0; itemIndex < toolboxWidget->count(); ++itemIndex)
+  {
+    if (toolboxWidget->itemText(itemIndex) == toolboxTitle)
+    {
+      toolboxWidget->setCurrentIndex(itemIndex);
+      return mainWindow.GetToolbox(toolboxType);
+    }
+  }
+  LOG_ERROR("No toolbox with title " << toolboxTitle.toStdString() << " found");
+  return NULL;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus InvokeToolboxSlot(QAbstractToolbox* toolbox, const char* slotName)
+{
+  // The toolbox slots are the handlers of the buttons, they are invoked the same way as by the button signals
+  QObject* toolboxObject = dynamic_cast<QObject*>(toolbox);
+  if (toolboxObject == NULL || !QMetaObject::invokeMethod(toolboxObject, slotName, Qt::DirectConnection))
+  {
+    LOG_ERROR("Unable to invoke toolbox slot " << slotName);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void ProcessEvents(double durationSec)
+{
+  // The acquisition timer of the visualization controller and the UI refresh timer of the main window keep running meanwhile
+  QEventLoop eventLoop;
+  QTimer::singleShot(static_cast<int>(durationSec * 1000.0), &eventLoop, SLOT(quit()));
+  eventLoop.exec();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus WaitForToolboxState(QAbstractToolbox* toolbox, ToolboxState state, double timeoutSec)
+{
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  while (toolbox->GetState() != state)
+  {
+    if (toolbox->GetState() == ToolboxState_Error)
+    {
+      LOG_ERROR("Toolbox is in error state");
+      return PLUS_FAIL;
+    }
+    if (vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec > timeoutSec)
+    {
+      LOG_ERROR("Toolbox did not finish in " << timeoutSec << " s");
+      return PLUS_FAIL;
+    }
+    ProcessEvents(0.05);
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus RecordFrames(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result)
+{
+  // Record and Stop in the Capturing toolbox, the frames are collected by its recording sampler thread
+  QCapturingToolbox* capturingToolbox = dynamic_cast<QCapturingToolbox*>(ActivateToolbox(mainWindow, ToolboxType_Capturing, "Capturing"));
+  if (capturingToolbox == NULL)
+  {
+    return PLUS_FAIL;
+  }
+
+  PlusPerformanceMonitor* monitor = PlusPerformanceMonitor::GetInstance();
+  int recordTimerId = monitor->RegisterTimer("CapturingRecordFrames");
+  PlusPerformanceMonitor::Statistics recordStatisticsBefore = monitor->GetStatistics(recordTimerId);
+
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  if (InvokeToolboxSlot(capturingToolbox, "Record") != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  ProcessEvents(durationSec);
+  if (InvokeToolboxSlot(capturingToolbox, "Stop") != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  result.ElapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+  result.Latency = monitor->GetStatistics(recordTimerId) - recordStatisticsBefore;
+  result.NumberOfFrames = capturingToolbox->GetRecordedFrames()->GetNumberOfTrackedFrames();
+
+  if (result.NumberOfFrames == 0)
+  {
+    LOG_ERROR("No frames were recorded");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus RunDisplayBenchmark(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result)
+{
+  // The acquisition timer of the visualization controller publishes and renders the frames, each published
+  // frame adds a sample to the acquisition to display latency of the performance monitor
+  PlusPerformanceMonitor* monitor = PlusPerformanceMonitor::GetInstance();
+  int latencyTimerId = monitor->RegisterTimer("AcquisitionToDisplayLatency");
+  int renderTimerId = monitor->RegisterTimer("Render");
+  PlusPerformanceMonitor::Statistics latencyStatisticsBefore = monitor->GetStatistics(latencyTimerId);
+  PlusPerformanceMonitor::Statistics renderStatisticsBefore = monitor->GetStatistics(renderTimerId);
+
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  ProcessEvents(durationSec);
+  result.ElapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+
+  result.Latency = monitor->GetStatistics(latencyTimerId) - latencyStatisticsBefore;
+  result.NumberOfFrames = static_cast<int>(result.Latency.Count);
+  PlusPerformanceMonitor::Statistics renderStatistics = monitor->GetStatistics(renderTimerId) - renderStatisticsBefore;
+  LOG_INFO("Rendering: " << renderStatistics.Count << " times, mean " << std::fixed << std::setprecision(3) << renderStatistics.GetMeanMs() << " ms, p95 " << renderStatistics.GetPercentileMs(0.95) << " ms");
+
+  if (result.NumberOfFrames == 0)
+  {
+    LOG_ERROR("No frames were displayed");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus RunSpatialCalibrationBenchmark(fCalMainWindow& mainWindow, double timeoutSec, BenchmarkResult& result)
+{
+  // Start spatial calibration in the toolbox and wait until it acquires, segments and calibrates,
+  // each acquisition step of the toolbox is a sample of its performance monitor timer
+  QAbstractToolbox* spatialCalibrationToolbox = ActivateToolbox(mainWindow, ToolboxType_SpatialCalibration, "Spatial calibration");
+  if (spatialCalibrationToolbox == NULL)
+  {
+    return PLUS_FAIL;
+  }
+
+  PlusPerformanceMonitor* monitor = PlusPerformanceMonitor::GetInstance();
+  int acquisitionTimerId = monitor->RegisterTimer("SpatialCalibrationAcquisition");
+  PlusPerformanceMonitor::Statistics acquisitionStatisticsBefore = monitor->GetStatistics(acquisitionTimerId);
+
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  if (InvokeToolboxSlot(spatialCalibrationToolbox, "StartCalibration") != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (WaitForToolboxState(spatialCalibrationToolbox, ToolboxState_Done, timeoutSec) != PLUS_SUCCESS)
+  {
+    InvokeToolboxSlot(spatialCalibrationToolbox, "CancelCalibration");
+    LOG_ERROR("Spatial calibration failed");
+    return PLUS_FAIL;
+  }
+  result.ElapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+  result.Latency = monitor->GetStatistics(acquisitionTimerId) - acquisitionStatisticsBefore;
+  result.NumberOfFrames = static_cast<int>(result.Latency.Count);
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus RunCaptureBenchmark(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result)
+{
+  return RecordFrames(mainWindow, durationSec, result);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus RunVolumeReconstructionBenchmark(fCalMainWindow& mainWindow, double durationSec, BenchmarkResult& result)
+{
+  // Record frames in the Capturing toolbox, then reconstruct the unsaved recording in the Volume reconstruction toolbox
+  BenchmarkResult recordingResult;
+  if (RecordFrames(mainWindow, durationSec, recordingResult) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  QAbstractToolbox* volumeReconstructionToolbox = ActivateToolbox(mainWindow, ToolboxType_VolumeReconstruction, "Volume reconstruction");
+  if (volumeReconstructionToolbox == NULL)
+  {
+    return PLUS_FAIL;
+  }
+  ResetPeakMemory();
+
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  if (InvokeToolboxSlot(volumeReconstructionToolbox, "Reconstruct") != PLUS_SUCCESS
+      || volumeReconstructionToolbox->GetState() != ToolboxState_Done)
+  {
+    LOG_ERROR("Volume reconstruction failed");
+    return PLUS_FAIL;
+  }
+  result.ElapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+  result.NumberOfFrames = recordingResult.NumberOfFrames;
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus CompareToBaseline(const std::string& benchmarkName, const BenchmarkResult& result, const std::string& baselineFileName, double tolerancePercent)
+{
+  vtkSmartPointer<vtkXMLDataElement> baselineElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromFile(baselineFileName.c_str()));
+  if (baselineElement == NULL || baselineElement->GetAttribute("Benchmark") == NULL || !igsioCommon::IsEqualInsensitive(baselineElement->GetAttribute("Benchmark"), benchmarkName))
+  {
+    LOG_ERROR("Unable to read baseline of benchmark " << benchmarkName << " from file " << baselineFileName);
+    return PLUS_FAIL;
+  }
+  double baselineFramesPerSecond = 0.0;
+  double baselineLatencyP95Ms = 0.0;
+  double baselinePeakMemoryMb = 0.0;
+  if (!baselineElement->GetScalarAttribute("FramesPerSecond", baselineFramesPerSecond)
+      || !baselineElement->GetScalarAttribute("LatencyP95Ms", baselineLatencyP95Ms)
+      || !baselineElement->GetScalarAttribute("PeakMemoryMb", baselinePeakMemoryMb))
+  {
+    LOG_ERROR("FramesPerSecond, LatencyP95Ms or PeakMemoryMb is missing from baseline file " << baselineFileName);
+    return PLUS_FAIL;
+  }
+
+  double tolerance = tolerancePercent / 100.0;
+  PlusStatus status = PLUS_SUCCESS;
+  if (result.GetFramesPerSecond() < baselineFramesPerSecond * (1.0 - tolerance))
+  {
+    LOG_ERROR("Frame rate regression: " << result.GetFramesPerSecond() << " fps (baseline: " << baselineFramesPerSecond << " fps)");
+    status = PLUS_FAIL;
+  }
+  if (baselineLatencyP95Ms > 0 && result.GetLatencyPercentileMs(0.95) > baselineLatencyP95Ms * (1.0 + tolerance))
+  {
+    LOG_ERROR("Latency regression: p95 " << result.GetLatencyPercentileMs(0.95) << " ms (baseline: " << baselineLatencyP95Ms << " ms)");
+    status = PLUS_FAIL;
+  }
+  if (baselinePeakMemoryMb > 0 && result.PeakMemoryMb > baselinePeakMemoryMb * (1.0 + tolerance))
+  {
+    LOG_ERROR("Memory usage regression: " << result.PeakMemoryMb << " MB (baseline: " << baselinePeakMemoryMb << " MB)");
+    status = PLUS_FAIL;
+  }
+  if (status == PLUS_SUCCESS)
+  {
+    LOG_INFO("Performance is within " << tolerancePercent << "% of the baseline");
+  }
+  return status;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus WriteBaseline(const std::string& benchmarkName, const BenchmarkResult& result, const std::string& baselineFileName)
+{
+  vtkSmartPointer<vtkXMLDataElement> baselineElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  baselineElement->SetName("PerformanceBaseline");
+  baselineElement->SetAttribute("Benchmark", benchmarkName.c_str());
+  baselineElement->SetIntAttribute("NumberOfFrames", result.NumberOfFrames);
+  baselineElement->SetDoubleAttribute("FramesPerSecond", result.GetFramesPerSecond());
+  baselineElement->SetDoubleAttribute("LatencyP95Ms", result.GetLatencyPercentileMs(0.95));
+  baselineElement->SetDoubleAttribute("PeakMemoryMb", result.PeakMemoryMb);
+  baselineElement->SetAttribute("Date", vtkIGSIOAccurateTimer::GetInstance()->GetDateAndTimeString().c_str());
+  vtksys::SystemTools::MakeDirectory(vtksys::SystemTools::GetFilenamePath(baselineFileName));
+  if (igsioCommon::XML::PrintXML(baselineFileName, baselineElement) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Failed to write baseline file " << baselineFileName);
+    return PLUS_FAIL;
+  }
+  LOG_INFO("Baseline written to " << baselineFileName);
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void ResetPeakMemory()
+{
+#if defined(__linux__)
+  // Resets the peak resident set size (VmHWM) of the process
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  if (clearRefs.is_open())
+  {
+    clearRefs << "5";
+  }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+double GetPeakMemoryMb()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+  }
+#elif defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+  }
+#elif defined(__linux__)
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+    {
+      return atof(line.c_str() + 6) / 1024.0;
+    }
+  }
+#endif
+  return 0.0;
+}
@@ -0,0 +1,378 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+/*
+* This test inserts synthetic frames with known poses into a vtkPlusBrickedVolume and checks the voxel extent,
+* the number of bricks and the voxel values of the dense volume (compounding, negative brick indices, subsampling).
+* Frames that are outside of the representable volume must be rejected.
+* The test is repeated with a resident memory limit of a few bricks, so the bricks are swapped out and mapped again,
+* and the volume written into a metafile is compared to the dense volume.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusBrickedVolume.h"
+#include "vtkDirectory.h"
+#include "vtkImageData.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMetaImageReader.h"
+#include "vtkSmartPointer.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include <cstring>
+#include <limits>
+
+namespace
+{
+  const int FRAME_SIZE[2] = {8, 6};
+  const int BRICK_SIZE = 4;
+  const double FRAME_ORIGIN[3] = { -5, -3, -2 }; // voxel position of the first pixel of the frames
+  const int SECOND_SLICE_Z = 3; // z position of the frame that is inserted apart from the first two
+  const double MAX_RESIDENT_MEMORY_MB = 0.001; // a brick of 4^3 voxels takes 384 bytes, so only 2 of them fit
+  const char SWAP_FILE_PREFIX[] = "PlusBrickedVolume_";
+
+  //-----------------------------------------------------------------------------
+  /*! Value of the first inserted frame at a pixel, the second frame at the same position is larger by 2 */
+  int GetPixelValue(int aColumn, int aRow)
+  {
+    return aColumn + FRAME_SIZE[0] * aRow + 1;
+  }
+
+  //-----------------------------------------------------------------------------
+  vtkSmartPointer<vtkImageData> CreateFrame(int aValueOffset, bool aUseRowValue)
+  {
+    vtkSmartPointer<vtkImageData> frame = vtkSmartPointer<vtkImageData>::New();
+    frame->SetExtent(0, FRAME_SIZE[0] - 1, 0, FRAME_SIZE[1] - 1, 0, 0);
+    frame->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    unsigned char* pixels = static_cast<unsigned char*>(frame->GetScalarPointer());
+    for (int row = 0; row < FRAME_SIZE[1]; ++row)
+    {
+      for (int column = 0; column < FRAME_SIZE[0]; ++column)
+      {
+        pixels[row * FRAME_SIZE[0] + column] = static_cast<unsigned char>(aValueOffset + (aUseRowValue ? GetPixelValue(column, row) : column));
+      }
+    }
+    return frame;
+  }
+
+  //-----------------------------------------------------------------------------
+  vtkSmartPointer<vtkMatrix4x4> CreatePose(double aX, double aY, double aZ)
+  {
+    vtkSmartPointer<vtkMatrix4x4> imageToVolume = vtkSmartPointer<vtkMatrix4x4>::New();
+    imageToVolume->SetElement(0, 3, aX);
+    imageToVolume->SetElement(1, 3, aY);
+    imageToVolume->SetElement(2, 3, aZ);
+    return imageToVolume;
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Insert two frames at the same position (their values are averaged) and a third one a few slices away */
+  PlusStatus InsertTestFrames(vtkPlusBrickedVolume* aVolume)
+  {
+    if (aVolume->InsertFrame(CreateFrame(0, true), CreatePose(FRAME_ORIGIN[0], FRAME_ORIGIN[1], FRAME_ORIGIN[2])) != PLUS_SUCCESS
+        || aVolume->InsertFrame(CreateFrame(2, true), CreatePose(FRAME_ORIGIN[0], FRAME_ORIGIN[1], FRAME_ORIGIN[2])) != PLUS_SUCCESS
+        || aVolume->InsertFrame(CreateFrame(100, false), CreatePose(FRAME_ORIGIN[0], FRAME_ORIGIN[1], SECOND_SLICE_Z)) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to insert the test frames");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Expected value of the dense volume at a voxel index of the full resolution volume */
+  int GetExpectedVoxelValue(int aX, int aY, int aZ)
+  {
+    if (aZ == 0)
+    {
+      return GetPixelValue(aX, aY) + 1;
+    }
+    if (aZ == SECOND_SLICE_Z - FRAME_ORIGIN[2])
+    {
+      return 100 + aX;
+    }
+    return 0;
+  }
+
+  //-----------------------------------------------------------------------------
+  PlusStatus CheckDenseVolume(vtkPlusBrickedVolume* aVolume, int aSubsampling)
+  {
+    vtkSmartPointer<vtkImageData> denseVolume = vtkSmartPointer<vtkImageData>::New();
+    if (aVolume->GetDenseVolume(denseVolume, aSubsampling) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get the dense volume (subsampling: " << aSubsampling << ")");
+      return PLUS_FAIL;
+    }
+
+    const int expectedFullSize[3] = { FRAME_SIZE[0], FRAME_SIZE[1], static_cast<int>(SECOND_SLICE_Z - FRAME_ORIGIN[2]) + 1 };
+    int dimensions[3] = {0};
+    denseVolume->GetDimensions(dimensions);
+    double origin[3] = {0};
+    denseVolume->GetOrigin(origin);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (dimensions[axis] != (expectedFullSize[axis] - 1) / aSubsampling + 1 || origin[axis] != FRAME_ORIGIN[axis] || denseVolume->GetSpacing()[axis] != aSubsampling)
+      {
+        LOG_ERROR("Unexpected geometry of the dense volume along axis " << axis << " (subsampling: " << aSubsampling << "): dimension " << dimensions[axis]
+                  << ", origin " << origin[axis] << ", spacing " << denseVolume->GetSpacing()[axis]);
+        return PLUS_FAIL;
+      }
+    }
+    if (denseVolume->GetScalarType() != VTK_UNSIGNED_CHAR)
+    {
+      LOG_ERROR("Unexpected scalar type of the dense volume: " << denseVolume->GetScalarTypeAsString());
+      return PLUS_FAIL;
+    }
+
+    for (int z = 0; z < dimensions[2]; ++z)
+    {
+      for (int y = 0; y < dimensions[1]; ++y)
+      {
+        for (int x = 0; x < dimensions[0]; ++x)
+        {
+          int value = *static_cast<unsigned char*>(denseVolume->GetScalarPointer(x, y, z));
+          int expectedValue = GetExpectedVoxelValue(x * aSubsampling, y * aSubsampling, z * aSubsampling);
+          if (value != expectedValue)
+          {
+            LOG_ERROR("Unexpected voxel value at (" << x << ", " << y << ", " << z << ") with subsampling " << aSubsampling << ": " << value << " (expected: " << expectedValue << ")");
+            return PLUS_FAIL;
+          }
+        }
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //-----------------------------------------------------------------------------
+  PlusStatus TestInMemoryVolume()
+  {
+    vtkSmartPointer<vtkPlusBrickedVolume> volume = vtkSmartPointer<vtkPlusBrickedVolume>::New();
+    volume->SetBrickSize(BRICK_SIZE);
+    if (InsertTestFrames(volume) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    int extent[6] = {0};
+    const int expectedExtent[6] = { -5, 2, -3, 2, -2, SECOND_SLICE_Z };
+    if (!volume->GetVoxelExtent(extent) || !std::equal(extent, extent + 6, expectedExtent))
+    {
+      LOG_ERROR("Unexpected voxel extent: " << extent[0] << " " << extent[1] << " " << extent[2] << " " << extent[3] << " " << extent[4] << " " << extent[5]);
+      return PLUS_FAIL;
+    }
+
+    // x -5..2 and y -3..2 cover 3 x 2 bricks of 4 voxels, z -2 and 3 fall into two different bricks
+    if (volume->GetNumberOfBricks() != 12)
+    {
+      LOG_ERROR("Unexpected number of bricks: " << volume->GetNumberOfBricks() << " (expected: 12)");
+      return PLUS_FAIL;
+    }
+
+    if (CheckDenseVolume(volume, 1) != PLUS_SUCCESS || CheckDenseVolume(volume, 2) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    // Frames that are far off or have an invalid pose cannot be pasted and must not change the volume
+    LOG_INFO("Insert frames outside of the representable volume, errors are expected");
+    const double invalidPositions[3] = { 1e12, -1e12, std::numeric_limits<double>::quiet_NaN() };
+    for (int positionIndex = 0; positionIndex < 3; ++positionIndex)
+    {
+      if (volume->InsertFrame(CreateFrame(0, true), CreatePose(0, invalidPositions[positionIndex], 0)) == PLUS_SUCCESS)
+      {
+        LOG_ERROR("Frame at y = " << invalidPositions[positionIndex] << " was inserted");
+        return PLUS_FAIL;
+      }
+    }
+    if (!volume->GetVoxelExtent(extent) || !std::equal(extent, extent + 6, expectedExtent) || volume->GetNumberOfBricks() != 12)
+    {
+      LOG_ERROR("The volume changed when inserting invalid frames");
+      return PLUS_FAIL;
+    }
+
+    volume->Reset();
+    if (volume->GetVoxelExtent(extent) || volume->GetNumberOfBricks() != 0)
+    {
+      LOG_ERROR("The volume is not empty after Reset");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //-----------------------------------------------------------------------------
+  int GetNumberOfSwapFiles(const std::string& aSwapDirectory)
+  {
+    vtkSmartPointer<vtkDirectory> directory = vtkSmartPointer<vtkDirectory>::New();
+    if (!directory->Open(aSwapDirectory.c_str()))
+    {
+      LOG_ERROR("Failed to open directory " << aSwapDirectory);
+      return -1;
+    }
+    int numberOfSwapFiles = 0;
+    for (vtkIdType fileIndex = 0; fileIndex < directory->GetNumberOfFiles(); ++fileIndex)
+    {
+      if (strncmp(directory->GetFile(fileIndex), SWAP_FILE_PREFIX, strlen(SWAP_FILE_PREFIX)) == 0)
+      {
+        numberOfSwapFiles++;
+      }
+    }
+    return numberOfSwapFiles;
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Write the volume into a metafile, read it back and compare it to the dense volume */
+  PlusStatus CheckMetafile(vtkPlusBrickedVolume* aVolume, const std::string& aFileName)
+  {
+    if (aVolume->WriteToMetafile(aFileName) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write the volume into " << aFileName);
+      return PLUS_FAIL;
+    }
+
+    vtkSmartPointer<vtkMetaImageReader> reader = vtkSmartPointer<vtkMetaImageReader>::New();
+    reader->SetFileName(aFileName.c_str());
+    reader->Update();
+    vtkImageData* writtenVolume = reader->GetOutput();
+
+    vtkSmartPointer<vtkImageData> denseVolume = vtkSmartPointer<vtkImageData>::New();
+    if (aVolume->GetDenseVolume(denseVolume) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get the dense volume");
+      return PLUS_FAIL;
+    }
+
+    int writtenDimensions[3] = {0};
+    writtenVolume->GetDimensions(writtenDimensions);
+    int denseDimensions[3] = {0};
+    denseVolume->GetDimensions(denseDimensions);
+    double writtenOrigin[3] = {0};
+    writtenVolume->GetOrigin(writtenOrigin);
+    double denseOrigin[3] = {0};
+    denseVolume->GetOrigin(denseOrigin);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (writtenDimensions[axis] != denseDimensions[axis] || writtenOrigin[axis] != denseOrigin[axis] || writtenVolume->GetSpacing()[axis] != denseVolume->GetSpacing()[axis])
+      {
+        LOG_ERROR("Geometry of the metafile differs from the dense volume along axis " << axis << ": dimension " << writtenDimensions[axis] << " (expected: " << denseDimensions[axis]
+                  << "), origin " << writtenOrigin[axis] << " (expected: " << denseOrigin[axis] << ")");
+        return PLUS_FAIL;
+      }
+    }
+    if (writtenVolume->GetScalarType() != denseVolume->GetScalarType() || writtenVolume->GetNumberOfScalarComponents() != denseVolume->GetNumberOfScalarComponents())
+    {
+      LOG_ERROR("Scalar type of the metafile differs from the dense volume: " << writtenVolume->GetScalarTypeAsString() << " (expected: " << denseVolume->GetScalarTypeAsString() << ")");
+      return PLUS_FAIL;
+    }
+
+    const size_t volumeSizeBytes = static_cast<size_t>(denseDimensions[0]) * denseDimensions[1] * denseDimensions[2] * denseVolume->GetScalarSize();
+    if (memcmp(writtenVolume->GetScalarPointer(), denseVolume->GetScalarPointer(), volumeSizeBytes) != 0)
+    {
+      LOG_ERROR("Voxel values of the metafile differ from the dense volume");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //-----------------------------------------------------------------------------
+  PlusStatus TestOutOfCoreVolume(const std::string& aOutputDirectory)
+  {
+    if (GetNumberOfSwapFiles(aOutputDirectory) != 0)
+    {
+      LOG_ERROR("Swap files of a previous run are left in " << aOutputDirectory);
+      return PLUS_FAIL;
+    }
+
+    vtkSmartPointer<vtkPlusBrickedVolume> volume = vtkSmartPointer<vtkPlusBrickedVolume>::New();
+    volume->SetBrickSize(BRICK_SIZE);
+    volume->SetMaxResidentMemoryMb(MAX_RESIDENT_MEMORY_MB);
+    volume->SetSwapDirectory(aOutputDirectory);
+    if (InsertTestFrames(volume) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    if (volume->GetNumberOfBricks() != 12 || volume->GetResidentMemoryMb() > MAX_RESIDENT_MEMORY_MB)
+    {
+      LOG_ERROR("Bricks are not swapped out: " << volume->GetNumberOfBricks() << " bricks, " << volume->GetResidentMemoryMb() << " MB resident (limit: " << MAX_RESIDENT_MEMORY_MB << " MB)");
+      return PLUS_FAIL;
+    }
+    if (GetNumberOfSwapFiles(aOutputDirectory) <= 0)
+    {
+      LOG_ERROR("No swap file is created in " << aOutputDirectory);
+      return PLUS_FAIL;
+    }
+
+    // Reading the volume maps the swapped out bricks again
+    if (CheckDenseVolume(volume, 1) != PLUS_SUCCESS || CheckDenseVolume(volume, 2) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (CheckMetafile(volume, aOutputDirectory + "/vtkPlusBrickedVolumeTest.mha") != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (volume->GetResidentMemoryMb() > MAX_RESIDENT_MEMORY_MB)
+    {
+      LOG_ERROR("Resident memory exceeds the limit after reading the volume: " << volume->GetResidentMemoryMb() << " MB");
+      return PLUS_FAIL;
+    }
+
+    volume->Reset();
+    if (GetNumberOfSwapFiles(aOutputDirectory) != 0)
+    {
+      LOG_ERROR("Swap files are not removed by Reset");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  std::string outputDirectory;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--output-dir", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputDirectory, "Directory of the swap files and the written metafile.");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  if (outputDirectory.empty())
+  {
+    std::cerr << "--output-dir is required" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestInMemoryVolume() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("In-memory bricked volume test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestOutOfCoreVolume(outputDirectory) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Out-of-core bricked volume test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
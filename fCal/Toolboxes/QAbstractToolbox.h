@@ -7,8 +7,12 @@
 #ifndef __QAbstractToolbox_h
 #define __QAbstractToolbox_h
 
+#include <igsioTransformName.h>
+
 #include <QApplication>
 
+#include <vector>
+
 class fCalMainWindow;
 
 //-----------------------------------------------------------------------------
@@ -25,6 +29,19 @@ enum ToolboxState
 
 //-----------------------------------------------------------------------------
 
+/*! Events that make a toolbox refresh its content. They can be combined. */
+enum ToolboxRefreshTrigger
+{
+  ToolboxRefreshTrigger_None = 0x00,
+  ToolboxRefreshTrigger_NewData = 0x01,           //!< New video or tracking data arrived on the selected channel
+  ToolboxRefreshTrigger_StateChanged = 0x02,      //!< The toolbox state changed or a refresh was requested explicitly
+  ToolboxRefreshTrigger_TransformChanged = 0x04,  //!< One of the transforms returned by GetWatchedTransformNames() changed
+  ToolboxRefreshTrigger_Timer = 0x08,             //!< Every tick of the UI refresh timer (for countdowns and progress)
+  ToolboxRefreshTrigger_All = 0x0F
+};
+
+//-----------------------------------------------------------------------------
+
 /*! \class QAbstractToolbox
  * \brief This class is the super class of all the toolboxes for standard handling
  * \ingroup PlusAppFCal
@@ -38,6 +55,8 @@ public:
     m_BusyCursorSet = false;
     m_ParentMainWindow = aParentMainWindow;
     m_State = ToolboxState_Uninitialized;
+    m_PendingRefreshTriggers = ToolboxRefreshTrigger_All;
+    m_CurrentRefreshTriggers = ToolboxRefreshTrigger_All;
   };
 
   /*! \brief Destructor */
@@ -46,6 +65,50 @@ public:
   /*! \brief Refresh contents (e.g. GUI elements) of toolbox according to the state in the toolbox controller - pure virtual function */
   virtual void RefreshContent() = 0;
 
+  /*!
+  * \brief Events that the toolbox content depends on, the main window only refreshes the toolbox when one of them occurred.
+  * The default is all events (refresh at every UI refresh tick), toolboxes override it to avoid refreshing unchanged widgets.
+  * \return Combination of ToolboxRefreshTrigger values, may depend on the current state
+  */
+  virtual int GetRefreshTriggers()
+  {
+    return ToolboxRefreshTrigger_All;
+  };
+
+  /*! \brief Transforms that are displayed by the toolbox, a change of any of them triggers ToolboxRefreshTrigger_TransformChanged */
+  virtual std::vector<igsioTransformName> GetWatchedTransformNames()
+  {
+    return std::vector<igsioTransformName>();
+  };
+
+  /*!
+  * \brief Mark the toolbox content as outdated. The refresh is done at the next UI refresh tick if the toolbox subscribed to any of the triggers.
+  * \param aTriggers Combination of ToolboxRefreshTrigger values that occurred
+  */
+  void RequestRefresh(int aTriggers = ToolboxRefreshTrigger_StateChanged)
+  {
+    m_PendingRefreshTriggers |= aTriggers;
+  };
+
+  /*!
+  * \brief Refresh content if any of the subscribed events occurred since the last refresh
+  * \return True if the content was refreshed
+  */
+  bool RefreshContentIfRequested()
+  {
+    int triggers = m_PendingRefreshTriggers & GetRefreshTriggers();
+    m_PendingRefreshTriggers = ToolboxRefreshTrigger_None;
+    if (triggers == ToolboxRefreshTrigger_None)
+    {
+      return false;
+    }
+    m_CurrentRefreshTriggers = triggers;
+    RefreshContent();
+    // Direct calls of RefreshContent() refresh everything
+    m_CurrentRefreshTriggers = ToolboxRefreshTrigger_All;
+    return true;
+  };
+
   /*! \brief Load session data and update view when the toolbox is activated - pure virtual function */
   virtual void OnActivated() = 0;
 
@@ -70,6 +133,7 @@ public:
   {
     m_State = aState;
     SetDisplayAccordingToState();
+    RequestRefresh(ToolboxRefreshTrigger_StateChanged);
   };
 
   /*!
@@ -104,6 +168,21 @@ protected:
 
   //! Helper for setting busy cursor instead of push/pop its state
   bool m_BusyCursorSet;
+
+  /*!
+  * \brief Check what made the toolbox refresh, so that RefreshContent() can skip the widgets that did not change
+  * \param aTriggers Combination of ToolboxRefreshTrigger values
+  */
+  bool IsRefreshTriggeredBy(int aTriggers)
+  {
+    return (m_CurrentRefreshTriggers & aTriggers) != 0;
+  };
+
+  //! Events that occurred since the last refresh
+  int m_PendingRefreshTriggers;
+
+  //! Events that caused the refresh in progress
+  int m_CurrentRefreshTriggers;
 };
 
 #endif
\ No newline at end of file
@@ -6,7 +6,10 @@ See License.txt for details.
 
 // Local includes
 #include "PlusCaptureControlWidget.h"
+#include "PlusPerformanceMonitor.h"
 #include "QCapturingToolbox.h"
+#include "QPlusCaptureWriterPool.h"
+#include "QPlusRecordingSampler.h"
 #include "QVolumeReconstructionToolbox.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusVisualizationController.h"
@@ -27,27 +30,28 @@ See License.txt for details.
 #include <QScrollArea>
 #include <QSpacerItem>
 #include <QString>
-#include <QTimer>
 
-static const int MAX_ALLOWED_RECORDING_LAG_SEC = 3.0; // if the recording lags more than this then it'll skip frames to catch up
+// STL includes
+#include <algorithm>
+#include <iomanip>
 
 //-----------------------------------------------------------------------------
 QCapturingToolbox::QCapturingToolbox(fCalMainWindow* aParentMainWindow, Qt::WindowFlags aFlags)
   : QAbstractToolbox(aParentMainWindow)
   , QWidget(aParentMainWindow, aFlags)
   , m_RecordedFrames(NULL)
-  , m_RecordingTimer(NULL)
-  , m_RecordingLastAlreadyRecordedFrameTimestamp(UNDEFINED_TIMESTAMP)
-  , m_RecordingNextFrameToBeRecordedTimestamp(0.0)
+  , m_RecordingSampler(NULL)
   , m_SamplingFrameRate(8)
   , m_RequestedFrameRate(0.0)
-  , m_ActualFrameRate(0.0)
+  , m_UseCompression(true)
+  , m_CaptureFileExtension(".mha")
+  , m_CaptureWriterPool(NULL)
+  , m_CaptureActiveAtLastRefresh(false)
 {
   ui.setupUi(this);
 
   // Create tracked frame list
-  m_RecordedFrames = vtkIGSIOTrackedFrameList::New();
-  m_RecordedFrames->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+  ReleaseRecordedFrames();
 
   // Connect events
   connect(ui.pushButton_Snapshot, SIGNAL(clicked()), this, SLOT(TakeSnapshot()));
@@ -60,9 +64,13 @@ QCapturingToolbox::QCapturingToolbox(fCalMainWindow* aParentMainWindow, Qt::Wind
   connect(ui.pushButton_StartStopAll, SIGNAL(clicked()), this, SLOT(StartStopAll()));
   connect(ui.horizontalSlider_SamplingRate, SIGNAL(valueChanged(int)), this, SLOT(SamplingRateChanged(int)));
 
-  // Create and connect recording timer
-  m_RecordingTimer = new QTimer(this);
-  connect(m_RecordingTimer, SIGNAL(timeout()), this, SLOT(Capture()));
+  // Create the sampler that records the frames on its own thread
+  m_RecordingSampler = new QPlusRecordingSampler(this);
+
+  // Create writer pool for saving all capture devices at once
+  m_CaptureWriterPool = new QPlusCaptureWriterPool(this);
+  connect(m_CaptureWriterPool, SIGNAL(FileFinished(vtkPlusVirtualCapture*, const QString&, bool, double, double)), this, SLOT(CaptureFileWritten(vtkPlusVirtualCapture*, const QString&, bool, double, double)));
+  connect(m_CaptureWriterPool, SIGNAL(SessionFinished(int, int, double)), this, SLOT(CaptureSessionWritten(int, int, double)));
 
   ui.pushButton_Save->setEnabled(m_RecordedFrames->GetNumberOfTrackedFrames() > 0);
   ui.pushButton_SaveAs->setEnabled(m_RecordedFrames->GetNumberOfTrackedFrames() > 0);
@@ -77,6 +85,9 @@ QCapturingToolbox::QCapturingToolbox(fCalMainWindow* aParentMainWindow, Qt::Wind
 //-----------------------------------------------------------------------------
 QCapturingToolbox::~QCapturingToolbox()
 {
+  // The sampler writes into the recorded frame list, stop it before deleting the list
+  m_RecordingSampler->StopSampling();
+
   if (m_RecordedFrames != NULL)
   {
     m_RecordedFrames->Delete();
@@ -92,6 +103,8 @@ void QCapturingToolbox::OnActivated()
   if ((m_ParentMainWindow->GetVisualizationController()->GetDataCollector() != NULL)
       && (m_ParentMainWindow->GetVisualizationController()->GetDataCollector()->GetConnected()))
   {
+    this->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+
     // Set initialized if it was uninitialized
     if (m_State == ToolboxState_Uninitialized || m_State == ToolboxState_Error)
     {
@@ -110,6 +123,53 @@ void QCapturingToolbox::OnActivated()
   }
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus QCapturingToolbox::ReadConfiguration(vtkXMLDataElement* aConfig)
+{
+  LOG_TRACE("CapturingToolbox::ReadConfiguration");
+
+  if (aConfig == NULL)
+  {
+    LOG_ERROR("Unable to read configuration");
+    return PLUS_FAIL;
+  }
+
+  vtkXMLDataElement* fCalElement = aConfig->FindNestedElementWithName("fCal");
+  if (fCalElement == NULL)
+  {
+    LOG_ERROR("Unable to find fCal element in XML tree");
+    return PLUS_FAIL;
+  }
+
+  const char* outputFileCompression = fCalElement->GetAttribute("OutputFileCompression");
+  if (outputFileCompression != NULL)
+  {
+    m_UseCompression = (STRCASECMP(outputFileCompression, "TRUE") == 0);
+  }
+
+  const char* captureFileExtension = fCalElement->GetAttribute("CaptureFileExtension");
+  if (captureFileExtension != NULL)
+  {
+    std::string extension = captureFileExtension;
+    if (STRCASECMP(extension.c_str(), ".mha") == 0 || STRCASECMP(extension.c_str(), ".nrrd") == 0 || STRCASECMP(extension.c_str(), ".seq.nrrd") == 0)
+    {
+      m_CaptureFileExtension = extension;
+    }
+    else
+    {
+      LOG_WARNING("Unsupported CaptureFileExtension '" << extension << "' in fCal element of the device set configuration, default value '" << m_CaptureFileExtension << "' will be used");
+    }
+  }
+
+  double capturePreTriggerSec = 0.0;
+  if (fCalElement->GetScalarAttribute("CapturePreTriggerSec", capturePreTriggerSec))
+  {
+    ui.doubleSpinBox_PreTriggerSec->setValue(capturePreTriggerSec);
+  }
+
+  return PLUS_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 void QCapturingToolbox::RefreshContent()
 {
@@ -117,12 +177,14 @@ void QCapturingToolbox::RefreshContent()
 
   if (m_State == ToolboxState_InProgress)
   {
-    ui.label_ActualRecordingFrameRate->setText(QString::number(m_ActualFrameRate, 'f', 2));
-    ui.label_NumberOfRecordedFrames->setText(QString::number(m_RecordedFrames->GetNumberOfTrackedFrames()));
+    // The frame list is being written by the sampler thread, only its statistics can be accessed
+    QPlusRecordingSampler::Statistics statistics = m_RecordingSampler->GetStatistics();
+    ui.label_ActualRecordingFrameRate->setText(QString::number(statistics.ActualFrameRate, 'f', 2));
+    ui.label_NumberOfRecordedFrames->setText(QString::number(statistics.NumberOfFrames));
   }
 
   ui.pushButton_SaveAll->setEnabled(false);
-  for (std::vector<PlusCaptureControlWidget*>::iterator it = m_CaptureWidgets.begin(); it != m_CaptureWidgets.end(); ++it)
+  for (std::vector<PlusCaptureControlWidget*>::iterator it = m_CaptureWidgets.begin(); it != m_CaptureWidgets.end() && !m_CaptureWriterPool->IsBusy(); ++it)
   {
     PlusCaptureControlWidget* widget = *it;
     if (widget->CanSave())
@@ -140,6 +202,34 @@ void QCapturingToolbox::RefreshContent()
     PlusCaptureControlWidget* widget = *it;
     widget->UpdateBasedOnState();
   }
+
+  m_CaptureActiveAtLastRefresh = IsCaptureActive();
+}
+
+//-----------------------------------------------------------------------------
+bool QCapturingToolbox::IsCaptureActive()
+{
+  bool captureActive = (m_State == ToolboxState_InProgress) || (m_CaptureWriterPool != NULL && m_CaptureWriterPool->IsBusy());
+  for (std::vector<PlusCaptureControlWidget*>::iterator it = m_CaptureWidgets.begin(); it != m_CaptureWidgets.end() && !captureActive; ++it)
+  {
+    vtkPlusVirtualCapture* device = (*it)->GetCaptureDevice();
+    if (device != NULL && device->GetEnableCapturing())
+    {
+      captureActive = true;
+    }
+  }
+
+  return captureActive;
+}
+
+//-----------------------------------------------------------------------------
+int QCapturingToolbox::GetRefreshTriggers()
+{
+  if (IsCaptureActive() || m_CaptureActiveAtLastRefresh)
+  {
+    return ToolboxRefreshTrigger_Timer | ToolboxRefreshTrigger_StateChanged;
+  }
+  return ToolboxRefreshTrigger_StateChanged;
 }
 
 //-----------------------------------------------------------------------------
@@ -251,6 +341,7 @@ void QCapturingToolbox::SetDisplayAccordingToState()
     ui.pushButton_Save->setEnabled(false);
     ui.pushButton_SaveAs->setEnabled(false);
     ui.horizontalSlider_SamplingRate->setEnabled(false);
+    ui.doubleSpinBox_PreTriggerSec->setEnabled(false);
   }
   else if (m_State == ToolboxState_Idle)
   {
@@ -264,6 +355,7 @@ void QCapturingToolbox::SetDisplayAccordingToState()
     ui.pushButton_Save->setEnabled(false);
     ui.pushButton_SaveAs->setEnabled(false);
     ui.horizontalSlider_SamplingRate->setEnabled(true);
+    ui.doubleSpinBox_PreTriggerSec->setEnabled(true);
 
     SamplingRateChanged(ui.horizontalSlider_SamplingRate->value());
 
@@ -283,6 +375,7 @@ void QCapturingToolbox::SetDisplayAccordingToState()
     ui.pushButton_Save->setEnabled(false);
     ui.pushButton_SaveAs->setEnabled(false);
     ui.horizontalSlider_SamplingRate->setEnabled(false);
+    ui.doubleSpinBox_PreTriggerSec->setEnabled(false);
 
     // Change the function to be invoked on clicking on the now Stop button
     disconnect(ui.pushButton_Record, SIGNAL(clicked()), this, SLOT(Record()));
@@ -299,6 +392,7 @@ void QCapturingToolbox::SetDisplayAccordingToState()
     ui.pushButton_Save->setEnabled(true);
     ui.pushButton_SaveAs->setEnabled(true);
     ui.horizontalSlider_SamplingRate->setEnabled(true);
+    ui.doubleSpinBox_PreTriggerSec->setEnabled(true);
 
     ui.label_ActualRecordingFrameRate->setText("0.00");
     ui.label_MaximumRecordingFrameRate->setText(QString::number(GetMaximumFrameRate()));
@@ -317,6 +411,7 @@ void QCapturingToolbox::SetDisplayAccordingToState()
     ui.pushButton_Save->setEnabled(false);
     ui.pushButton_SaveAs->setEnabled(false);
     ui.horizontalSlider_SamplingRate->setEnabled(false);
+    ui.doubleSpinBox_PreTriggerSec->setEnabled(false);
   }
 }
 
@@ -364,6 +459,7 @@ void QCapturingToolbox::TakeSnapshot()
   }
 
   // Add tracked frame to the list
+  DetachRecordedFrames();
   if (m_RecordedFrames->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS)
   {
     LOG_WARNING("Frame could not be added because validation failed!");
@@ -381,38 +477,46 @@ void QCapturingToolbox::Record()
   LOG_INFO("Capturing started");
 
   m_ParentMainWindow->SetToolboxesEnabled(false);
-  m_ActualFrameRate = 0.0; // display 0.00 until a real estimation is available
-
-  // Reset accessory members
-  m_RecordingFirstFrameIndexInThisSegment = m_RecordedFrames->GetNumberOfTrackedFrames();
 
   ui.plainTextEdit_saveResult->clear();
 
-  m_RecordingNextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
-  m_RecordingLastAlreadyRecordedFrameTimestamp = UNDEFINED_TIMESTAMP; // none yet
+  // The frames are appended to the current list
+  DetachRecordedFrames();
 
-  // Start capturing
-  SetState(ToolboxState_InProgress);
-  double samplingPeriodMsec = GetSamplingPeriodSec() * 1000.0;
-  m_RecordingTimer->start(samplingPeriodMsec);
-}
+  double nextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+  double lastAlreadyRecordedFrameTimestamp = UNDEFINED_TIMESTAMP; // none yet
+  double preTriggerBacklogSec = 0.0;
 
-//-----------------------------------------------------------------------------
-void QCapturingToolbox::Capture()
-{
-  //LOG_TRACE("CapturingToolbox::Capture");
+  // Start from data that is already in the device buffers, so the recording includes what happened just before pressing Record
+  double preTriggerSec = ui.doubleSpinBox_PreTriggerSec->value();
+  if (preTriggerSec > 0)
+  {
+    double recordingStartTimestamp = nextFrameToBeRecordedTimestamp - preTriggerSec;
+    double oldestTimestamp = UNDEFINED_TIMESTAMP;
+    if (m_ParentMainWindow->GetSelectedChannel()->GetOldestTimestamp(oldestTimestamp) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Unable to get the oldest timestamp of the selected channel, recording starts without pre-trigger data");
+      recordingStartTimestamp = nextFrameToBeRecordedTimestamp;
+    }
+    else if (recordingStartTimestamp < oldestTimestamp)
+    {
+      LOG_INFO("Only " << std::fixed << std::setprecision(1) << nextFrameToBeRecordedTimestamp - oldestTimestamp << " seconds of data are available in the device buffers, the requested pre-trigger is " << preTriggerSec << " seconds");
+      recordingStartTimestamp = oldestTimestamp;
+    }
 
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    // When appending to earlier recorded frames, do not go back before the last of them
+    if (m_RecordedFrames->GetNumberOfTrackedFrames() > 0)
+    {
+      double lastRecordedTimestamp = m_RecordedFrames->GetTrackedFrame(m_RecordedFrames->GetNumberOfTrackedFrames() - 1)->GetTimestamp();
+      recordingStartTimestamp = std::max(recordingStartTimestamp, lastRecordedTimestamp);
+      lastAlreadyRecordedFrameTimestamp = lastRecordedTimestamp;
+    }
 
-  vtkPlusDataCollector* dataCollector = NULL;
-  if ((m_ParentMainWindow == NULL) || (m_ParentMainWindow->GetVisualizationController() == NULL) || ((dataCollector = m_ParentMainWindow->GetVisualizationController()->GetDataCollector()) == NULL))
-  {
-    LOG_ERROR("Unable to reach valid data collector object!");
-    return;
+    preTriggerBacklogSec = std::max(nextFrameToBeRecordedTimestamp - recordingStartTimestamp, 0.0);
+    nextFrameToBeRecordedTimestamp = recordingStartTimestamp;
+    LOG_INFO("Recording includes " << std::fixed << std::setprecision(1) << preTriggerBacklogSec << " seconds of data acquired before pressing Record");
   }
 
-  // Record
-  double maxProcessingTimeSec = GetSamplingPeriodSec() * 2.0; // put a hard limit on the max processing time to make sure the application remains responsive during recording
   double requestedFramePeriodSec = 0.1;
   if (m_RequestedFrameRate > 0)
   {
@@ -422,59 +526,28 @@ void QCapturingToolbox::Capture()
   {
     LOG_WARNING("RequestedFrameRate is invalid");
   }
-  int nbFramesBefore = m_RecordedFrames->GetNumberOfTrackedFrames();
-  if (m_ParentMainWindow->GetSelectedChannel()->GetTrackedFrameListSampled(m_RecordingLastAlreadyRecordedFrameTimestamp, m_RecordingNextFrameToBeRecordedTimestamp, m_RecordedFrames, requestedFramePeriodSec, maxProcessingTimeSec) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Error while getting tracked frame list from data collector during capturing. Last recorded timestamp: " << std::fixed << m_RecordingNextFrameToBeRecordedTimestamp);
-  }
-  int nbFramesAfter = m_RecordedFrames->GetNumberOfTrackedFrames();
-
-  // Compute the average frame rate from the ratio of recently acquired frames
-  int frame1Index = m_RecordedFrames->GetNumberOfTrackedFrames() - 1; // index of the latest frame
-  int frame2Index = frame1Index - m_RequestedFrameRate * 5.0 - 1; // index of an earlier acquired frame (go back by approximately 5 seconds + one frame)
-  if (frame2Index < m_RecordingFirstFrameIndexInThisSegment)
-  {
-    // make sure we stay in the current recording segment
-    frame2Index = m_RecordingFirstFrameIndexInThisSegment;
-  }
-  if (frame1Index > frame2Index)
-  {
-    igsioTrackedFrame* frame1 = m_RecordedFrames->GetTrackedFrame(frame1Index);
-    igsioTrackedFrame* frame2 = m_RecordedFrames->GetTrackedFrame(frame2Index);
-    if (frame1 != NULL && frame2 != NULL)
-    {
-      double frameTimeDiff = frame1->GetTimestamp() - frame2->GetTimestamp();
-      if (frameTimeDiff > 0)
-      {
-        m_ActualFrameRate = (frame1Index - frame2Index) / frameTimeDiff;
-      }
-      else
-      {
-        m_ActualFrameRate = 0;
-      }
-    }
-  }
 
-  // Check whether the recording needed more time than the sampling interval
-  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
-  if (recordingTimeSec > GetSamplingPeriodSec())
-  {
-    LOG_WARNING("Recording of frames takes too long time (" << recordingTimeSec << "sec instead of the allocated " << GetSamplingPeriodSec() << "sec). This can cause slow-down of the application and non-uniform sampling. Reduce the acquisition rate or sampling rate to resolve the problem.");
-  }
-  double recordingLagSec = vtkIGSIOAccurateTimer::GetSystemTime() - m_RecordingNextFrameToBeRecordedTimestamp;
-  if (recordingLagSec > MAX_ALLOWED_RECORDING_LAG_SEC)
+  // Start capturing
+  if (m_RecordingSampler->StartSampling(m_ParentMainWindow->GetSelectedChannel(), m_RecordedFrames, requestedFramePeriodSec, GetSamplingPeriodSec(),
+                                        nextFrameToBeRecordedTimestamp, lastAlreadyRecordedFrameTimestamp, preTriggerBacklogSec) != PLUS_SUCCESS)
   {
-    LOG_ERROR("Recording cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up.");
-    m_RecordingNextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    LOG_ERROR("Failed to start capturing");
+    m_ParentMainWindow->SetToolboxesEnabled(true);
+    return;
   }
+  SetState(ToolboxState_InProgress);
 }
 
 //-----------------------------------------------------------------------------
 void QCapturingToolbox::Stop()
 {
-  LOG_INFO("Capturing stopped");
+  m_RecordingSampler->StopSampling();
+
+  QPlusRecordingSampler::Statistics statistics = m_RecordingSampler->GetStatistics();
+  LOG_INFO("Capturing stopped. Recorded " << statistics.NumberOfRecordedFrames << " frames at " << std::fixed << std::setprecision(2) << statistics.ActualFrameRate
+           << " fps, worst-case lag " << statistics.MaxLagSec << " sec, longest batch " << statistics.MaxBatchDurationSec * 1000.0 << " ms, "
+           << statistics.NumberOfMissedDeadlines << " missed sampling deadlines, " << statistics.SkippedSec << " sec skipped");
 
-  m_RecordingTimer->stop();
   SetState(ToolboxState_Done);
 
   m_ParentMainWindow->SetToolboxesEnabled(true);
@@ -486,7 +559,7 @@ void QCapturingToolbox::Save()
   LOG_TRACE("CapturingToolbox::Save");
 
   // TODO: just for testing
-  std::string defaultFileName = m_LastSaveLocation + "/TrackedImageSequence_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + ".mha";
+  std::string defaultFileName = m_LastSaveLocation + "/TrackedImageSequence_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + m_CaptureFileExtension;
   WriteToFile(QString(defaultFileName.c_str()));
 
   LOG_INFO("Captured tracked frame list saved into '" << defaultFileName << "'");
@@ -497,8 +570,8 @@ void QCapturingToolbox::SaveAs()
 {
   LOG_TRACE("CapturingToolbox::SaveAs");
 
-  std::string defaultFileName = m_LastSaveLocation + "/TrackedImageSequence_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + ".mha";
-  QString filter = QString(tr("SequenceMetaFiles (*.mha *.mhd);;"));
+  std::string defaultFileName = m_LastSaveLocation + "/TrackedImageSequence_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + m_CaptureFileExtension;
+  QString filter = QString(tr("SequenceMetaFiles (*.mha *.mhd);;Nrrd sequence files (*.seq.nrrd *.nrrd);;"));
   QString fileNameQt = QFileDialog::getSaveFileName(NULL, tr("Save captured tracked frames"), QString(defaultFileName.c_str()), filter);
   std::string fileName = fileNameQt.toLatin1().constData();
   m_LastSaveLocation = vtksys::SystemTools::GetFilenamePath(fileName.c_str());
@@ -519,10 +592,11 @@ void QCapturingToolbox::WriteToFile(const QString& aFilename)
 
   QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
 
-  // Actual saving
-  if (vtkPlusSequenceIO::Write(aFilename.toLatin1().constData(), m_RecordedFrames) != PLUS_SUCCESS)
+  // Actual saving, the file format is chosen from the extension
+  if (vtkPlusSequenceIO::Write(aFilename.toLatin1().constData(), m_RecordedFrames, US_IMG_ORIENT_MF, m_UseCompression) != PLUS_SUCCESS)
   {
-    LOG_ERROR("Failed to save tracked frames to sequence metafile!");
+    LOG_ERROR("Failed to save tracked frames to sequence file!");
+    QApplication::restoreOverrideCursor();
     return;
   }
 
@@ -530,11 +604,11 @@ void QCapturingToolbox::WriteToFile(const QString& aFilename)
   ui.plainTextEdit_saveResult->clear();
   ui.plainTextEdit_saveResult->insertPlainText(result);
 
-  // Add file name to image list in Volume reconstruction toolbox
+  // Add file name to image list in Volume reconstruction toolbox, along with the frames, so they need not be read back from the file
   QVolumeReconstructionToolbox* volumeReconstructionToolbox = dynamic_cast<QVolumeReconstructionToolbox*>(m_ParentMainWindow->GetToolbox(ToolboxType_VolumeReconstruction));
   if (volumeReconstructionToolbox != NULL)
   {
-    volumeReconstructionToolbox->AddImageFileName(aFilename);
+    volumeReconstructionToolbox->AddImageFileName(aFilename, m_RecordedFrames);
   }
 
   // Write the current state into the device set configuration XML
@@ -547,7 +621,7 @@ void QCapturingToolbox::WriteToFile(const QString& aFilename)
   std::string configFileName = path + "/" + filename + "_config.xml";
   igsioCommon::XML::PrintXML(configFileName, vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
 
-  m_RecordedFrames->Clear();
+  ReleaseRecordedFrames();
   SetState(ToolboxState_Idle);
 
   QApplication::restoreOverrideCursor();
@@ -612,17 +686,45 @@ void QCapturingToolbox::Reset()
 {
   QAbstractToolbox::Reset();
 
+  m_RecordingSampler->StopSampling();
   this->ClearRecordedFramesInternal();
 }
 
 //-----------------------------------------------------------------------------
 void QCapturingToolbox::ClearRecordedFramesInternal()
 {
-  m_RecordedFrames->Clear();
+  ReleaseRecordedFrames();
 
   SetState(ToolboxState_Idle);
 }
 
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::DetachRecordedFrames()
+{
+  // If the list is still used somewhere else, continue in a copy, as the shared list must not change
+  if (m_RecordedFrames->GetReferenceCount() > 1)
+  {
+    vtkIGSIOTrackedFrameList* recordedFrames = vtkIGSIOTrackedFrameList::New();
+    recordedFrames->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+    recordedFrames->AddTrackedFrameList(m_RecordedFrames);
+    m_RecordedFrames->Delete();
+    m_RecordedFrames = recordedFrames;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::ReleaseRecordedFrames()
+{
+  // Frames are not cleared from the list, as the Volume reconstruction toolbox may still use it.
+  // The list (and its frames) are deleted when the last holder releases it.
+  if (m_RecordedFrames != NULL)
+  {
+    m_RecordedFrames->Delete();
+  }
+  m_RecordedFrames = vtkIGSIOTrackedFrameList::New();
+  m_RecordedFrames->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+}
+
 //-----------------------------------------------------------------------------
 double QCapturingToolbox::GetSamplingPeriodSec()
 {
@@ -644,6 +746,14 @@ void QCapturingToolbox::HandleStatusMessage(const std::string& aMessage)
   ui.plainTextEdit_saveResult->clear();
   QString message(aMessage.c_str());
   ui.plainTextEdit_saveResult->insertPlainText(message);
+
+  RequestRefresh();
+}
+
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::CaptureWidgetStateChanged()
+{
+  RequestRefresh();
 }
 
 //-----------------------------------------------------------------------------
@@ -683,11 +793,84 @@ void QCapturingToolbox::ClearAll()
 //-----------------------------------------------------------------------------
 void QCapturingToolbox::SaveAll()
 {
+  LOG_TRACE("CapturingToolbox::SaveAll");
+
+  if (m_CaptureWriterPool->IsBusy())
+  {
+    LOG_WARNING("Previous save is still in progress");
+    return;
+  }
+
+  // Flush the configuration once, before the files are finalized in parallel
+  vtkPlusDataCollector* dataCollector = m_ParentMainWindow->GetVisualizationController()->GetDataCollector();
+  if (dataCollector != NULL)
+  {
+    dataCollector->WriteConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+  }
+
+  // All files of the session get the same time stamp in their names
+  std::string sessionId = vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S");
   for (std::vector<PlusCaptureControlWidget*>::iterator it = m_CaptureWidgets.begin(); it != m_CaptureWidgets.end(); ++it)
   {
     PlusCaptureControlWidget* widget = *it;
-    widget->SaveFile();
+    widget->SetEnableCapturing(false);
+    if (!widget->GetCaptureDevice()->HasUnsavedData())
+    {
+      continue;
+    }
+    if (m_CaptureWriterPool->AddJob(widget->GetCaptureDevice(), widget->GetOutputFilename(sessionId)) == PLUS_SUCCESS)
+    {
+      widget->SetSaveInProgress(true);
+    }
   }
+
+  int numberOfFiles = m_CaptureWriterPool->GetNumberOfJobs();
+  std::string manifestFileName = vtkPlusConfig::GetInstance()->GetOutputPath("CaptureSession_" + sessionId + ".xml");
+  if (m_CaptureWriterPool->Start(sessionId, manifestFileName) != PLUS_SUCCESS)
+  {
+    return;
+  }
+
+  ui.pushButton_SaveAll->setEnabled(false);
+  ui.plainTextEdit_saveResult->clear();
+  ui.plainTextEdit_saveResult->insertPlainText(QString("Saving %1 files...\n").arg(numberOfFiles));
+}
+
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::CaptureFileWritten(vtkPlusVirtualCapture* aDevice, const QString& aFilename, bool aSuccess, double aElapsedSec, double aThroughputMbPerSec)
+{
+  for (std::vector<PlusCaptureControlWidget*>::iterator it = m_CaptureWidgets.begin(); it != m_CaptureWidgets.end(); ++it)
+  {
+    if ((*it)->GetCaptureDevice() == aDevice)
+    {
+      (*it)->SetSaveInProgress(false);
+    }
+  }
+
+  QString message;
+  if (aSuccess)
+  {
+    message = QString("Successfully wrote: %1 (%2 sec, %3 MB/s)\n").arg(aFilename).arg(aElapsedSec, 0, 'f', 1).arg(aThroughputMbPerSec, 0, 'f', 1);
+  }
+  else
+  {
+    message = QString("Failed to write: %1\n").arg(aFilename);
+  }
+  ui.plainTextEdit_saveResult->moveCursor(QTextCursor::End);
+  ui.plainTextEdit_saveResult->insertPlainText(message);
+
+  RequestRefresh();
+}
+
+//-----------------------------------------------------------------------------
+void QCapturingToolbox::CaptureSessionWritten(int aNumberOfSucceededFiles, int aNumberOfFiles, double aElapsedSec)
+{
+  LOG_INFO("Saved " << aNumberOfSucceededFiles << " of " << aNumberOfFiles << " capture files in " << aElapsedSec << " sec");
+
+  ui.plainTextEdit_saveResult->moveCursor(QTextCursor::End);
+  ui.plainTextEdit_saveResult->insertPlainText(QString("Saved %1 of %2 files in %3 sec").arg(aNumberOfSucceededFiles).arg(aNumberOfFiles).arg(aElapsedSec, 0, 'f', 1));
+
+  RequestRefresh();
 }
 
 //-----------------------------------------------------------------------------
@@ -696,6 +879,7 @@ void QCapturingToolbox::OnDeactivated()
   for (std::vector<PlusCaptureControlWidget*>::iterator it = m_CaptureWidgets.begin(); it != m_CaptureWidgets.end(); ++it)
   {
     disconnect((*it), SIGNAL(EmitStatusMessage(const std::string&)), this, SLOT(HandleStatusMessage(const std::string&)));
+    disconnect((*it), SIGNAL(StateChanged()), this, SLOT(CaptureWidgetStateChanged()));
     m_GridLayout->removeWidget(*it);
     delete *it;
   }
@@ -753,6 +937,7 @@ void QCapturingToolbox::InitCaptureDeviceScrollArea()
         m_GridLayout->addWidget(aWidget);
         m_CaptureWidgets.push_back(aWidget);
         connect(aWidget, SIGNAL(EmitStatusMessage(const std::string&)), this, SLOT(HandleStatusMessage(const std::string&)));
+        connect(aWidget, SIGNAL(StateChanged()), this, SLOT(CaptureWidgetStateChanged()));
       }
     }
   }
@@ -18,12 +18,15 @@ See License.txt for details.
 #include <QWidget>
 
 class PlusCaptureControlWidget;
+class QPlusCaptureWriterPool;
 class QGridLayout;
 class QScrollArea;
 class QSpacerItem;
 class QString;
-class QTimer;
+class QPlusRecordingSampler;
 class vtkIGSIOTrackedFrameList;
+class vtkPlusVirtualCapture;
+class vtkXMLDataElement;
 
 //-----------------------------------------------------------------------------
 
@@ -57,15 +60,28 @@ public:
   /*! Refresh contents (e.g. GUI elements) of toolbox according to the state in the toolbox controller - implementation of a pure virtual function */
   virtual void RefreshContent();
 
+  /*! Refresh periodically only while recording or saving, the progress is not signaled otherwise */
+  virtual int GetRefreshTriggers();
+
   /*! \brief Reset toolbox to initial state - */
   virtual void Reset();
 
   /*! Sets display mode (visibility of actors) according to the current state - implementation of a pure virtual function */
   void SetDisplayAccordingToState();
 
-  /*! Get recorded tracked frame list */
+  /*!
+  * Get recorded tracked frame list. The list is shared, it must not be modified by the caller. Hold a reference
+  * to it (vtkSmartPointer) to keep using it after the toolbox has cleared or saved the recording: the toolbox
+  * starts a new list then instead of clearing this one. The list is only appended to while recording is in progress.
+  */
   inline vtkIGSIOTrackedFrameList* GetRecordedFrames() { return m_RecordedFrames; }
 
+  /*!
+  * Read output file settings (OutputFileCompression, CaptureFileExtension) from the fCal element
+  * \param aConfig Root element of the device set configuration
+  */
+  PlusStatus ReadConfiguration(vtkXMLDataElement* aConfig);
+
 protected:
   /*!
   * Saves recorded tracked frame list to file
@@ -84,6 +100,13 @@ protected:
   * Actual clearing of frames
   */
   void ClearRecordedFramesInternal();
+
+  /*! Release the recorded frame list (other holders keep it unchanged) and start a new, empty one */
+  void ReleaseRecordedFrames();
+
+  /*! Make sure that the recorded frame list is not shared before appending to it, if it is then continue in a copy */
+  void DetachRecordedFrames();
+
   /*!
   * Save data to file
   */
@@ -95,6 +118,9 @@ protected:
   /// Initialize the scroll area and any capture widgets
   void InitCaptureDeviceScrollArea();
 
+  /*! Returns true while recording, capturing to any capture device or saving files */
+  bool IsCaptureActive();
+
 protected slots:
   /*!
   * Take snapshot (record the current frame only)
@@ -148,27 +174,31 @@ protected slots:
   void SamplingRateChanged(int aValue);
 
   /*!
-  * Record tracked frames (the recording timer calls it)
+  * Handle status message from any sub capture widgets
   */
-  void Capture();
+  void HandleStatusMessage(const std::string& aMessage);
 
   /*!
-  * Handle status message from any sub capture widgets
+  * Update the buttons after recording was started, stopped or cleared in any sub capture widget
   */
-  void HandleStatusMessage(const std::string& aMessage);
+  void CaptureWidgetStateChanged();
 
-protected:
-  /*! Recorded tracked frame list */
-  vtkIGSIOTrackedFrameList* m_RecordedFrames;
+  /*!
+  * Report a capture file written by the writer pool
+  */
+  void CaptureFileWritten(vtkPlusVirtualCapture* aDevice, const QString& aFilename, bool aSuccess, double aElapsedSec, double aThroughputMbPerSec);
 
-  /*! Timer triggering the */
-  QTimer* m_RecordingTimer;
+  /*!
+  * Report the end of a Save All session
+  */
+  void CaptureSessionWritten(int aNumberOfSucceededFiles, int aNumberOfFiles, double aElapsedSec);
 
-  /*! Timestamp of last recorded frame (only frames that have more recent timestamp will be added) */
-  double m_RecordingLastAlreadyRecordedFrameTimestamp;
+protected:
+  /*! Recorded tracked frame list, shared with the Volume reconstruction toolbox (see GetRecordedFrames) */
+  vtkIGSIOTrackedFrameList* m_RecordedFrames;
 
-  /*! Desired timestamp of the next frame to be recorded */
-  double m_RecordingNextFrameToBeRecordedTimestamp;
+  /*! Records the frames of the selected channel into m_RecordedFrames on a dedicated thread while recording is in progress */
+  QPlusRecordingSampler* m_RecordingSampler;
 
   /*! Frame rate of the sampling */
   const int m_SamplingFrameRate;
@@ -176,23 +206,24 @@ protected:
   /*! Requested frame rate (frames per second) */
   double m_RequestedFrameRate;
 
-  /*! Actual frame rate (frames per second) */
-  double m_ActualFrameRate;
-
-  /*!
-    Frame index of the first frame that is recorded in this segment (since pressed the record button).
-    It is used when estimating the actual frame rate: frames that are acquired before this frame index (i.e.,
-    those that were acquired in a different recording segment) will not be taken into account in the actual
-    frame rate computation.
-  */
-  int m_RecordingFirstFrameIndexInThisSegment;
-
   /*! String to hold the last location of data saved */
   std::string m_LastSaveLocation;
 
+  /*! Flag indicating whether the image data in the saved sequence files is compressed */
+  bool m_UseCompression;
+
+  /*! Extension of the saved sequence files (.mha, .nrrd or .seq.nrrd) */
+  std::string m_CaptureFileExtension;
+
   /* Container holding capture widgets */
   std::vector<PlusCaptureControlWidget*>  m_CaptureWidgets;
 
+  /*! Writes the files of all capture devices concurrently on Save All */
+  QPlusCaptureWriterPool* m_CaptureWriterPool;
+
+  /*! Flag indicating whether recording or saving was in progress at the last refresh (one more refresh is needed when it stops) */
+  bool m_CaptureActiveAtLastRefresh;
+
   QScrollArea* m_ScrollArea;
 
   QWidget* m_GridWidget;
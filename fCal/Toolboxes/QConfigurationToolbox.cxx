@@ -102,6 +102,12 @@ void QConfigurationToolbox::RefreshContent()
   }
 }
 
+//-----------------------------------------------------------------------------
+int QConfigurationToolbox::GetRefreshTriggers()
+{
+  return ToolboxRefreshTrigger_NewData | ToolboxRefreshTrigger_StateChanged;
+}
+
 //-----------------------------------------------------------------------------
 void QConfigurationToolbox::RefreshToolDisplayIfDetached()
 {
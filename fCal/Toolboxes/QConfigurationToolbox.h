@@ -56,6 +56,11 @@ public:
   */
   virtual void RefreshContent();
 
+  /*!
+  * The tool state display follows the acquired data
+  */
+  virtual int GetRefreshTriggers();
+
   /*!
   * Refresh contents if tool display is detached
   */
@@ -14,11 +14,10 @@ See License.txt for details.
 #include <QFileDialog>
 #include <QTimer>
 
-// IGSIO includes
-#include <vtkIGSIOAccurateTimer.h>
-
 // PlusLib includes
 #include <igsioMath.h>
+#include <vtkPlusChannel.h>
+#include <vtkPlusDataSource.h>
 #include <vtkPlusFakeTracker.h>
 #include <vtkPlusLandmarkDetectionAlgo.h>
 #include <vtkPlusPhantomLandmarkRegistrationAlgo.h>
@@ -27,7 +26,7 @@ See License.txt for details.
 
 // VTK includes
 #include <vtkCamera.h>
-#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
@@ -36,6 +35,11 @@ See License.txt for details.
 #include <vtkSphereSource.h>
 #include <vtkXMLUtilities.h>
 
+// STL includes
+#include <algorithm>
+
+static const int MAX_NUMBER_OF_STYLUS_TIP_FRAMES_PER_BATCH = 100; // upper limit of tracker samples processed in one acquisition timer tick
+
 //-----------------------------------------------------------------------------
 QPhantomRegistrationToolbox::QPhantomRegistrationToolbox(fCalMainWindow* aParentMainWindow, Qt::WindowFlags aFlags)
   : QAbstractToolbox(aParentMainWindow)
@@ -52,6 +56,7 @@ QPhantomRegistrationToolbox::QPhantomRegistrationToolbox(fCalMainWindow* aParent
   , m_LandmarkPivotingState(LandmarkPivotingState_Incomplete)
   , m_PreviousStylusTipToReferenceTransformMatrix(vtkSmartPointer<vtkMatrix4x4>::New())
   , m_LandmarkDetected(-1)
+  , m_LastRecordedStylusTipTimestamp(UNDEFINED_TIMESTAMP)
 {
   ui.setupUi(this);
 
@@ -71,14 +76,14 @@ QPhantomRegistrationToolbox::QPhantomRegistrationToolbox(fCalMainWindow* aParent
   vtkSmartPointer<vtkPoints> requestedLandmarkPoints = vtkSmartPointer<vtkPoints>::New();
   m_RequestedLandmarkPolyData->SetPoints(requestedLandmarkPoints);
 
-  vtkSmartPointer<vtkPolyDataMapper> requestedLandmarksMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  vtkSmartPointer<vtkGlyph3D> requestedLandmarksGlyph = vtkSmartPointer<vtkGlyph3D>::New();
+  vtkSmartPointer<vtkGlyph3DMapper> requestedLandmarksMapper = vtkSmartPointer<vtkGlyph3DMapper>::New();
   vtkSmartPointer<vtkSphereSource> requestedLandmarksSphereSource = vtkSmartPointer<vtkSphereSource>::New();
   requestedLandmarksSphereSource->SetRadius(1.5);   // mm
 
-  requestedLandmarksGlyph->SetInputData(m_RequestedLandmarkPolyData);
-  requestedLandmarksGlyph->SetSourceConnection(requestedLandmarksSphereSource->GetOutputPort());
-  requestedLandmarksMapper->SetInputConnection(requestedLandmarksGlyph->GetOutputPort());
+  requestedLandmarksMapper->SetInputData(m_RequestedLandmarkPolyData);
+  requestedLandmarksMapper->SetSourceConnection(requestedLandmarksSphereSource->GetOutputPort());
+  requestedLandmarksMapper->ScalingOff();
+  requestedLandmarksMapper->OrientOff();
   m_RequestedLandmarkActor->SetMapper(requestedLandmarksMapper);
   m_RequestedLandmarkActor->GetProperty()->SetColor(1.0, 0.5, 0.0);
 
@@ -203,6 +208,15 @@ PlusStatus QPhantomRegistrationToolbox::ReadConfiguration(vtkXMLDataElement* aCo
     return PLUS_FAIL;
   }
 
+  // Read stylus coordinate frame name, the stylus tool buffer is read directly while registering
+  vtkSmartPointer<vtkPlusPivotCalibrationAlgo> pivotCalibrationAlgo = vtkSmartPointer<vtkPlusPivotCalibrationAlgo>::New();
+  if (pivotCalibrationAlgo->ReadConfiguration(aConfig) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read stylus coordinate frame name!");
+    return PLUS_FAIL;
+  }
+  m_ObjectMarkerCoordinateFrame = QString(pivotCalibrationAlgo->GetObjectMarkerCoordinateFrame());
+
   return PLUS_SUCCESS;
 }
 
@@ -373,6 +387,32 @@ void QPhantomRegistrationToolbox::RefreshContent()
   ui.canvasPhantom->update();
 }
 
+//-----------------------------------------------------------------------------
+int QPhantomRegistrationToolbox::GetRefreshTriggers()
+{
+  switch (m_State)
+  {
+    case ToolboxState_InProgress:
+      return ToolboxRefreshTrigger_NewData | ToolboxRefreshTrigger_TransformChanged | ToolboxRefreshTrigger_StateChanged;
+    case ToolboxState_Done:
+      return ToolboxRefreshTrigger_TransformChanged | ToolboxRefreshTrigger_StateChanged;
+    default:
+      return ToolboxRefreshTrigger_StateChanged;
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::vector<igsioTransformName> QPhantomRegistrationToolbox::GetWatchedTransformNames()
+{
+  std::vector<igsioTransformName> transformNames;
+  if ((m_State == ToolboxState_Done || m_State == ToolboxState_InProgress)
+      && m_PhantomLandmarkRegistration->GetStylusTipCoordinateFrame() != NULL && m_PhantomLandmarkRegistration->GetReferenceCoordinateFrame() != NULL)
+  {
+    transformNames.push_back(igsioTransformName(m_PhantomLandmarkRegistration->GetStylusTipCoordinateFrame(), m_PhantomLandmarkRegistration->GetReferenceCoordinateFrame()));
+  }
+  return transformNames;
+}
+
 //-----------------------------------------------------------------------------
 void QPhantomRegistrationToolbox::SetDisplayAccordingToState()
 {
@@ -736,7 +776,8 @@ void QPhantomRegistrationToolbox::RecordPoint()
   //// disConnect acquisition function to timer, Maybe needed but it work without it.
   //disconnect( m_ParentMainWindow->GetVisualizationController()->GetAcquisitionTimer(), SIGNAL( timeout() ), this, SLOT( AddStylusTipPositionToLandmarkPivotingRegistration() ) );
 
-  // If tracker is FakeTracker then set counter (trigger position change) and wait for it to apply the new position
+  // If tracker is FakeTracker then set counter (trigger position change) and wait for it to apply the new position.
+  // The wait is done by a single shot timer so that the GUI is not blocked meanwhile.
   vtkPlusDataCollector* dataCollector = m_ParentMainWindow->GetVisualizationController()->GetDataCollector();
 
   if (dataCollector)
@@ -748,12 +789,27 @@ void QPhantomRegistrationToolbox::RecordPoint()
       {
         fakeTracker->SetCounter(m_CurrentLandmarkIndex);
         fakeTracker->SetTransformRepository(m_ParentMainWindow->GetVisualizationController()->GetTransformRepository());
-        vtkIGSIOAccurateTimer::Delay(2.1 / fakeTracker->GetAcquisitionRate());
-        break;
+        ui.pushButton_RecordPoint->setEnabled(false);
+        int positionChangeDelayMs = static_cast<int>(2100.0 / fakeTracker->GetAcquisitionRate()) + 1;
+        QTimer::singleShot(positionChangeDelayMs, this, SLOT(AcquireRecordedPoint()));
+        return;
       }
     }
   }
 
+  AcquireRecordedPoint();
+}
+
+//-----------------------------------------------------------------------------
+void QPhantomRegistrationToolbox::AcquireRecordedPoint()
+{
+  LOG_TRACE("PhantomRegistrationToolbox::AcquireRecordedPoint");
+
+  if (m_State == ToolboxState_InProgress && m_LandmarkPivotingState == LandmarkPivotingState_InProgress)
+  {
+    ui.pushButton_RecordPoint->setEnabled(true);
+  }
+
   // Acquire point
   vtkSmartPointer<vtkMatrix4x4> stylusTipToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   ToolStatus status(TOOL_INVALID);
@@ -1022,6 +1078,9 @@ void QPhantomRegistrationToolbox::StartLinearObjectRegistration()
   // Set state to in progress
   SetLinearObjectRegistrationState(LinearObjectRegistrationState_InProgress);
 
+  // Only process the samples that are acquired from now on
+  m_LastRecordedStylusTipTimestamp = UNDEFINED_TIMESTAMP;
+
   // Connect acquisition function to timer
   connect(&m_ParentMainWindow->GetVisualizationController()->GetAcquisitionTimer(), SIGNAL(timeout()), this, SLOT(AddStylusTipTransformToLinearObjectRegistration()));
 }
@@ -1105,6 +1164,10 @@ void QPhantomRegistrationToolbox::StartLandmarkDetectionRegistration()
     // Set state to in progress
     SetLandmarkPivotingState(LandmarkPivotingState_InProgress);
   }
+
+  // Only process the samples that are acquired from now on
+  m_LastRecordedStylusTipTimestamp = UNDEFINED_TIMESTAMP;
+
   // Connect acquisition function to timer
   connect(&m_ParentMainWindow->GetVisualizationController()->GetAcquisitionTimer(), SIGNAL(timeout()), this, SLOT(AddStylusTipTransformToLandmarkPivotingRegistration()));
 }
@@ -1148,138 +1211,246 @@ void QPhantomRegistrationToolbox::StopLandmarkPivotingRegistration()
 }
 
 //-----------------------------------------------------------------------------
-void QPhantomRegistrationToolbox::AddStylusTipTransformToLandmarkPivotingRegistration()
+PlusStatus QPhantomRegistrationToolbox::AcquireStylusTipToReferenceTransforms(const igsioTransformName& aStylusTipToReferenceTransformName, std::vector<vtkSmartPointer<vtkMatrix4x4> >& aStylusTipToReferenceTransforms)
 {
-  LOG_TRACE("PhantomRegistrationToolbox::AddStylusTipPositionToLandmarkPivotingRegistration");
+  aStylusTipToReferenceTransforms.clear();
 
-  ToolStatus status(TOOL_INVALID);
-  vtkSmartPointer<vtkMatrix4x4> stylusTipToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  if (m_ParentMainWindow->GetVisualizationController()->GetTransformMatrix(m_PhantomLandmarkRegistration->GetStylusTipCoordinateFrame(), m_PhantomLandmarkRegistration->GetReferenceCoordinateFrame(), stylusTipToReferenceTransformMatrix, &status) != PLUS_SUCCESS)
+  vtkPlusChannel* selectedChannel = m_ParentMainWindow->GetSelectedChannel();
+  if (selectedChannel == NULL)
   {
-    LOG_ERROR("No transform found between stylus tip and reference!");
-    return;
+    LOG_ERROR("Unable to acquire stylus tip transforms: no channel is selected!");
+    return PLUS_FAIL;
   }
 
-  if (status == TOOL_OK && ToolboxState_InProgress == GetState())
+  // The samples are read from the stylus tool buffer directly, so no video frame is copied
+  vtkPlusDataSource* stylusTool = NULL;
+  for (DataSourceContainerConstIterator it = selectedChannel->GetToolsStartConstIterator(); it != selectedChannel->GetToolsEndConstIterator(); ++it)
   {
-    double positionDifferenceLowThresholdMm = 2.0;
-    double positionDifferenceHighThresholdMm = 500.0;
-    double positionDifferenceMm = -1.0;
-    double orientationDifferenceLowThresholdDegrees = 1.0;
-    double orientationDifferenceHighThresholdDegrees = 90.0;
-    double orientationDifferenceDegrees = -1.0;
+    if (igsioTransformName(it->second->GetId()).From() == m_ObjectMarkerCoordinateFrame.toStdString())
+    {
+      stylusTool = it->second;
+      break;
+    }
+  }
+  if (stylusTool == NULL)
+  {
+    LOG_ERROR("Unable to acquire stylus tip transforms: no " << m_ObjectMarkerCoordinateFrame.toStdString() << " tool found in the selected channel!");
+    return PLUS_FAIL;
+  }
+  if (stylusTool->GetNumberOfItems() < 1)
+  {
+    return PLUS_SUCCESS;
+  }
 
-    if (m_CurrentPointNumber < 1)
+  // Get the samples that have been acquired since the last call (at most one batch per call to keep the GUI responsive)
+  BufferItemUidType latestUid = stylusTool->GetLatestItemUidInBuffer();
+  BufferItemUidType firstUid = latestUid;
+  if (m_LastRecordedStylusTipTimestamp != UNDEFINED_TIMESTAMP)
+  {
+    BufferItemUidType lastRecordedUid = 0;
+    if (stylusTool->GetItemUidFromTime(m_LastRecordedStylusTipTimestamp, lastRecordedUid) == ITEM_OK)
     {
-      // Always allow
-      positionDifferenceMm = (positionDifferenceLowThresholdMm + positionDifferenceHighThresholdMm) / 2.0;
-      orientationDifferenceDegrees = (orientationDifferenceLowThresholdDegrees + orientationDifferenceHighThresholdDegrees) / 2.0;
+      firstUid = lastRecordedUid + 1;
     }
     else
     {
-      // Compute position and orientation difference of current and previous positions
-      positionDifferenceMm = igsioMath::GetPositionDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
-      orientationDifferenceDegrees = igsioMath::GetOrientationDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
+      // The last recorded sample has already been overwritten in the buffer
+      firstUid = stylusTool->GetOldestItemUidInBuffer();
     }
+  }
+  BufferItemUidType lastUid = std::min(latestUid, firstUid + MAX_NUMBER_OF_STYLUS_TIP_FRAMES_PER_BATCH - 1);
 
-    if (positionDifferenceMm > positionDifferenceHighThresholdMm || orientationDifferenceDegrees > orientationDifferenceHighThresholdDegrees)
+  vtkIGSIOTransformRepository* transformRepository = m_ParentMainWindow->GetVisualizationController()->GetTransformRepository();
+  vtkSmartPointer<vtkMatrix4x4> toolToTrackerTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (BufferItemUidType uid = firstUid; uid <= lastUid; ++uid)
+  {
+    StreamBufferItem stylusItem;
+    if (stylusTool->GetStreamBufferItem(uid, &stylusItem) != ITEM_OK)
     {
-      LOG_DEBUG("Acquired position seems to be an outlier - it is skipped");
-      return;
+      LOG_DEBUG("Stylus sample (UID: " << uid << ") is no longer available");
+      continue;
     }
+    double timestamp = stylusItem.GetFilteredTimestamp(stylusTool->GetLocalTimeOffsetSec());
+    m_LastRecordedStylusTipTimestamp = timestamp;
 
-    // Assemble position string for toolbox
-    double sylusTip_Reference[4] = {stylusTipToReferenceTransformMatrix->GetElement(0, 3), stylusTipToReferenceTransformMatrix->GetElement(1, 3), stylusTipToReferenceTransformMatrix->GetElement(2, 3), 1};
-    std::stringstream ss;
-    ss << sylusTip_Reference[0] << " " << sylusTip_Reference[1] << " " << sylusTip_Reference[2];
-    m_StylusPositionString = QString(ss.str().c_str());
+    // Set the pose of every tool of the channel at the time of the stylus sample
+    for (DataSourceContainerConstIterator it = selectedChannel->GetToolsStartConstIterator(); it != selectedChannel->GetToolsEndConstIterator(); ++it)
+    {
+      vtkPlusDataSource* tool = it->second;
+      StreamBufferItem toolItem;
+      ToolStatus toolStatus(TOOL_INVALID);
+      if (tool->GetStreamBufferItemFromTime(timestamp, &toolItem, vtkPlusBuffer::INTERPOLATED) == ITEM_OK
+          && toolItem.GetMatrix(toolToTrackerTransformMatrix) == PLUS_SUCCESS)
+      {
+        toolStatus = toolItem.GetStatus();
+      }
+      transformRepository->SetTransform(igsioTransformName(tool->GetId()), toolToTrackerTransformMatrix, toolStatus);
+    }
 
-    m_LandmarkDetected = m_LandmarkDetection->GetNearExistingLandmarkId(sylusTip_Reference);
-    if (m_LandmarkDetected >= 0)
+    vtkSmartPointer<vtkMatrix4x4> stylusTipToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    ToolStatus status(TOOL_INVALID);
+    if (transformRepository->GetTransform(aStylusTipToReferenceTransformName, stylusTipToReferenceTransformMatrix, &status) != PLUS_SUCCESS)
     {
-      LOG_DEBUG("There is a Landmark detected close to the stylus tip position.");
-      return;
+      LOG_ERROR("No transform found between stylus tip and reference!");
+      m_ParentMainWindow->GetVisualizationController()->InvalidateTrackedFrameSnapshot();
+      return PLUS_FAIL;
     }
 
-    // Set new current point number
-    ++m_CurrentPointNumber;
-    int newLandmarkDetected = -1;
-    m_LandmarkDetection->InsertNextStylusTipToReferenceTransform(stylusTipToReferenceTransformMatrix, newLandmarkDetected);
-    if (newLandmarkDetected > 0)
+    if (status == TOOL_OK)
     {
-      double landmarkDetected_Reference[4] = {0, 0, 0, 1};
-      LOG_DEBUG("\n" << m_LandmarkDetection->GetDetectedLandmarksString() << "\n");
-      m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetPoint(m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetNumberOfPoints() - 1, landmarkDetected_Reference);
-
-      // Add recorded point to visualization input if fulfills the criteria
-      vtkPoints* detectedLandmarks_Reference = m_ParentMainWindow->GetVisualizationController()->GetResultPolyDataPoints();
-      detectedLandmarks_Reference->InsertPoint(m_CurrentLandmarkIndex, landmarkDetected_Reference[0], landmarkDetected_Reference[1], landmarkDetected_Reference[2]);
-      detectedLandmarks_Reference->Modified();
-      LOG_DEBUG("\nLandmark detected Number " << m_CurrentLandmarkIndex << " found (" << landmarkDetected_Reference[0] << ", " << landmarkDetected_Reference[1] << ", " << landmarkDetected_Reference[2] << ") \nNumber of pivots in phantonReg " << m_PhantomLandmarkRegistration->GetRecordedLandmarks_Reference()->GetNumberOfPoints());
-      m_CurrentLandmarkIndex++;
-
-      int numberOfExpectedLandmarks = m_PhantomLandmarkRegistration->GetDefinedLandmarks_Phantom()->GetNumberOfPoints();
-      vtkPlusLogger::PrintProgressbar((100.0 * m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetNumberOfPoints() - 1) / numberOfExpectedLandmarks);
-
-      // Add recorded landmark to registration algorithm
-      m_PhantomLandmarkRegistration->GetRecordedLandmarks_Reference()->InsertPoint(m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetNumberOfPoints() - 1, landmarkDetected_Reference);
-      m_PhantomLandmarkRegistration->GetRecordedLandmarks_Reference()->Modified();
-
-      // If there are at least 3 acquired landmarks then register
-      if (m_CurrentLandmarkIndex >= 3)
-      {
-        if (m_PhantomLandmarkRegistration->LandmarkRegister(m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()) == PLUS_SUCCESS)
-        {
-          m_ParentMainWindow->GetVisualizationController()->ShowObjectById(m_ParentMainWindow->GetPhantomModelId(), true);
-          m_ParentMainWindow->GetVisualizationController()->ShowObjectById(m_ParentMainWindow->GetPhantomWiresModelId(), true);
-        }
-        else
-        {
-          LOG_ERROR("Phantom landmark registration failed!");
-        }
+      aStylusTipToReferenceTransforms.push_back(stylusTipToReferenceTransformMatrix);
+    }
+  }
 
-        //stop registration
-        if (newLandmarkDetected == numberOfExpectedLandmarks)
-        {
-          ui.tabWidget->setTabEnabled(1, false);
-          if (m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()->WriteConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS)
-          {
-            LOG_ERROR("Unable to save phantom registration result in configuration XML tree!");
-            SetState(ToolboxState_Error);
-            return;
-          }
-          SetState(ToolboxState_Done);
+  // The repository now holds the transforms of a past sample, make the visualization update it again
+  m_ParentMainWindow->GetVisualizationController()->InvalidateTrackedFrameSnapshot();
 
-          m_RequestedLandmarkPolyData->GetPoints()->GetData()->RemoveTuple(0);
-          m_RequestedLandmarkPolyData->GetPoints()->Modified();
+  return PLUS_SUCCESS;
+}
 
-          StopLandmarkPivotingRegistration();
-          LOG_INFO("\n" << m_LandmarkDetection->GetDetectedLandmarksString() << "\n");
-          m_PhantomLandmarkRegistration->PrintRecordedLandmarks_Phantom();
-          return;
-        }
-        else
-        {
-          // Set the camera to face the new pivot to be found
-          m_ParentMainWindow->GetVisualizationController()->ShowInput(true);
-          SetCameraViewAndHighlightNextLandmark(m_ParentMainWindow->GetVisualizationController()->GetCanvasRenderer()->GetActiveCamera(), m_PhantomLandmarkRegistration,
-                                                m_CurrentLandmarkIndex, m_ParentMainWindow->GetVisualizationController()->GetInputPolyDataPoints());
-        }
+//-----------------------------------------------------------------------------
+void QPhantomRegistrationToolbox::AddStylusTipTransformToLandmarkPivotingRegistration()
+{
+  LOG_TRACE("PhantomRegistrationToolbox::AddStylusTipPositionToLandmarkPivotingRegistration");
+
+  std::vector<vtkSmartPointer<vtkMatrix4x4> > stylusTipToReferenceTransforms;
+  igsioTransformName stylusTipToReferenceTransformName(m_PhantomLandmarkRegistration->GetStylusTipCoordinateFrame(), m_PhantomLandmarkRegistration->GetReferenceCoordinateFrame());
+  if (AcquireStylusTipToReferenceTransforms(stylusTipToReferenceTransformName, stylusTipToReferenceTransforms) != PLUS_SUCCESS)
+  {
+    return;
+  }
+
+  for (std::vector<vtkSmartPointer<vtkMatrix4x4> >::iterator it = stylusTipToReferenceTransforms.begin(); it != stylusTipToReferenceTransforms.end(); ++it)
+  {
+    if (ToolboxState_InProgress != GetState() || !InsertStylusTipTransformToLandmarkPivotingRegistration(*it))
+    {
+      return;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool QPhantomRegistrationToolbox::InsertStylusTipTransformToLandmarkPivotingRegistration(vtkMatrix4x4* stylusTipToReferenceTransformMatrix)
+{
+  double positionDifferenceLowThresholdMm = 2.0;
+  double positionDifferenceHighThresholdMm = 500.0;
+  double positionDifferenceMm = -1.0;
+  double orientationDifferenceLowThresholdDegrees = 1.0;
+  double orientationDifferenceHighThresholdDegrees = 90.0;
+  double orientationDifferenceDegrees = -1.0;
+
+  if (m_CurrentPointNumber < 1)
+  {
+    // Always allow
+    positionDifferenceMm = (positionDifferenceLowThresholdMm + positionDifferenceHighThresholdMm) / 2.0;
+    orientationDifferenceDegrees = (orientationDifferenceLowThresholdDegrees + orientationDifferenceHighThresholdDegrees) / 2.0;
+  }
+  else
+  {
+    // Compute position and orientation difference of current and previous positions
+    positionDifferenceMm = igsioMath::GetPositionDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
+    orientationDifferenceDegrees = igsioMath::GetOrientationDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
+  }
+
+  if (positionDifferenceMm > positionDifferenceHighThresholdMm || orientationDifferenceDegrees > orientationDifferenceHighThresholdDegrees)
+  {
+    LOG_DEBUG("Acquired position seems to be an outlier - it is skipped");
+    return true;
+  }
+
+  // Assemble position string for toolbox
+  double sylusTip_Reference[4] = {stylusTipToReferenceTransformMatrix->GetElement(0, 3), stylusTipToReferenceTransformMatrix->GetElement(1, 3), stylusTipToReferenceTransformMatrix->GetElement(2, 3), 1};
+  std::stringstream ss;
+  ss << sylusTip_Reference[0] << " " << sylusTip_Reference[1] << " " << sylusTip_Reference[2];
+  m_StylusPositionString = QString(ss.str().c_str());
+
+  m_LandmarkDetected = m_LandmarkDetection->GetNearExistingLandmarkId(sylusTip_Reference);
+  if (m_LandmarkDetected >= 0)
+  {
+    LOG_DEBUG("There is a Landmark detected close to the stylus tip position.");
+    return true;
+  }
+
+  // Set new current point number
+  ++m_CurrentPointNumber;
+  int newLandmarkDetected = -1;
+  m_LandmarkDetection->InsertNextStylusTipToReferenceTransform(stylusTipToReferenceTransformMatrix, newLandmarkDetected);
+  if (newLandmarkDetected > 0)
+  {
+    double landmarkDetected_Reference[4] = {0, 0, 0, 1};
+    LOG_DEBUG("\n" << m_LandmarkDetection->GetDetectedLandmarksString() << "\n");
+    m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetPoint(m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetNumberOfPoints() - 1, landmarkDetected_Reference);
+
+    // Add recorded point to visualization input if fulfills the criteria
+    vtkPoints* detectedLandmarks_Reference = m_ParentMainWindow->GetVisualizationController()->GetResultPolyDataPoints();
+    detectedLandmarks_Reference->InsertPoint(m_CurrentLandmarkIndex, landmarkDetected_Reference[0], landmarkDetected_Reference[1], landmarkDetected_Reference[2]);
+    detectedLandmarks_Reference->Modified();
+    LOG_DEBUG("\nLandmark detected Number " << m_CurrentLandmarkIndex << " found (" << landmarkDetected_Reference[0] << ", " << landmarkDetected_Reference[1] << ", " << landmarkDetected_Reference[2] << ") \nNumber of pivots in phantonReg " << m_PhantomLandmarkRegistration->GetRecordedLandmarks_Reference()->GetNumberOfPoints());
+    m_CurrentLandmarkIndex++;
+
+    int numberOfExpectedLandmarks = m_PhantomLandmarkRegistration->GetDefinedLandmarks_Phantom()->GetNumberOfPoints();
+    vtkPlusLogger::PrintProgressbar((100.0 * m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetNumberOfPoints() - 1) / numberOfExpectedLandmarks);
+
+    // Add recorded landmark to registration algorithm
+    m_PhantomLandmarkRegistration->GetRecordedLandmarks_Reference()->InsertPoint(m_LandmarkDetection->GetDetectedLandmarkPoints_Reference()->GetNumberOfPoints() - 1, landmarkDetected_Reference);
+    m_PhantomLandmarkRegistration->GetRecordedLandmarks_Reference()->Modified();
+
+    // If there are at least 3 acquired landmarks then register
+    if (m_CurrentLandmarkIndex >= 3)
+    {
+      if (m_PhantomLandmarkRegistration->LandmarkRegister(m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()) == PLUS_SUCCESS)
+      {
+        m_ParentMainWindow->GetVisualizationController()->ShowObjectById(m_ParentMainWindow->GetPhantomModelId(), true);
+        m_ParentMainWindow->GetVisualizationController()->ShowObjectById(m_ParentMainWindow->GetPhantomWiresModelId(), true);
       }
       else
       {
-        m_ParentMainWindow->GetVisualizationController()->GetCanvasRenderer()->ResetCamera();
+        LOG_ERROR("Phantom landmark registration failed!");
       }
 
-      if (m_CurrentLandmarkIndex < numberOfExpectedLandmarks)
+      //stop registration
+      if (newLandmarkDetected == numberOfExpectedLandmarks)
       {
-        // Highlight next landmark
-        m_RequestedLandmarkPolyData->GetPoints()->InsertPoint(0, m_PhantomLandmarkRegistration->GetDefinedLandmarks_Phantom()->GetPoint(m_CurrentLandmarkIndex));
+        ui.tabWidget->setTabEnabled(1, false);
+        if (m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()->WriteConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Unable to save phantom registration result in configuration XML tree!");
+          SetState(ToolboxState_Error);
+          return false;
+        }
+        SetState(ToolboxState_Done);
+
+        m_RequestedLandmarkPolyData->GetPoints()->GetData()->RemoveTuple(0);
         m_RequestedLandmarkPolyData->GetPoints()->Modified();
+
+        StopLandmarkPivotingRegistration();
+        LOG_INFO("\n" << m_LandmarkDetection->GetDetectedLandmarksString() << "\n");
+        m_PhantomLandmarkRegistration->PrintRecordedLandmarks_Phantom();
+        return false;
+      }
+      else
+      {
+        // Set the camera to face the new pivot to be found
+        m_ParentMainWindow->GetVisualizationController()->ShowInput(true);
+        SetCameraViewAndHighlightNextLandmark(m_ParentMainWindow->GetVisualizationController()->GetCanvasRenderer()->GetActiveCamera(), m_PhantomLandmarkRegistration,
+                                              m_CurrentLandmarkIndex, m_ParentMainWindow->GetVisualizationController()->GetInputPolyDataPoints());
       }
     }
-    m_PreviousStylusTipToReferenceTransformMatrix->DeepCopy(stylusTipToReferenceTransformMatrix);
+    else
+    {
+      m_ParentMainWindow->GetVisualizationController()->GetCanvasRenderer()->ResetCamera();
+    }
+
+    if (m_CurrentLandmarkIndex < numberOfExpectedLandmarks)
+    {
+      // Highlight next landmark
+      m_RequestedLandmarkPolyData->GetPoints()->InsertPoint(0, m_PhantomLandmarkRegistration->GetDefinedLandmarks_Phantom()->GetPoint(m_CurrentLandmarkIndex));
+      m_RequestedLandmarkPolyData->GetPoints()->Modified();
+    }
   }
+  m_PreviousStylusTipToReferenceTransformMatrix->DeepCopy(stylusTipToReferenceTransformMatrix);
+
+  return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -1287,76 +1458,81 @@ void QPhantomRegistrationToolbox::AddStylusTipTransformToLinearObjectRegistratio
 {
   LOG_TRACE("PhantomRegistrationToolbox::AddStylusTipPositionToLinearObjectRegistration");
 
-  // Get stylus tip position
-  vtkSmartPointer<vtkMatrix4x4> stylusTipToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  ToolStatus status(TOOL_INVALID);
-  if (m_ParentMainWindow->GetVisualizationController()->GetTransformMatrix(m_PhantomLinearObjectRegistration->GetStylusTipCoordinateFrame(), m_PhantomLinearObjectRegistration->GetReferenceCoordinateFrame(), stylusTipToReferenceTransformMatrix, &status) != PLUS_SUCCESS)
+  // Get stylus tip positions acquired since the last call
+  std::vector<vtkSmartPointer<vtkMatrix4x4> > stylusTipToReferenceTransforms;
+  igsioTransformName stylusTipToReferenceTransformName(m_PhantomLinearObjectRegistration->GetStylusTipCoordinateFrame(), m_PhantomLinearObjectRegistration->GetReferenceCoordinateFrame());
+  if (AcquireStylusTipToReferenceTransforms(stylusTipToReferenceTransformName, stylusTipToReferenceTransforms) != PLUS_SUCCESS)
   {
-    LOG_ERROR("No transform found between stylus tip and reference!");
     return;
   }
 
-  if (status == TOOL_OK)
+  for (std::vector<vtkSmartPointer<vtkMatrix4x4> >::iterator it = stylusTipToReferenceTransforms.begin(); it != stylusTipToReferenceTransforms.end(); ++it)
   {
-    // Assemble position string for toolbox
-    std::stringstream ss;
-    ss << stylusTipToReferenceTransformMatrix->GetElement(0, 3) << " " << stylusTipToReferenceTransformMatrix->GetElement(1, 3) << " " << stylusTipToReferenceTransformMatrix->GetElement(2, 3);
-    m_StylusPositionString = QString(ss.str().c_str());
+    InsertStylusTipTransformToLinearObjectRegistration(*it);
+  }
+}
 
-    // Add point to the input if fulfills the criteria
-    vtkPoints* points = m_ParentMainWindow->GetVisualizationController()->GetResultPolyDataPoints();
+//-----------------------------------------------------------------------------
+void QPhantomRegistrationToolbox::InsertStylusTipTransformToLinearObjectRegistration(vtkMatrix4x4* stylusTipToReferenceTransformMatrix)
+{
+  // Assemble position string for toolbox
+  std::stringstream ss;
+  ss << stylusTipToReferenceTransformMatrix->GetElement(0, 3) << " " << stylusTipToReferenceTransformMatrix->GetElement(1, 3) << " " << stylusTipToReferenceTransformMatrix->GetElement(2, 3);
+  m_StylusPositionString = QString(ss.str().c_str());
 
-    double positionDifferenceLowThresholdMm = 2.0;
-    double positionDifferenceHighThresholdMm = 500.0;
-    double positionDifferenceMm = -1.0;
-    double orientationDifferenceLowThresholdDegrees = 2.0;
-    double orientationDifferenceHighThresholdDegrees = 90.0;
-    double orientationDifferenceDegrees = -1.0;
+  // Add point to the input if fulfills the criteria
+  vtkPoints* points = m_ParentMainWindow->GetVisualizationController()->GetResultPolyDataPoints();
 
-    //TODO: make sure that when you switch planes you are recording, all the new points are not treated as outliers
-    if (m_CurrentPointNumber < 1)
-    {
-      // Always allow
-      positionDifferenceMm = (positionDifferenceLowThresholdMm + positionDifferenceHighThresholdMm) / 2.0;
-      orientationDifferenceDegrees = (orientationDifferenceLowThresholdDegrees + orientationDifferenceHighThresholdDegrees) / 2.0;
-    }
-    else
-    {
-      // Compute position and orientation difference of current and previous positions
-      positionDifferenceMm = igsioMath::GetPositionDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
-      orientationDifferenceDegrees = igsioMath::GetOrientationDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
-    }
+  double positionDifferenceLowThresholdMm = 2.0;
+  double positionDifferenceHighThresholdMm = 500.0;
+  double positionDifferenceMm = -1.0;
+  double orientationDifferenceLowThresholdDegrees = 2.0;
+  double orientationDifferenceHighThresholdDegrees = 90.0;
+  double orientationDifferenceDegrees = -1.0;
 
-    // If current point is close to the previous one, or too far (outlier), we do not insert it
-    if (positionDifferenceMm < orientationDifferenceLowThresholdDegrees && orientationDifferenceDegrees < orientationDifferenceLowThresholdDegrees)
-    {
-      LOG_DEBUG("Acquired position is too close to the previous - it is skipped");
-    }
-    else if (positionDifferenceMm > positionDifferenceHighThresholdMm || orientationDifferenceDegrees > orientationDifferenceHighThresholdDegrees)
-    {
-      LOG_DEBUG("Acquired position seems to be an outlier - it is skipped");
-    }
-    else
-    {
-      // Add the point into the registration dataset
-      m_PhantomLinearObjectRegistration->InsertNextCalibrationPoint(stylusTipToReferenceTransformMatrix);
+  //TODO: make sure that when you switch planes you are recording, all the new points are not treated as outliers
+  if (m_CurrentPointNumber < 1)
+  {
+    // Always allow
+    positionDifferenceMm = (positionDifferenceLowThresholdMm + positionDifferenceHighThresholdMm) / 2.0;
+    orientationDifferenceDegrees = (orientationDifferenceLowThresholdDegrees + orientationDifferenceHighThresholdDegrees) / 2.0;
+  }
+  else
+  {
+    // Compute position and orientation difference of current and previous positions
+    positionDifferenceMm = igsioMath::GetPositionDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
+    orientationDifferenceDegrees = igsioMath::GetOrientationDifference(stylusTipToReferenceTransformMatrix, m_PreviousStylusTipToReferenceTransformMatrix);
+  }
 
-      // Add to polydata for rendering
-      points->InsertPoint(m_CurrentPointNumber, stylusTipToReferenceTransformMatrix->GetElement(0, 3), stylusTipToReferenceTransformMatrix->GetElement(1, 3), stylusTipToReferenceTransformMatrix->GetElement(2, 3));
-      points->Modified();
+  // If current point is close to the previous one, or too far (outlier), we do not insert it
+  if (positionDifferenceMm < orientationDifferenceLowThresholdDegrees && orientationDifferenceDegrees < orientationDifferenceLowThresholdDegrees)
+  {
+    LOG_DEBUG("Acquired position is too close to the previous - it is skipped");
+  }
+  else if (positionDifferenceMm > positionDifferenceHighThresholdMm || orientationDifferenceDegrees > orientationDifferenceHighThresholdDegrees)
+  {
+    LOG_DEBUG("Acquired position seems to be an outlier - it is skipped");
+  }
+  else
+  {
+    // Add the point into the registration dataset
+    m_PhantomLinearObjectRegistration->InsertNextCalibrationPoint(stylusTipToReferenceTransformMatrix);
 
-      // Set new current point number
-      ++m_CurrentPointNumber;
+    // Add to polydata for rendering
+    points->InsertPoint(m_CurrentPointNumber, stylusTipToReferenceTransformMatrix->GetElement(0, 3), stylusTipToReferenceTransformMatrix->GetElement(1, 3), stylusTipToReferenceTransformMatrix->GetElement(2, 3));
+    points->Modified();
 
-      // Reset the camera once in a while
-      if ((m_CurrentPointNumber > 0) && ((m_CurrentPointNumber % 10 == 0) || (m_CurrentPointNumber == 5)))
-      {
-        m_ParentMainWindow->GetVisualizationController()->GetCanvasRenderer()->ResetCamera();
-      }
+    // Set new current point number
+    ++m_CurrentPointNumber;
 
-      //TODO: if there are more than 3 planes recorded, try to add a visualization of the phantom to the GUI
-      m_PreviousStylusTipToReferenceTransformMatrix->DeepCopy(stylusTipToReferenceTransformMatrix);
+    // Reset the camera once in a while
+    if ((m_CurrentPointNumber > 0) && ((m_CurrentPointNumber % 10 == 0) || (m_CurrentPointNumber == 5)))
+    {
+      m_ParentMainWindow->GetVisualizationController()->GetCanvasRenderer()->ResetCamera();
     }
+
+    //TODO: if there are more than 3 planes recorded, try to add a visualization of the phantom to the GUI
+    m_PreviousStylusTipToReferenceTransformMatrix->DeepCopy(stylusTipToReferenceTransformMatrix);
   }
 }
 
@@ -18,6 +18,7 @@ class vtkPlusPhantomLandmarkRegistrationAlgo;
 class vtkPlusPhantomLinearObjectRegistrationAlgo;
 class vtkPlusLandmarkDetectionAlgo;
 class vtkActor;
+class vtkMatrix4x4;
 class vtkPolyData;
 class vtkRenderer;
 
@@ -80,6 +81,16 @@ public:
   */
   virtual void RefreshContent();
 
+  /*!
+  * Registration progress follows the acquired data, the stylus position is refreshed only when the stylus tip moves
+  */
+  virtual int GetRefreshTriggers();
+
+  /*!
+  * Stylus tip to reference transform, displayed while registering and when done
+  */
+  virtual std::vector<igsioTransformName> GetWatchedTransformNames();
+
   /*!
   * Sets display mode (visibility of actors) according to the current state - implementation of a pure virtual function
   */
@@ -133,6 +144,25 @@ protected:
   /*! Get message telling the state of the calibration */
   QString GetCalibrationStateMessage();
 
+  /*!
+  * Collect all the valid stylus tip to reference transforms that were acquired since the last call from the stylus tool buffer of the selected channel
+  * \param aStylusTipToReferenceTransformName Name of the transform to compute for each acquired frame
+  * \param aStylusTipToReferenceTransforms Output list of valid transforms in acquisition order
+  * \return Success flag
+  */
+  PlusStatus AcquireStylusTipToReferenceTransforms(const igsioTransformName& aStylusTipToReferenceTransformName, std::vector<vtkSmartPointer<vtkMatrix4x4> >& aStylusTipToReferenceTransforms);
+
+  /*!
+  * Feed one stylus tip to reference transform to the landmark detection algorithm
+  * \return False if the registration has been finished (no more transforms are needed), true otherwise
+  */
+  bool InsertStylusTipTransformToLandmarkPivotingRegistration(vtkMatrix4x4* aStylusTipToReferenceTransformMatrix);
+
+  /*!
+  * Add one stylus tip to reference transform to the linear object registration algorithm if it fulfills the criteria
+  */
+  void InsertStylusTipTransformToLinearObjectRegistration(vtkMatrix4x4* aStylusTipToReferenceTransformMatrix);
+
 protected slots:
   /*!
   * Slot handling open stylus calibration button click
@@ -144,6 +174,11 @@ protected slots:
   */
   void RecordPoint();
 
+  /*!
+  * Acquire the current stylus tip position as a landmark (called by RecordPoint directly or after the fake tracker applied its new position)
+  */
+  void AcquireRecordedPoint();
+
   /*!
   * Slot handling undo button for the landmark registration click
   */
@@ -236,6 +271,9 @@ protected:
   /*! Previous stylus tip to reference transform matrix to determine the difference at each point acquisition */
   vtkSmartPointer<vtkMatrix4x4>           m_PreviousStylusTipToReferenceTransformMatrix;
 
+  /*! Timestamp of last stylus sample read from the stylus tool buffer (only frames that have more recent timestamp will be processed) */
+  double                                  m_LastRecordedStylusTipTimestamp;
+
 protected:
   Ui::PhantomRegistrationToolbox ui;
 
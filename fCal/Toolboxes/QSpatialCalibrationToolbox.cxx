@@ -5,6 +5,7 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 // Local includes
+#include "PlusPerformanceMonitor.h"
 #include "QSpatialCalibrationToolbox.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusDisplayableObject.h"
@@ -33,7 +34,7 @@ QSpatialCalibrationToolbox::QSpatialCalibrationToolbox(fCalMainWindow* aParentMa
   : QAbstractToolbox(aParentMainWindow)
   , QWidget(aParentMainWindow, aFlags)
   , m_Calibration(vtkSmartPointer<vtkPlusProbeCalibrationAlgo>::New())
-  , m_PatternRecognition(new PlusFidPatternRecognition())
+  , m_PatternRecognition(NULL)
   , m_SpatialCalibrationData(vtkSmartPointer<vtkIGSIOTrackedFrameList>::New())
   , m_SpatialValidationData(vtkSmartPointer<vtkIGSIOTrackedFrameList>::New())
   , m_CancelRequest(false)
@@ -197,7 +198,7 @@ PlusStatus QSpatialCalibrationToolbox::ReadConfiguration(vtkXMLDataElement* aCon
 
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, FreeHandStartupDelaySec, fCalElement);
 
-  return m_PatternRecognition->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+  return GetPatternRecognition()->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
 }
 
 //-----------------------------------------------------------------------------
@@ -205,6 +206,12 @@ void QSpatialCalibrationToolbox::RefreshContent()
 {
 }
 
+//-----------------------------------------------------------------------------
+int QSpatialCalibrationToolbox::GetRefreshTriggers()
+{
+  return ToolboxRefreshTrigger_StateChanged;
+}
+
 //-----------------------------------------------------------------------------
 void QSpatialCalibrationToolbox::SetDisplayAccordingToState()
 {
@@ -519,7 +526,7 @@ void QSpatialCalibrationToolbox::OpenSegmentationParameters()
   }
 
   // Load calibration configuration xml
-  if (m_PatternRecognition->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS)
+  if (GetPatternRecognition()->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS)
   {
     LOG_ERROR("Unable to import segmentation parameters");
     return;
@@ -562,7 +569,7 @@ void QSpatialCalibrationToolbox::EditSegmentationParameters()
   m_ParentMainWindow->GetVisualizationController()->ReadRoiConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
 
   // Update segmentation parameters
-  if (m_PatternRecognition->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS)
+  if (GetPatternRecognition()->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS)
   {
     LOG_ERROR("Unable to update segmentation parameters");
     return;
@@ -625,7 +632,7 @@ void QSpatialCalibrationToolbox::StartCalibration()
 
   // Initialize algorithms and containers
   if ((this->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS)
-      || (m_PatternRecognition->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS))
+      || (GetPatternRecognition()->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) != PLUS_SUCCESS))
   {
     LOG_ERROR("Reading configuration failed");
     return;
@@ -650,6 +657,7 @@ void QSpatialCalibrationToolbox::StartCalibration()
 void QSpatialCalibrationToolbox::DoCalibration()
 {
   LOG_TRACE("SpatialCalibrationToolbox::DoSpatialCalibration");
+  PLUS_SCOPED_TIMER("SpatialCalibrationAcquisition");
 
   // Enable wire label visualization
   m_ParentMainWindow->GetVisualizationController()->EnableWireLabels(true);
@@ -663,7 +671,7 @@ void QSpatialCalibrationToolbox::DoCalibration()
   {
     LOG_INFO("Segmentation success rate: " << m_NumberOfSegmentedCalibrationImages + m_NumberOfSegmentedValidationImages << " out of " << m_SpatialCalibrationData->GetNumberOfTrackedFrames() + m_SpatialValidationData->GetNumberOfTrackedFrames() << " (" << (int)(((double)(m_NumberOfSegmentedCalibrationImages + m_NumberOfSegmentedValidationImages) / (double)(m_SpatialCalibrationData->GetNumberOfTrackedFrames() + m_SpatialValidationData->GetNumberOfTrackedFrames())) * 100.0 + 0.49) << " percent)");
 
-    if (m_Calibration->Calibrate(m_SpatialValidationData, m_SpatialCalibrationData, m_ParentMainWindow->GetVisualizationController()->GetTransformRepository(), m_PatternRecognition->GetFidLineFinder()->GetNWires()) != PLUS_SUCCESS)
+    if (m_Calibration->Calibrate(m_SpatialValidationData, m_SpatialCalibrationData, m_ParentMainWindow->GetVisualizationController()->GetTransformRepository(), GetPatternRecognition()->GetFidLineFinder()->GetNWires()) != PLUS_SUCCESS)
     {
       LOG_ERROR("Calibration failed");
       CancelCalibration();
@@ -746,6 +754,7 @@ void QSpatialCalibrationToolbox::DoCalibration()
       frameIndex--; // we've deleted the current frame, so continue with the same frameIndex
     }
   }
+  m_ParentMainWindow->GetVisualizationController()->InvalidateTrackedFrameSnapshot();
 
   if (probeToPhantomTransformValid)
   {
@@ -765,7 +774,7 @@ void QSpatialCalibrationToolbox::DoCalibration()
   if (numberOfFramesBeforeRecording < trackedFrameListToUse->GetNumberOfTrackedFrames())
   {
     PlusFidPatternRecognition::PatternRecognitionError error;
-    if (m_PatternRecognition->RecognizePattern(trackedFrameListToUse, error, &numberOfNewlySegmentedImages) != PLUS_SUCCESS)
+    if (GetPatternRecognition()->RecognizePattern(trackedFrameListToUse, error, &numberOfNewlySegmentedImages) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to segment tracked frame list");
       QTimer::singleShot(50, this, SLOT(DoCalibration()));
@@ -974,7 +983,6 @@ void QSpatialCalibrationToolbox::Reset()
 
   // Create algorithms
   m_Calibration = vtkSmartPointer<vtkPlusProbeCalibrationAlgo>::New();
-  m_PatternRecognition = new PlusFidPatternRecognition();
 
   // Create tracked frame lists
   m_SpatialCalibrationData = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
@@ -987,6 +995,16 @@ void QSpatialCalibrationToolbox::Reset()
   this->OnActivated();
 }
 
+//-----------------------------------------------------------------------------
+PlusFidPatternRecognition* QSpatialCalibrationToolbox::GetPatternRecognition()
+{
+  if (m_PatternRecognition == NULL)
+  {
+    m_PatternRecognition = new PlusFidPatternRecognition();
+  }
+  return m_PatternRecognition;
+}
+
 //-----------------------------------------------------------------------------
 void QSpatialCalibrationToolbox::OnDeactivated()
 {
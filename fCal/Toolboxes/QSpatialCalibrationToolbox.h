@@ -61,6 +61,9 @@ public:
   /*! Refresh contents (e.g. GUI elements) of toolbox according to the state in the toolbox controller - implementation of a pure virtual function */
   virtual void RefreshContent();
 
+  /*! Nothing is displayed continuously, refresh only on state changes */
+  virtual int GetRefreshTriggers();
+
   /*! Sets display mode (visibility of actors) according to the current state - implementation of a pure virtual function */
   void SetDisplayAccordingToState();
 
@@ -80,6 +83,9 @@ protected:
   /*! Set and save calibration results */
   PlusStatus SetAndSaveResults();
 
+  /*! Get the pattern recognition algorithm, create it at the first call */
+  PlusFidPatternRecognition* GetPatternRecognition();
+
   void SetFreeHandStartupDelaySec(int freeHandStartupDelaySec) {m_FreeHandStartupDelaySec = freeHandStartupDelaySec;};
 
 protected slots:
@@ -112,7 +118,7 @@ protected:
   /*! Calibration algorithm */
   vtkSmartPointer<vtkPlusProbeCalibrationAlgo>  m_Calibration;
 
-  /*! Pattern recognition algorithm */
+  /*! Pattern recognition algorithm, created on first use */
   PlusFidPatternRecognition*                    m_PatternRecognition;
 
   /*! Tracked frame data for spatial calibration */
@@ -5,6 +5,7 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 // Local includes
+#include "PlusPerformanceMonitor.h"
 #include "QStylusCalibrationToolbox.h"
 #include "fCalMainWindow.h"
 #include "igsioMath.h"
@@ -188,6 +189,33 @@ void QStylusCalibrationToolbox::RefreshContent()
   }
 }
 
+//-----------------------------------------------------------------------------
+int QStylusCalibrationToolbox::GetRefreshTriggers()
+{
+  switch (m_State)
+  {
+    case ToolboxState_StartupDelay:
+      return ToolboxRefreshTrigger_Timer | ToolboxRefreshTrigger_StateChanged;
+    case ToolboxState_InProgress:
+      return ToolboxRefreshTrigger_NewData | ToolboxRefreshTrigger_StateChanged;
+    case ToolboxState_Done:
+      return ToolboxRefreshTrigger_TransformChanged | ToolboxRefreshTrigger_StateChanged;
+    default:
+      return ToolboxRefreshTrigger_StateChanged;
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::vector<igsioTransformName> QStylusCalibrationToolbox::GetWatchedTransformNames()
+{
+  std::vector<igsioTransformName> transformNames;
+  if (m_State == ToolboxState_Done)
+  {
+    transformNames.push_back(igsioTransformName(m_PivotCalibration->GetObjectPivotPointCoordinateFrame(), m_PivotCalibration->GetReferenceCoordinateFrame()));
+  }
+  return transformNames;
+}
+
 //-----------------------------------------------------------------------------
 void QStylusCalibrationToolbox::SetDisplayAccordingToState()
 {
@@ -516,6 +544,7 @@ void QStylusCalibrationToolbox::NumberOfStylusCalibrationPointsChanged(int aNumb
 void QStylusCalibrationToolbox::OnDataAcquired()
 {
   LOG_TRACE("StylusCalibrationToolbox::OnDataAcquired");
+  PLUS_SCOPED_TIMER("StylusCalibrationAcquisition");
 
   if (m_State == ToolboxState_StartupDelay)
   {
@@ -59,6 +59,15 @@ public:
   */
   virtual void RefreshContent();
 
+  /*!
+    Countdown is refreshed by the timer, the calibration progress by the acquired data
+    and the result only when the stylus tip moves
+  */
+  virtual int GetRefreshTriggers();
+
+  /*! Stylus tip to reference transform, displayed when the calibration is done */
+  virtual std::vector<igsioTransformName> GetWatchedTransformNames();
+
   /*!
     Sets display mode (visibility of actors) according to the current state - implementation of a pure virtual function
   */
@@ -5,6 +5,7 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 // Local includes
+#include "PlusPerformanceMonitor.h"
 #include "QTemporalCalibrationToolbox.h"
 #include "fCalMainWindow.h"
 #include "vtkPlusVisualizationController.h"
@@ -25,10 +26,13 @@ See License.txt for details.
 
 // VTK includes
 #include <vtkAbstractArray.h>
+#include <vtkAxis.h>
 #include <vtkBox.h>
 #include <vtkChartXY.h>
+#include <vtkCommand.h>
 #include <vtkContextScene.h>
 #include <vtkContextView.h>
+#include <vtkDoubleArray.h>
 #include <vtkPNGWriter.h>
 #include <vtkPlot.h>
 #include <vtkRenderWindow.h>
@@ -38,12 +42,161 @@ See License.txt for details.
 #include <vtkWindowToImageFilter.h>
 #include <vtkXMLUtilities.h>
 
+// STL includes
+#include <algorithm>
+#include <cmath>
+
 //-----------------------------------------------------------------------------
 
 namespace
 {
   const double INVALID_OFFSET = std::numeric_limits<double>::infinity();
   const double NEGLIGIBLE_OFFSET_DIFFERENCE_SEC = 0.0001;
+
+  const int MINIMUM_PLOT_WIDTH_PX = 800;
+  const int SAVED_PLOT_WIDTH_PX = 1600;
+  const double PLOT_VALUE_RANGE_MARGIN = 0.05;
+
+  //-----------------------------------------------------------------------------
+  /*! Index of the first sample that is not before the given time. Samples are sorted by time. */
+  vtkIdType FindFirstSampleNotBefore(vtkDataArray* timeArray, double timeSec)
+  {
+    vtkIdType first = 0;
+    vtkIdType count = timeArray->GetNumberOfTuples();
+    while (count > 0)
+    {
+      vtkIdType step = count / 2;
+      if (timeArray->GetTuple1(first + step) < timeSec)
+      {
+        first += step + 1;
+        count -= step + 1;
+      }
+      else
+      {
+        count = step;
+      }
+    }
+    return first;
+  }
+
+  //-----------------------------------------------------------------------------
+  /*!
+    Copy the samples of a signal table (time, value) within the given time range into the output table,
+    keeping only the lowest and highest sample of each of the numberOfBins equal time intervals.
+    If an interval is not wider than a pixel column, the drawn line cannot be told apart from the full
+    resolution one. The nearest sample outside of the range is kept on both sides, so that the line reaches
+    the edges of the chart.
+  */
+  void DecimateSignalMinMax(vtkTable* input, double fromTimeSec, double toTimeSec, int numberOfBins, vtkTable* output)
+  {
+    if (output->GetNumberOfColumns() != 2)
+    {
+      output->RemoveAllColumns();
+      vtkSmartPointer<vtkDoubleArray> outputTimeArray = vtkSmartPointer<vtkDoubleArray>::New();
+      output->AddColumn(outputTimeArray);
+      vtkSmartPointer<vtkDoubleArray> outputValueArray = vtkSmartPointer<vtkDoubleArray>::New();
+      output->AddColumn(outputValueArray);
+    }
+    vtkDoubleArray* outputTimes = vtkDoubleArray::SafeDownCast(output->GetColumn(0));
+    vtkDoubleArray* outputValues = vtkDoubleArray::SafeDownCast(output->GetColumn(1));
+    outputTimes->Reset();
+    outputValues->Reset();
+
+    vtkDataArray* times = (input->GetNumberOfColumns() >= 2 ? vtkDataArray::SafeDownCast(input->GetColumn(0)) : NULL);
+    vtkDataArray* values = (input->GetNumberOfColumns() >= 2 ? vtkDataArray::SafeDownCast(input->GetColumn(1)) : NULL);
+    if (times == NULL || values == NULL || times->GetNumberOfTuples() == 0 || toTimeSec <= fromTimeSec || numberOfBins < 1)
+    {
+      output->Modified();
+      return;
+    }
+    outputTimes->SetName(times->GetName());
+    outputValues->SetName(values->GetName());
+
+    vtkIdType firstIndex = std::max<vtkIdType>(FindFirstSampleNotBefore(times, fromTimeSec) - 1, 0);
+    vtkIdType lastIndex = std::min<vtkIdType>(FindFirstSampleNotBefore(times, toTimeSec), times->GetNumberOfTuples() - 1);
+
+    double binsPerSec = numberOfBins / (toTimeSec - fromTimeSec);
+    vtkIdType sampleIndex = firstIndex;
+    while (sampleIndex <= lastIndex)
+    {
+      // The samples outside of the range get their own bins (-1 and numberOfBins)
+      int bin = std::min(std::max(static_cast<int>(floor((times->GetTuple1(sampleIndex) - fromTimeSec) * binsPerSec)), -1), numberOfBins);
+      vtkIdType minIndex = sampleIndex;
+      vtkIdType maxIndex = sampleIndex;
+      for (++sampleIndex; sampleIndex <= lastIndex; ++sampleIndex)
+      {
+        int sampleBin = std::min(std::max(static_cast<int>(floor((times->GetTuple1(sampleIndex) - fromTimeSec) * binsPerSec)), -1), numberOfBins);
+        if (sampleBin != bin)
+        {
+          break;
+        }
+        double value = values->GetTuple1(sampleIndex);
+        if (value < values->GetTuple1(minIndex))
+        {
+          minIndex = sampleIndex;
+        }
+        if (value > values->GetTuple1(maxIndex))
+        {
+          maxIndex = sampleIndex;
+        }
+      }
+
+      // Keep the original order of the extremes, so the line does not go back in time
+      vtkIdType firstExtremeIndex = std::min(minIndex, maxIndex);
+      vtkIdType secondExtremeIndex = std::max(minIndex, maxIndex);
+      outputTimes->InsertNextValue(times->GetTuple1(firstExtremeIndex));
+      outputValues->InsertNextValue(values->GetTuple1(firstExtremeIndex));
+      if (secondExtremeIndex != firstExtremeIndex)
+      {
+        outputTimes->InsertNextValue(times->GetTuple1(secondExtremeIndex));
+        outputValues->InsertNextValue(values->GetTuple1(secondExtremeIndex));
+      }
+    }
+
+    output->Modified();
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Extend the time and value ranges to contain all samples of a signal table (time, value) */
+  void ExpandSignalRange(vtkTable* signal, double timeRange[2], double valueRange[2])
+  {
+    if (signal->GetNumberOfColumns() < 2 || signal->GetNumberOfRows() == 0)
+    {
+      return;
+    }
+    vtkDataArray* times = vtkDataArray::SafeDownCast(signal->GetColumn(0));
+    vtkDataArray* values = vtkDataArray::SafeDownCast(signal->GetColumn(1));
+    if (times == NULL || values == NULL)
+    {
+      return;
+    }
+    double range[2] = { 0.0, 0.0 };
+    times->GetRange(range, 0);
+    timeRange[0] = std::min(timeRange[0], range[0]);
+    timeRange[1] = std::max(timeRange[1], range[1]);
+    values->GetRange(range, 0);
+    valueRange[0] = std::min(valueRange[0], range[0]);
+    valueRange[1] = std::max(valueRange[1], range[1]);
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Show the given ranges and keep them until the user pans or zooms */
+  void SetChartRange(vtkChartXY* chart, const double timeRange[2], const double valueRange[2])
+  {
+    if (timeRange[0] >= timeRange[1] || valueRange[0] > valueRange[1])
+    {
+      return;
+    }
+    double valueMargin = std::max(PLOT_VALUE_RANGE_MARGIN * (valueRange[1] - valueRange[0]), 1e-6);
+
+    vtkAxis* timeAxis = chart->GetAxis(vtkAxis::BOTTOM);
+    timeAxis->SetBehavior(vtkAxis::FIXED);
+    timeAxis->SetRange(timeRange[0], timeRange[1]);
+
+    vtkAxis* valueAxis = chart->GetAxis(vtkAxis::LEFT);
+    valueAxis->SetBehavior(vtkAxis::FIXED);
+    valueAxis->SetRange(valueRange[0] - valueMargin, valueRange[1] + valueMargin);
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -68,11 +221,17 @@ QTemporalCalibrationToolbox::QTemporalCalibrationToolbox(fCalMainWindow* aParent
   , TemporalCalibrationPlotsWindow(NULL)
   , UncalibratedPlotContextView(NULL)
   , CalibratedPlotContextView(NULL)
+  , UncalibratedChart(vtkSmartPointer<vtkChartXY>::New())
+  , CalibratedChart(vtkSmartPointer<vtkChartXY>::New())
+  , UncalibratedPlotFixedSignal(vtkSmartPointer<vtkTable>::New())
+  , UncalibratedPlotMovingSignal(vtkSmartPointer<vtkTable>::New())
+  , CalibratedPlotFixedSignal(vtkSmartPointer<vtkTable>::New())
+  , CalibratedPlotMovingSignal(vtkSmartPointer<vtkTable>::New())
+  , PlotsOutdated(true)
   , FixedChannel(NULL)
   , FixedType(vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_NONE)
   , MovingChannel(NULL)
   , MovingType(vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_NONE)
-  , TemporalCalibrationAlgo(vtkSmartPointer<vtkPlusTemporalCalibrationAlgo>::New())
   , RequestedFixedChannel("")
   , RequestedMovingChannel("")
   , SaveFileButton(nullptr)
@@ -209,6 +368,16 @@ void QTemporalCalibrationToolbox::OnActivated()
   SetDisplayAccordingToState();
 }
 
+//-----------------------------------------------------------------------------
+vtkPlusTemporalCalibrationAlgo* QTemporalCalibrationToolbox::GetTemporalCalibrationAlgo()
+{
+  if (this->TemporalCalibrationAlgo == NULL)
+  {
+    this->TemporalCalibrationAlgo = vtkSmartPointer<vtkPlusTemporalCalibrationAlgo>::New();
+  }
+  return this->TemporalCalibrationAlgo;
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus QTemporalCalibrationToolbox::ReadConfiguration(vtkXMLDataElement* aConfig)
 {
@@ -250,13 +419,13 @@ PlusStatus QTemporalCalibrationToolbox::ReadConfiguration(vtkXMLDataElement* aCo
     LOG_WARNING("Unable to read TemporalCalibrationDurationSec attribute from fCal element of the device set configuration, default value '" << TemporalCalibrationDurationSec << "' will be used");
   }
 
-  if (this->TemporalCalibrationAlgo->ReadConfiguration(aConfig) != PLUS_SUCCESS)
+  if (this->GetTemporalCalibrationAlgo()->ReadConfiguration(aConfig) != PLUS_SUCCESS)
   {
     LOG_ERROR("Unable to configure temporal calibration algorithm.");
     this->SetState(ToolboxState_Error);
   }
 
-  std::vector<int> clipping = this->TemporalCalibrationAlgo->GetVideoClipRectangle();
+  std::vector<int> clipping = this->GetTemporalCalibrationAlgo()->GetVideoClipRectangle();
   this->LineSegmenter->SetClipRectangle(clipping.data(), &(clipping.data()[2]));
 
   if (fCalElement->GetAttribute("FixedChannelId") != NULL)
@@ -281,6 +450,12 @@ PlusStatus QTemporalCalibrationToolbox::ReadConfiguration(vtkXMLDataElement* aCo
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+int QTemporalCalibrationToolbox::GetRefreshTriggers()
+{
+  return ToolboxRefreshTrigger_NewData | ToolboxRefreshTrigger_StateChanged;
+}
+
 //-----------------------------------------------------------------------------
 void QTemporalCalibrationToolbox::RefreshContent()
 {
@@ -292,34 +467,35 @@ void QTemporalCalibrationToolbox::RefreshContent()
 
   vtkPlusDataSource* selectedChannelVideoSource;
   m_ParentMainWindow->GetVisualizationController()->GetSelectedChannel()->GetVideoSource(selectedChannelVideoSource);
+  // Only the video shown on the canvas is segmented, so the image of the current tick can be taken from the shared snapshot
   if (this->FixedChannel != NULL && this->FixedType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_VIDEO)
   {
-    igsioTrackedFrame frame;
-    if (this->FixedChannel->GetTrackedFrame(frame) == PLUS_SUCCESS)
+    vtkPlusDataSource* fixedVideoSource(NULL);
+    this->FixedChannel->GetVideoSource(fixedVideoSource);
+    if (fixedVideoSource != nullptr &&
+        fixedVideoSource == selectedChannelVideoSource
+       )
     {
-      vtkPlusDataSource* fixedVideoSource;
-      this->FixedChannel->GetVideoSource(fixedVideoSource);
-      if (fixedVideoSource != nullptr &&
-          fixedVideoSource == selectedChannelVideoSource
-         )
+      igsioTrackedFrame* frame = m_ParentMainWindow->GetVisualizationController()->GetTrackedFrameSnapshot(true);
+      if (frame != NULL)
       {
-        SegmentAndDisplayLine(frame);
+        SegmentAndDisplayLine(*frame);
       }
     }
   }
 
   if (this->MovingChannel != NULL && this->MovingType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_VIDEO)
   {
-    igsioTrackedFrame frame;
-    if (this->MovingChannel->GetTrackedFrame(frame) == PLUS_SUCCESS)
+    vtkPlusDataSource* movingVideoSource(NULL);
+    this->MovingChannel->GetVideoSource(movingVideoSource);
+    if (movingVideoSource != nullptr &&
+        movingVideoSource == selectedChannelVideoSource
+       )
     {
-      vtkPlusDataSource* movingVideoSource;
-      this->MovingChannel->GetVideoSource(movingVideoSource);
-      if (movingVideoSource != nullptr &&
-          movingVideoSource == selectedChannelVideoSource
-         )
+      igsioTrackedFrame* frame = m_ParentMainWindow->GetVisualizationController()->GetTrackedFrameSnapshot(true);
+      if (frame != NULL)
       {
-        SegmentAndDisplayLine(frame);
+        SegmentAndDisplayLine(*frame);
       }
     }
   }
@@ -677,30 +853,30 @@ void QTemporalCalibrationToolbox::ComputeCalibrationResults()
 
   QApplication::processEvents();
 
-  this->TemporalCalibrationAlgo->SetFixedFrames(TemporalCalibrationFixedData, this->FixedType);
+  this->GetTemporalCalibrationAlgo()->SetFixedFrames(TemporalCalibrationFixedData, this->FixedType);
   if (this->FixedType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_TRACKER)
   {
-    this->TemporalCalibrationAlgo->SetFixedProbeToReferenceTransformName(std::string(ui.comboBox_FixedSourceValue->currentText().toLatin1()));
+    this->GetTemporalCalibrationAlgo()->SetFixedProbeToReferenceTransformName(std::string(ui.comboBox_FixedSourceValue->currentText().toLatin1()));
   }
-  this->TemporalCalibrationAlgo->SetMovingFrames(TemporalCalibrationMovingData, this->MovingType);
+  this->GetTemporalCalibrationAlgo()->SetMovingFrames(TemporalCalibrationMovingData, this->MovingType);
   if (this->MovingType == vtkPlusTemporalCalibrationAlgo::FRAME_TYPE_TRACKER)
   {
-    this->TemporalCalibrationAlgo->SetMovingProbeToReferenceTransformName(std::string(ui.comboBox_MovingSourceValue->currentText().toLatin1()));
+    this->GetTemporalCalibrationAlgo()->SetMovingProbeToReferenceTransformName(std::string(ui.comboBox_MovingSourceValue->currentText().toLatin1()));
   }
 
-  this->TemporalCalibrationAlgo->SetSamplingResolutionSec(0.001);
+  this->GetTemporalCalibrationAlgo()->SetSamplingResolutionSec(0.001);
 
   //  Calculate the time-offset
   vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR error = vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR_NONE;
   std::string errorStr;
   std::ostringstream strs;
-  if (this->TemporalCalibrationAlgo->Update(error) != PLUS_SUCCESS)
+  if (this->GetTemporalCalibrationAlgo()->Update(error) != PLUS_SUCCESS)
   {
     switch (error)
     {
       case vtkPlusTemporalCalibrationAlgo::TEMPORAL_CALIBRATION_ERROR_RESULT_ABOVE_THRESHOLD:
         double correlation;
-        this->TemporalCalibrationAlgo->GetBestCorrelation(correlation);
+        this->GetTemporalCalibrationAlgo()->GetBestCorrelation(correlation);
 
         strs << "Result above threshold. " << correlation;
         errorStr = strs.str();
@@ -753,7 +929,7 @@ void QTemporalCalibrationToolbox::ComputeCalibrationResults()
 
   // Get result
   double movingLagSec = 0;
-  if (this->TemporalCalibrationAlgo->GetMovingLagSec(movingLagSec) != PLUS_SUCCESS)
+  if (this->GetTemporalCalibrationAlgo()->GetMovingLagSec(movingLagSec) != PLUS_SUCCESS)
   {
     LOG_ERROR("Cannot determine time lag, temporal calibration failed");
     CancelCalibration();
@@ -776,16 +952,26 @@ void QTemporalCalibrationToolbox::ComputeCalibrationResults()
   ui.label_State->setText(tr("Current moving time offset: %1 s").arg(movingLagSec));
 
   // Save metric tables
-  this->TemporalCalibrationAlgo->GetFixedPositionSignal(this->FixedPositionMetric);
+  this->GetTemporalCalibrationAlgo()->GetFixedPositionSignal(this->FixedPositionMetric);
   this->FixedPositionMetric->GetColumn(0)->SetName("Time [s]");
   this->FixedPositionMetric->GetColumn(1)->SetName("Fixed signal");
-  this->TemporalCalibrationAlgo->GetUncalibratedMovingPositionSignal(this->UncalibratedMovingPositionMetric);
+  this->GetTemporalCalibrationAlgo()->GetUncalibratedMovingPositionSignal(this->UncalibratedMovingPositionMetric);
   this->UncalibratedMovingPositionMetric->GetColumn(0)->SetName("Time [s]");
   this->UncalibratedMovingPositionMetric->GetColumn(1)->SetName("Moving signal before calibration");
-  this->TemporalCalibrationAlgo->GetCalibratedMovingPositionSignal(this->CalibratedMovingPositionMetric);
+  this->GetTemporalCalibrationAlgo()->GetCalibratedMovingPositionSignal(this->CalibratedMovingPositionMetric);
   this->CalibratedMovingPositionMetric->GetColumn(0)->SetName("Time [s]");
   this->CalibratedMovingPositionMetric->GetColumn(1)->SetName("Moving signal after calibration");
 
+  // Update the plots in place if the report window is open
+  if (TemporalCalibrationPlotsWindow != NULL && TemporalCalibrationPlotsWindow->isVisible())
+  {
+    UpdatePlots(true);
+  }
+  else
+  {
+    this->PlotsOutdated = true;
+  }
+
   TemporalCalibrationFixedData->Clear();
   TemporalCalibrationMovingData->Clear();
 
@@ -807,6 +993,7 @@ void QTemporalCalibrationToolbox::ComputeCalibrationResults()
 void QTemporalCalibrationToolbox::DoCalibration()
 {
   LOG_TRACE("TemporalCalibrationToolbox::DoCalibration");
+  PLUS_SCOPED_TIMER("TemporalCalibrationAcquisition");
 
   // Get current time
   double currentTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
@@ -914,121 +1101,176 @@ void QTemporalCalibrationToolbox::CancelCalibration()
 //-----------------------------------------------------------------------------
 void QTemporalCalibrationToolbox::ShowPlotsToggled(bool aOn)
 {
-  // Delete objects if toggled off, make sure they are deleted when toggled on
-  if (TemporalCalibrationPlotsWindow != NULL)
+  // The window is built once and only hidden when toggled off, so that it opens instantly next time
+  if (!aOn)
   {
-    disconnect(this->SaveFileButton, &QPushButton::clicked, this, &QTemporalCalibrationToolbox::OnSavePlotsRequested);
-    this->SaveFileButton = nullptr;
-    delete TemporalCalibrationPlotsWindow;
-    TemporalCalibrationPlotsWindow = NULL;
+    if (TemporalCalibrationPlotsWindow != NULL)
+    {
+      TemporalCalibrationPlotsWindow->hide();
+    }
+    return;
   }
 
-  if (UncalibratedPlotContextView != NULL)
+  if (TemporalCalibrationPlotsWindow == NULL)
   {
-    UncalibratedPlotContextView->Delete();
-    UncalibratedPlotContextView = NULL;
+    CreatePlotsWindow();
+    TemporalCalibrationPlotsWindow->move(mapToGlobal(QPoint(ui.pushButton_ShowPlots->x() + ui.pushButton_ShowPlots->width(), 20)));
   }
 
-  if (CalibratedPlotContextView != NULL)
-  {
-    CalibratedPlotContextView->Delete();
-    CalibratedPlotContextView = NULL;
-  }
+  TemporalCalibrationPlotsWindow->show();
 
-  if (aOn)
+  if (this->PlotsOutdated)
   {
-    // Create window and layout
-    TemporalCalibrationPlotsWindow = new QWidget(this, Qt::Tool);
-    TemporalCalibrationPlotsWindow->setMinimumSize(QSize(800, 600));
-    TemporalCalibrationPlotsWindow->setWindowTitle(tr("Temporal Calibration Report"));
+    // The plot widths are known only after the window is shown
+    UpdatePlots(true);
+  }
+}
 
-    // Install event filter that is called on closing the window
-    TemporalCalibrationPlotsWindow->installEventFilter(this);
+//-----------------------------------------------------------------------------
+void QTemporalCalibrationToolbox::CreatePlotsWindow()
+{
+  // Create window and layout
+  TemporalCalibrationPlotsWindow = new QWidget(this, Qt::Tool);
+  TemporalCalibrationPlotsWindow->setMinimumSize(QSize(MINIMUM_PLOT_WIDTH_PX, 600));
+  TemporalCalibrationPlotsWindow->setWindowTitle(tr("Temporal Calibration Report"));
 
-    QGridLayout* gridPlotLayout = new QGridLayout(TemporalCalibrationPlotsWindow);
-    gridPlotLayout->setMargin(0);
-    gridPlotLayout->setSpacing(4);
+  // Install event filter that is called on closing the window
+  TemporalCalibrationPlotsWindow->installEventFilter(this);
 
-    // Uncalibrated chart view
-    QVTKOpenGLNativeWidget* uncalibratedPlotVtkWidget = new QVTKOpenGLNativeWidget(TemporalCalibrationPlotsWindow);
+  QGridLayout* gridPlotLayout = new QGridLayout(TemporalCalibrationPlotsWindow);
+  gridPlotLayout->setMargin(0);
+  gridPlotLayout->setSpacing(4);
 
-    UncalibratedPlotContextView = vtkContextView::New();
-    UncalibratedPlotContextView->GetRenderer()->SetBackground(1.0, 1.0, 1.0);
+  // Uncalibrated chart view
+  QVTKOpenGLNativeWidget* uncalibratedPlotVtkWidget = new QVTKOpenGLNativeWidget(TemporalCalibrationPlotsWindow);
 
-    vtkSmartPointer<vtkChartXY> uncalibratedChart = vtkSmartPointer<vtkChartXY>::New();
-    uncalibratedChart->Register(UncalibratedPlotContextView);
+  UncalibratedPlotContextView = vtkContextView::New();
+  UncalibratedPlotContextView->GetRenderer()->SetBackground(1.0, 1.0, 1.0);
 
-    vtkPlot* uncalibratedTrackerMetricLine = uncalibratedChart->AddPlot(vtkChart::LINE);
-    uncalibratedTrackerMetricLine->SetInputData(UncalibratedMovingPositionMetric, 0, 1);
-    uncalibratedTrackerMetricLine->SetColor(1, 0, 0);
-    uncalibratedTrackerMetricLine->SetWidth(1.0);
+  vtkPlot* uncalibratedTrackerMetricLine = UncalibratedChart->AddPlot(vtkChart::LINE);
+  uncalibratedTrackerMetricLine->SetInputData(UncalibratedPlotMovingSignal, 0, 1);
+  uncalibratedTrackerMetricLine->SetColor(1, 0, 0);
+  uncalibratedTrackerMetricLine->SetWidth(1.0);
 
-    vtkPlot* videoPositionMetricLineU = uncalibratedChart->AddPlot(vtkChart::LINE);
-    videoPositionMetricLineU->SetInputData(FixedPositionMetric, 0, 1);
-    videoPositionMetricLineU->SetColor(0, 0, 1);
-    videoPositionMetricLineU->SetWidth(1.0);
+  vtkPlot* videoPositionMetricLineU = UncalibratedChart->AddPlot(vtkChart::LINE);
+  videoPositionMetricLineU->SetInputData(UncalibratedPlotFixedSignal, 0, 1);
+  videoPositionMetricLineU->SetColor(0, 0, 1);
+  videoPositionMetricLineU->SetWidth(1.0);
 
-    uncalibratedChart->SetShowLegend(true);
-    UncalibratedPlotContextView->GetScene()->AddItem(uncalibratedChart);
+  UncalibratedChart->SetShowLegend(true);
+  UncalibratedChart->AddObserver(vtkCommand::InteractionEvent, this, &QTemporalCalibrationToolbox::OnPlotInteraction);
+  UncalibratedPlotContextView->GetScene()->AddItem(UncalibratedChart);
 
 #if VTK_MAJOR_VERSION < 9
-    uncalibratedPlotVtkWidget->GetRenderWindow()->AddRenderer(UncalibratedPlotContextView->GetRenderer());
-    uncalibratedPlotVtkWidget->GetRenderWindow()->SetSize(800, 600);
+  uncalibratedPlotVtkWidget->GetRenderWindow()->AddRenderer(UncalibratedPlotContextView->GetRenderer());
+  uncalibratedPlotVtkWidget->GetRenderWindow()->SetSize(800, 600);
 #else
-    uncalibratedPlotVtkWidget->renderWindow()->AddRenderer(UncalibratedPlotContextView->GetRenderer());
-    uncalibratedPlotVtkWidget->renderWindow()->SetSize(800, 600);
+  uncalibratedPlotVtkWidget->renderWindow()->AddRenderer(UncalibratedPlotContextView->GetRenderer());
+  uncalibratedPlotVtkWidget->renderWindow()->SetSize(800, 600);
 #endif
 
-    gridPlotLayout->addWidget(uncalibratedPlotVtkWidget, 0, 0);
-
-    // Calibrated chart view
-    QVTKOpenGLNativeWidget* calibratedPlotVtkWidget = new QVTKOpenGLNativeWidget(TemporalCalibrationPlotsWindow);
+  gridPlotLayout->addWidget(uncalibratedPlotVtkWidget, 0, 0);
 
-    CalibratedPlotContextView = vtkContextView::New();
-    CalibratedPlotContextView->GetRenderer()->SetBackground(1.0, 1.0, 1.0);
+  // Calibrated chart view
+  QVTKOpenGLNativeWidget* calibratedPlotVtkWidget = new QVTKOpenGLNativeWidget(TemporalCalibrationPlotsWindow);
 
-    vtkSmartPointer<vtkChartXY> calibratedChart = vtkSmartPointer<vtkChartXY>::New();
-    calibratedChart->Register(CalibratedPlotContextView);
+  CalibratedPlotContextView = vtkContextView::New();
+  CalibratedPlotContextView->GetRenderer()->SetBackground(1.0, 1.0, 1.0);
 
-    vtkPlot* calibratedTrackerMetricLine = calibratedChart->AddPlot(vtkChart::LINE);
-    calibratedTrackerMetricLine->SetInputData(CalibratedMovingPositionMetric, 0, 1);
-    calibratedTrackerMetricLine->SetColor(0, 1, 0);
-    calibratedTrackerMetricLine->SetWidth(1.0);
+  vtkPlot* calibratedTrackerMetricLine = CalibratedChart->AddPlot(vtkChart::LINE);
+  calibratedTrackerMetricLine->SetInputData(CalibratedPlotMovingSignal, 0, 1);
+  calibratedTrackerMetricLine->SetColor(0, 1, 0);
+  calibratedTrackerMetricLine->SetWidth(1.0);
 
-    vtkPlot* videoPositionMetricLineC = calibratedChart->AddPlot(vtkChart::LINE);
-    videoPositionMetricLineC->SetInputData(FixedPositionMetric, 0, 1);
-    videoPositionMetricLineC->SetColor(0, 0, 1);
-    videoPositionMetricLineC->SetWidth(1.0);
+  vtkPlot* videoPositionMetricLineC = CalibratedChart->AddPlot(vtkChart::LINE);
+  videoPositionMetricLineC->SetInputData(CalibratedPlotFixedSignal, 0, 1);
+  videoPositionMetricLineC->SetColor(0, 0, 1);
+  videoPositionMetricLineC->SetWidth(1.0);
 
-    calibratedChart->SetShowLegend(true);
-    CalibratedPlotContextView->GetScene()->AddItem(calibratedChart);
+  CalibratedChart->SetShowLegend(true);
+  CalibratedChart->AddObserver(vtkCommand::InteractionEvent, this, &QTemporalCalibrationToolbox::OnPlotInteraction);
+  CalibratedPlotContextView->GetScene()->AddItem(CalibratedChart);
 
 #if VTK_MAJOR_VERSION < 9
-    calibratedPlotVtkWidget->GetRenderWindow()->AddRenderer(CalibratedPlotContextView->GetRenderer());
-    calibratedPlotVtkWidget->GetRenderWindow()->SetSize(800, 600);
+  calibratedPlotVtkWidget->GetRenderWindow()->AddRenderer(CalibratedPlotContextView->GetRenderer());
+  calibratedPlotVtkWidget->GetRenderWindow()->SetSize(800, 600);
 #else
-    calibratedPlotVtkWidget->renderWindow()->AddRenderer(CalibratedPlotContextView->GetRenderer());
-    calibratedPlotVtkWidget->renderWindow()->SetSize(800, 600);
+  calibratedPlotVtkWidget->renderWindow()->AddRenderer(CalibratedPlotContextView->GetRenderer());
+  calibratedPlotVtkWidget->renderWindow()->SetSize(800, 600);
 #endif
 
-    gridPlotLayout->addWidget(calibratedPlotVtkWidget, 1, 0);
+  gridPlotLayout->addWidget(calibratedPlotVtkWidget, 1, 0);
 
-    QWidget* actionBar = new QWidget();
-    QHBoxLayout* layout = new QHBoxLayout(actionBar);
-    layout->setMargin(4);
-    layout->setSpacing(0);
-    layout->addSpacerItem(new QSpacerItem(5, 5, QSizePolicy::MinimumExpanding, QSizePolicy::Fixed));
-    this->SaveFileButton = new QPushButton(tr("Save..."));
-    layout->addWidget(this->SaveFileButton);
-    actionBar->setLayout(layout);
-    connect(this->SaveFileButton, &QPushButton::clicked, this, &QTemporalCalibrationToolbox::OnSavePlotsRequested);
+  QWidget* actionBar = new QWidget();
+  QHBoxLayout* layout = new QHBoxLayout(actionBar);
+  layout->setMargin(4);
+  layout->setSpacing(0);
+  layout->addSpacerItem(new QSpacerItem(5, 5, QSizePolicy::MinimumExpanding, QSizePolicy::Fixed));
+  this->SaveFileButton = new QPushButton(tr("Save..."));
+  layout->addWidget(this->SaveFileButton);
+  actionBar->setLayout(layout);
+  connect(this->SaveFileButton, &QPushButton::clicked, this, &QTemporalCalibrationToolbox::OnSavePlotsRequested);
 
-    gridPlotLayout->addWidget(actionBar, 2, 0);
+  gridPlotLayout->addWidget(actionBar, 2, 0);
 
-    // Position and show window
-    TemporalCalibrationPlotsWindow->setLayout(gridPlotLayout);
-    TemporalCalibrationPlotsWindow->move(mapToGlobal(QPoint(ui.pushButton_ShowPlots->x() + ui.pushButton_ShowPlots->width(), 20)));
-    TemporalCalibrationPlotsWindow->show();
+  TemporalCalibrationPlotsWindow->setLayout(gridPlotLayout);
+}
+
+//-----------------------------------------------------------------------------
+void QTemporalCalibrationToolbox::UpdatePlots(bool aResetRange, int aPlotWidthPx/*=0*/)
+{
+  if (TemporalCalibrationPlotsWindow == NULL)
+  {
+    this->PlotsOutdated = true;
+    return;
+  }
+
+  if (aResetRange)
+  {
+    // Fixed axis ranges, otherwise the chart would zoom out to the decimated data at each update
+    double timeRange[2] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    double uncalibratedValueRange[2] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    double calibratedValueRange[2] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    ExpandSignalRange(this->FixedPositionMetric, timeRange, uncalibratedValueRange);
+    ExpandSignalRange(this->UncalibratedMovingPositionMetric, timeRange, uncalibratedValueRange);
+    ExpandSignalRange(this->FixedPositionMetric, timeRange, calibratedValueRange);
+    ExpandSignalRange(this->CalibratedMovingPositionMetric, timeRange, calibratedValueRange);
+    SetChartRange(UncalibratedChart, timeRange, uncalibratedValueRange);
+    SetChartRange(CalibratedChart, timeRange, calibratedValueRange);
+  }
+
+  UpdateChartSignals(UncalibratedChart, UncalibratedPlotContextView, this->UncalibratedMovingPositionMetric, UncalibratedPlotFixedSignal, UncalibratedPlotMovingSignal, aPlotWidthPx);
+  UpdateChartSignals(CalibratedChart, CalibratedPlotContextView, this->CalibratedMovingPositionMetric, CalibratedPlotFixedSignal, CalibratedPlotMovingSignal, aPlotWidthPx);
+
+  this->PlotsOutdated = false;
+}
+
+//-----------------------------------------------------------------------------
+void QTemporalCalibrationToolbox::UpdateChartSignals(vtkChartXY* aChart, vtkContextView* aView, vtkTable* aMovingMetric, vtkTable* aFixedSignal, vtkTable* aMovingSignal, int aPlotWidthPx)
+{
+  int plotWidthPx = aPlotWidthPx;
+  if (plotWidthPx <= 0)
+  {
+    plotWidthPx = std::max(aView->GetRenderer()->GetSize()[0], MINIMUM_PLOT_WIDTH_PX);
+  }
+
+  // Only the visible time range is decimated, so zooming in reveals the details
+  vtkAxis* timeAxis = aChart->GetAxis(vtkAxis::BOTTOM);
+  DecimateSignalMinMax(this->FixedPositionMetric, timeAxis->GetMinimum(), timeAxis->GetMaximum(), plotWidthPx, aFixedSignal);
+  DecimateSignalMinMax(aMovingMetric, timeAxis->GetMinimum(), timeAxis->GetMaximum(), plotWidthPx, aMovingSignal);
+}
+
+//-----------------------------------------------------------------------------
+void QTemporalCalibrationToolbox::OnPlotInteraction(vtkObject* aCaller, unsigned long aEventId, void* aCallData)
+{
+  // Pan and zoom change the visible time range, refine the level of detail accordingly
+  if (aCaller == UncalibratedChart.GetPointer())
+  {
+    UpdateChartSignals(UncalibratedChart, UncalibratedPlotContextView, this->UncalibratedMovingPositionMetric, UncalibratedPlotFixedSignal, UncalibratedPlotMovingSignal, 0);
+  }
+  else if (aCaller == CalibratedChart.GetPointer())
+  {
+    UpdateChartSignals(CalibratedChart, CalibratedPlotContextView, this->CalibratedMovingPositionMetric, CalibratedPlotFixedSignal, CalibratedPlotMovingSignal, 0);
   }
 }
 
@@ -1083,7 +1325,7 @@ void QTemporalCalibrationToolbox::FixedSignalChanged(int newIndex)
       ui.comboBox_FixedSourceValue->addItem(QString::fromStdString(aSource->GetId()), strVar);
     }
     igsioTrackedFrame frame;
-    if (this->FixedChannel->GetTrackedFrame(frame) != PLUS_SUCCESS)
+    if (vtkPlusVisualizationController::GetLatestTrackedFrame(this->FixedChannel, frame, false) != PLUS_SUCCESS)
     {
       LOG_ERROR("Unable to retrieve tracked frame from channel: " << this->FixedChannel->GetChannelId());
       return;
@@ -1160,7 +1402,7 @@ void QTemporalCalibrationToolbox::MovingSignalChanged(int newIndex)
       ui.comboBox_MovingSourceValue->addItem(QString::fromStdString(aSource->GetId()), strVar);
     }
     igsioTrackedFrame frame;
-    if (this->MovingChannel->GetTrackedFrame(frame) != PLUS_SUCCESS)
+    if (vtkPlusVisualizationController::GetLatestTrackedFrame(this->MovingChannel, frame, false) != PLUS_SUCCESS)
     {
       LOG_ERROR("Unable to retrieve tracked frame from channel: " << this->MovingChannel->GetChannelId());
       return;
@@ -1249,6 +1491,9 @@ void QTemporalCalibrationToolbox::OnSavePlotsRequested()
 
   this->LastSaveDirectory = fileInfo.absolutePath().toStdString();
 
+  // Decimate to the resolution of the saved images
+  UpdatePlots(false, SAVED_PLOT_WIDTH_PX);
+
   // Render plot and save it to file
   vtkSmartPointer<vtkRenderWindow> renderWindow = vtkSmartPointer<vtkRenderWindow>::New();
   renderWindow->AddRenderer(this->UncalibratedPlotContextView->GetRenderer());
@@ -1309,6 +1554,8 @@ void QTemporalCalibrationToolbox::OnSavePlotsRequested()
 #endif
     }
   }
+
+  UpdatePlots(false);
 }
 
 //-----------------------------------------------------------------------------
@@ -23,7 +23,9 @@ See License.txt for details.
 // IGSIO includes
 #include <igsioCommon.h>
 
+class vtkChartXY;
 class vtkContextView;
+class vtkObject;
 class vtkPlusChannel;
 class vtkTable;
 class vtkIGSIOTrackedFrameList;
@@ -66,6 +68,9 @@ public:
   /*! Refresh contents (e.g. GUI elements) of toolbox according to the state in the toolbox controller - implementation of a pure virtual function */
   virtual void RefreshContent();
 
+  /*! The segmented line is updated for each new video frame */
+  virtual int GetRefreshTriggers();
+
   /*! Sets display mode (visibility of actors) according to the current state - implementation of a pure virtual function */
   void SetDisplayAccordingToState();
 
@@ -81,6 +86,9 @@ protected:
   /*! Prints a time value in sec as a string in msec */
   static std::string GetTimeAsString(double timeSec);
 
+  /*! Get the temporal calibration algorithm, create it at the first call */
+  vtkPlusTemporalCalibrationAlgo* GetTemporalCalibrationAlgo();
+
   void SetFreeHandStartupDelaySec(int freeHandStartupDelaySec) {FreeHandStartupDelaySec = freeHandStartupDelaySec;};
   void SegmentAndDisplayLine(igsioTrackedFrame& frame);
 
@@ -117,6 +125,23 @@ protected slots:
   /*! When the user requests to save the calibration plots */
   void OnSavePlotsRequested();
 
+protected:
+  /*! Build the plots window and charts. They are kept until the toolbox is deleted. */
+  void CreatePlotsWindow();
+
+  /*!
+  * Update the plotted signals in place from the metric tables
+  * \param aResetRange Show the whole signals, otherwise keep the zoom of the charts
+  * \param aPlotWidthPx Number of pixel columns the signals are decimated to, the width of the charts if 0
+  */
+  void UpdatePlots(bool aResetRange, int aPlotWidthPx = 0);
+
+  /*! Decimate the fixed and the moving signal to the visible time range of a chart */
+  void UpdateChartSignals(vtkChartXY* aChart, vtkContextView* aView, vtkTable* aMovingMetric, vtkTable* aFixedSignal, vtkTable* aMovingSignal, int aPlotWidthPx);
+
+  /*! Callback of chart pan and zoom, refines the level of detail */
+  void OnPlotInteraction(vtkObject* aCaller, unsigned long aEventId, void* aCallData);
+
 protected:
   /*! Tracked frame for tracking data for temporal calibration */
   vtkSmartPointer<vtkIGSIOTrackedFrameList>        TemporalCalibrationFixedData;
@@ -156,6 +181,17 @@ protected:
   vtkContextView*                                 UncalibratedPlotContextView;
   /*! Chart view for the calibrated plot */
   vtkContextView*                                 CalibratedPlotContextView;
+  /*! Chart of the signals before calibration */
+  vtkSmartPointer<vtkChartXY>                     UncalibratedChart;
+  /*! Chart of the signals after calibration */
+  vtkSmartPointer<vtkChartXY>                     CalibratedChart;
+  /*! Decimated signals displayed in the charts (the fixed signal is decimated separately, as the charts can be zoomed independently) */
+  vtkSmartPointer<vtkTable>                       UncalibratedPlotFixedSignal;
+  vtkSmartPointer<vtkTable>                       UncalibratedPlotMovingSignal;
+  vtkSmartPointer<vtkTable>                       CalibratedPlotFixedSignal;
+  vtkSmartPointer<vtkTable>                       CalibratedPlotMovingSignal;
+  /*! Flag indicating whether the metric tables changed since the plots were updated */
+  bool                                            PlotsOutdated;
 
   vtkPlusChannel*                                 FixedChannel;
   vtkPlusTemporalCalibrationAlgo::FRAME_TYPE      FixedType;
@@ -165,6 +201,7 @@ protected:
   igsioTransformName                               FixedValidationTransformName;
   igsioTransformName                               MovingValidationTransformName;
 
+  /*! Temporal calibration algorithm, created on first use */
   vtkSmartPointer<vtkPlusTemporalCalibrationAlgo> TemporalCalibrationAlgo;
 
   std::string                                     RequestedFixedChannel;
@@ -7,6 +7,7 @@ See License.txt for details.
 #include "QCapturingToolbox.h"
 #include "QVolumeReconstructionToolbox.h"
 #include "fCalMainWindow.h"
+#include "vtkPlusBrickedVolume.h"
 #include "vtkPlusVisualizationController.h"
 
 // PlusLib includes
@@ -17,6 +18,8 @@ See License.txt for details.
 // VTK includes
 #include <vtkImageData.h>
 #include <vtkMarchingContourFilter.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMetaImageWriter.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkRenderer.h>
 #include <vtkXMLUtilities.h>
@@ -24,19 +27,30 @@ See License.txt for details.
 // Qt includes
 #include <QFileDialog>
 
+// STL includes
+#include <iomanip>
+
+static const double MAX_DISPLAYED_VOLUME_SIZE_MB = 256.0; // out-of-core reconstructions are subsampled for display to fit into this size
+
 //-----------------------------------------------------------------------------
 QVolumeReconstructionToolbox::QVolumeReconstructionToolbox(fCalMainWindow* aParentMainWindow, Qt::WindowFlags aFlags)
   : QAbstractToolbox(aParentMainWindow)
   , QWidget(aParentMainWindow, aFlags)
   , m_VolumeReconstructor(NULL)
+  , m_BrickedVolume(NULL)
+  , m_StreamingReconstruction(false)
+  , m_ReconstructedVolumeIsStreamed(false)
+  , m_OutOfCoreReconstruction(false)
+  , m_OutOfCoreMemoryLimitMb(2048.0)
+  , m_ReconstructedVolumeSubsampling(1)
   , m_ReconstructedVolume(NULL)
   , m_VolumeReconstructionConfigFileLoaded(false)
   , m_VolumeReconstructionComplete(false)
   , m_ContouringThreshold(64.0)
+  , m_UseCompression(true)
 {
   ui.setupUi(this);
 
-  m_VolumeReconstructor = vtkPlusVolumeReconstructor::New();
   m_ReconstructedVolume = vtkImageData::New();
 
   // Connect events
@@ -59,6 +73,12 @@ QVolumeReconstructionToolbox::~QVolumeReconstructionToolbox()
     m_VolumeReconstructor = NULL;
   }
 
+  if (m_BrickedVolume != NULL)
+  {
+    m_BrickedVolume->Delete();
+    m_BrickedVolume = NULL;
+  }
+
   if (m_ReconstructedVolume != NULL)
   {
     m_ReconstructedVolume->Delete();
@@ -73,11 +93,36 @@ void QVolumeReconstructionToolbox::OnActivated()
 
   // Try to load volume reconstruction configuration from the device set configuration
   if ((vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData() != NULL)
-      && (m_VolumeReconstructor->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) == PLUS_SUCCESS))
+      && (GetVolumeReconstructor()->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) == PLUS_SUCCESS)
+      && (GetBrickedVolume()->ReadConfiguration(vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()) == PLUS_SUCCESS))
   {
     m_VolumeReconstructionConfigFileLoaded = true;
   }
 
+  // Output file compression is shared with the Capturing toolbox
+  vtkXMLDataElement* fCalElement = NULL;
+  if (vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData() != NULL)
+  {
+    fCalElement = vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData()->FindNestedElementWithName("fCal");
+  }
+  if (fCalElement != NULL && fCalElement->GetAttribute("OutputFileCompression") != NULL)
+  {
+    m_UseCompression = (STRCASECMP(fCalElement->GetAttribute("OutputFileCompression"), "TRUE") == 0);
+  }
+  if (fCalElement != NULL && fCalElement->GetAttribute("VolumeReconstructionStreaming") != NULL)
+  {
+    m_StreamingReconstruction = (STRCASECMP(fCalElement->GetAttribute("VolumeReconstructionStreaming"), "TRUE") == 0);
+  }
+  if (fCalElement != NULL && fCalElement->GetAttribute("VolumeReconstructionOutOfCore") != NULL)
+  {
+    m_OutOfCoreReconstruction = (STRCASECMP(fCalElement->GetAttribute("VolumeReconstructionOutOfCore"), "TRUE") == 0);
+  }
+  double outOfCoreMemoryLimitMb = 0.0;
+  if (fCalElement != NULL && fCalElement->GetScalarAttribute("VolumeReconstructionMemoryLimitMb", outOfCoreMemoryLimitMb) && outOfCoreMemoryLimitMb > 0)
+  {
+    m_OutOfCoreMemoryLimitMb = outOfCoreMemoryLimitMb;
+  }
+
   // Clear results polydata
   if (m_State != ToolboxState_Done)
   {
@@ -112,6 +157,12 @@ void QVolumeReconstructionToolbox::RefreshContent()
   }
 }
 
+//-----------------------------------------------------------------------------
+int QVolumeReconstructionToolbox::GetRefreshTriggers()
+{
+  return ToolboxRefreshTrigger_StateChanged;
+}
+
 //-----------------------------------------------------------------------------
 void QVolumeReconstructionToolbox::SetDisplayAccordingToState()
 {
@@ -276,7 +327,8 @@ void QVolumeReconstructionToolbox::OpenVolumeReconstructionConfig()
   }
 
   // Load volume reconstruction configuration xml
-  if (m_VolumeReconstructor->ReadConfiguration(rootElement) != PLUS_SUCCESS)
+  if (GetVolumeReconstructor()->ReadConfiguration(rootElement) != PLUS_SUCCESS
+      || GetBrickedVolume()->ReadConfiguration(rootElement) != PLUS_SUCCESS)
   {
     m_VolumeReconstructionConfigFileLoaded = false;
 
@@ -297,7 +349,7 @@ void QVolumeReconstructionToolbox::OpenInputImage()
   LOG_TRACE("VolumeReconstructionToolbox::OpenInputImage");
 
   // File open dialog for selecting phantom definition xml
-  QString filter = QString(tr("MHA files ( *.mha );;"));
+  QString filter = QString(tr("Sequence files ( *.mha *.seq.nrrd *.nrrd );;"));
   QString fileName = QFileDialog::getOpenFileName(NULL, QString(tr("Open input sequence metafile image")), "", filter);
 
   if (fileName.isNull())
@@ -369,96 +421,161 @@ PlusStatus QVolumeReconstructionToolbox::ReconstructVolumeFromInputImage()
   m_ParentMainWindow->SetStatusBarProgress(0);
   RefreshContent();
 
-  vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = NULL;
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = GetInputFrames();
+  if (trackedFrameList == NULL)
+  {
+    return PLUS_FAIL;
+  }
 
-  if (ui.comboBox_InputImage->currentText().left(1) == "<" && ui.comboBox_InputImage->currentText().right(1) == ">")       // If unsaved image is selected
+  if (m_StreamingReconstruction || m_OutOfCoreReconstruction)
   {
-    QCapturingToolbox* capturingToolbox = dynamic_cast<QCapturingToolbox*>(m_ParentMainWindow->GetToolbox(ToolboxType_Capturing));
-    if ((capturingToolbox == NULL) || ((trackedFrameList = capturingToolbox->GetRecordedFrames()) == NULL))
+    if (ReconstructBrickedVolume(trackedFrameList) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Unable to get recorded frame list from Capturing toolbox!");
       return PLUS_FAIL;
     }
   }
   else
   {
-    int imageFileNameIndex = -1;
-    if (ui.comboBox_InputImage->itemText(0).left(1) == "<" && ui.comboBox_InputImage->itemText(0).right(1) == ">")           // If unsaved image exists
-    {
-      imageFileNameIndex = ui.comboBox_InputImage->currentIndex() - 1;
-    }
-    else
+    m_ParentMainWindow->SetStatusBarText(QString(" Reconstructing volume ..."));
+    m_ParentMainWindow->SetStatusBarProgress(0);
+    RefreshContent();
+
+    GetVolumeReconstructor()->SetReferenceCoordinateFrame(m_ParentMainWindow->GetReferenceCoordinateFrame().c_str());
+    GetVolumeReconstructor()->SetImageCoordinateFrame(m_ParentMainWindow->GetImageCoordinateFrame().c_str());
+
+    std::string errorDetail;
+    if (GetVolumeReconstructor()->SetOutputExtentFromFrameList(trackedFrameList,
+        m_ParentMainWindow->GetVisualizationController()->GetTransformRepository(), errorDetail) == PLUS_FAIL)
     {
-      imageFileNameIndex = ui.comboBox_InputImage->currentIndex();
+      return PLUS_FAIL;
     }
-    trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
-    if (vtkPlusSequenceIO::Read(m_ImageFileNames.at(imageFileNameIndex).toLatin1().constData(), trackedFrameList) != PLUS_SUCCESS)
+
+    const int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+    for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex += GetVolumeReconstructor()->GetSkipInterval())
     {
-      LOG_ERROR("Unable to load input image file!");
-      return PLUS_FAIL;
+      // Set progress
+      m_ParentMainWindow->SetStatusBarProgress((int)((100.0 * frameIndex) / numberOfFrames + 0.49));
+      RefreshContent();
+
+      igsioTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
+
+      if (m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()->SetTransforms(*frame) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to update transform repository with frame #" << frameIndex);
+        continue;
+      }
+
+      // Add this tracked frame to the reconstructor
+      bool insertedIntoVolume = false;
+      if (GetVolumeReconstructor()->AddTrackedFrame(frame, m_ParentMainWindow->GetVisualizationController()->GetTransformRepository(), frameIndex == 0, frameIndex == numberOfFrames-1, &insertedIntoVolume) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add tracked frame to volume with frame #" << frameIndex);
+        continue;
+      }
     }
+
+    // The transform repository now holds the transforms of the last reconstructed frame
+    m_ParentMainWindow->GetVisualizationController()->InvalidateTrackedFrameSnapshot();
+
+    m_ParentMainWindow->SetStatusBarProgress(0);
+    RefreshContent();
+
+    // The frames are shared with the Capturing toolbox or kept for the next reconstruction, so they are not cleared here
+    trackedFrameList = NULL;
+
+    m_ParentMainWindow->SetStatusBarProgress(0);
+    m_ParentMainWindow->SetStatusBarText(QString(" Filling holes in output volume..."));
+    RefreshContent();
+
+    GetVolumeReconstructor()->ExtractGrayLevels(m_ReconstructedVolume);
   }
+  m_ReconstructedVolumeIsStreamed = (m_StreamingReconstruction || m_OutOfCoreReconstruction);
+
+  // Display result
+  DisplayReconstructedVolume();
+
+  m_ParentMainWindow->SetStatusBarProgress(100);
 
+  m_VolumeReconstructionComplete = true;
+
+  SetState(ToolboxState_Done);
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus QVolumeReconstructionToolbox::ReconstructBrickedVolume(vtkIGSIOTrackedFrameList* aTrackedFrameList)
+{
+  LOG_TRACE("VolumeReconstructionToolbox::ReconstructBrickedVolume");
 
   m_ParentMainWindow->SetStatusBarText(QString(" Reconstructing volume ..."));
   m_ParentMainWindow->SetStatusBarProgress(0);
   RefreshContent();
 
-  m_VolumeReconstructor->SetReferenceCoordinateFrame(m_ParentMainWindow->GetReferenceCoordinateFrame().c_str());
-  m_VolumeReconstructor->SetImageCoordinateFrame(m_ParentMainWindow->GetImageCoordinateFrame().c_str());
+  vtkIGSIOTransformRepository* transformRepository = m_ParentMainWindow->GetVisualizationController()->GetTransformRepository();
+  igsioTransformName imageToReferenceTransformName(m_ParentMainWindow->GetImageCoordinateFrame(), m_ParentMainWindow->GetReferenceCoordinateFrame());
+  vtkSmartPointer<vtkMatrix4x4> imageToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
 
-  std::string errorDetail;
-  if (m_VolumeReconstructor->SetOutputExtentFromFrameList(trackedFrameList,
-      m_ParentMainWindow->GetVisualizationController()->GetTransformRepository(), errorDetail) == PLUS_FAIL)
-  {
-    return PLUS_FAIL;
-  }
-
-  const int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
-  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex += m_VolumeReconstructor->GetSkipInterval())
+  // No pass over the frames is needed to determine the output extent, the volume grows as the frames are inserted.
+  // Out of core only the recently used bricks are kept in memory, the others are in memory-mapped swap files.
+  GetBrickedVolume()->Reset();
+  GetBrickedVolume()->SetMaxResidentMemoryMb(m_OutOfCoreReconstruction ? m_OutOfCoreMemoryLimitMb : 0.0);
+  GetBrickedVolume()->SetSwapDirectory(vtkPlusConfig::GetInstance()->GetOutputDirectory());
+  int numberOfInsertedFrames = 0;
+  const int numberOfFrames = aTrackedFrameList->GetNumberOfTrackedFrames();
+  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex += GetVolumeReconstructor()->GetSkipInterval())
   {
     // Set progress
     m_ParentMainWindow->SetStatusBarProgress((int)((100.0 * frameIndex) / numberOfFrames + 0.49));
     RefreshContent();
 
-    igsioTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
+    igsioTrackedFrame* frame = aTrackedFrameList->GetTrackedFrame(frameIndex);
 
-    if (m_ParentMainWindow->GetVisualizationController()->GetTransformRepository()->SetTransforms(*frame) != PLUS_SUCCESS)
+    if (transformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to update transform repository with frame #" << frameIndex);
       continue;
     }
 
-    // Add this tracked frame to the reconstructor
-    bool insertedIntoVolume = false;
-    if (m_VolumeReconstructor->AddTrackedFrame(frame, m_ParentMainWindow->GetVisualizationController()->GetTransformRepository(), frameIndex == 0, frameIndex == numberOfFrames-1, &insertedIntoVolume) != PLUS_SUCCESS)
+    ToolStatus status(TOOL_INVALID);
+    if (transformRepository->GetTransform(imageToReferenceTransformName, imageToReferenceMatrix, &status) != PLUS_SUCCESS || status != TOOL_OK)
+    {
+      // Frames without valid tracking are skipped, like in the volume reconstructor
+      LOG_DEBUG("Invalid image to reference transform in frame #" << frameIndex << ", the frame is not inserted");
+      continue;
+    }
+
+    if (GetBrickedVolume()->InsertFrame(frame->GetImageData()->GetImage(), imageToReferenceMatrix) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to add tracked frame to volume with frame #" << frameIndex);
       continue;
     }
+    numberOfInsertedFrames++;
   }
 
-  m_ParentMainWindow->SetStatusBarProgress(0);
-  RefreshContent();
+  // The transform repository now holds the transforms of the last reconstructed frame
+  m_ParentMainWindow->GetVisualizationController()->InvalidateTrackedFrameSnapshot();
 
-  trackedFrameList->Clear();
+  if (numberOfInsertedFrames == 0)
+  {
+    LOG_ERROR("No frame could be inserted into the volume");
+    return PLUS_FAIL;
+  }
+
+  LOG_INFO("Reconstructed " << numberOfInsertedFrames << " frames into " << GetBrickedVolume()->GetNumberOfBricks() << " bricks ("
+           << std::fixed << std::setprecision(1) << GetBrickedVolume()->GetAllocatedMemoryMb() << " MB, the bounding box would need "
+           << GetBrickedVolume()->GetBoundingBoxMemoryMb() << " MB, " << GetBrickedVolume()->GetResidentMemoryMb() << " MB resident)");
 
   m_ParentMainWindow->SetStatusBarProgress(0);
-  m_ParentMainWindow->SetStatusBarText(QString(" Filling holes in output volume..."));
+  m_ParentMainWindow->SetStatusBarText(QString(" Creating output volume..."));
   RefreshContent();
 
-  m_VolumeReconstructor->ExtractGrayLevels(m_ReconstructedVolume);
-
-  // Display result
-  DisplayReconstructedVolume();
-
-  m_ParentMainWindow->SetStatusBarProgress(100);
-
-  m_VolumeReconstructionComplete = true;
-
-  SetState(ToolboxState_Done);
-
-  return PLUS_SUCCESS;
+  m_ReconstructedVolumeSubsampling = (m_OutOfCoreReconstruction ? GetBrickedVolume()->GetSubsamplingForMemoryLimit(MAX_DISPLAYED_VOLUME_SIZE_MB) : 1);
+  if (m_ReconstructedVolumeSubsampling > 1)
+  {
+    LOG_INFO("Every " << m_ReconstructedVolumeSubsampling << ". voxel of the reconstructed volume is displayed, the volume is saved in full resolution");
+  }
+  return GetBrickedVolume()->GetDenseVolume(m_ReconstructedVolume, m_ReconstructedVolumeSubsampling);
 }
 
 //-----------------------------------------------------------------------------
@@ -485,9 +602,35 @@ PlusStatus QVolumeReconstructionToolbox::SaveVolumeToFile(QString aOutput)
 {
   LOG_TRACE("VolumeReconstructionToolbox::SaveVolumeToFile(" << aOutput.toLatin1().constData() << ")");
 
-  if (aOutput.right(3).toLower() == QString("mha"))
+  if (aOutput.right(3).toLower() == QString("mha") && m_ReconstructedVolumeIsStreamed && (m_ReconstructedVolumeSubsampling > 1 || !m_UseCompression))
+  {
+    // Written brick by brick, the full resolution volume may not fit into memory
+    if (m_UseCompression)
+    {
+      LOG_WARNING("The reconstructed volume is too large to be compressed, it is saved uncompressed");
+    }
+    if (GetBrickedVolume()->WriteToMetafile(aOutput.toStdString()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to save reconstructed volume in sequence metafile!");
+      return PLUS_FAIL;
+    }
+  }
+  else if (aOutput.right(3).toLower() == QString("mha") && m_ReconstructedVolumeIsStreamed)
   {
-    if (m_VolumeReconstructor->SaveReconstructedVolumeToMetafile(aOutput.toStdString()) != PLUS_SUCCESS)
+    vtkSmartPointer<vtkMetaImageWriter> writer = vtkSmartPointer<vtkMetaImageWriter>::New();
+    writer->SetFileName(aOutput.toLatin1().constData());
+    writer->SetCompression(m_UseCompression);
+    writer->SetInputData(m_ReconstructedVolume);
+    writer->Write();
+    if (writer->GetErrorCode() != 0)
+    {
+      LOG_ERROR("Failed to save reconstructed volume in sequence metafile!");
+      return PLUS_FAIL;
+    }
+  }
+  else if (aOutput.right(3).toLower() == QString("mha"))
+  {
+    if (GetVolumeReconstructor()->SaveReconstructedVolumeToMetafile(aOutput.toStdString(), false, m_UseCompression) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to save reconstructed volume in sequence metafile!");
       return PLUS_FAIL;
@@ -505,11 +648,96 @@ PlusStatus QVolumeReconstructionToolbox::SaveVolumeToFile(QString aOutput)
 }
 
 //-----------------------------------------------------------------------------
-void QVolumeReconstructionToolbox::AddImageFileName(QString aImageFileName)
+void QVolumeReconstructionToolbox::AddImageFileName(QString aImageFileName, vtkIGSIOTrackedFrameList* aFrames/*=NULL*/)
 {
   LOG_TRACE("VolumeReconstructionToolbox::AddImageFileName(" << aImageFileName.toLatin1().constData() << ")");
 
   m_ImageFileNames.append(aImageFileName);
+
+  if (aFrames != NULL)
+  {
+    m_InputFrames = aFrames;
+    m_InputFramesFileName = aImageFileName;
+  }
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkIGSIOTrackedFrameList> QVolumeReconstructionToolbox::GetInputFrames()
+{
+  if (ui.comboBox_InputImage->currentText().left(1) == "<" && ui.comboBox_InputImage->currentText().right(1) == ">")       // If unsaved image is selected
+  {
+    QCapturingToolbox* capturingToolbox = dynamic_cast<QCapturingToolbox*>(m_ParentMainWindow->GetToolbox(ToolboxType_Capturing));
+    if ((capturingToolbox == NULL) || (capturingToolbox->GetRecordedFrames() == NULL))
+    {
+      LOG_ERROR("Unable to get recorded frame list from Capturing toolbox!");
+      return NULL;
+    }
+    return capturingToolbox->GetRecordedFrames();
+  }
+
+  QString imageFileName = GetSelectedImageFileName();
+  if (imageFileName.isEmpty())
+  {
+    LOG_ERROR("No input image is selected!");
+    return NULL;
+  }
+
+  if (m_InputFrames != NULL && m_InputFramesFileName == imageFileName)
+  {
+    LOG_DEBUG("Use the frames of " << imageFileName.toLatin1().constData() << " already in memory");
+    return m_InputFrames;
+  }
+
+  // Only the frames of one file are kept, release the previous ones before reading the new file
+  m_InputFrames = NULL;
+  m_InputFramesFileName.clear();
+
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(imageFileName.toLatin1().constData(), trackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to load input image file!");
+    return NULL;
+  }
+
+  m_InputFrames = trackedFrameList;
+  m_InputFramesFileName = imageFileName;
+  return m_InputFrames;
+}
+
+//-----------------------------------------------------------------------------
+QString QVolumeReconstructionToolbox::GetSelectedImageFileName()
+{
+  if (!ui.comboBox_InputImage->isEnabled())
+  {
+    return QString();
+  }
+
+  int imageFileNameIndex = -1;
+  if (ui.comboBox_InputImage->itemText(0).left(1) == "<" && ui.comboBox_InputImage->itemText(0).right(1) == ">")           // If unsaved image exists
+  {
+    imageFileNameIndex = ui.comboBox_InputImage->currentIndex() - 1;
+  }
+  else
+  {
+    imageFileNameIndex = ui.comboBox_InputImage->currentIndex();
+  }
+  if (imageFileNameIndex < 0 || imageFileNameIndex >= m_ImageFileNames.size())
+  {
+    return QString();
+  }
+
+  return m_ImageFileNames.at(imageFileNameIndex);
+}
+
+//-----------------------------------------------------------------------------
+void QVolumeReconstructionToolbox::ReleaseUnselectedInputFrames()
+{
+  if (m_InputFrames != NULL && m_InputFramesFileName != GetSelectedImageFileName())
+  {
+    LOG_DEBUG("Release the frames of " << m_InputFramesFileName.toLatin1().constData() << " from memory");
+    m_InputFrames = NULL;
+    m_InputFramesFileName.clear();
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -517,6 +745,9 @@ void QVolumeReconstructionToolbox::PopulateImageComboBox()
 {
   LOG_TRACE("VolumeReconstructionToolbox::PopulateImageComboBox");
 
+  // The selection change is handled once the list is complete, so that the frames of the selected file are not released meanwhile
+  ui.comboBox_InputImage->blockSignals(true);
+
   // Clear images combobox
   if (ui.comboBox_InputImage->count() > 0)
   {
@@ -532,6 +763,8 @@ void QVolumeReconstructionToolbox::PopulateImageComboBox()
   if ((capturingToolbox == NULL) || ((recordedFrames = capturingToolbox->GetRecordedFrames()) == NULL))
   {
     LOG_ERROR("Capturing toolbox not found!");
+    ui.comboBox_InputImage->blockSignals(false);
+    InputImageChanged(ui.comboBox_InputImage->currentIndex());
     return;
   }
 
@@ -554,12 +787,22 @@ void QVolumeReconstructionToolbox::PopulateImageComboBox()
   if (ui.comboBox_InputImage->count() > 0)
   {
     ui.comboBox_InputImage->setEnabled(true);
+
+    // Select the recording that the Capturing toolbox has just saved if there is no unsaved one, its frames are already in memory
+    int inputFramesIndex = (m_InputFrames != NULL ? ui.comboBox_InputImage->findText(m_InputFramesFileName) : -1);
+    if (recordedFrames->GetNumberOfTrackedFrames() == 0 && inputFramesIndex >= 0)
+    {
+      ui.comboBox_InputImage->setCurrentIndex(inputFramesIndex);
+    }
   }
   else // Disable the combobox and indicate that it is empty
   {
     ui.comboBox_InputImage->addItem(tr("Open or capture image first"));
     ui.comboBox_InputImage->setEnabled(false);
   }
+
+  ui.comboBox_InputImage->blockSignals(false);
+  InputImageChanged(ui.comboBox_InputImage->currentIndex());
 }
 
 //-----------------------------------------------------------------------------
@@ -567,6 +810,8 @@ void QVolumeReconstructionToolbox::InputImageChanged(int aItemIndex)
 {
   LOG_TRACE("VolumeReconstructionToolbox::InputImageChanged(" << aItemIndex << ")");
 
+  ReleaseUnselectedInputFrames();
+
   SetState(ToolboxState_Idle);
 }
 
@@ -576,6 +821,7 @@ void QVolumeReconstructionToolbox::RecomputeContourFromReconstructedVolume(int a
   LOG_TRACE("VolumeReconstructionToolbox::UpdateContourThresholdLabel(" << aValue << ")");
 
   m_ContouringThreshold = ui.horizontalSlider_ContouringThreshold->value();
+  RequestRefresh();
 
   LOG_INFO("Recomputing controur from reconstructed volume using threshold " << m_ContouringThreshold);
 
@@ -588,23 +834,54 @@ void QVolumeReconstructionToolbox::Reset()
   QAbstractToolbox::Reset();
 
   m_VolumeReconstructionComplete = false;
+  m_ReconstructedVolumeIsStreamed = false;
+  m_ReconstructedVolumeSubsampling = 1;
 
   if (m_VolumeReconstructor != NULL)
   {
     m_VolumeReconstructor->Delete();
     m_VolumeReconstructor = NULL;
   }
+  if (m_BrickedVolume != NULL)
+  {
+    m_BrickedVolume->Delete();
+    m_BrickedVolume = NULL;
+  }
   if (m_ReconstructedVolume != NULL)
   {
     m_ReconstructedVolume->Delete();
     m_ReconstructedVolume = NULL;
   }
-  m_VolumeReconstructor = vtkPlusVolumeReconstructor::New();
   m_ReconstructedVolume = vtkImageData::New();
+
+  m_InputFrames = NULL;
+  m_InputFramesFileName.clear();
 }
 
 //-----------------------------------------------------------------------------
-void QVolumeReconstructionToolbox::OnDeactivated()
+vtkPlusVolumeReconstructor* QVolumeReconstructionToolbox::GetVolumeReconstructor()
 {
+  if (m_VolumeReconstructor == NULL)
+  {
+    m_VolumeReconstructor = vtkPlusVolumeReconstructor::New();
+  }
+  return m_VolumeReconstructor;
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusBrickedVolume* QVolumeReconstructionToolbox::GetBrickedVolume()
+{
+  if (m_BrickedVolume == NULL)
+  {
+    m_BrickedVolume = vtkPlusBrickedVolume::New();
+  }
+  return m_BrickedVolume;
+}
 
+//-----------------------------------------------------------------------------
+void QVolumeReconstructionToolbox::OnDeactivated()
+{
+  // The frames are read from the file again when needed, a long recording must not stay in memory while the toolbox is not used
+  m_InputFrames = NULL;
+  m_InputFramesFileName.clear();
 }
\ No newline at end of file
@@ -14,6 +14,10 @@
 
 #include <QWidget>
 
+#include <vtkIGSIOTrackedFrameList.h>
+#include <vtkSmartPointer.h>
+
+class vtkPlusBrickedVolume;
 class vtkPlusVolumeReconstructor;
 class vtkImageData;
 
@@ -51,6 +55,11 @@ public:
   */
   virtual void RefreshContent();
 
+  /*!
+  * Refresh only on state or threshold changes
+  */
+  virtual int GetRefreshTriggers();
+
   /*! \brief Reset toolbox to initial state - */
   virtual void Reset();
 
@@ -62,8 +71,9 @@ public:
   /*!
   * Add image file name to the list (usually when one is saved in Capturing toolbox)
   * \param aImageFileName Path and filename of the image
+  * \param aFrames Frames of the image if they are already in memory (optional). The list is shared, it is not modified.
   */
-  void AddImageFileName(QString aImageFileName);
+  void AddImageFileName(QString aImageFileName, vtkIGSIOTrackedFrameList* aFrames = NULL);
 
 protected:
   /*!
@@ -72,6 +82,14 @@ protected:
   */
   PlusStatus ReconstructVolumeFromInputImage();
 
+  /*!
+  * Reconstruct the volume in a single pass into a bricked volume that grows as the frames are inserted, then convert it into m_ReconstructedVolume.
+  * In out-of-core mode m_ReconstructedVolume is a subsampled copy for display, the full resolution volume stays in the bricked volume.
+  * \param aTrackedFrameList Input frames
+  * \return Success flag
+  */
+  PlusStatus ReconstructBrickedVolume(vtkIGSIOTrackedFrameList* aTrackedFrameList);
+
   /*!
   * Saves volume to file
   * \param aOutput Output file
@@ -87,6 +105,24 @@ protected:
   */
   void PopulateImageComboBox();
 
+  /*!
+  * Get the frames of the selected input image: the unsaved frames of the Capturing toolbox or the frames of a file.
+  * The frames of the last used file are kept in memory, so reconstructing it again with different settings does not read the file again.
+  */
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> GetInputFrames();
+
+  /*! Get the file name of the selected input image, empty if the unsaved frames of the Capturing toolbox or nothing is selected */
+  QString GetSelectedImageFileName();
+
+  /*! Release the frames kept in memory unless they belong to the selected input image */
+  void ReleaseUnselectedInputFrames();
+
+  /*! Get the volume reconstructor, create it at the first call */
+  vtkPlusVolumeReconstructor* GetVolumeReconstructor();
+
+  /*! Get the bricked volume used for streaming reconstruction, create it at the first call */
+  vtkPlusBrickedVolume* GetBrickedVolume();
+
 protected slots:
   /*! Slot handling open volume reconstruction config button click */
   void OpenVolumeReconstructionConfig();
@@ -107,9 +143,27 @@ protected slots:
   void RecomputeContourFromReconstructedVolume(int aValue);
 
 protected:
-  /*! Volume reconstructor instance */
+  /*! Volume reconstructor instance, created on first use */
   vtkPlusVolumeReconstructor*  m_VolumeReconstructor;
 
+  /*! Bricked volume for streaming reconstruction, created on first use */
+  vtkPlusBrickedVolume*    m_BrickedVolume;
+
+  /*! Flag indicating whether the volume is reconstructed in a single pass into a bricked volume (VolumeReconstructionStreaming attribute of the fCal element) */
+  bool                    m_StreamingReconstruction;
+
+  /*! Flag indicating whether m_ReconstructedVolume has been created by streaming reconstruction (it is saved from there instead of from the volume reconstructor) */
+  bool                    m_ReconstructedVolumeIsStreamed;
+
+  /*! Flag indicating whether the bricks of the streaming reconstruction are stored in swap files (VolumeReconstructionOutOfCore attribute of the fCal element) */
+  bool                    m_OutOfCoreReconstruction;
+
+  /*! Memory limit of the resident bricks in out-of-core reconstruction (VolumeReconstructionMemoryLimitMb attribute of the fCal element) */
+  double                  m_OutOfCoreMemoryLimitMb;
+
+  /*! Subsampling of m_ReconstructedVolume compared to the bricked volume (it is only used for display if larger than 1) */
+  int                     m_ReconstructedVolumeSubsampling;
+
   /*! Reconstructed volume */
   vtkImageData*            m_ReconstructedVolume;
 
@@ -122,12 +176,21 @@ protected:
   /*! Contouring threshold */
   double                  m_ContouringThreshold;
 
+  /*! Flag indicating whether the saved volume is compressed (OutputFileCompression attribute of the fCal element) */
+  bool                    m_UseCompression;
+
   /*! String list containing the file names of the loaded images and the images that have been saved by Capturing toolbox */
   QStringList             m_ImageFileNames;
 
   /*! String to hold the last location of data saved */
   QString                 m_LastSaveLocation;
 
+  /*! Frames of the selected image file (shared, not modified), only kept while the file is selected and the toolbox is active */
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> m_InputFrames;
+
+  /*! File name of the image that m_InputFrames belongs to */
+  QString                 m_InputFramesFileName;
+
 protected:
   Ui::VolumeReconstructionToolbox ui;
 };
@@ -5,13 +5,17 @@
 =========================================================Plus=header=end*/
 
 #include "fCalMainWindow.h"
+#include "vtkIGSIOAccurateTimer.h"
 #include <QApplication>
 
 int main(int argc, char* argv[])
 {
+  // Taken first to measure the time to interactive from the launch of the application
+  double launchTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+
   QApplication app(argc, argv);
 
-  fCalMainWindow mainWindow;
+  fCalMainWindow mainWindow(0, 0, launchTimeSec);
   mainWindow.showMaximized();
 
   mainWindow.Initialize();
@@ -26,6 +26,8 @@ See License.txt for details.
 #include <QPlusStatusIcon.h>
 
 // vtk includes
+#include "vtkIGSIOAccurateTimer.h"
+#include "vtkMatrix4x4.h"
 #include "vtkRenderWindow.h"
 
 // Qt includes
@@ -35,9 +37,34 @@ See License.txt for details.
 #include <QProgressBar>
 #include <QTimer>
 
+// STL includes
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+  /*! Performance timer names of the toolbox content refreshes (the indices are the toolbox type identifiers) */
+  const char* TOOLBOX_REFRESH_TIMER_NAMES[ToolboxType_Count] =
+  {
+    "ConfigurationRefresh",
+    "StylusCalibrationRefresh",
+    "PhantomRegistrationRefresh",
+    "TemporalCalibrationRefresh",
+    "SpatialCalibrationRefresh",
+    "CapturingRefresh",
+    "VolumeReconstructionRefresh"
+  };
+
+  /*! Interval of updating the performance overlay text */
+  const int64_t PERFORMANCE_OVERLAY_UPDATE_INTERVAL_NS = 500000000;
+
+  /*! Performance value name of the time between launching the application and the first UI refresh */
+  const char* TIME_TO_INTERACTIVE_VALUE_NAME = "TimeToInteractive";
+}
+
 
 //-----------------------------------------------------------------------------
-fCalMainWindow::fCalMainWindow(QWidget* parent, Qt::WindowFlags flags)
+fCalMainWindow::fCalMainWindow(QWidget* parent, Qt::WindowFlags flags, double launchTimeSec)
   : QMainWindow(parent, flags)
   , m_StatusBarLabel(NULL)
   , m_StatusBarProgress(NULL)
@@ -53,6 +80,11 @@ fCalMainWindow::fCalMainWindow(QWidget* parent, Qt::WindowFlags flags)
   , m_ShowPhantomModelAction(NULL)
   , m_ShowPhantomWiresModelAction(NULL)
   , m_SelectedChannel(NULL)
+  , m_PerformanceOverlayUpdateTimeNs(0)
+  , m_ToolDisplayRefreshRequested(true)
+  , m_CanvasUpdateRequested(true)
+  , m_LaunchTimeSec(launchTimeSec >= 0 ? launchTimeSec : vtkIGSIOAccurateTimer::GetSystemTime())
+  , m_TimeToInteractiveReported(false)
 {
   // Set up UI
   ui.setupUi(this);
@@ -107,6 +139,17 @@ void fCalMainWindow::Initialize()
   QAction* dumpBuffersAction = new QAction("Dump buffers into files...", ui.pushButton_Tools);
   connect(dumpBuffersAction, SIGNAL(triggered()), this, SLOT(DumpBuffers()));
   ui.pushButton_Tools->addAction(dumpBuffersAction);
+  QAction* showPerformanceOverlayAction = new QAction("Show performance overlay", ui.pushButton_Tools);
+  showPerformanceOverlayAction->setCheckable(true);
+  connect(showPerformanceOverlayAction, SIGNAL(toggled(bool)), this, SLOT(ShowPerformanceOverlayToggled(bool)));
+  ui.pushButton_Tools->addAction(showPerformanceOverlayAction);
+  QAction* recordPerformanceTraceAction = new QAction("Record performance trace", ui.pushButton_Tools);
+  recordPerformanceTraceAction->setCheckable(true);
+  connect(recordPerformanceTraceAction, SIGNAL(toggled(bool)), this, SLOT(RecordPerformanceTraceToggled(bool)));
+  ui.pushButton_Tools->addAction(recordPerformanceTraceAction);
+  QAction* exportPerformanceTraceAction = new QAction("Export performance trace...", ui.pushButton_Tools);
+  connect(exportPerformanceTraceAction, SIGNAL(triggered()), this, SLOT(ExportPerformanceTrace()));
+  ui.pushButton_Tools->addAction(exportPerformanceTraceAction);
 
   // Declare this class as the event handler
   ui.pushButton_Tools->installEventFilter(this);
@@ -153,8 +196,12 @@ void fCalMainWindow::Initialize()
   ui.horizontalSlider_SliceNumber->setVisible(false);
   ui.spinBox_SliceNumber->setVisible(false);
 
-  // Create toolboxes
-  CreateToolboxes();
+  // Toolboxes are created on first use, only the one on the current tab is created now (in CurrentToolboxChanged)
+  m_ToolboxList.resize(ToolboxType_Count, NULL);
+  for (int toolboxType = 0; toolboxType < ToolboxType_Count; ++toolboxType)
+  {
+    m_ToolboxRefreshTimerIds.push_back(PlusPerformanceMonitor::GetInstance()->RegisterTimer(TOOLBOX_REFRESH_TIMER_NAMES[toolboxType]));
+  }
 
   // Set up status bar (message and progress bar)
   SetupStatusBar();
@@ -163,6 +210,7 @@ void fCalMainWindow::Initialize()
   connect(ui.toolbox, SIGNAL(currentChanged(int)), this, SLOT(CurrentToolboxChanged(int)));
   connect(ui.pushButton_SaveConfiguration, SIGNAL(clicked()), this, SLOT(SaveDeviceSetConfiguration()));
   connect(m_UiRefreshTimer, SIGNAL(timeout()), this, SLOT(UpdateGUI()));
+  connect(m_VisualizationController, SIGNAL(NewDataAcquired()), this, SLOT(OnNewDataAcquired()));
   connect(ui.horizontalSlider_SliceNumber, SIGNAL(valueChanged(int)), this, SLOT(SliceNumberSliderChanged(int)));
   connect(ui.spinBox_SliceNumber, SIGNAL(valueChanged(int)), this, SLOT(SliceNumberSpinBoxChanged(int)));
 
@@ -183,77 +231,57 @@ vtkPlusVisualizationController* fCalMainWindow::GetVisualizationController()
 }
 
 //-----------------------------------------------------------------------------
-void fCalMainWindow::CreateToolboxes()
+QAbstractToolbox* fCalMainWindow::CreateToolbox(ToolboxType aType)
 {
-  LOG_TRACE("fCalMainWindow::CreateToolboxes");
+  LOG_TRACE("fCalMainWindow::CreateToolbox(" << aType << ")");
+  PLUS_SCOPED_TIMER("ToolboxCreation");
 
-  // Resize toolbox list to the number of toolboxes
-  m_ToolboxList.resize(ToolboxType_Count);
-
-  // Configuration widget
-  QConfigurationToolbox* configurationToolbox = new QConfigurationToolbox(this);
-  if (configurationToolbox != NULL)
+  QAbstractToolbox* toolbox = NULL;
+  QWidget* page = NULL;
+  switch (aType)
   {
-    QGridLayout* grid = new QGridLayout(ui.toolbox_Configuration);
-    grid->addWidget(configurationToolbox);
+    case ToolboxType_Configuration:
+      toolbox = new QConfigurationToolbox(this);
+      page = ui.toolbox_Configuration;
+      break;
+    case ToolboxType_Capturing:
+      toolbox = new QCapturingToolbox(this);
+      page = ui.toolbox_Capturing;
+      break;
+    case ToolboxType_StylusCalibration:
+      toolbox = new QStylusCalibrationToolbox(this);
+      page = ui.toolbox_StylusCalibration;
+      break;
+    case ToolboxType_PhantomRegistration:
+      toolbox = new QPhantomRegistrationToolbox(this);
+      page = ui.toolbox_PhantomRegistration;
+      break;
+    case ToolboxType_TemporalCalibration:
+      toolbox = new QTemporalCalibrationToolbox(this);
+      page = ui.toolbox_TemporalCalibration;
+      break;
+    case ToolboxType_SpatialCalibration:
+      toolbox = new QSpatialCalibrationToolbox(this);
+      page = ui.toolbox_SpatialCalibration;
+      break;
+    case ToolboxType_VolumeReconstruction:
+      toolbox = new QVolumeReconstructionToolbox(this);
+      page = ui.toolbox_VolumeReconstruction;
+      break;
+    default:
+      LOG_ERROR("Unable to create toolbox: invalid toolbox type " << aType);
+      return NULL;
   }
-  m_ToolboxList[ToolboxType_Configuration] = configurationToolbox;
 
-  // Capturing widget
-  QCapturingToolbox* capturingToolbox = new QCapturingToolbox(this);
-  if (capturingToolbox != NULL)
+  QGridLayout* grid = new QGridLayout(page);
+  if (aType == ToolboxType_Capturing)
   {
-    QGridLayout* grid = new QGridLayout(ui.toolbox_Capturing);
     grid->setRowStretch(1, 1);
     grid->setVerticalSpacing(0);
-    grid->addWidget(capturingToolbox);
-  }
-  m_ToolboxList[ToolboxType_Capturing] = capturingToolbox;
-
-  // Stylus calibration widget
-  QStylusCalibrationToolbox* stylusCalibrationToolbox = new QStylusCalibrationToolbox(this);
-  if (stylusCalibrationToolbox != NULL)
-  {
-    QGridLayout* grid = new QGridLayout(ui.toolbox_StylusCalibration);
-    grid->addWidget(stylusCalibrationToolbox);
-  }
-  m_ToolboxList[ToolboxType_StylusCalibration] = stylusCalibrationToolbox;
-
-  // Phantom registration widget
-  QPhantomRegistrationToolbox* phantomRegistrationToolbox = new QPhantomRegistrationToolbox(this);
-  if (phantomRegistrationToolbox != NULL)
-  {
-    QGridLayout* grid = new QGridLayout(ui.toolbox_PhantomRegistration);
-    grid->addWidget(phantomRegistrationToolbox);
   }
-  m_ToolboxList[ToolboxType_PhantomRegistration] = phantomRegistrationToolbox;
+  grid->addWidget(toolbox);
 
-  // Temporal calibration widget
-  QTemporalCalibrationToolbox* temporalCalibrationToolbox = new QTemporalCalibrationToolbox(this);
-  if (temporalCalibrationToolbox != NULL)
-  {
-    QGridLayout* grid = new QGridLayout(ui.toolbox_TemporalCalibration);
-    grid->addWidget(temporalCalibrationToolbox);
-  }
-  m_ToolboxList[ToolboxType_TemporalCalibration] = temporalCalibrationToolbox;
-
-  // Spatial calibration widget
-  QSpatialCalibrationToolbox* spatialCalibrationToolbox = new QSpatialCalibrationToolbox(this);
-  if (spatialCalibrationToolbox != NULL)
-  {
-    QGridLayout* grid = new QGridLayout(ui.toolbox_SpatialCalibration);
-    grid->addWidget(spatialCalibrationToolbox);
-  }
-  m_ToolboxList[ToolboxType_SpatialCalibration] = spatialCalibrationToolbox;
-
-  // Volume reconstruction widget
-  QVolumeReconstructionToolbox* volumeReconstructionToolbox = new QVolumeReconstructionToolbox(this);
-  if (volumeReconstructionToolbox != NULL)
-  {
-    QGridLayout* grid = new QGridLayout(ui.toolbox_VolumeReconstruction);
-    grid->addWidget(volumeReconstructionToolbox);
-  }
-  m_ToolboxList[ToolboxType_VolumeReconstruction] = volumeReconstructionToolbox;
+  return toolbox;
 }
 
 //-----------------------------------------------------------------------------
@@ -324,8 +352,11 @@ void fCalMainWindow::CurrentToolboxChanged(int aToolboxIndex)
     return;
   }
 
-  m_ToolboxList[m_ActiveToolbox]->OnActivated();
-  m_ToolboxList[m_ActiveToolbox]->SetDisplayAccordingToState();
+  QAbstractToolbox* activeToolbox = GetToolbox(m_ActiveToolbox);
+  activeToolbox->OnActivated();
+  activeToolbox->SetDisplayAccordingToState();
+  activeToolbox->RequestRefresh(ToolboxRefreshTrigger_All);
+  m_WatchedTransformValues.clear();
 
   LOG_INFO("Toolbox changed to " << currentToolboxText.toLatin1().constData());
 }
@@ -402,19 +433,126 @@ void fCalMainWindow::UpdateGUI()
     return;
   }
 
-  m_ToolboxList[m_ActiveToolbox]->RefreshContent();
+  if (!m_TimeToInteractiveReported)
+  {
+    // The first tick is processed once the window is shown and the event loop is running
+    m_TimeToInteractiveReported = true;
+    ReportTimeToInteractive();
+  }
+
+  // Only the toolboxes subscribed to the timer are refreshed in every tick, the others wait for their events
+  bool toolboxRefreshed = false;
+  m_ToolboxList[m_ActiveToolbox]->RequestRefresh(ToolboxRefreshTrigger_Timer);
+  {
+    PlusScopedTimer refreshTimer(m_ToolboxRefreshTimerIds[m_ActiveToolbox]);
+    toolboxRefreshed = m_ToolboxList[m_ActiveToolbox]->RefreshContentIfRequested();
+  }
 
   // Refresh tool state display if detached
-  if (m_ActiveToolbox != ToolboxType_Configuration)
+  if (m_ActiveToolbox != ToolboxType_Configuration && m_ToolDisplayRefreshRequested)
   {
     QConfigurationToolbox* configurationToolbox = dynamic_cast<QConfigurationToolbox*>(m_ToolboxList[ToolboxType_Configuration]);
     if (configurationToolbox)
     {
+      PlusScopedTimer refreshTimer(m_ToolboxRefreshTimerIds[ToolboxType_Configuration]);
       configurationToolbox->RefreshToolDisplayIfDetached();
     }
   }
+  m_ToolDisplayRefreshRequested = false;
 
-  ui.canvas->update();
+  if (m_VisualizationController->IsPerformanceOverlayShown()
+      && PlusPerformanceMonitor::GetTimeNs() - m_PerformanceOverlayUpdateTimeNs >= PERFORMANCE_OVERLAY_UPDATE_INTERVAL_NS)
+  {
+    UpdatePerformanceOverlay();
+    m_CanvasUpdateRequested = true;
+  }
+
+  if (toolboxRefreshed || m_CanvasUpdateRequested)
+  {
+    ui.canvas->update();
+    m_CanvasUpdateRequested = false;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::OnNewDataAcquired()
+{
+  m_ToolDisplayRefreshRequested = true;
+  m_CanvasUpdateRequested = true;
+
+  if (m_ActiveToolbox == ToolboxType_Undefined)
+  {
+    return;
+  }
+  QAbstractToolbox* activeToolbox = m_ToolboxList[m_ActiveToolbox];
+  activeToolbox->RequestRefresh(ToolboxRefreshTrigger_NewData);
+
+  // Compare the watched transforms to their values at the previous data, only if the toolbox cares about them
+  if ((activeToolbox->GetRefreshTriggers() & ToolboxRefreshTrigger_TransformChanged) == 0)
+  {
+    return;
+  }
+  std::vector<igsioTransformName> watchedTransformNames = activeToolbox->GetWatchedTransformNames();
+  vtkSmartPointer<vtkMatrix4x4> transformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (std::vector<igsioTransformName>::iterator nameIt = watchedTransformNames.begin(); nameIt != watchedTransformNames.end(); ++nameIt)
+  {
+    ToolStatus status(TOOL_INVALID);
+    if (m_VisualizationController->GetTransformMatrix(*nameIt, transformMatrix, &status) != PLUS_SUCCESS)
+    {
+      status = TOOL_INVALID;
+    }
+    std::vector<double> values(transformMatrix->GetData(), transformMatrix->GetData() + 16);
+    values.push_back(status);
+
+    std::vector<double>& lastValues = m_WatchedTransformValues[nameIt->GetTransformName()];
+    if (lastValues != values)
+    {
+      lastValues = values;
+      activeToolbox->RequestRefresh(ToolboxRefreshTrigger_TransformChanged);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::UpdatePerformanceOverlay()
+{
+  PlusPerformanceMonitor* monitor = PlusPerformanceMonitor::GetInstance();
+  int64_t currentTimeNs = PlusPerformanceMonitor::GetTimeNs();
+  double elapsedTimeSec = (currentTimeNs - m_PerformanceOverlayUpdateTimeNs) / 1e9;
+  m_PerformanceOverlayUpdateTimeNs = currentTimeNs;
+
+  // Timers are looked up by name, the visualization controller registers its own ones
+  std::vector<int> timerIds;
+  timerIds.push_back(monitor->RegisterTimer("Render"));
+  timerIds.push_back(monitor->RegisterTimer("AcquisitionToDisplayLatency"));
+  timerIds.insert(timerIds.end(), m_ToolboxRefreshTimerIds.begin(), m_ToolboxRefreshTimerIds.end());
+
+  std::map<int, PlusPerformanceMonitor::Statistics> intervalStatistics;
+  for (std::vector<int>::iterator timerIt = timerIds.begin(); timerIt != timerIds.end(); ++timerIt)
+  {
+    PlusPerformanceMonitor::Statistics statistics = monitor->GetStatistics(*timerIt);
+    intervalStatistics[*timerIt] = statistics - m_PerformanceOverlayStatistics[*timerIt];
+    m_PerformanceOverlayStatistics[*timerIt] = statistics;
+  }
+
+  const PlusPerformanceMonitor::Statistics& render = intervalStatistics[timerIds[0]];
+  const PlusPerformanceMonitor::Statistics& latency = intervalStatistics[timerIds[1]];
+
+  std::ostringstream overlayText;
+  overlayText << std::fixed << std::setprecision(1);
+  overlayText << "Render: " << (elapsedTimeSec > 0 ? render.Count / elapsedTimeSec : 0.0) << " fps, "
+              << render.GetMeanMs() << " ms (p95 " << render.GetPercentileMs(0.95) << " ms)" << std::endl;
+  overlayText << "Latency: " << latency.GetMeanMs() << " ms (p95 " << latency.GetPercentileMs(0.95) << " ms)";
+  for (int toolboxType = 0; toolboxType < ToolboxType_Count; ++toolboxType)
+  {
+    const PlusPerformanceMonitor::Statistics& refresh = intervalStatistics[m_ToolboxRefreshTimerIds[toolboxType]];
+    if (refresh.Count > 0)
+    {
+      overlayText << std::endl << TOOLBOX_REFRESH_TIMER_NAMES[toolboxType] << ": " << refresh.GetMeanMs() << " ms (max " << refresh.MaxMs << " ms)";
+    }
+  }
+
+  m_VisualizationController->SetPerformanceOverlayText(overlayText.str());
 }
 
 //-----------------------------------------------------------------------------
@@ -447,9 +585,38 @@ void fCalMainWindow::ResetAllToolboxes()
 //----------------------------------------------------------------------------
 QAbstractToolbox* fCalMainWindow::GetToolbox(ToolboxType aType)
 {
+  if (aType < 0 || aType >= static_cast<int>(m_ToolboxList.size()))
+  {
+    LOG_ERROR("Invalid toolbox type: " << aType);
+    return NULL;
+  }
+
+  if (m_ToolboxList[aType] == NULL)
+  {
+    m_ToolboxList[aType] = CreateToolbox(aType);
+  }
   return m_ToolboxList[aType];
 }
 
+//----------------------------------------------------------------------------
+void fCalMainWindow::ReportTimeToInteractive()
+{
+  double timeToInteractiveMs = 1000.0 * (vtkIGSIOAccurateTimer::GetSystemTime() - m_LaunchTimeSec);
+  static const int timeToInteractiveValueId = PlusPerformanceMonitor::GetInstance()->RegisterTimer(TIME_TO_INTERACTIVE_VALUE_NAME);
+  PlusPerformanceMonitor::GetInstance()->AddValue(timeToInteractiveValueId, timeToInteractiveMs);
+
+  int numberOfCreatedToolboxes = 0;
+  for (std::vector<QAbstractToolbox*>::iterator it = m_ToolboxList.begin(); it != m_ToolboxList.end(); ++it)
+  {
+    if ((*it) != NULL)
+    {
+      ++numberOfCreatedToolboxes;
+    }
+  }
+
+  LOG_INFO("fCal is interactive " << static_cast<int>(timeToInteractiveMs + 0.5) << " ms after launch (" << numberOfCreatedToolboxes << " of " << ToolboxType_Count << " toolboxes created)");
+}
+
 //-----------------------------------------------------------------------------
 bool fCalMainWindow::eventFilter(QObject* obj, QEvent* ev)
 {
@@ -649,6 +816,50 @@ void fCalMainWindow::SaveDeviceSetConfiguration()
   delete configSaverDialog;
 }
 
+//-----------------------------------------------------------------------------
+void fCalMainWindow::ShowPerformanceOverlayToggled(bool aOn)
+{
+  LOG_TRACE("fCalMainWindow::ShowPerformanceOverlayToggled(" << (aOn ? "true" : "false") << ")");
+
+  if (aOn)
+  {
+    // Start the statistics from now, older samples would distort the first values
+    m_PerformanceOverlayStatistics.clear();
+    m_PerformanceOverlayUpdateTimeNs = 0;
+    UpdatePerformanceOverlay();
+    m_VisualizationController->SetPerformanceOverlayText("Collecting timing statistics...");
+  }
+  m_VisualizationController->ShowPerformanceOverlay(aOn);
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::RecordPerformanceTraceToggled(bool aOn)
+{
+  LOG_TRACE("fCalMainWindow::RecordPerformanceTraceToggled(" << (aOn ? "true" : "false") << ")");
+
+  PlusPerformanceMonitor::GetInstance()->SetTracingEnabled(aOn);
+  LOG_INFO("Performance trace recording " << (aOn ? "started" : "stopped"));
+}
+
+//-----------------------------------------------------------------------------
+void fCalMainWindow::ExportPerformanceTrace()
+{
+  LOG_TRACE("fCalMainWindow::ExportPerformanceTrace");
+
+  QString fileName = QFileDialog::getSaveFileName(NULL, tr("Save performance trace"),
+                     QString(vtkPlusConfig::GetInstance()->GetOutputPath("fCalPerformanceTrace.json").c_str()), tr("Chrome trace files (*.json)"));
+  if (fileName.isEmpty())
+  {
+    // Cancel button hit, just cancel gracefully
+    return;
+  }
+
+  if (PlusPerformanceMonitor::GetInstance()->WriteChromeTrace(fileName.toStdString()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Writing performance trace failed (output file: " << fileName.toStdString() << ")!");
+  }
+}
+
 //-----------------------------------------------------------------------------
 void fCalMainWindow::ShowDevicesToggled()
 {
@@ -1019,7 +1230,7 @@ void fCalMainWindow::ChannelSelected(vtkPlusChannel* aChannel)
 
   this->BuildChannelMenu();
 
-  QConfigurationToolbox* aToolbox = dynamic_cast<QConfigurationToolbox*>(this->m_ToolboxList[ToolboxType_Configuration]);
+  QConfigurationToolbox* aToolbox = dynamic_cast<QConfigurationToolbox*>(this->GetToolbox(ToolboxType_Configuration));
   if (aToolbox != NULL)
   {
     aToolbox->ChannelChanged(*aChannel);
@@ -8,8 +8,10 @@ See License.txt for details.
 #define __fCalMainWindow_h
 
 #include "PlusConfigure.h"
+#include "PlusPerformanceMonitor.h"
 #include "ui_fCalMainWindow.h"
 #include <QMainWindow>
+#include <map>
 
 class QAbstractToolbox;
 class QPlusChannelAction;
@@ -51,8 +53,9 @@ public:
   * Constructor
   * \param aParent parent
   * \param aFlags widget flag
+  * \param launchTimeSec System time when the application was started, used for reporting the time to interactive (current time if negative)
   */
-  fCalMainWindow(QWidget* parent = 0, Qt::WindowFlags flags = 0);
+  fCalMainWindow(QWidget* parent = 0, Qt::WindowFlags flags = 0, double launchTimeSec = -1.0);
 
   /*!
   * Destructor
@@ -60,7 +63,8 @@ public:
   ~fCalMainWindow();
 
   /*!
-  * Initialize controller, toolboxes, canvas and connect to devices
+  * Initialize controller, canvas and the toolbox on the current tab and connect to devices.
+  * The other toolboxes are created when they are first needed.
   */
   void Initialize();
 
@@ -111,7 +115,7 @@ public:
   void ResetAllToolboxes();
 
   /*!
-  * Return a toolbox
+  * Return a toolbox, create it if it has not been created yet
   * \param aType Toolbox type identifier
   * \return Toolbox object
   */
@@ -188,15 +192,25 @@ public:
 
 protected:
   /*!
-  * Create toolboxes
+  * Create a toolbox and add it to its tab page
+  * \param aType Toolbox type identifier
+  * \return Toolbox object
   */
-  void CreateToolboxes();
+  QAbstractToolbox* CreateToolbox(ToolboxType aType);
 
   /*!
   * Set up status bar (label and progress)
   */
   void SetupStatusBar();
 
+  /*!
+  * Update the text of the performance overlay with the statistics of the samples recorded since the last update
+  */
+  void UpdatePerformanceOverlay();
+
+  /*! Log the time elapsed since the application was launched and record it in the performance monitor */
+  void ReportTimeToInteractive();
+
   /*!
   * Filters events if this object has been installed as an event filter for the watched object
   * \param obj object
@@ -219,10 +233,15 @@ protected slots:
   void ChangeBackToolbox(int);
 
   /*!
-  * Updates every part of the GUI (called by ui refresh timer)
+  * Updates the parts of the GUI that changed since the last call (called by ui refresh timer)
   */
   void UpdateGUI();
 
+  /*!
+  * Mark the parts of the GUI that depend on the acquired data as outdated (called when the visualization controller acquired new data)
+  */
+  void OnNewDataAcquired();
+
   /*!
   * Update the slicer number UI based on channel data
   */
@@ -270,6 +289,15 @@ protected slots:
   /*! Save current device set configuration */
   void SaveDeviceSetConfiguration();
 
+  /*! Show or hide the frame timing overlay on the canvas */
+  void ShowPerformanceOverlayToggled(bool aOn);
+
+  /*! Start or stop storing timing samples for the performance trace */
+  void RecordPerformanceTraceToggled(bool aOn);
+
+  /*! Save the recorded timing samples into a Chrome trace file */
+  void ExportPerformanceTrace();
+
   /*! Functions to set orientation of the 2D image */
   void SetOrientationMRightFUp();
   void SetOrientationMLeftFUp();
@@ -297,10 +325,32 @@ protected:
   /*! Timer that refreshes the UI */
   QTimer*                             m_UiRefreshTimer;
 
+  /*! Performance monitor timer identifiers of the content refresh of each toolbox (the indices are the type identifiers) */
+  std::vector<int>                    m_ToolboxRefreshTimerIds;
+
+  /*! Statistics at the last update of the performance overlay, the overlay shows the samples recorded since then */
+  std::map<int, PlusPerformanceMonitor::Statistics> m_PerformanceOverlayStatistics;
+
+  /*! Time of the last update of the performance overlay */
+  int64_t                             m_PerformanceOverlayUpdateTimeNs;
+
+  /*! Flags indicating that new data arrived since the last UI refresh, so the detached tool state display and the canvas need an update */
+  bool                                m_ToolDisplayRefreshRequested;
+  bool                                m_CanvasUpdateRequested;
+
+  /*! System time when the application was started */
+  double                              m_LaunchTimeSec;
+
+  /*! Flag indicating that the time to interactive has been reported already */
+  bool                                m_TimeToInteractiveReported;
+
+  /*! Matrix elements and status of the transforms watched by the active toolbox at the last check, to detect changes */
+  std::map<std::string, std::vector<double> > m_WatchedTransformValues;
+
   /*! Status icon instance */
   QPlusStatusIcon*                    m_StatusIcon;
 
-  /*! List of toolbox objects (the indices are the type identifiers) */
+  /*! List of toolbox objects (the indices are the type identifiers), NULL if the toolbox has not been created yet */
   std::vector<QAbstractToolbox*>      m_ToolboxList;
 
   /*! Image coordinate frame name for Volume reconstruction */
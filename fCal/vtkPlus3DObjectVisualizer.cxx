@@ -15,7 +15,7 @@ See License.txt for details.
 #include <vtkPlusDevice.h>
 
 // VTK includes
-#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkImageSliceMapper.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyDataMapper.h>
@@ -32,9 +32,9 @@ vtkPlus3DObjectVisualizer::vtkPlus3DObjectVisualizer()
   : CanvasRenderer(vtkSmartPointer<vtkRenderer>::New())
   , ImageActor(vtkSmartPointer<vtkImageActor>::New())
   , InputActor(vtkSmartPointer<vtkActor>::New())
-  , InputGlyph(vtkSmartPointer<vtkGlyph3D>::New())
+  , InputGlyphMapper(vtkSmartPointer<vtkGlyph3DMapper>::New())
   , ResultActor(vtkSmartPointer<vtkActor>::New())
-  , ResultGlyph(vtkSmartPointer<vtkGlyph3D>::New())
+  , ResultGlyphMapper(vtkSmartPointer<vtkGlyph3DMapper>::New())
   , TransformRepository(NULL)
   , WorldCoordinateFrame("")
   , VolumeID("")
@@ -46,25 +46,26 @@ vtkPlus3DObjectVisualizer::vtkPlus3DObjectVisualizer()
   this->CanvasRenderer->SetGradientBackground(true);
 
   // Input points actor
-  vtkSmartPointer<vtkPolyDataMapper> inputMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+  // The points are drawn as instances of a single sphere, adding a point does not regenerate the geometry of the others
   vtkSmartPointer<vtkSphereSource> inputSphereSource = vtkSmartPointer<vtkSphereSource>::New();
   inputSphereSource->SetRadius(2.0);   // mm
 
   // Connect all input items (except poly data) in chain
-  this->InputGlyph->SetSourceConnection(inputSphereSource->GetOutputPort());
-  inputMapper->SetInputConnection(this->InputGlyph->GetOutputPort());
-  this->InputActor->SetMapper(inputMapper);
+  this->InputGlyphMapper->SetSourceConnection(inputSphereSource->GetOutputPort());
+  this->InputGlyphMapper->ScalingOff();
+  this->InputGlyphMapper->OrientOff();
+  this->InputActor->SetMapper(this->InputGlyphMapper);
   this->InputActor->GetProperty()->SetColor(0.0, 0.7, 1.0);
 
   // Result points actor
-  vtkSmartPointer<vtkPolyDataMapper> resultMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
   vtkSmartPointer<vtkSphereSource> resultSphereSource = vtkSmartPointer<vtkSphereSource>::New();
   resultSphereSource->SetRadius(1.0);   // mm
 
   // Connect all result items (except poly data) in chain
-  this->ResultGlyph->SetSourceConnection(resultSphereSource->GetOutputPort());
-  resultMapper->SetInputConnection(this->ResultGlyph->GetOutputPort());
-  this->ResultActor->SetMapper(resultMapper);
+  this->ResultGlyphMapper->SetSourceConnection(resultSphereSource->GetOutputPort());
+  this->ResultGlyphMapper->ScalingOff();
+  this->ResultGlyphMapper->OrientOff();
+  this->ResultActor->SetMapper(this->ResultGlyphMapper);
   this->ResultActor->GetProperty()->SetColor(0.0, 0.8, 0.0);
 
   this->ImageMapper = vtkImageSliceMapper::SafeDownCast(this->ImageActor->GetMapper());
@@ -105,23 +106,11 @@ PlusStatus vtkPlus3DObjectVisualizer::Update()
     return PLUS_SUCCESS;
   }
 
-  // Get tracked frame and set the transforms
-  igsioTrackedFrame trackedFrame;
-  if (this->SelectedChannel->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Failed to get tracked frame!");
-    return PLUS_FAIL;
-  }
-
+  // The transforms of the current tick are already set to the repository by the visualization controller
   if (this->TransformRepository == NULL)
   {
     return PLUS_FAIL;
   }
-  if (this->TransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Failed to set current transforms to transform repository!");
-    return PLUS_FAIL;
-  }
 
   bool resetCameraNeeded = false;
 
@@ -232,27 +221,27 @@ void vtkPlus3DObjectVisualizer::SetResultActor(vtkSmartPointer<vtkActor> resultA
 }
 
 //----------------------------------------------------------------------------
-void vtkPlus3DObjectVisualizer::SetResultGlyph(vtkSmartPointer<vtkGlyph3D> glyph)
+void vtkPlus3DObjectVisualizer::SetResultGlyphMapper(vtkSmartPointer<vtkGlyph3DMapper> glyphMapper)
 {
-  this->ResultGlyph = glyph;
+  this->ResultGlyphMapper = glyphMapper;
 }
 
 //----------------------------------------------------------------------------
-vtkSmartPointer<vtkGlyph3D> vtkPlus3DObjectVisualizer::GetResultGlyph() const
+vtkSmartPointer<vtkGlyph3DMapper> vtkPlus3DObjectVisualizer::GetResultGlyphMapper() const
 {
-  return this->ResultGlyph;
+  return this->ResultGlyphMapper;
 }
 
 //----------------------------------------------------------------------------
-void vtkPlus3DObjectVisualizer::SetInputGlyph(vtkSmartPointer<vtkGlyph3D> glyph)
+void vtkPlus3DObjectVisualizer::SetInputGlyphMapper(vtkSmartPointer<vtkGlyph3DMapper> glyphMapper)
 {
-  this->InputGlyph = glyph;
+  this->InputGlyphMapper = glyphMapper;
 }
 
 //----------------------------------------------------------------------------
-vtkSmartPointer<vtkGlyph3D> vtkPlus3DObjectVisualizer::GetInputGlyph() const
+vtkSmartPointer<vtkGlyph3DMapper> vtkPlus3DObjectVisualizer::GetInputGlyphMapper() const
 {
-  return this->InputGlyph;
+  return this->InputGlyphMapper;
 }
 
 //-----------------------------------------------------------------------------
@@ -341,13 +330,13 @@ PlusStatus vtkPlus3DObjectVisualizer::HideAll()
 //-----------------------------------------------------------------------------
 void vtkPlus3DObjectVisualizer::SetInputPolyData(vtkPolyData* aPolyData)
 {
-  this->InputGlyph->SetInputData(aPolyData);
+  this->InputGlyphMapper->SetInputData(aPolyData);
 }
 
 //-----------------------------------------------------------------------------
 void vtkPlus3DObjectVisualizer::SetResultPolyData(vtkPolyData* aPolyData)
 {
-  this->ResultGlyph->SetInputData(aPolyData);
+  this->ResultGlyphMapper->SetInputData(aPolyData);
 }
 
 //-----------------------------------------------------------------------------
@@ -18,7 +18,7 @@
 // VTK includes
 #include <vtkActor.h>
 #include <vtkCamera.h>
-#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkImageActor.h>
 #include <vtkObject.h>
 #include <vtkPolyData.h>
@@ -119,6 +119,7 @@ public:
 
   /*!
   * Update the displayable objects
+  * The transform repository must already contain the transforms of the current tracked frame
   */
   PlusStatus Update();
 
@@ -143,11 +144,11 @@ protected:
   void SetInputActor(vtkSmartPointer<vtkActor> inputActor);
   void SetResultActor(vtkSmartPointer<vtkActor> resultActor);
 
-  void SetResultGlyph(vtkSmartPointer<vtkGlyph3D> glyph);
-  vtkSmartPointer<vtkGlyph3D> GetResultGlyph() const;
+  void SetResultGlyphMapper(vtkSmartPointer<vtkGlyph3DMapper> glyphMapper);
+  vtkSmartPointer<vtkGlyph3DMapper> GetResultGlyphMapper() const;
 
-  void SetInputGlyph(vtkSmartPointer<vtkGlyph3D> glyph);
-  vtkSmartPointer<vtkGlyph3D> GetInputGlyph() const;
+  void SetInputGlyphMapper(vtkSmartPointer<vtkGlyph3DMapper> glyphMapper);
+  vtkSmartPointer<vtkGlyph3DMapper> GetInputGlyphMapper() const;
 
   vtkSetMacro(VolumeID, std::string);
   vtkSetObjectMacro(SelectedChannel, vtkPlusChannel);
@@ -168,14 +169,17 @@ protected:
   /*! Slice mapper to enable slice selection */
   vtkSmartPointer<vtkImageSliceMapper> ImageMapper;
 
-  /*! Glyph producer for result */
-  vtkSmartPointer<vtkGlyph3D> InputGlyph;
+  /*!
+    Instancing mapper for the input points. The sphere template is uploaded once and only the
+    per-point transforms are updated when points are added, no sphere geometry is generated per point.
+  */
+  vtkSmartPointer<vtkGlyph3DMapper> InputGlyphMapper;
 
   /*! Actor for displaying the result points (eg. stylus tip, segmented points) */
   vtkSmartPointer<vtkActor> ResultActor;
 
-  /*! Glyph producer for result */
-  vtkSmartPointer<vtkGlyph3D> ResultGlyph;
+  /*! Instancing mapper for the result points */
+  vtkSmartPointer<vtkGlyph3DMapper> ResultGlyphMapper;
 
   /*! Name of the rendering world coordinate frame */
   std::string WorldCoordinateFrame;
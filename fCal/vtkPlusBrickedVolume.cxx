@@ -0,0 +1,706 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "vtkPlusBrickedVolume.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkXMLDataElement.h>
+
+// Qt includes
+#include <QCoreApplication>
+#include <QFile>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace
+{
+  const int BRICK_INDEX_BITS = 21; // number of bits of each brick index in the brick key
+  const int BRICK_INDEX_OFFSET = 1 << (BRICK_INDEX_BITS - 1);
+  const unsigned short MAX_VOXEL_COUNT = 65535;
+  const int SWAP_FILE_NUMBER_OF_SLOTS = 256; // number of bricks stored in one swap file
+
+  //-----------------------------------------------------------------------------
+  template <class T>
+  double GetPixelValue(const void* aPixels, vtkIdType aIndex)
+  {
+    return static_cast<const T*>(aPixels)[aIndex];
+  }
+
+  //-----------------------------------------------------------------------------
+  template <class T>
+  void SetVoxelValue(void* aVoxels, vtkIdType aIndex, double aValue)
+  {
+    static_cast<T*>(aVoxels)[aIndex] = static_cast<T>(aValue);
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Floor of the division, also for negative numbers */
+  inline int FloorDivide(int aValue, int aDivisor)
+  {
+    return (aValue >= 0) ? (aValue / aDivisor) : -((-aValue + aDivisor - 1) / aDivisor);
+  }
+
+  //-----------------------------------------------------------------------------
+  /*! Element type of a VTK scalar type in a metafile header, empty if not supported */
+  std::string GetMetaElementType(int aScalarType)
+  {
+    switch (aScalarType)
+    {
+      case VTK_CHAR:
+      case VTK_SIGNED_CHAR:
+        return "MET_CHAR";
+      case VTK_UNSIGNED_CHAR:
+        return "MET_UCHAR";
+      case VTK_SHORT:
+        return "MET_SHORT";
+      case VTK_UNSIGNED_SHORT:
+        return "MET_USHORT";
+      case VTK_INT:
+        return "MET_INT";
+      case VTK_UNSIGNED_INT:
+        return "MET_UINT";
+      case VTK_FLOAT:
+        return "MET_FLOAT";
+      case VTK_DOUBLE:
+        return "MET_DOUBLE";
+    }
+    return "";
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+vtkStandardNewMacro(vtkPlusBrickedVolume);
+
+//-----------------------------------------------------------------------------
+vtkPlusBrickedVolume::Brick::Brick()
+  : Sum(NULL)
+  , Count(NULL)
+  , SwapSlot(-1)
+{
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusBrickedVolume::vtkPlusBrickedVolume()
+  : BrickSize(32)
+  , VoxelExtentValid(false)
+  , ScalarType(-1)
+  , MaxResidentMemoryMb(0.0)
+  , NumberOfSwapSlots(0)
+{
+  this->Spacing[0] = 1.0;
+  this->Spacing[1] = 1.0;
+  this->Spacing[2] = 1.0;
+  this->ClipRectangleOrigin[0] = 0;
+  this->ClipRectangleOrigin[1] = 0;
+  this->ClipRectangleSize[0] = 0;
+  this->ClipRectangleSize[1] = 0;
+  std::fill(this->VoxelExtent, this->VoxelExtent + 6, 0);
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusBrickedVolume::~vtkPlusBrickedVolume()
+{
+  this->RemoveSwapFiles();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusBrickedVolume::ReadConfiguration(vtkXMLDataElement* aConfig)
+{
+  LOG_TRACE("vtkPlusBrickedVolume::ReadConfiguration");
+
+  vtkXMLDataElement* reconConfig = (aConfig != NULL ? aConfig->FindNestedElementWithName("VolumeReconstruction") : NULL);
+  if (reconConfig == NULL)
+  {
+    LOG_ERROR("No volume reconstruction is found in the XML tree!");
+    return PLUS_FAIL;
+  }
+
+  double spacing[3] = {0};
+  if (reconConfig->GetVectorAttribute("OutputSpacing", 3, spacing))
+  {
+    if (spacing[0] <= 0 || spacing[1] <= 0 || spacing[2] <= 0)
+    {
+      LOG_ERROR("Invalid OutputSpacing: " << spacing[0] << " " << spacing[1] << " " << spacing[2]);
+      return PLUS_FAIL;
+    }
+    this->SetSpacing(spacing);
+  }
+
+  int clipRectangleOrigin[2] = {0};
+  int clipRectangleSize[2] = {0};
+  if (reconConfig->GetVectorAttribute("ClipRectangleOrigin", 2, clipRectangleOrigin)
+      && reconConfig->GetVectorAttribute("ClipRectangleSize", 2, clipRectangleSize))
+  {
+    this->SetClipRectangleOrigin(clipRectangleOrigin);
+    this->SetClipRectangleSize(clipRectangleSize);
+  }
+  else
+  {
+    this->ClipRectangleSize[0] = 0;
+    this->ClipRectangleSize[1] = 0;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBrickedVolume::SetBrickSize(int aBrickSize)
+{
+  if (aBrickSize == this->BrickSize)
+  {
+    return;
+  }
+  if (aBrickSize < 1 || !this->Bricks.empty())
+  {
+    LOG_ERROR("Brick size cannot be set to " << aBrickSize << " (it must be positive and the volume must be empty)");
+    return;
+  }
+  this->BrickSize = aBrickSize;
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBrickedVolume::SetMaxResidentMemoryMb(double aMaxResidentMemoryMb)
+{
+  if (aMaxResidentMemoryMb == this->MaxResidentMemoryMb)
+  {
+    return;
+  }
+  if (!this->Bricks.empty())
+  {
+    LOG_ERROR("Resident memory limit cannot be changed while the volume is not empty");
+    return;
+  }
+  this->MaxResidentMemoryMb = std::max(aMaxResidentMemoryMb, 0.0);
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+size_t vtkPlusBrickedVolume::GetBrickSizeBytes() const
+{
+  const size_t numberOfVoxels = static_cast<size_t>(this->BrickSize) * this->BrickSize * this->BrickSize;
+  return numberOfVoxels * (sizeof(float) + sizeof(unsigned short));
+}
+
+//-----------------------------------------------------------------------------
+long long vtkPlusBrickedVolume::GetBrickKey(int aBrickX, int aBrickY, int aBrickZ)
+{
+  return (static_cast<long long>(aBrickX + BRICK_INDEX_OFFSET) << (2 * BRICK_INDEX_BITS))
+         | (static_cast<long long>(aBrickY + BRICK_INDEX_OFFSET) << BRICK_INDEX_BITS)
+         | static_cast<long long>(aBrickZ + BRICK_INDEX_OFFSET);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBrickedVolume::GetBrickIndex(long long aBrickKey, int aBrickIndex[3])
+{
+  const long long indexMask = (1LL << BRICK_INDEX_BITS) - 1;
+  aBrickIndex[0] = static_cast<int>((aBrickKey >> (2 * BRICK_INDEX_BITS)) & indexMask) - BRICK_INDEX_OFFSET;
+  aBrickIndex[1] = static_cast<int>((aBrickKey >> BRICK_INDEX_BITS) & indexMask) - BRICK_INDEX_OFFSET;
+  aBrickIndex[2] = static_cast<int>(aBrickKey & indexMask) - BRICK_INDEX_OFFSET;
+}
+
+//-----------------------------------------------------------------------------
+vtkPlusBrickedVolume::Brick* vtkPlusBrickedVolume::GetBrick(int aBrickX, int aBrickY, int aBrickZ)
+{
+  const long long brickKey = GetBrickKey(aBrickX, aBrickY, aBrickZ);
+  Brick& brick = this->Bricks[brickKey];
+  if (brick.Sum != NULL)
+  {
+    // Resident already, mark it as the most recently used
+    if (brick.ResidentPosition != this->ResidentBricks.begin())
+    {
+      this->ResidentBricks.splice(this->ResidentBricks.begin(), this->ResidentBricks, brick.ResidentPosition);
+    }
+    return &brick;
+  }
+  if (this->MakeResident(brickKey, brick) != PLUS_SUCCESS)
+  {
+    return NULL;
+  }
+  return &brick;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusBrickedVolume::MakeResident(long long aBrickKey, Brick& aBrick)
+{
+  const size_t brickSizeBytes = this->GetBrickSizeBytes();
+  unsigned char* memory = NULL;
+
+  if (this->MaxResidentMemoryMb <= 0)
+  {
+    // All bricks are kept in memory, only new bricks can be non-resident
+    aBrick.Storage.assign(brickSizeBytes, 0);
+    memory = &aBrick.Storage[0];
+  }
+  else
+  {
+    // Swap out the least recently used bricks to stay within the memory limit. The mapped memory is written back by the operating system.
+    const size_t maxResidentBricks = std::max<size_t>(1, static_cast<size_t>(this->MaxResidentMemoryMb * 1024.0 * 1024.0 / brickSizeBytes));
+    while (this->ResidentBricks.size() >= maxResidentBricks)
+    {
+      Brick& leastRecentlyUsedBrick = this->Bricks[this->ResidentBricks.back()];
+      this->SwapFiles[leastRecentlyUsedBrick.SwapSlot / SWAP_FILE_NUMBER_OF_SLOTS]->unmap(reinterpret_cast<unsigned char*>(leastRecentlyUsedBrick.Sum));
+      leastRecentlyUsedBrick.Sum = NULL;
+      leastRecentlyUsedBrick.Count = NULL;
+      this->ResidentBricks.pop_back();
+    }
+
+    if (aBrick.SwapSlot < 0)
+    {
+      // New brick, take the next slot. The swap files are created with their full size, so new slots are filled with zeros.
+      if (this->NumberOfSwapSlots % SWAP_FILE_NUMBER_OF_SLOTS == 0)
+      {
+        std::ostringstream swapFileName;
+        swapFileName << this->SwapDirectory << "/PlusBrickedVolume_" << QCoreApplication::applicationPid() << "_" << this << "_" << this->SwapFiles.size() << ".swap";
+        QFile* swapFile = new QFile(QString::fromStdString(swapFileName.str()));
+        if (!swapFile->open(QIODevice::ReadWrite | QIODevice::Truncate) || !swapFile->resize(static_cast<qint64>(SWAP_FILE_NUMBER_OF_SLOTS) * brickSizeBytes))
+        {
+          LOG_ERROR("Failed to create volume swap file " << swapFileName.str() << ": " << swapFile->errorString().toStdString());
+          swapFile->remove();
+          delete swapFile;
+          return PLUS_FAIL;
+        }
+        this->SwapFiles.push_back(swapFile);
+      }
+      aBrick.SwapSlot = this->NumberOfSwapSlots++;
+    }
+
+    QFile* swapFile = this->SwapFiles[aBrick.SwapSlot / SWAP_FILE_NUMBER_OF_SLOTS];
+    memory = swapFile->map(static_cast<qint64>(aBrick.SwapSlot % SWAP_FILE_NUMBER_OF_SLOTS) * brickSizeBytes, brickSizeBytes);
+    if (memory == NULL)
+    {
+      LOG_ERROR("Failed to map volume brick from swap file " << swapFile->fileName().toStdString() << ": " << swapFile->errorString().toStdString());
+      return PLUS_FAIL;
+    }
+  }
+
+  const size_t numberOfVoxels = brickSizeBytes / (sizeof(float) + sizeof(unsigned short));
+  aBrick.Sum = reinterpret_cast<float*>(memory);
+  aBrick.Count = reinterpret_cast<unsigned short*>(memory + numberOfVoxels * sizeof(float));
+  this->ResidentBricks.push_front(aBrickKey);
+  aBrick.ResidentPosition = this->ResidentBricks.begin();
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusBrickedVolume::InsertFrame(vtkImageData* aFrame, vtkMatrix4x4* aImageToVolumeMatrix)
+{
+  if (aFrame == NULL || aImageToVolumeMatrix == NULL)
+  {
+    LOG_ERROR("vtkPlusBrickedVolume::InsertFrame failed: invalid input");
+    return PLUS_FAIL;
+  }
+  if (aFrame->GetNumberOfScalarComponents() != 1)
+  {
+    LOG_ERROR("vtkPlusBrickedVolume::InsertFrame failed: only single component images are supported (the frame has " << aFrame->GetNumberOfScalarComponents() << ")");
+    return PLUS_FAIL;
+  }
+  if (this->ScalarType >= 0 && aFrame->GetScalarType() != this->ScalarType)
+  {
+    LOG_ERROR("vtkPlusBrickedVolume::InsertFrame failed: all frames must have the same scalar type");
+    return PLUS_FAIL;
+  }
+
+  double (*getPixelValue)(const void*, vtkIdType) = NULL;
+  switch (aFrame->GetScalarType())
+  {
+    vtkTemplateMacro(getPixelValue = &GetPixelValue<VTK_TT>);
+    default:
+      LOG_ERROR("vtkPlusBrickedVolume::InsertFrame failed: unsupported scalar type " << aFrame->GetScalarTypeAsString());
+      return PLUS_FAIL;
+  }
+
+  int frameSize[3] = {0};
+  aFrame->GetDimensions(frameSize);
+  int pixelMin[2] = {0, 0};
+  int pixelMax[2] = {frameSize[0] - 1, frameSize[1] - 1};
+  if (this->ClipRectangleSize[0] > 0 && this->ClipRectangleSize[1] > 0)
+  {
+    pixelMin[0] = std::max(this->ClipRectangleOrigin[0], 0);
+    pixelMin[1] = std::max(this->ClipRectangleOrigin[1], 0);
+    pixelMax[0] = std::min(this->ClipRectangleOrigin[0] + this->ClipRectangleSize[0] - 1, pixelMax[0]);
+    pixelMax[1] = std::min(this->ClipRectangleOrigin[1] + this->ClipRectangleSize[1] - 1, pixelMax[1]);
+  }
+
+  // Position of the pixels in voxel coordinates: origin + column * columnStep + row * rowStep
+  double origin[3] = {0};
+  double columnStep[3] = {0};
+  double rowStep[3] = {0};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    columnStep[axis] = aImageToVolumeMatrix->GetElement(axis, 0) / this->Spacing[axis];
+    rowStep[axis] = aImageToVolumeMatrix->GetElement(axis, 1) / this->Spacing[axis];
+    origin[axis] = aImageToVolumeMatrix->GetElement(axis, 3) / this->Spacing[axis];
+  }
+
+  // Brick indices must fit into the brick key and voxel indices into an int. The pixel positions are an affine function
+  // of the column and row, so it is enough to check the corners of the pasted region (also catches NaN and infinity).
+  const int brickSize = this->BrickSize;
+  const double maxAbsVoxelIndex = std::min(static_cast<double>(BRICK_INDEX_OFFSET - 1) * brickSize, static_cast<double>(std::numeric_limits<int>::max() / 2));
+  for (int corner = 0; corner < 4 && pixelMin[0] <= pixelMax[0] && pixelMin[1] <= pixelMax[1]; ++corner)
+  {
+    int column = (corner & 1) ? pixelMax[0] : pixelMin[0];
+    int row = (corner & 2) ? pixelMax[1] : pixelMin[1];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      double voxelPosition = origin[axis] + column * columnStep[axis] + row * rowStep[axis] + 0.5;
+      if (!(voxelPosition >= -maxAbsVoxelIndex && voxelPosition <= maxAbsVoxelIndex))
+      {
+        LOG_ERROR("vtkPlusBrickedVolume::InsertFrame failed: the frame is outside of the representable volume (pixel (" << column << ", " << row << ") is at voxel coordinate " << voxelPosition - 0.5 << " along axis " << axis << ")");
+        return PLUS_FAIL;
+      }
+    }
+  }
+  this->ScalarType = aFrame->GetScalarType();
+
+  const void* pixels = aFrame->GetScalarPointer();
+  Brick* brick = NULL;
+  int brickIndex[3] = {0};
+  for (int row = pixelMin[1]; row <= pixelMax[1]; ++row)
+  {
+    for (int column = pixelMin[0]; column <= pixelMax[0]; ++column)
+    {
+      int voxel[3] = {0};
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        voxel[axis] = static_cast<int>(std::floor(origin[axis] + column * columnStep[axis] + row * rowStep[axis] + 0.5));
+      }
+
+      // Neighboring pixels usually fall into the same brick, only look it up when it changes
+      int voxelBrickIndex[3] = { FloorDivide(voxel[0], brickSize), FloorDivide(voxel[1], brickSize), FloorDivide(voxel[2], brickSize) };
+      if (brick == NULL || voxelBrickIndex[0] != brickIndex[0] || voxelBrickIndex[1] != brickIndex[1] || voxelBrickIndex[2] != brickIndex[2])
+      {
+        std::copy(voxelBrickIndex, voxelBrickIndex + 3, brickIndex);
+        brick = this->GetBrick(brickIndex[0], brickIndex[1], brickIndex[2]);
+        if (brick == NULL)
+        {
+          LOG_ERROR("vtkPlusBrickedVolume::InsertFrame failed: brick cannot be allocated");
+          return PLUS_FAIL;
+        }
+      }
+
+      size_t voxelIndexInBrick = (static_cast<size_t>(voxel[2] - brickIndex[2] * brickSize) * brickSize + (voxel[1] - brickIndex[1] * brickSize)) * brickSize + (voxel[0] - brickIndex[0] * brickSize);
+      if (brick->Count[voxelIndexInBrick] < MAX_VOXEL_COUNT)
+      {
+        brick->Sum[voxelIndexInBrick] += static_cast<float>(getPixelValue(pixels, static_cast<vtkIdType>(row) * frameSize[0] + column));
+        brick->Count[voxelIndexInBrick]++;
+      }
+
+      if (!this->VoxelExtentValid)
+      {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          this->VoxelExtent[axis * 2] = voxel[axis];
+          this->VoxelExtent[axis * 2 + 1] = voxel[axis];
+        }
+        this->VoxelExtentValid = true;
+      }
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        this->VoxelExtent[axis * 2] = std::min(this->VoxelExtent[axis * 2], voxel[axis]);
+        this->VoxelExtent[axis * 2 + 1] = std::max(this->VoxelExtent[axis * 2 + 1], voxel[axis]);
+      }
+    }
+  }
+
+  this->Modified();
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBrickedVolume::CopyBrickToVolume(const int aBrickIndex[3], Brick& aBrick, void* aVoxels, const int aVolumeExtent[6], int aSubsampling)
+{
+  void (*setVoxelValue)(void*, vtkIdType, double) = NULL;
+  switch (this->ScalarType)
+  {
+    vtkTemplateMacro(setVoxelValue = &SetVoxelValue<VTK_TT>);
+    default:
+      return;
+  }
+  const double minValue = vtkDataArray::GetDataTypeMin(this->ScalarType);
+  const double maxValue = vtkDataArray::GetDataTypeMax(this->ScalarType);
+  const bool roundValues = (this->ScalarType != VTK_FLOAT && this->ScalarType != VTK_DOUBLE);
+
+  int volumeSize[3] = {0};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    volumeSize[axis] = (aVolumeExtent[axis * 2 + 1] - aVolumeExtent[axis * 2]) / aSubsampling + 1;
+  }
+
+  const int brickSize = this->BrickSize;
+  size_t voxelIndexInBrick = 0;
+  for (int z = aBrickIndex[2] * brickSize; z < (aBrickIndex[2] + 1) * brickSize; ++z)
+  {
+    for (int y = aBrickIndex[1] * brickSize; y < (aBrickIndex[1] + 1) * brickSize; ++y)
+    {
+      for (int x = aBrickIndex[0] * brickSize; x < (aBrickIndex[0] + 1) * brickSize; ++x, ++voxelIndexInBrick)
+      {
+        if (aBrick.Count[voxelIndexInBrick] == 0
+            || x < aVolumeExtent[0] || x > aVolumeExtent[1] || y < aVolumeExtent[2] || y > aVolumeExtent[3] || z < aVolumeExtent[4] || z > aVolumeExtent[5]
+            || (x - aVolumeExtent[0]) % aSubsampling != 0 || (y - aVolumeExtent[2]) % aSubsampling != 0 || (z - aVolumeExtent[4]) % aSubsampling != 0)
+        {
+          continue;
+        }
+        double value = aBrick.Sum[voxelIndexInBrick] / aBrick.Count[voxelIndexInBrick];
+        if (roundValues)
+        {
+          value = std::floor(value + 0.5);
+        }
+        value = std::min(std::max(value, minValue), maxValue);
+        vtkIdType volumeIndex = (static_cast<vtkIdType>((z - aVolumeExtent[4]) / aSubsampling) * volumeSize[1] + (y - aVolumeExtent[2]) / aSubsampling) * volumeSize[0]
+                                + (x - aVolumeExtent[0]) / aSubsampling;
+        setVoxelValue(aVoxels, volumeIndex, value);
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusBrickedVolume::GetDenseVolume(vtkImageData* aVolume, int aSubsampling/*=1*/)
+{
+  if (aVolume == NULL)
+  {
+    LOG_ERROR("vtkPlusBrickedVolume::GetDenseVolume failed: invalid output");
+    return PLUS_FAIL;
+  }
+  if (!this->VoxelExtentValid)
+  {
+    LOG_ERROR("vtkPlusBrickedVolume::GetDenseVolume failed: no frame has been inserted");
+    return PLUS_FAIL;
+  }
+  aSubsampling = std::max(aSubsampling, 1);
+
+  int volumeSize[3] = {0};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    volumeSize[axis] = (this->VoxelExtent[axis * 2 + 1] - this->VoxelExtent[axis * 2]) / aSubsampling + 1;
+  }
+  aVolume->SetExtent(0, volumeSize[0] - 1, 0, volumeSize[1] - 1, 0, volumeSize[2] - 1);
+  aVolume->SetSpacing(this->Spacing[0] * aSubsampling, this->Spacing[1] * aSubsampling, this->Spacing[2] * aSubsampling);
+  aVolume->SetOrigin(this->VoxelExtent[0] * this->Spacing[0], this->VoxelExtent[2] * this->Spacing[1], this->VoxelExtent[4] * this->Spacing[2]);
+  aVolume->AllocateScalars(this->ScalarType, 1);
+
+  void* voxels = aVolume->GetScalarPointer();
+  memset(voxels, 0, static_cast<size_t>(volumeSize[0]) * volumeSize[1] * volumeSize[2] * aVolume->GetScalarSize());
+
+  for (std::unordered_map<long long, Brick>::iterator brickIt = this->Bricks.begin(); brickIt != this->Bricks.end(); ++brickIt)
+  {
+    int brickIndex[3] = {0};
+    GetBrickIndex(brickIt->first, brickIndex);
+    Brick* brick = this->GetBrick(brickIndex[0], brickIndex[1], brickIndex[2]);
+    if (brick == NULL)
+    {
+      LOG_ERROR("vtkPlusBrickedVolume::GetDenseVolume failed: brick cannot be read");
+      return PLUS_FAIL;
+    }
+    this->CopyBrickToVolume(brickIndex, *brick, voxels, this->VoxelExtent, aSubsampling);
+  }
+
+  aVolume->Modified();
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusBrickedVolume::WriteToMetafile(const std::string& aFileName)
+{
+  LOG_TRACE("vtkPlusBrickedVolume::WriteToMetafile(" << aFileName << ")");
+
+  if (!this->VoxelExtentValid)
+  {
+    LOG_ERROR("vtkPlusBrickedVolume::WriteToMetafile failed: no frame has been inserted");
+    return PLUS_FAIL;
+  }
+  std::string elementType = GetMetaElementType(this->ScalarType);
+  if (elementType.empty())
+  {
+    LOG_ERROR("vtkPlusBrickedVolume::WriteToMetafile failed: unsupported scalar type " << this->ScalarType);
+    return PLUS_FAIL;
+  }
+
+  std::ofstream file(aFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    LOG_ERROR("Failed to open " << aFileName << " for writing");
+    return PLUS_FAIL;
+  }
+
+  int volumeSize[3] = {0};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    volumeSize[axis] = this->VoxelExtent[axis * 2 + 1] - this->VoxelExtent[axis * 2] + 1;
+  }
+
+  file << "ObjectType = Image\n";
+  file << "NDims = 3\n";
+  file << "BinaryData = True\n";
+#ifdef VTK_WORDS_BIGENDIAN
+  file << "BinaryDataByteOrderMSB = True\n";
+#else
+  file << "BinaryDataByteOrderMSB = False\n";
+#endif
+  file << "CompressedData = False\n";
+  file << "TransformMatrix = 1 0 0 0 1 0 0 0 1\n";
+  file << "Offset = " << this->VoxelExtent[0] * this->Spacing[0] << " " << this->VoxelExtent[2] * this->Spacing[1] << " " << this->VoxelExtent[4] * this->Spacing[2] << "\n";
+  file << "CenterOfRotation = 0 0 0\n";
+  file << "ElementSpacing = " << this->Spacing[0] << " " << this->Spacing[1] << " " << this->Spacing[2] << "\n";
+  file << "DimSize = " << volumeSize[0] << " " << volumeSize[1] << " " << volumeSize[2] << "\n";
+  file << "AnatomicalOrientation = RAI\n";
+  file << "ElementType = " << elementType << "\n";
+  file << "ElementDataFile = LOCAL\n";
+
+  // Group the bricks by slab (bricks with the same z index), so each brick is read only once
+  std::map<int, std::vector<long long> > slabBricks;
+  for (std::unordered_map<long long, Brick>::iterator brickIt = this->Bricks.begin(); brickIt != this->Bricks.end(); ++brickIt)
+  {
+    int brickIndex[3] = {0};
+    GetBrickIndex(brickIt->first, brickIndex);
+    slabBricks[brickIndex[2]].push_back(brickIt->first);
+  }
+
+  const int brickSize = this->BrickSize;
+  const size_t scalarSize = vtkDataArray::GetDataTypeSize(this->ScalarType);
+  std::vector<unsigned char> slab;
+  for (int slabIndex = FloorDivide(this->VoxelExtent[4], brickSize); slabIndex <= FloorDivide(this->VoxelExtent[5], brickSize); ++slabIndex)
+  {
+    int slabExtent[6] =
+    {
+      this->VoxelExtent[0], this->VoxelExtent[1], this->VoxelExtent[2], this->VoxelExtent[3],
+      std::max(slabIndex * brickSize, this->VoxelExtent[4]), std::min((slabIndex + 1) * brickSize - 1, this->VoxelExtent[5])
+    };
+    slab.assign(static_cast<size_t>(volumeSize[0]) * volumeSize[1] * (slabExtent[5] - slabExtent[4] + 1) * scalarSize, 0);
+
+    std::vector<long long>& brickKeys = slabBricks[slabIndex];
+    for (std::vector<long long>::iterator keyIt = brickKeys.begin(); keyIt != brickKeys.end(); ++keyIt)
+    {
+      int brickIndex[3] = {0};
+      GetBrickIndex(*keyIt, brickIndex);
+      Brick* brick = this->GetBrick(brickIndex[0], brickIndex[1], brickIndex[2]);
+      if (brick == NULL)
+      {
+        LOG_ERROR("vtkPlusBrickedVolume::WriteToMetafile failed: brick cannot be read");
+        return PLUS_FAIL;
+      }
+      this->CopyBrickToVolume(brickIndex, *brick, &slab[0], slabExtent, 1);
+    }
+
+    file.write(reinterpret_cast<const char*>(&slab[0]), slab.size());
+    if (!file.good())
+    {
+      LOG_ERROR("Failed to write volume into " << aFileName);
+      return PLUS_FAIL;
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusBrickedVolume::GetSubsamplingForMemoryLimit(double aMemoryLimitMb)
+{
+  if (!this->VoxelExtentValid || this->ScalarType < 0 || aMemoryLimitMb <= 0)
+  {
+    return 1;
+  }
+  double volumeSizeMb = static_cast<double>(vtkDataArray::GetDataTypeSize(this->ScalarType)) / (1024.0 * 1024.0);
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    volumeSizeMb *= this->VoxelExtent[axis * 2 + 1] - this->VoxelExtent[axis * 2] + 1;
+  }
+  int subsampling = 1;
+  while (volumeSizeMb / (static_cast<double>(subsampling) * subsampling * subsampling) > aMemoryLimitMb)
+  {
+    subsampling++;
+  }
+  return subsampling;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBrickedVolume::RemoveSwapFiles()
+{
+  for (std::list<long long>::iterator keyIt = this->ResidentBricks.begin(); keyIt != this->ResidentBricks.end(); ++keyIt)
+  {
+    Brick& brick = this->Bricks[*keyIt];
+    if (brick.SwapSlot >= 0)
+    {
+      this->SwapFiles[brick.SwapSlot / SWAP_FILE_NUMBER_OF_SLOTS]->unmap(reinterpret_cast<unsigned char*>(brick.Sum));
+      brick.Sum = NULL;
+      brick.Count = NULL;
+    }
+  }
+  for (std::vector<QFile*>::iterator fileIt = this->SwapFiles.begin(); fileIt != this->SwapFiles.end(); ++fileIt)
+  {
+    (*fileIt)->close();
+    (*fileIt)->remove();
+    delete *fileIt;
+  }
+  this->SwapFiles.clear();
+  this->NumberOfSwapSlots = 0;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBrickedVolume::Reset()
+{
+  this->RemoveSwapFiles();
+  this->Bricks.clear();
+  this->ResidentBricks.clear();
+  this->VoxelExtentValid = false;
+  this->ScalarType = -1;
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusBrickedVolume::GetVoxelExtent(int aExtent[6])
+{
+  std::copy(this->VoxelExtent, this->VoxelExtent + 6, aExtent);
+  return this->VoxelExtentValid;
+}
+
+//-----------------------------------------------------------------------------
+int vtkPlusBrickedVolume::GetNumberOfBricks()
+{
+  return static_cast<int>(this->Bricks.size());
+}
+
+//-----------------------------------------------------------------------------
+double vtkPlusBrickedVolume::GetAllocatedMemoryMb()
+{
+  return this->Bricks.size() * static_cast<double>(this->GetBrickSizeBytes()) / (1024.0 * 1024.0);
+}
+
+//-----------------------------------------------------------------------------
+double vtkPlusBrickedVolume::GetResidentMemoryMb()
+{
+  return this->ResidentBricks.size() * static_cast<double>(this->GetBrickSizeBytes()) / (1024.0 * 1024.0);
+}
+
+//-----------------------------------------------------------------------------
+double vtkPlusBrickedVolume::GetBoundingBoxMemoryMb()
+{
+  if (!this->VoxelExtentValid)
+  {
+    return 0.0;
+  }
+  const double bytesPerVoxel = sizeof(float) + sizeof(unsigned short);
+  double numberOfVoxels = 1.0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    numberOfVoxels *= this->VoxelExtent[axis * 2 + 1] - this->VoxelExtent[axis * 2] + 1;
+  }
+  return numberOfVoxels * bytesPerVoxel / (1024.0 * 1024.0);
+}
@@ -0,0 +1,200 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusBrickedVolume_h
+#define __vtkPlusBrickedVolume_h
+
+// PlusLib includes
+#include <PlusConfigure.h>
+
+// VTK includes
+#include <vtkObject.h>
+
+// STL includes
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class QFile;
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkXMLDataElement;
+
+//-----------------------------------------------------------------------------
+
+/*! \class vtkPlusBrickedVolume
+* \brief Reconstruction volume that grows in bricks as frames are inserted
+
+The volume is divided into cubic bricks of BrickSize voxels along each axis. A brick is only allocated
+when a pixel of an inserted frame falls into it, so the memory use follows the scanned region instead of
+its bounding box, and the output extent need not be known before the first frame is inserted. Frames can
+therefore be reconstructed in a single pass, as they arrive. Each pixel is pasted into the nearest voxel
+and the voxel values are averaged (compounding). GetDenseVolume() converts the bricks into an image
+covering all inserted pixels.
+
+If MaxResidentMemoryMb is set then the bricks are stored out of core: each brick has a slot in swap files
+in SwapDirectory and is memory-mapped while it is resident. When the resident bricks would exceed the
+limit, the least recently used brick is unmapped (the operating system writes it back to the disk), so
+volumes larger than the available memory can be reconstructed. Such volumes are written to file with
+WriteToMetafile(), which assembles the output from the bricks one slab at a time, and displayed from a
+subsampled dense volume (see GetDenseVolume()).
+
+Unlike vtkPlusVolumeReconstructor, no interpolation or hole filling is performed: the output spacing should
+not be much smaller than the pixel spacing and the distance between neighboring frames.
+
+\ingroup PlusAppFCal
+*/
+class vtkPlusBrickedVolume : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkPlusBrickedVolume, vtkObject);
+  static vtkPlusBrickedVolume* New();
+
+  /*!
+  * Read OutputSpacing, ClipRectangleOrigin and ClipRectangleSize from the VolumeReconstruction element
+  * \param aConfig Root element of the configuration
+  */
+  PlusStatus ReadConfiguration(vtkXMLDataElement* aConfig);
+
+  /*!
+  * Paste the pixels of a frame into the volume
+  * \param aFrame Single component image
+  * \param aImageToVolumeMatrix Transform from image pixel coordinates to the volume coordinate system (in which the spacing is defined)
+  */
+  PlusStatus InsertFrame(vtkImageData* aFrame, vtkMatrix4x4* aImageToVolumeMatrix);
+
+  /*!
+  * Create an image from the bricks that covers all the inserted pixels. Voxels that no pixel was pasted into are 0.
+  * The scalar type is the scalar type of the inserted frames.
+  * \param aSubsampling Only every n-th voxel is copied along each axis, to get a smaller volume (e.g., for display)
+  */
+  PlusStatus GetDenseVolume(vtkImageData* aVolume, int aSubsampling = 1);
+
+  /*!
+  * Write the volume into an uncompressed metafile (.mha) without creating the whole dense volume in memory.
+  * The output is assembled from the bricks one slab (BrickSize slices) at a time.
+  */
+  PlusStatus WriteToMetafile(const std::string& aFileName);
+
+  /*! Smallest subsampling (see GetDenseVolume) with which the dense volume fits into the given memory */
+  int GetSubsamplingForMemoryLimit(double aMemoryLimitMb);
+
+  /*! Remove all bricks and the swap files */
+  void Reset();
+
+  /*! Voxel index extent of the inserted pixels, returns false if the volume is empty */
+  bool GetVoxelExtent(int aExtent[6]);
+
+  /*! Number of allocated bricks */
+  int GetNumberOfBricks();
+
+  /*! Memory used by the allocated bricks, resident or swapped out */
+  double GetAllocatedMemoryMb();
+
+  /*! Memory used by the resident bricks */
+  double GetResidentMemoryMb();
+
+  /*! Memory that a dense volume of the same extent would use for compounding (same per-voxel storage as the bricks) */
+  double GetBoundingBoxMemoryMb();
+
+public:
+  vtkSetVector3Macro(Spacing, double);
+  vtkGetVector3Macro(Spacing, double);
+
+  /*! Brick edge length in voxels. It can only be changed while the volume is empty. */
+  void SetBrickSize(int aBrickSize);
+  vtkGetMacro(BrickSize, int);
+
+  vtkSetVector2Macro(ClipRectangleOrigin, int);
+  vtkGetVector2Macro(ClipRectangleOrigin, int);
+
+  /*! Size of the region of the frames that is pasted, in pixels. If any of the components is 0 then the whole frame is pasted. */
+  vtkSetVector2Macro(ClipRectangleSize, int);
+  vtkGetVector2Macro(ClipRectangleSize, int);
+
+  /*! Memory limit of the resident bricks. If 0 then all bricks are kept in memory and no swap file is used. It can only be changed while the volume is empty. */
+  void SetMaxResidentMemoryMb(double aMaxResidentMemoryMb);
+  vtkGetMacro(MaxResidentMemoryMb, double);
+
+  /*! Directory of the swap files (should be on a local disk) */
+  vtkSetMacro(SwapDirectory, std::string);
+  vtkGetMacro(SwapDirectory, std::string);
+
+protected:
+  vtkPlusBrickedVolume();
+  virtual ~vtkPlusBrickedVolume();
+
+  /*! Compounding accumulators of the voxels of a brick */
+  struct Brick
+  {
+    Brick();
+
+    /*! Voxel accumulators, NULL if the brick is not resident. They point into Storage or into the mapped swap file slot. */
+    float* Sum;
+    unsigned short* Count;
+
+    /*! Memory of the brick if it is kept in memory (no swap file is used) */
+    std::vector<unsigned char> Storage;
+
+    /*! Slot of the brick in the swap files, -1 if no swap file is used */
+    long long SwapSlot;
+
+    /*! Position of the brick in the list of resident bricks */
+    std::list<long long>::iterator ResidentPosition;
+  };
+
+  /*! Get the brick of a brick index, allocate it if it does not exist yet, make it resident if it is swapped out. Returns NULL on error. */
+  Brick* GetBrick(int aBrickX, int aBrickY, int aBrickZ);
+
+  /*! Make a brick resident and most recently used, swap out the least recently used brick if needed */
+  PlusStatus MakeResident(long long aBrickKey, Brick& aBrick);
+
+  /*! Number of bytes of the accumulators of a brick */
+  size_t GetBrickSizeBytes() const;
+
+  /*! Key of a brick in the brick map */
+  static long long GetBrickKey(int aBrickX, int aBrickY, int aBrickZ);
+
+  /*! Brick index of a brick key */
+  static void GetBrickIndex(long long aBrickKey, int aBrickIndex[3]);
+
+  /*! Copy the voxels of a brick into a dense volume buffer */
+  void CopyBrickToVolume(const int aBrickIndex[3], Brick& aBrick, void* aVoxels, const int aVolumeExtent[6], int aSubsampling);
+
+  /*! Remove the swap files */
+  void RemoveSwapFiles();
+
+protected:
+  double Spacing[3];
+  int BrickSize;
+  int ClipRectangleOrigin[2];
+  int ClipRectangleSize[2];
+
+  /*! Bricks, indexed by the brick key */
+  std::unordered_map<long long, Brick> Bricks;
+
+  /*! Voxel index extent of the inserted pixels (valid if VoxelExtentValid) */
+  int VoxelExtent[6];
+  bool VoxelExtentValid;
+
+  /*! Scalar type of the inserted frames, -1 if no frame has been inserted */
+  int ScalarType;
+
+  /*! Keys of the resident bricks, the most recently used first */
+  std::list<long long> ResidentBricks;
+
+  double MaxResidentMemoryMb;
+  std::string SwapDirectory;
+
+  /*! Swap files, each holds a fixed number of brick slots (files are not resized while their slots are mapped) */
+  std::vector<QFile*> SwapFiles;
+
+  /*! Number of brick slots used in the swap files */
+  long long NumberOfSwapSlots;
+};
+
+#endif
@@ -13,9 +13,9 @@ See License.txt for details.
 
 // VTK includes
 #include <vtkConeSource.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkImageSliceMapper.h>
 #include <vtkLineSource.h>
-#include <vtkProp3DCollection.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
@@ -23,6 +23,9 @@ See License.txt for details.
 #include <vtkSphereSource.h>
 #include <vtkTextProperty.h>
 
+// STL includes
+#include <algorithm>
+
 //-----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkPlusImageVisualizer);
 //-----------------------------------------------------------------------------
@@ -43,15 +46,13 @@ vtkPlusImageVisualizer::vtkPlusImageVisualizer()
   : CanvasRenderer(vtkSmartPointer<vtkRenderer>::New())
   , ImageActor(vtkSmartPointer<vtkImageActor>::New())
   , ResultActor(vtkSmartPointer<vtkActor>::New())
-  , ResultGlyph(vtkSmartPointer<vtkGlyph3D>::New())
+  , ResultGlyphMapper(vtkSmartPointer<vtkGlyph3DMapper>::New())
   , ImageCamera(vtkSmartPointer<vtkCamera>::New())
   , OrientationMarkerAssembly(vtkSmartPointer<vtkAssembly>::New())
   , HorizontalOrientationTextActor(vtkSmartPointer<vtkTextActor3D>::New())
   , VerticalOrientationTextActor(vtkSmartPointer<vtkTextActor3D>::New())
-  , ScreenAlignedCurrentXRotation(0.0)
-  , ScreenAlignedCurrentYRotation(0.0)
   , CurrentMarkerOrientation(US_IMG_ORIENT_MF)
-  , ScreenAlignedProps(vtkSmartPointer<vtkProp3DCollection>::New())
+  , ScreenAlignedOrientationMatrix(vtkSmartPointer<vtkMatrix4x4>::New())
   , ROIActorAssembly(vtkSmartPointer<vtkAssembly>::New())
   , LeftLineSource(vtkSmartPointer<vtkLineSource>::New())
   , TopLineSource(vtkSmartPointer<vtkLineSource>::New())
@@ -65,6 +66,8 @@ vtkPlusImageVisualizer::vtkPlusImageVisualizer()
   this->RegionOfInterest[1] = -1;
   this->RegionOfInterest[2] = -1;
   this->RegionOfInterest[3] = -1;
+  this->DisplayedFrameSize = {0, 0, 0};
+
   // Set up canvas renderer
   this->CanvasRenderer->SetBackground(0.1, 0.1, 0.1);
   this->CanvasRenderer->SetBackground2(0.4, 0.4, 0.4);
@@ -74,13 +77,13 @@ vtkPlusImageVisualizer::vtkPlusImageVisualizer()
   this->CanvasRenderer->SetActiveCamera(this->ImageCamera);
 
   // Create Glyph and Actor
-  vtkSmartPointer<vtkPolyDataMapper> resultMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
   vtkSmartPointer<vtkSphereSource> resultSphereSource = vtkSmartPointer<vtkSphereSource>::New();
   resultSphereSource->SetRadius(3.0);   // mm
 
-  this->ResultGlyph->SetSourceConnection(resultSphereSource->GetOutputPort());
-  resultMapper->SetInputConnection(this->ResultGlyph->GetOutputPort());
-  this->ResultActor->SetMapper(resultMapper);
+  this->ResultGlyphMapper->SetSourceConnection(resultSphereSource->GetOutputPort());
+  this->ResultGlyphMapper->ScalingOff();
+  this->ResultGlyphMapper->OrientOff();
+  this->ResultActor->SetMapper(this->ResultGlyphMapper);
   this->ResultActor->GetProperty()->SetColor(RESULT_SPHERE_COLOR);
 
   this->ImageMapper = vtkImageSliceMapper::SafeDownCast(this->ImageActor->GetMapper());
@@ -302,8 +305,7 @@ PlusStatus vtkPlusImageVisualizer::UpdateCameraPose()
   }
 
   // Calculate image center
-  FrameSizeType dimensions = {0, 0, 0};
-  this->SelectedChannel->GetBrightnessFrameSize(dimensions);
+  const FrameSizeType& dimensions = this->DisplayedFrameSize;
   double imageCenterX = dimensions[0] / 2.0;
   double imageCenterY = dimensions[1] / 2.0;
   double imageCenterZ = dimensions[2] / 2.0;
@@ -482,6 +484,14 @@ void vtkPlusImageVisualizer::SetInputData(vtkImageData* aImage)
 {
   LOG_TRACE("vtkPlusImageVisualizer::SetInputData");
 
+  if (aImage != NULL)
+  {
+    int* dimensions = aImage->GetDimensions();
+    this->DisplayedFrameSize[0] = static_cast<unsigned int>(dimensions[0]);
+    this->DisplayedFrameSize[1] = static_cast<unsigned int>(dimensions[1]);
+    this->DisplayedFrameSize[2] = static_cast<unsigned int>(dimensions[2]);
+  }
+
   this->GetImageActor()->SetInputData(aImage);
 }
 
@@ -489,7 +499,7 @@ void vtkPlusImageVisualizer::SetInputData(vtkImageData* aImage)
 void vtkPlusImageVisualizer::SetResultPolyData(vtkPolyData* aResultPolyData)
 {
   LOG_TRACE("vtkPlusImageVisualizer::SetResultPolyData");
-  this->ResultGlyph->SetInputData(aResultPolyData);
+  this->ResultGlyphMapper->SetInputData(aResultPolyData);
 }
 
 //-----------------------------------------------------------------------------
@@ -498,14 +508,10 @@ PlusStatus vtkPlusImageVisualizer::AddScreenAlignedProp(vtkProp3D* aProp)
   LOG_TRACE("vtkPlusImageVisualizer::AddScreenAlignedProp");
 
   // Store the prop for later manipulation
-  this->ScreenAlignedProps->AddItem(aProp);
+  this->ScreenAlignedProps.push_back(aProp);
 
-  // Store the original position of the prop
-  std::vector<double> pos;
-  pos.push_back(aProp->GetPosition()[0]);
-  pos.push_back(aProp->GetPosition()[1]);
-  pos.push_back(aProp->GetPosition()[2]);
-  this->ScreenAlignedPropOriginalPosition.push_back(pos);
+  // The prop keeps its MF position, the orientation is applied on top of it
+  aProp->SetUserMatrix(this->ScreenAlignedOrientationMatrix);
 
   // Add it to the canvas
   this->GetCanvasRenderer()->AddActor(aProp);
@@ -516,33 +522,16 @@ PlusStatus vtkPlusImageVisualizer::AddScreenAlignedProp(vtkProp3D* aProp)
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusImageVisualizer::RemoveScreenAlignedProp(vtkProp3D* aProp)
 {
-  // Find index of aProp
-  int i = 0;
-  {
-    vtkProp3D* prop = NULL;
-    this->ScreenAlignedProps->InitTraversal();
-
-    do
-    {
-      prop = this->ScreenAlignedProps->GetNextProp3D();
-      if (prop == NULL || prop == aProp)
-      {
-        break;
-      }
-      ++i;
-    }
-    while (prop != NULL);
-  }
-
-  if (i > this->ScreenAlignedProps->GetNumberOfItems())
+  auto propIt = std::find(this->ScreenAlignedProps.begin(), this->ScreenAlignedProps.end(), aProp);
+  if (propIt == this->ScreenAlignedProps.end())
   {
     LOG_ERROR("Prop not found in screen aligned prop list.");
     return PLUS_FAIL;
   }
 
-  this->ScreenAlignedProps->RemoveItem(aProp);
-  this->ScreenAlignedPropOriginalPosition.erase(this->ScreenAlignedPropOriginalPosition.begin() + i);
+  this->ScreenAlignedProps.erase(propIt);
 
+  aProp->SetUserMatrix(NULL);
   this->GetCanvasRenderer()->RemoveActor(aProp);
 
   return PLUS_SUCCESS;
@@ -553,15 +542,13 @@ PlusStatus vtkPlusImageVisualizer::ClearScreenAlignedActorList()
 {
   LOG_TRACE("vtkPlusImageVisualizer::ClearScreenAlignedActorList");
 
-  vtkProp3D* prop = NULL;
-  vtkCollectionSimpleIterator pit;
-  for (this->ScreenAlignedProps->InitTraversal(pit);  prop = this->ScreenAlignedProps->GetNextProp3D(pit);)
+  for (auto it = this->ScreenAlignedProps.begin(); it != this->ScreenAlignedProps.end(); ++it)
   {
-    this->GetCanvasRenderer()->RemoveActor(prop);
+    (*it)->SetUserMatrix(NULL);
+    this->GetCanvasRenderer()->RemoveActor(*it);
   }
 
-  this->ScreenAlignedPropOriginalPosition.clear();
-  this->ScreenAlignedProps->RemoveAllItems();
+  this->ScreenAlignedProps.clear();
 
   return PLUS_SUCCESS;
 }
@@ -571,84 +558,34 @@ PlusStatus vtkPlusImageVisualizer::UpdateScreenAlignedActors()
 {
   LOG_TRACE("vtkPlusImageVisualizer::UpdateScreenAlignedActors");
 
-  // Only set new camera if image actor is visible and data collector is connected
-  if (this->SelectedChannel == NULL)
-  {
-    return PLUS_SUCCESS;
-  }
-
-  FrameSizeType dimensions = {0, 0, 0};
-  this->SelectedChannel->GetBrightnessFrameSize(dimensions);
-
-  vtkCollectionSimpleIterator pit;
-  vtkProp3D* prop = NULL;
-  int i = 0;
-  for (this->ScreenAlignedProps->InitTraversal(pit); prop = this->ScreenAlignedProps->GetNextProp3D(pit); ++i)
-  {
-    // Undo any existing rotations to the prop, so that all subsequent rotations are from a base orientation
-    // Base orientation is MF_SCREEN_RIGHT_DOWN
-    prop->RotateX(-this->ScreenAlignedCurrentXRotation);
-    prop->RotateY(-this->ScreenAlignedCurrentYRotation);
-
-    // Future work: instead of saving the original position of a prop (which will prevent any clients from changing the position of the prop after adding it)
-    // determine a method to back calculate the original position
-    // Possible solution is to pass in the previous orientation, then reverse the following calculations
-    double originalPosition[3] = {0};
-    originalPosition[0] = this->ScreenAlignedPropOriginalPosition.at(i).at(0);
-    originalPosition[1] = this->ScreenAlignedPropOriginalPosition.at(i).at(1);
-    originalPosition[2] = this->ScreenAlignedPropOriginalPosition.at(i).at(2);
-
-    // Apply any necessary rotations and repositioning
-    double newPosition[3] = {0};
-    switch (this->CurrentMarkerOrientation)
-    {
-    case US_IMG_ORIENT_MF:
-      newPosition[0] = originalPosition[0];
-      newPosition[1] = originalPosition[1];
-      newPosition[2] = originalPosition[2];
-      break;
-    case US_IMG_ORIENT_MN:
-      prop->RotateX(180);
-      newPosition[0] = originalPosition[0];
-      newPosition[1] = dimensions[1] - originalPosition[1];
-      newPosition[2] = -originalPosition[2];
-      break;
-    case US_IMG_ORIENT_UN:
-      prop->RotateX(180);
-      prop->RotateY(180);
-      newPosition[0] = dimensions[0] - originalPosition[0];
-      newPosition[1] = dimensions[1] - originalPosition[1];
-      newPosition[2] = originalPosition[2];
-      break;
-    case US_IMG_ORIENT_UF:
-      prop->RotateY(180);
-      newPosition[0] = dimensions[0] - originalPosition[0];
-      newPosition[1] = originalPosition[1];
-      newPosition[2] = -originalPosition[2];
-      break;
-    }
-
-    prop->SetPosition(newPosition);
-  }
+  // Screen-aligned props are positioned in MF orientation. The other orientations are reached by
+  // flipping them around the image, which is the same for every prop, so only the shared matrix
+  // needs to be recomputed and the props pick it up through their user matrix.
+  const FrameSizeType& dimensions = this->DisplayedFrameSize;
 
-  // Now update the member variables so that future rotations correctly undo the current rotations
+  this->ScreenAlignedOrientationMatrix->Identity();
   switch (this->CurrentMarkerOrientation)
   {
-  case US_IMG_ORIENT_MF:
-    this->ScreenAlignedCurrentXRotation = 0;
-    this->ScreenAlignedCurrentYRotation = 0;
-    break;
   case US_IMG_ORIENT_MN:
-    this->ScreenAlignedCurrentYRotation = 0;
-    this->ScreenAlignedCurrentXRotation = 180;
+    // Rotate 180 degrees about X
+    this->ScreenAlignedOrientationMatrix->SetElement(1, 1, -1.0);
+    this->ScreenAlignedOrientationMatrix->SetElement(2, 2, -1.0);
+    this->ScreenAlignedOrientationMatrix->SetElement(1, 3, dimensions[1]);
     break;
   case US_IMG_ORIENT_UN:
-    this->ScreenAlignedCurrentXRotation = 180.0;
-    this->ScreenAlignedCurrentYRotation = 180.0;
+    // Rotate 180 degrees about X and Y
+    this->ScreenAlignedOrientationMatrix->SetElement(0, 0, -1.0);
+    this->ScreenAlignedOrientationMatrix->SetElement(1, 1, -1.0);
+    this->ScreenAlignedOrientationMatrix->SetElement(0, 3, dimensions[0]);
+    this->ScreenAlignedOrientationMatrix->SetElement(1, 3, dimensions[1]);
     break;
   case US_IMG_ORIENT_UF:
-    this->ScreenAlignedCurrentYRotation = 180.0;
-    this->ScreenAlignedCurrentXRotation = 0;
+    // Rotate 180 degrees about Y
+    this->ScreenAlignedOrientationMatrix->SetElement(0, 0, -1.0);
+    this->ScreenAlignedOrientationMatrix->SetElement(2, 2, -1.0);
+    this->ScreenAlignedOrientationMatrix->SetElement(0, 3, dimensions[0]);
+    break;
+  default:
     break;
   }
 
@@ -926,30 +863,12 @@ PlusStatus vtkPlusImageVisualizer::SetWireLabelPositions(vtkPoints* aPointList)
     return PLUS_FAIL;
   }
 
+  // Wire label positions are in MF orientation, the screen-aligned orientation matrix takes care of the rest
   for (int i = 0; i < aPointList->GetNumberOfPoints(); ++i)
   {
     double* coords = aPointList->GetPoint(i);
-    vtkTextActor3D* actor = this->WireActors.at(i);
+    vtkTextActor3D* actor = this->WireActors[i];
     actor->SetPosition(coords[0] - 10.0, coords[1] - 10.0, actor->GetPosition()[2]);
-
-    // Since we would like the screen aligned prop system to manage the orientation of these for us,
-    // We must update the "original position" of the prop so that the system can use the latest position of the
-    // wire labels
-    int j = 0;
-    vtkProp3D* prop = NULL;
-    vtkCollectionSimpleIterator pit;
-    for (this->ScreenAlignedProps->InitTraversal(pit);  prop = this->ScreenAlignedProps->GetNextProp3D(pit); ++j)
-    {
-      vtkTextActor3D* ptr = dynamic_cast<vtkTextActor3D*>(prop);
-      if (ptr != NULL && ptr == actor)
-      {
-        std::vector<double> origCoords = ScreenAlignedPropOriginalPosition[j];
-        origCoords[0] = coords[0];
-        origCoords[1] = coords[1];
-        ScreenAlignedPropOriginalPosition[j] = origCoords;
-        break;
-      }
-    }
   }
   this->EnableWireLabels(true);
 
@@ -16,12 +16,12 @@ See License.txt for details.
 #include <vtkActor.h>
 #include <vtkAssembly.h>
 #include <vtkCamera.h>
-#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObject.h>
 #include <vtkPolyData.h>
-#include <vtkProp3DCollection.h>
 #include <vtkRenderer.h>
 #include <vtkSmartPointer.h>
 #include <vtkTextActor3D.h>
@@ -63,7 +63,8 @@ public:
   */
   PlusStatus ShowOrientationMarkers(bool aShow);
 
-  /*! Set the input source
+  /*! Set the input source. The frame size is cached so that camera and screen-aligned
+  * actor updates do not need to query the channel.
   * \param aImage pointer to the image data to show
   */
   void SetInputData(vtkImageData* aImage);
@@ -160,7 +161,7 @@ protected:
   /// Clear list of screen-aligned actors, Also does memory cleanup
   PlusStatus ClearScreenAlignedActorList();
 
-  /// Update the position and orientation of actors to become screen aligned
+  /// Update the orientation matrix shared by all screen-aligned actors
 
   PlusStatus UpdateScreenAlignedActors();
 
@@ -181,8 +182,8 @@ protected:
   vtkSmartPointer<vtkPolyData>                          ResultPolyData;
   ///  Actor for displaying the result points (eg. stylus tip, segmented points)
   vtkSmartPointer<vtkActor>                             ResultActor;
-  ///  Glyph producer for result
-  vtkSmartPointer<vtkGlyph3D>                           ResultGlyph;
+  ///  Instancing mapper for the result points, draws one sphere template at each point
+  vtkSmartPointer<vtkGlyph3DMapper>                     ResultGlyphMapper;
   ///  Camera of the scene
   vtkSmartPointer<vtkCamera>                            ImageCamera;
   ///  Assembly of actors for displaying the MF orientation
@@ -191,16 +192,14 @@ protected:
   vtkSmartPointer<vtkTextActor3D>                       HorizontalOrientationTextActor;
   ///  Specific reference to the vertical text actor
   vtkSmartPointer<vtkTextActor3D>                       VerticalOrientationTextActor;
-  ///  The current horizontal orientation of the orientation markers
-  double                                                ScreenAlignedCurrentXRotation;
-  ///  The current vertical orientation of the orientation markers
-  double                                                ScreenAlignedCurrentYRotation;
   ///  Record the current state of the marker orientation
   US_IMAGE_ORIENTATION                                  CurrentMarkerOrientation;
-  ///  List of objects maintained by the visualizer to be screen aligned
-  vtkSmartPointer<vtkProp3DCollection>                  ScreenAlignedProps;
-  ///  List of original positions of screen-aligned objects
-  std::vector<std::vector<double>>                      ScreenAlignedPropOriginalPosition;
+  ///  Size of the frame currently connected to the image actor
+  FrameSizeType                                         DisplayedFrameSize;
+  ///  List of objects maintained by the visualizer to be screen aligned. Their own position is always expressed in MF orientation.
+  std::vector<vtkSmartPointer<vtkProp3D>>               ScreenAlignedProps;
+  ///  MF to current orientation transform, set as user matrix of every screen-aligned object
+  vtkSmartPointer<vtkMatrix4x4>                         ScreenAlignedOrientationMatrix;
   ///  Flag to hold value of show/hide ROI
   bool                                                  ShowROI;
   ///  Assembly to hold all of the actors of the ROI for easy hide/show
@@ -8,21 +8,30 @@ See License.txt for details.
 #include "vtkPlusVisualizationController.h"
 #include "vtkPlus3DObjectVisualizer.h"
 #include "vtkPlusImageVisualizer.h"
+#include "PlusPerformanceMonitor.h"
 
 // PlusLib includes
 #include <igsioTrackedFrame.h>
 #include <vtkPlusDevice.h>
+#include <vtkIGSIOAccurateTimer.h>
 #include <vtkIGSIOTrackedFrameList.h>
 
 // VTK includes
 #include <QVTKOpenGLNativeWidget.h>
 #include <vtkDirectory.h>
+#include <vtkImageActor.h>
+#include <vtkImageData.h>
+#include <vtkImageProperty.h>
 #include <vtkInteractorStyleTrackballCamera.h>
+#include <vtkLookupTable.h>
 #include <vtkMath.h>
+#include <vtkPointData.h>
 #include <vtkPolyData.h>
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
+#include <vtkTextActor.h>
+#include <vtkTextProperty.h>
 #include <vtkTransform.h>
 #include <vtkXMLUtilities.h>
 #include <vtksys/SystemTools.hxx>
@@ -32,6 +41,28 @@ See License.txt for details.
 #include <QEvent>
 #include <QTimer>
 
+// STL includes
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  /*! Compute the mean of consecutive slices of a volume, the output has the size of one slice */
+  template <class T>
+  void AverageSlices(const T* aFirstSlice, vtkIdType aSliceSize, int aNumberOfSlices, T* aOutput)
+  {
+    for (vtkIdType i = 0; i < aSliceSize; ++i)
+    {
+      double sum = 0.0;
+      for (int slice = 0; slice < aNumberOfSlices; ++slice)
+      {
+        sum += aFirstSlice[slice * aSliceSize + i];
+      }
+      aOutput[i] = static_cast<T>(sum / aNumberOfSlices);
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusVisualizationController);
@@ -55,6 +86,28 @@ vtkPlusVisualizationController::vtkPlusVisualizationController()
   , InputPolyData(vtkSmartPointer<vtkPolyData>::New())
   , CurrentMode(DISPLAY_MODE_NONE)
   , AcquisitionFrameRate(20)
+  , FrontDisplayFrameIndex(0)
+  , LastPublishedFrameSource(NULL)
+  , LastPublishedFrameMTime(0)
+  , LastPublishedVideoSource(NULL)
+  , LastPublishedItemUid(0)
+  , ImageLookupTable(vtkSmartPointer<vtkLookupTable>::New())
+  , ImageColorWindow(255.0)
+  , ImageColorLevel(127.5)
+  , ImageWindowLevelValid(false)
+  , ImageWindowLevelSpecified(false)
+  , SliceNumber(0)
+  , SliceSlabThickness(1)
+  , FrontDisplaySliceIndex(0)
+  , LastSlicedFrame(NULL)
+  , LastSlicedFrameMTime(0)
+  , DisplaySliceOutdated(true)
+  , LastAcquiredDataTimestamp(0.0)
+  , TrackedFrameSnapshotValid(false)
+  , TrackedFrameSnapshotHasImageData(false)
+  , PerformanceOverlayActor(vtkSmartPointer<vtkTextActor>::New())
+  , RenderTimerId(PlusPerformanceMonitor::GetInstance()->RegisterTimer("Render"))
+  , DisplayLatencyTimerId(PlusPerformanceMonitor::GetInstance()->RegisterTimer("AcquisitionToDisplayLatency"))
   , TransformRepository(NULL)
   , SelectedChannel(NULL)
   , DataCollector(NULL)
@@ -62,6 +115,18 @@ vtkPlusVisualizationController::vtkPlusVisualizationController()
   // Create transform repository
   this->ClearTransformRepository();
 
+  // Slice buffers, their memory is reused as long as the frame size does not change
+  this->DisplaySliceBuffers[0] = vtkSmartPointer<vtkImageData>::New();
+  this->DisplaySliceBuffers[1] = vtkSmartPointer<vtkImageData>::New();
+
+  // Linear gray scale ramp, the window and level of the image actor select the pixel value range it covers
+  this->ImageLookupTable->SetNumberOfTableValues(256);
+  this->ImageLookupTable->SetHueRange(0.0, 0.0);
+  this->ImageLookupTable->SetSaturationRange(0.0, 0.0);
+  this->ImageLookupTable->SetValueRange(0.0, 1.0);
+  this->ImageLookupTable->SetRampToLinear();
+  this->ImageLookupTable->Build();
+
   // Input points poly data
   this->InputPoints = vtkSmartPointer<vtkPoints>::New();
   this->InputPolyData->SetPoints(this->InputPoints);
@@ -86,6 +151,14 @@ vtkPlusVisualizationController::vtkPlusVisualizationController()
   this->BlankRenderer->SetBackground(0.1, 0.1, 0.1);
   this->BlankRenderer->SetBackground2(0.4, 0.4, 0.4);
   this->BlankRenderer->SetGradientBackground(true);
+
+  // Set up performance overlay, it is only added to the renderers when shown
+  this->PerformanceOverlayActor->GetTextProperty()->SetFontFamilyToCourier();
+  this->PerformanceOverlayActor->GetTextProperty()->SetFontSize(12);
+  this->PerformanceOverlayActor->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
+  this->PerformanceOverlayActor->GetTextProperty()->SetVerticalJustificationToTop();
+  this->PerformanceOverlayActor->GetPositionCoordinate()->SetCoordinateSystemToNormalizedViewport();
+  this->PerformanceOverlayActor->GetPositionCoordinate()->SetValue(0.01, 0.99);
 }
 
 //-----------------------------------------------------------------------------
@@ -447,26 +520,77 @@ PlusStatus vtkPlusVisualizationController::SetScreenRightDownAxesOrientation(US_
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVisualizationController::Update()
 {
+  // New tick, the tracked frame is fetched again by the first consumer that needs it
+  this->InvalidateTrackedFrameSnapshot();
+
   if (this->PerspectiveVisualizer != NULL && CurrentMode == DISPLAY_MODE_3D)
   {
-    this->PerspectiveVisualizer->Update();
+    // The 3D visualizer reads the transforms of this tick from the shared transform repository
+    if (this->GetTrackedFrameSnapshot() != NULL)
+    {
+      this->PerspectiveVisualizer->Update();
+    }
   }
 
-  // Force update of the brightness image in the DataCollector,
-  // because it is the image that the image actors show
+  // Force update of the brightness image in the DataCollector and hand it over to the image actors.
+  // The actor input only changes when a new frame has been published into the back buffer
+  // (or, for volumetric frames, when a new slice has been extracted from it).
   if (this->SelectedChannel != NULL && this->GetImageActor() != NULL)
   {
-    this->GetImageActor()->SetInputData(this->SelectedChannel->GetBrightnessOutput());
+    vtkImageData* displayedImage = this->GetDisplaySlice(this->PublishLatestFrame());
+    if (displayedImage != NULL && this->GetImageActor()->GetInput() != displayedImage)
+    {
+      this->SetImageActorInput(displayedImage);
+    }
   }
 
   if (this->GetCanvasRenderer() != nullptr && this->GetCanvasRenderer()->GetRenderWindow() != nullptr)
   {
+    PlusScopedTimer renderTimer(this->RenderTimerId);
     this->GetCanvasRenderer()->GetRenderWindow()->Render();
   }
 
+  // Let the toolboxes know that they have something new to show
+  double mostRecentTimestamp = 0.0;
+  if (this->SelectedChannel != NULL && this->SelectedChannel->GetMostRecentTimestamp(mostRecentTimestamp) == PLUS_SUCCESS
+      && mostRecentTimestamp != this->LastAcquiredDataTimestamp)
+  {
+    this->LastAcquiredDataTimestamp = mostRecentTimestamp;
+    emit NewDataAcquired();
+  }
+
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::ShowPerformanceOverlay(bool aShow)
+{
+  vtkRenderer* renderers[2] = { this->ImageVisualizer->GetCanvasRenderer(), this->PerspectiveVisualizer->GetCanvasRenderer() };
+  for (int i = 0; i < 2; ++i)
+  {
+    if (aShow && !renderers[i]->HasViewProp(this->PerformanceOverlayActor))
+    {
+      renderers[i]->AddActor2D(this->PerformanceOverlayActor);
+    }
+    else if (!aShow && renderers[i]->HasViewProp(this->PerformanceOverlayActor))
+    {
+      renderers[i]->RemoveActor2D(this->PerformanceOverlayActor);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusVisualizationController::IsPerformanceOverlayShown()
+{
+  return this->ImageVisualizer->GetCanvasRenderer()->HasViewProp(this->PerformanceOverlayActor) != 0;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetPerformanceOverlayText(const std::string& aText)
+{
+  this->PerformanceOverlayActor->SetInput(aText.c_str());
+}
+
 //-----------------------------------------------------------------------------
 vtkRenderer* vtkPlusVisualizationController::GetCanvasRenderer()
 {
@@ -540,15 +664,8 @@ PlusStatus vtkPlusVisualizationController::GetTransformMatrix(const char* aTrans
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVisualizationController::GetTransformMatrix(igsioTransformName aTransform, vtkMatrix4x4* aOutputMatrix, ToolStatus* aStatus/* = NULL*/)
 {
-  igsioTrackedFrame trackedFrame;
-  if (this->SelectedChannel == NULL || this->SelectedChannel->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
+  if (this->GetTrackedFrameSnapshot() == NULL)
   {
-    LOG_ERROR("Unable to get tracked frame from selected channel!");
-    return PLUS_FAIL;
-  }
-  if (this->TransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Unable to set transforms from tracked frame!");
     return PLUS_FAIL;
   }
 
@@ -607,15 +724,8 @@ PlusStatus vtkPlusVisualizationController::IsExistingTransform(const char* aTran
       return PLUS_FAIL;
     }
 
-    igsioTrackedFrame trackedFrame;
-    if (this->SelectedChannel->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Unable to get tracked frame from data collector!");
-      return PLUS_FAIL;
-    }
-    if (this->TransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
+    if (this->GetTrackedFrameSnapshot() == NULL)
     {
-      LOG_ERROR("Unable to set transforms from tracked frame!");
       return PLUS_FAIL;
     }
   }
@@ -630,6 +740,62 @@ PlusStatus vtkPlusVisualizationController::IsExistingTransform(const char* aTran
   return this->TransformRepository->IsExistingTransform(transformName)  == IGSIO_SUCCESS ? PLUS_SUCCESS : PLUS_FAIL;
 }
 
+//-----------------------------------------------------------------------------
+igsioTrackedFrame* vtkPlusVisualizationController::GetTrackedFrameSnapshot(bool aImageDataRequired/* = false*/)
+{
+  if (this->TrackedFrameSnapshotValid && (this->TrackedFrameSnapshotHasImageData || !aImageDataRequired))
+  {
+    return &this->TrackedFrameSnapshot;
+  }
+
+  this->InvalidateTrackedFrameSnapshot();
+
+  if (this->SelectedChannel == NULL || GetLatestTrackedFrame(this->SelectedChannel, this->TrackedFrameSnapshot, aImageDataRequired) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to get tracked frame from selected channel!");
+    return NULL;
+  }
+  if (this->TransformRepository->SetTransforms(this->TrackedFrameSnapshot) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to set transforms from tracked frame!");
+    return NULL;
+  }
+
+  this->TrackedFrameSnapshotValid = true;
+  this->TrackedFrameSnapshotHasImageData = aImageDataRequired;
+
+  return &this->TrackedFrameSnapshot;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::InvalidateTrackedFrameSnapshot()
+{
+  this->TrackedFrameSnapshotValid = false;
+  this->TrackedFrameSnapshotHasImageData = false;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVisualizationController::GetLatestTrackedFrame(vtkPlusChannel* aChannel, igsioTrackedFrame& aTrackedFrame, bool aImageDataRequired)
+{
+  if (aChannel == NULL)
+  {
+    return PLUS_FAIL;
+  }
+
+  if (aImageDataRequired)
+  {
+    return aChannel->GetTrackedFrame(aTrackedFrame);
+  }
+
+  double latestTimestamp(0);
+  if (aChannel->GetMostRecentTimestamp(latestTimestamp) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  return aChannel->GetTrackedFrame(latestTimestamp, aTrackedFrame, false);
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVisualizationController::DisconnectInput()
 {
@@ -644,15 +810,191 @@ PlusStatus vtkPlusVisualizationController::DisconnectInput()
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVisualizationController::ConnectInput()
 {
-  vtkPlusChannel* aChannel(NULL);
   if (this->GetImageActor() != NULL && this->SelectedChannel != NULL)
   {
-    this->GetImageActor()->SetInputData(this->SelectedChannel->GetBrightnessOutput());
+    this->SetImageActorInput(this->GetDisplaySlice(this->PublishLatestFrame()));
   }
 
   return PLUS_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusVisualizationController::PublishLatestFrame()
+{
+  if (this->SelectedChannel == NULL)
+  {
+    return NULL;
+  }
+
+  // RF data has to be converted to brightness on the CPU, all other frames are displayed as they are acquired
+  vtkPlusDataSource* videoSource = NULL;
+  if (this->SelectedChannel->GetVideoSource(videoSource) == PLUS_SUCCESS && videoSource != NULL)
+  {
+    US_IMAGE_TYPE imageType = videoSource->GetImageType();
+    if (imageType != US_IMG_RF_REAL && imageType != US_IMG_RF_IQ_LINE && imageType != US_IMG_RF_I_LINE_Q_LINE)
+    {
+      return this->PublishLatestRawFrame(videoSource);
+    }
+  }
+
+  return this->PublishLatestBrightnessFrame();
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusVisualizationController::PublishLatestRawFrame(vtkPlusDataSource* aVideoSource)
+{
+  if (aVideoSource->GetNumberOfItems() < 1)
+  {
+    return NULL;
+  }
+
+  BufferItemUidType latestUid = aVideoSource->GetLatestItemUidInBuffer();
+  if (aVideoSource != this->LastPublishedVideoSource || latestUid != this->LastPublishedItemUid)
+  {
+    // Copy the frame from the video buffer straight into the back buffer while the front one stays connected to the actor, then swap
+    int backIndex = 1 - this->FrontDisplayFrameIndex;
+    if (aVideoSource->GetStreamBufferItem(latestUid, &this->DisplayFrameItems[backIndex]) != ITEM_OK)
+    {
+      LOG_DEBUG("Latest video frame (UID: " << latestUid << ") is no longer available for display");
+      return this->DisplayFrameItems[this->FrontDisplayFrameIndex].GetFrame().GetImage();
+    }
+    this->FrontDisplayFrameIndex = backIndex;
+
+    // Time from the acquisition of the newest frame until it is handed over to the renderer
+    double acquisitionTimestamp = 0.0;
+    if (this->SelectedChannel->GetMostRecentTimestamp(acquisitionTimestamp) == PLUS_SUCCESS)
+    {
+      PlusPerformanceMonitor::GetInstance()->AddValue(this->DisplayLatencyTimerId, (vtkIGSIOAccurateTimer::GetSystemTime() - acquisitionTimestamp) * 1000.0);
+    }
+
+    this->LastPublishedVideoSource = aVideoSource;
+    this->LastPublishedItemUid = latestUid;
+  }
+
+  return this->DisplayFrameItems[this->FrontDisplayFrameIndex].GetFrame().GetImage();
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusVisualizationController::PublishLatestBrightnessFrame()
+{
+  vtkImageData* brightnessOutput = this->SelectedChannel->GetBrightnessOutput();
+  if (brightnessOutput == NULL)
+  {
+    return NULL;
+  }
+
+  if (brightnessOutput != this->LastPublishedFrameSource || brightnessOutput->GetMTime() > this->LastPublishedFrameMTime)
+  {
+    // Time from the acquisition of the newest frame until it is handed over to the renderer
+    double acquisitionTimestamp = 0.0;
+    if (this->SelectedChannel->GetMostRecentTimestamp(acquisitionTimestamp) == PLUS_SUCCESS)
+    {
+      PlusPerformanceMonitor::GetInstance()->AddValue(this->DisplayLatencyTimerId, (vtkIGSIOAccurateTimer::GetSystemTime() - acquisitionTimestamp) * 1000.0);
+    }
+
+    this->LastPublishedFrameSource = brightnessOutput;
+    this->LastPublishedFrameMTime = brightnessOutput->GetMTime();
+  }
+
+  // There is no double buffering here: copying the buffers would only alias the scalars of the brightness image.
+  // The channel regenerates the image on this thread, so it is never modified while it is being rendered.
+  return brightnessOutput;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetImageActorInput(vtkImageData* aImage)
+{
+  if (this->CurrentMode == DISPLAY_MODE_2D && this->ImageVisualizer != NULL)
+  {
+    // The image visualizer caches the frame size for its camera and screen-aligned actors
+    this->ImageVisualizer->SetInputData(aImage);
+  }
+  else if (this->GetImageActor() != NULL)
+  {
+    this->GetImageActor()->SetInputData(aImage);
+  }
+
+  if (this->GetImageActor() != NULL && aImage != NULL)
+  {
+    this->UpdateImageDisplayProperties(this->GetImageActor(), aImage);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::UpdateImageDisplayProperties(vtkImageActor* aImageActor, vtkImageData* aImage)
+{
+  vtkImageProperty* imageProperty = aImageActor->GetProperty();
+  if (aImage->GetNumberOfScalarComponents() != 1)
+  {
+    // Color frames are shown as they are
+    imageProperty->SetLookupTable(NULL);
+    imageProperty->SetColorWindow(255.0);
+    imageProperty->SetColorLevel(127.5);
+    return;
+  }
+
+  if (!this->ImageWindowLevelValid)
+  {
+    if (aImage->GetScalarType() == VTK_UNSIGNED_CHAR)
+    {
+      // B-mode images are displayed without any intensity change
+      this->ImageColorWindow = 255.0;
+      this->ImageColorLevel = 127.5;
+    }
+    else
+    {
+      // Only done once per channel, later frames are mapped with the same window and level
+      double range[2] = { 0.0, 0.0 };
+      aImage->GetScalarRange(range);
+      this->ImageColorWindow = std::max(range[1] - range[0], 1.0);
+      this->ImageColorLevel = 0.5 * (range[0] + range[1]);
+    }
+    this->ImageWindowLevelValid = true;
+    LOG_DEBUG("Image window/level: " << this->ImageColorWindow << "/" << this->ImageColorLevel);
+  }
+
+  // The property setters only modify the actor if the values change
+  imageProperty->SetLookupTable(this->ImageLookupTable);
+  imageProperty->UseLookupTableScalarRangeOff();
+  imageProperty->SetColorWindow(this->ImageColorWindow);
+  imageProperty->SetColorLevel(this->ImageColorLevel);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetImageWindowLevel(double aWindow, double aLevel)
+{
+  this->ImageColorWindow = std::max(aWindow, 1.0);
+  this->ImageColorLevel = aLevel;
+  this->ImageWindowLevelValid = true;
+  this->ImageWindowLevelSpecified = true;
+
+  vtkImageActor* imageActor = this->GetImageActor();
+  if (imageActor != NULL && imageActor->GetInput() != NULL)
+  {
+    this->UpdateImageDisplayProperties(imageActor, imageActor->GetInput());
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::GetImageWindowLevel(double& aWindow, double& aLevel)
+{
+  aWindow = this->ImageColorWindow;
+  aLevel = this->ImageColorLevel;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::ResetImageWindowLevel()
+{
+  this->ImageWindowLevelValid = false;
+  this->ImageWindowLevelSpecified = false;
+
+  vtkImageActor* imageActor = this->GetImageActor();
+  if (imageActor != NULL && imageActor->GetInput() != NULL)
+  {
+    this->UpdateImageDisplayProperties(imageActor, imageActor->GetInput());
+  }
+}
+
 //-----------------------------------------------------------------------------
 vtkImageActor* vtkPlusVisualizationController::GetImageActor()
 {
@@ -765,6 +1107,21 @@ PlusStatus vtkPlusVisualizationController::ReadConfiguration(vtkXMLDataElement*
     }
   }
 
+  // Optional window and level of the displayed image, computed from the first frame if not specified
+  vtkXMLDataElement* renderingElement = aXMLElement->FindNestedElementWithName("Rendering");
+  double imageWindow = 0.0;
+  double imageLevel = 0.0;
+  if (renderingElement != NULL
+      && renderingElement->GetScalarAttribute("DisplayedImageWindow", imageWindow)
+      && renderingElement->GetScalarAttribute("DisplayedImageLevel", imageLevel))
+  {
+    this->SetImageWindowLevel(imageWindow, imageLevel);
+  }
+  else
+  {
+    this->ResetImageWindowLevel();
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -815,6 +1172,7 @@ PlusStatus vtkPlusVisualizationController::ClearTransformRepository()
 {
   vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
   this->SetTransformRepository(transformRepository);
+  this->InvalidateTrackedFrameSnapshot();
 
   return PLUS_SUCCESS;
 }
@@ -963,6 +1321,21 @@ void vtkPlusVisualizationController::SetSelectedChannel(vtkPlusChannel* aChannel
 {
   this->SelectedChannel = aChannel;
 
+  // Make sure the first frame of the new channel is published
+  this->LastPublishedFrameSource = NULL;
+  this->LastPublishedFrameMTime = 0;
+  this->LastPublishedVideoSource = NULL;
+  this->LastPublishedItemUid = 0;
+  this->LastSlicedFrame = NULL;
+  this->DisplaySliceOutdated = true;
+  this->LastAcquiredDataTimestamp = 0.0;
+  if (!this->ImageWindowLevelSpecified)
+  {
+    // The pixel type and value range may be different in the new channel
+    this->ImageWindowLevelValid = false;
+  }
+  this->InvalidateTrackedFrameSnapshot();
+
   if (this->ImageVisualizer != NULL)
   {
     this->ImageVisualizer->SetChannel(aChannel);
@@ -983,12 +1356,96 @@ vtkPlusChannel* vtkPlusVisualizationController::GetSelectedChannel()
 //-----------------------------------------------------------------------------
 void vtkPlusVisualizationController::SetSliceNumber(int number)
 {
-  if (this->ImageVisualizer != NULL)
+  // The image actors receive the extracted slice only, so the slice is selected here instead of in their mappers
+  if (number == this->SliceNumber)
   {
-    this->ImageVisualizer->SetSliceNumber(number);
+    return;
   }
-  if (this->PerspectiveVisualizer != NULL)
+  this->SliceNumber = number;
+  this->DisplaySliceOutdated = true;
+  this->ConnectInput();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVisualizationController::SetSliceSlabThickness(int numberOfSlices)
+{
+  numberOfSlices = std::max(numberOfSlices, 1);
+  if (numberOfSlices == this->SliceSlabThickness)
   {
-    this->PerspectiveVisualizer->SetSliceNumber(number);
+    return;
   }
+  this->SliceSlabThickness = numberOfSlices;
+  this->DisplaySliceOutdated = true;
+  this->ConnectInput();
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* vtkPlusVisualizationController::GetDisplaySlice(vtkImageData* aFrame)
+{
+  if (aFrame == NULL)
+  {
+    return NULL;
+  }
+
+  int* extent = aFrame->GetExtent();
+  int numberOfSlices = extent[5] - extent[4] + 1;
+  if (numberOfSlices <= 1)
+  {
+    // 2D frames are displayed as they are
+    return aFrame;
+  }
+
+  if (!this->DisplaySliceOutdated && aFrame == this->LastSlicedFrame && aFrame->GetMTime() <= this->LastSlicedFrameMTime)
+  {
+    return this->DisplaySliceBuffers[this->FrontDisplaySliceIndex];
+  }
+
+  // Slab of slices around the selected one, clamped to the volume
+  int slabThickness = std::min(this->SliceSlabThickness, numberOfSlices);
+  int firstSlice = std::max(0, std::min(this->SliceNumber - (slabThickness - 1) / 2, numberOfSlices - slabThickness));
+
+  // Fill the back buffer while the front one stays connected to the actor, then swap
+  int backIndex = 1 - this->FrontDisplaySliceIndex;
+  vtkImageData* slice = this->DisplaySliceBuffers[backIndex];
+  int numberOfComponents = aFrame->GetNumberOfScalarComponents();
+  int scalarType = aFrame->GetScalarType();
+  int* sliceDimensions = slice->GetDimensions();
+  if (sliceDimensions[0] != extent[1] - extent[0] + 1 || sliceDimensions[1] != extent[3] - extent[2] + 1 || sliceDimensions[2] != 1
+      || slice->GetScalarType() != scalarType || slice->GetNumberOfScalarComponents() != numberOfComponents || slice->GetPointData()->GetScalars() == NULL)
+  {
+    // Memory of the slice buffer is only reallocated when the frame format changes
+    slice->SetExtent(extent[0], extent[1], extent[2], extent[3], 0, 0);
+    slice->AllocateScalars(scalarType, numberOfComponents);
+  }
+
+  // The slice keeps its position in the volume, so it appears at the same place as the slice of the whole frame did
+  double* spacing = aFrame->GetSpacing();
+  double* origin = aFrame->GetOrigin();
+  slice->SetSpacing(spacing);
+  slice->SetOrigin(origin[0], origin[1], origin[2] + (extent[4] + firstSlice + (slabThickness - 1) / 2.0) * spacing[2]);
+
+  vtkIdType sliceSize = static_cast<vtkIdType>(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) * numberOfComponents;
+  char* sliceStart = static_cast<char*>(aFrame->GetScalarPointer()) + firstSlice * sliceSize * aFrame->GetScalarSize();
+  if (slabThickness == 1)
+  {
+    memcpy(slice->GetScalarPointer(), sliceStart, sliceSize * aFrame->GetScalarSize());
+  }
+  else
+  {
+    switch (scalarType)
+    {
+      vtkTemplateMacro(AverageSlices(reinterpret_cast<const VTK_TT*>(sliceStart), sliceSize, slabThickness, static_cast<VTK_TT*>(slice->GetScalarPointer())));
+      default:
+        LOG_ERROR("Unable to extract slab from volumetric frame: unsupported scalar type " << scalarType);
+        return this->DisplaySliceBuffers[this->FrontDisplaySliceIndex];
+    }
+  }
+  slice->Modified();
+  this->FrontDisplaySliceIndex = backIndex;
+
+  this->LastSlicedFrame = aFrame;
+  this->LastSlicedFrameMTime = aFrame->GetMTime();
+  this->DisplaySliceOutdated = false;
+
+  return slice;
 }
\ No newline at end of file
@@ -10,8 +10,10 @@ See License.txt for details.
 // PlusLib includes
 #include <PlusConfigure.h>
 #include <PlusCommon.h>
+#include <igsioTrackedFrame.h>
 #include <igsioVideoFrame.h>
 #include <vtkPlusDataCollector.h>
+#include <vtkPlusDataSource.h>
 #include <vtkIGSIOTransformRepository.h>
 
 // Qt includes
@@ -26,12 +28,15 @@ class vtkPlusDisplayableObject;
 // VTK includes
 class QVTKOpenGLNativeWidget;
 class vtkImageActor;
+class vtkImageData;
+class vtkLookupTable;
 class vtkMatrix4x4;
 class vtkPolyData;
 class vtkPolyDataMapper;
 class vtkRenderWindow;
 class vtkRenderer;
 class vtkSTLReader;
+class vtkTextActor;
 class vtkTransform;
 class vtkXMLDataElement;
 
@@ -175,6 +180,24 @@ public:
   */
   PlusStatus IsExistingTransform(const char* aTransformFrom, const char* aTransformTo, bool aUseLatestTrackedFrame = true);
 
+  /*!
+  Get the tracked frame of the current acquisition tick. The frame is fetched from the selected channel at most once per tick and
+  its transforms are set to the transform repository at the same time, so every consumer of the tick reads the same sample.
+  The returned frame is owned by the controller and is only valid until the next tick.
+  /param aImageDataRequired If false then only the transforms are fetched and the pixel data is not copied
+  /return The snapshot frame, NULL if no tracked frame is available
+  */
+  igsioTrackedFrame* GetTrackedFrameSnapshot(bool aImageDataRequired = false);
+
+  /*! Discard the snapshot of the current tick (e.g. after the transform repository was filled from recorded frames) */
+  void InvalidateTrackedFrameSnapshot();
+
+  /*!
+  Get the latest tracked frame of a channel
+  /param aImageDataRequired If false then only the transforms are copied into the frame, the pixel data is skipped
+  */
+  static PlusStatus GetLatestTrackedFrame(vtkPlusChannel* aChannel, igsioTrackedFrame& aTrackedFrame, bool aImageDataRequired);
+
   /*! Function to handle resize events */
   void resizeEvent(QResizeEvent* aEvent);
 
@@ -268,8 +291,13 @@ public:
   void SetSelectedChannel(vtkPlusChannel* aChannel);
   vtkPlusChannel* GetSelectedChannel();
 
-  /*! Set the slice number in the image visualizer */
+  /*! Set the slice of volumetric frames that is displayed in the image actors */
   void SetSliceNumber(int number);
+  vtkGetMacro(SliceNumber, int);
+
+  /*! Set the number of slices around the selected slice that are averaged for display (1 shows the selected slice only) */
+  void SetSliceSlabThickness(int numberOfSlices);
+  vtkGetMacro(SliceSlabThickness, int);
 
   /*! Set the location of the line actor for the line segmentation result */
   void SetLineSegmentationPoints(double startPoint_Image[2], double endPoint_Image[2]);
@@ -289,6 +317,34 @@ public:
   vtkSmartPointer<vtkPoints> GetResultPolyDataPoints();
   vtkSmartPointer<vtkPoints> GetInputPolyDataPoints();
 
+  /*!
+  * Show or hide the performance overlay in the top left corner of both the 2D and the 3D canvas
+  * \param aShow Show if true, else hide
+  */
+  void ShowPerformanceOverlay(bool aShow);
+  bool IsPerformanceOverlayShown();
+
+  /*! Set the text of the performance overlay */
+  void SetPerformanceOverlayText(const std::string& aText);
+
+  /*!
+  * Set the window and level used for mapping single-component video frames to gray levels at render time
+  * \param aWindow Width of the mapped pixel value range
+  * \param aLevel Center of the mapped pixel value range
+  */
+  void SetImageWindowLevel(double aWindow, double aLevel);
+  void GetImageWindowLevel(double& aWindow, double& aLevel);
+
+  /*! Compute the window and level from the pixel type and value range of the next displayed frame */
+  void ResetImageWindowLevel();
+
+signals:
+  /*!
+  * Emitted in the acquisition tick when the selected channel has new video or tracking data since the previous tick.
+  * The transform repository and the image actors are already updated when it is emitted.
+  */
+  void NewDataAcquired();
+
 protected slots:
   /*!
   * Forward any updates to members that require it
@@ -316,6 +372,36 @@ protected:
 
   vtkImageActor* GetImageActor();
 
+  /*!
+  * Get the latest frame of the selected channel for display. Frames that are not RF data are copied from the
+  * video buffer into the back display buffer without any conversion, then the buffers are swapped, so the
+  * returned front buffer is never written to while it is connected to the image actor. Their gray levels are
+  * mapped by the lookup table of the image actor at render time. RF data is not double buffered, the brightness
+  * image of the channel is returned (see PublishLatestBrightnessFrame).
+  */
+  vtkImageData* PublishLatestFrame();
+
+  /*! Publish the latest frame of the video source directly from its buffer (used for all image types except RF) */
+  vtkImageData* PublishLatestRawFrame(vtkPlusDataSource* aVideoSource);
+
+  /*!
+  * Publish the brightness image computed by the selected channel (used for RF data). The image of the channel
+  * itself is returned, it is regenerated on the rendering thread only, so it does not change during rendering.
+  */
+  vtkImageData* PublishLatestBrightnessFrame();
+
+  /*! Connect a published frame to the image actor of the current mode */
+  void SetImageActorInput(vtkImageData* aImage);
+
+  /*! Set the lookup table, window and level of an image actor according to the frame it displays */
+  void UpdateImageDisplayProperties(vtkImageActor* aImageActor, vtkImageData* aImage);
+
+  /*!
+  * Get the image to display from a published frame. 2D frames are returned as they are. From volumetric frames the
+  * selected slice (or slab) is extracted into a reusable 2D buffer, only if the frame or the slice selection changed.
+  */
+  vtkImageData* GetDisplaySlice(vtkImageData* aFrame);
+
   QVTKOpenGLNativeWidget* GetCanvas()
   {
     return Canvas;
@@ -352,6 +438,47 @@ protected:
   DISPLAY_MODE                                CurrentMode;
   /*! Desired frame rate of synchronized recording */
   int                                         AcquisitionFrameRate;
+  /*! Front and back display buffers of the raw (non-RF) frames, filled directly from the video buffer */
+  StreamBufferItem                            DisplayFrameItems[2];
+  /*! Index of the buffer currently connected to the image actor */
+  int                                         FrontDisplayFrameIndex;
+  /*! Brightness image and its modification time at the last publish, used to detect new frames */
+  vtkImageData*                               LastPublishedFrameSource;
+  vtkMTimeType                                LastPublishedFrameMTime;
+  /*! Video source and buffer item identifier of the last published raw frame, used to detect new frames */
+  vtkPlusDataSource*                          LastPublishedVideoSource;
+  BufferItemUidType                           LastPublishedItemUid;
+  /*! Gray scale lookup table applied to single-component frames at render time */
+  vtkSmartPointer<vtkLookupTable>             ImageLookupTable;
+  /*! Window and level of the lookup table mapping, computed from the next frame if not valid */
+  double                                      ImageColorWindow;
+  double                                      ImageColorLevel;
+  bool                                        ImageWindowLevelValid;
+  /*! Window and level were set explicitly (configuration or SetImageWindowLevel), keep them when the channel changes */
+  bool                                        ImageWindowLevelSpecified;
+  /*! Displayed slice of volumetric frames and the number of slices averaged around it */
+  int                                         SliceNumber;
+  int                                         SliceSlabThickness;
+  /*! Front and back buffers of the slice extracted from volumetric frames */
+  vtkSmartPointer<vtkImageData>               DisplaySliceBuffers[2];
+  int                                         FrontDisplaySliceIndex;
+  /*! Frame and its modification time at the last slice extraction, used to detect new frames */
+  vtkImageData*                               LastSlicedFrame;
+  vtkMTimeType                                LastSlicedFrameMTime;
+  /*! Flag indicating that the slice selection changed since the last extraction */
+  bool                                        DisplaySliceOutdated;
+  /*! Most recent timestamp of the selected channel at the last acquisition tick, used to detect new data */
+  double                                      LastAcquiredDataTimestamp;
+  /*! Tracked frame fetched once per acquisition tick and shared by all consumers */
+  igsioTrackedFrame                           TrackedFrameSnapshot;
+  /*! Flags indicating if the snapshot belongs to the current tick and if it contains pixel data */
+  bool                                        TrackedFrameSnapshotValid;
+  bool                                        TrackedFrameSnapshotHasImageData;
+  /*! Text actor showing frame timing statistics on top of the canvas */
+  vtkSmartPointer<vtkTextActor>               PerformanceOverlayActor;
+  /*! Performance monitor timer identifiers of rendering and acquisition-to-display latency */
+  int                                         RenderTimerId;
+  int                                         DisplayLatencyTimerId;
   /// Cached variables from other systems
   QVTKOpenGLNativeWidget*                     Canvas;
   vtkIGSIOTransformRepository*                TransformRepository;